@@ -48,10 +48,21 @@ pub const TIMER_TICK_NS: u64 = 1_000_000_000 / TIMER_FREQUENCY_HZ as u64;
 // --- 🔊 Configuração de Dispositivos (Exemplo: MMIO Sound) ---
 // ------------------------------------------------------------------------
 
-/// Endereço de MMIO (Memory Mapped I/O) base para um dispositivo de som simulado/virtual.
-/// (Este seria o valor lido do Barramento PCI/VirtIO na inicialização real)
+/// Endereço do exemplo de dispositivo de som MMIO. NÃO é mapeado: nos PCs esta
+/// é a janela do HPET. O som real vem do HDA, com os endereços lidos dos BARs
+/// (`drivers::pci`).
 pub const SOUND_DEVICE_MMIO_BASE: usize = 0xFED0_0000;
 
+/// IRQ ISA do controlador de touchscreen MMIO (`drivers::touchscreen`).
+pub const TOUCHSCREEN_IRQ_LINE: u8 = 11;
+
+/// Roda o benchmark de tom do áudio (`drivers::audio_bench`) em uma tarefa no boot.
+pub const AUDIO_BENCHMARK_AT_BOOT: bool = false;
+/// Duração do benchmark, em períodos (500 x 10 ms = 5 s).
+pub const AUDIO_BENCHMARK_PERIODS: u64 = 500;
+/// Frequência do tom do benchmark.
+pub const AUDIO_BENCHMARK_TONE_HZ: u32 = 440;
+
 // ------------------------------------------------------------------------
 // --- ⌨️ Configuração de I/O de Dispositivos Legados ---
 // ------------------------------------------------------------------------
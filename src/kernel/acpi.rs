@@ -0,0 +1,161 @@
+// src/kernel/acpi.rs
+
+//! Leitura das Tabelas ACPI (somente leitura).
+//!
+//! A RSDP vem da tag do Multiboot2; dela saem a XSDT (ACPI 2.0+, ponteiros de
+//! 64 bits) ou a RSDT (ACPI 1.0, ponteiros de 32 bits), que listam as demais
+//! tabelas. O LightOS usa:
+//! * MCFG: janelas ECAM do espaço de configuração PCIe (`drivers::pci`).
+//!
+//! As tabelas ficam em RAM (ACPI Reclaimable/NVS) e são lidas pelo mapeamento
+//! linear da memória física em `KERNEL_HH_BASE`.
+
+use alloc::vec::Vec;
+use core::ptr;
+use spin::Once;
+
+use crate::multiboot2::BootInfo;
+use crate::RustKernelConfig::arch_hal::KERNEL_HH_BASE;
+
+const RSDP_SIGNATURE: &[u8] = b"RSD PTR ";
+/// Tamanho da RSDP do ACPI 1.0 e da estendida (ACPI 2.0+).
+const RSDP_V1_SIZE: usize = 20;
+const RSDP_V2_SIZE: usize = 36;
+/// Cabeçalho comum das tabelas (signature, length, revision, checksum, OEM...).
+const SDT_HEADER_SIZE: usize = 36;
+
+/// Cabeçalho da MCFG após o SDT (reservado) e tamanho de cada entrada.
+const MCFG_RESERVED: usize = 8;
+const MCFG_ENTRY_SIZE: usize = 16;
+
+/// 🚨 Erros de leitura das tabelas ACPI.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum AcpiError {
+    /// O bootloader não entregou a RSDP.
+    NoRsdp,
+    /// Assinatura ou checksum da RSDP inválidos.
+    InvalidRsdp,
+    /// Tabela com tamanho ou checksum inválidos.
+    InvalidTable,
+}
+
+/// 📚 Tabela raiz (XSDT ou RSDT).
+struct RootTable {
+    phys: u64,
+    /// Tamanho de cada ponteiro: 8 (XSDT) ou 4 (RSDT).
+    entry_size: usize,
+}
+
+static ROOT: Once<RootTable> = Once::new();
+
+/// Soma de todos os bytes: zero numa estrutura íntegra.
+fn checksum_ok(bytes: &[u8]) -> bool {
+    bytes.iter().fold(0u8, |sum, &b| sum.wrapping_add(b)) == 0
+}
+
+/// 📄 Uma tabela (SDT) validada.
+#[derive(Debug, Clone, Copy)]
+pub struct SdtTable {
+    data: &'static [u8],
+}
+
+impl SdtTable {
+    /// 🏭 Valida a tabela no endereço físico `phys`.
+    ///
+    /// # Safety
+    /// `phys` deve apontar para uma tabela ACPI (vinda da RSDT/XSDT).
+    unsafe fn load(phys: u64) -> Result<Self, AcpiError> {
+        let base = (KERNEL_HH_BASE as u64 + phys) as *const u8;
+        let length = ptr::read_unaligned(base.add(4) as *const u32) as usize;
+        if length < SDT_HEADER_SIZE {
+            return Err(AcpiError::InvalidTable);
+        }
+        let data = core::slice::from_raw_parts(base, length);
+        if !checksum_ok(data) {
+            return Err(AcpiError::InvalidTable);
+        }
+        Ok(SdtTable { data })
+    }
+
+    /// Assinatura de 4 caracteres (ex: `b"MCFG"`).
+    pub fn signature(&self) -> &'static [u8] {
+        &self.data[..4]
+    }
+
+    /// Conteúdo após o cabeçalho comum.
+    pub fn body(&self) -> &'static [u8] {
+        &self.data[SDT_HEADER_SIZE..]
+    }
+}
+
+/// ⚙️ Valida a RSDP entregue pelo bootloader e a tabela raiz.
+/// * Chamado do kernel_main depois do Paging (as tabelas são lidas pelo mapeamento linear).
+pub fn init(boot_info: &BootInfo) -> Result<(), AcpiError> {
+    let rsdp = boot_info.acpi_rsdp().ok_or(AcpiError::NoRsdp)?;
+    if rsdp.len() < RSDP_V1_SIZE || &rsdp[..8] != RSDP_SIGNATURE || !checksum_ok(&rsdp[..RSDP_V1_SIZE]) {
+        return Err(AcpiError::InvalidRsdp);
+    }
+    let read_u32 = |offset: usize| u32::from_le_bytes([rsdp[offset], rsdp[offset + 1], rsdp[offset + 2], rsdp[offset + 3]]);
+
+    // Revisão 2+: a XSDT (ponteiros de 64 bits) tem preferência sobre a RSDT.
+    let root = if rsdp[15] >= 2 && rsdp.len() >= RSDP_V2_SIZE && checksum_ok(&rsdp[..RSDP_V2_SIZE]) {
+        RootTable { phys: read_u32(24) as u64 | (read_u32(28) as u64) << 32, entry_size: 8 }
+    } else {
+        RootTable { phys: read_u32(16) as u64, entry_size: 4 }
+    };
+    // # SAFETY: O endereço vem da RSDP validada.
+    unsafe { SdtTable::load(root.phys)? };
+    ROOT.call_once(|| root);
+    Ok(())
+}
+
+/// 🔍 Primeira tabela íntegra com a `signature` dada.
+pub fn find_table(signature: &[u8; 4]) -> Option<SdtTable> {
+    let root = ROOT.get()?;
+    // # SAFETY: A tabela raiz foi validada em `init`.
+    let table = unsafe { SdtTable::load(root.phys) }.ok()?;
+    table
+        .body()
+        .chunks_exact(root.entry_size)
+        .filter_map(|entry| {
+            let mut phys = [0u8; 8];
+            phys[..entry.len()].copy_from_slice(entry);
+            // # SAFETY: Os ponteiros da tabela raiz apontam para tabelas ACPI.
+            unsafe { SdtTable::load(u64::from_le_bytes(phys)) }.ok()
+        })
+        .find(|table| table.signature() == signature)
+}
+
+// ------------------------------------------------------------------------
+// --- MCFG ---
+// ------------------------------------------------------------------------
+
+/// 🧱 Uma janela ECAM: 4 KiB de configuração por função, dos barramentos `start_bus..=end_bus`.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct McfgEntry {
+    /// Endereço físico da configuração do barramento 0 (mesmo se `start_bus > 0`).
+    pub base: u64,
+    pub segment: u16,
+    pub start_bus: u8,
+    pub end_bus: u8,
+}
+
+/// 🗺️ Janelas ECAM da MCFG (vazio sem ACPI ou sem PCIe).
+pub fn mcfg_entries() -> Vec<McfgEntry> {
+    let body = match find_table(b"MCFG") {
+        Some(table) => table.body().get(MCFG_RESERVED..).unwrap_or(&[]),
+        None => return Vec::new(),
+    };
+    body.chunks_exact(MCFG_ENTRY_SIZE)
+        .map(|entry| {
+            let mut base = [0u8; 8];
+            base.copy_from_slice(&entry[..8]);
+            McfgEntry {
+                base: u64::from_le_bytes(base),
+                segment: u16::from_le_bytes([entry[8], entry[9]]),
+                start_bus: entry[10],
+                end_bus: entry[11],
+            }
+        })
+        .collect()
+}
@@ -0,0 +1,571 @@
+// src/kernel/drivers/audio.rs
+
+//! Pipeline de Reprodução de Áudio do LightOS.
+//!
+//! O hardware lê, em laço, um anel de `period_count` períodos contíguos na
+//! memória física (descritos por uma lista de buffers no estilo BDL do HDA) e
+//! interrompe ao fim de cada período. A cada interrupção:
+//! * Top half: reconhece o dispositivo (nenhuma cópia de dados).
+//! * Bottom half (`lightos-irqd`): reabastece os períodos já tocados com a
+//!   mistura dos fluxos abertos (`mixer`); um fluxo sem dados contribui com
+//!   silêncio e conta um underrun.
+//!
+//! `write` escreve no fluxo padrão (no formato do pipeline); `open_stream` abre
+//! fluxos adicionais em qualquer formato/taxa. A latência entre a escrita e o
+//! som é limitada ao tamanho do anel mais o que estiver na fila do fluxo, e
+//! nenhuma chamada de escrita espera pelo hardware.
+
+use alloc::boxed::Box;
+use alloc::vec::Vec;
+use core::cell::UnsafeCell;
+use core::sync::atomic::{AtomicU64, AtomicUsize, Ordering};
+use spin::{Mutex, Once};
+use x86_64::instructions::interrupts;
+use x86_64::PhysAddr;
+
+use super::mixer::{Mixer, StreamHandle};
+use super::pcm_ring::PcmRing;
+use super::sound::SoundError;
+use crate::interrupts::stats::read_tsc;
+use crate::interrupts::threaded::{self, Coalescing, IrqReturn};
+use crate::memory::dma::DmaBuffer;
+
+/// Menor número de períodos no anel (um tocando, um pronto, um sendo reabastecido).
+pub const MIN_PERIODS: usize = 3;
+/// Maior número de períodos (limite das listas BDL).
+pub const MAX_PERIODS: usize = 32;
+/// Tamanho de uma entrada da lista de buffers (endereço, tamanho, flags).
+pub const BDL_ENTRY_SIZE: usize = 16;
+/// Bit "Interrupt On Completion" da entrada BDL.
+const BDL_IOC: u32 = 1;
+
+// ------------------------------------------------------------------------
+// --- Formato e Dispositivo ---
+// ------------------------------------------------------------------------
+
+/// 🎚️ Formato PCM intercalado (little-endian, com sinal).
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct AudioFormat {
+    pub sample_rate: u32,
+    pub channels: u8,
+    pub bits_per_sample: u8,
+}
+
+impl AudioFormat {
+    /// 48 kHz, estéreo, 16 bits: o formato nativo do pipeline.
+    pub const DEFAULT: AudioFormat = AudioFormat { sample_rate: 48_000, channels: 2, bits_per_sample: 16 };
+
+    /// Bytes por quadro (uma amostra de cada canal).
+    pub fn bytes_per_frame(&self) -> usize {
+        self.channels as usize * (self.bits_per_sample as usize / 8)
+    }
+
+    /// Bytes por segundo.
+    pub fn bytes_per_second(&self) -> usize {
+        self.bytes_per_frame() * self.sample_rate as usize
+    }
+
+    /// Bytes de um período de `frames` quadros, arredondado para cima até
+    /// conter quadros inteiros e ser múltiplo de 128 (alinhamento da BDL).
+    pub fn period_bytes(&self, frames: usize) -> usize {
+        let frame = self.bytes_per_frame().max(1);
+        let (mut a, mut b) = (frame, 128);
+        while b != 0 {
+            let r = a % b;
+            a = b;
+            b = r;
+        }
+        let step = frame / a * 128;
+        (frames * frame + step - 1) / step * step
+    }
+}
+
+/// 🔊 O que o pipeline precisa de um dispositivo de som com DMA em anel.
+pub trait SoundDevice: Send {
+    /// Escolhe o formato suportado mais próximo de `wanted` e o configura.
+    fn negotiate(&mut self, wanted: AudioFormat) -> Result<AudioFormat, SoundError>;
+    /// Programa o DMA para tocar `ring` em laço e inicia a reprodução.
+    fn start(&mut self, ring: &PeriodRing) -> Result<(), SoundError>;
+    /// Para a reprodução.
+    fn stop(&mut self);
+    /// Reconhece a interrupção. Retorna `true` se ela veio deste dispositivo.
+    fn ack_interrupt(&mut self) -> bool;
+    /// Posição do DMA no anel, em bytes.
+    fn position(&self) -> usize;
+}
+
+// ------------------------------------------------------------------------
+// --- Anel de Períodos (DMA) ---
+// ------------------------------------------------------------------------
+
+/// 💿 Períodos fisicamente contíguos + a lista de buffers que os descreve.
+pub struct PeriodRing {
+    buffer: DmaBuffer,
+    bdl: DmaBuffer,
+    period_bytes: usize,
+    period_count: usize,
+    /// Próximo período a reabastecer (o mais antigo já tocado).
+    next_fill: usize,
+}
+
+impl PeriodRing {
+    /// 🏭 Aloca `period_count` períodos de `period_bytes` bytes, zerados (silêncio).
+    pub fn new(period_bytes: usize, period_count: usize) -> Result<Self, SoundError> {
+        if period_bytes == 0 || period_bytes % 128 != 0 || !(MIN_PERIODS..=MAX_PERIODS).contains(&period_count) {
+            return Err(SoundError::InvalidBuffer);
+        }
+        let buffer = DmaBuffer::new(period_bytes * period_count).map_err(|_| SoundError::OutOfMemory)?;
+        let bdl = DmaBuffer::new(period_count * BDL_ENTRY_SIZE).map_err(|_| SoundError::OutOfMemory)?;
+
+        // Uma entrada por período, todas com interrupção ao completar.
+        for i in 0..period_count {
+            let phys = buffer.phys_addr().as_u64() + (i * period_bytes) as u64;
+            // # SAFETY: A entrada `i` está dentro da lista recém-alocada.
+            unsafe {
+                let entry = bdl.as_mut_ptr().add(i * BDL_ENTRY_SIZE);
+                core::ptr::write_unaligned(entry as *mut u64, phys);
+                core::ptr::write_unaligned(entry.add(8) as *mut u32, period_bytes as u32);
+                core::ptr::write_unaligned(entry.add(12) as *mut u32, BDL_IOC);
+            }
+        }
+        Ok(PeriodRing { buffer, bdl, period_bytes, period_count, next_fill: 0 })
+    }
+
+    pub fn period_bytes(&self) -> usize {
+        self.period_bytes
+    }
+
+    pub fn period_count(&self) -> usize {
+        self.period_count
+    }
+
+    /// Tamanho total do anel em bytes.
+    pub fn total_bytes(&self) -> usize {
+        self.period_bytes * self.period_count
+    }
+
+    /// Endereço físico do primeiro período.
+    pub fn buffer_addr(&self) -> PhysAddr {
+        self.buffer.phys_addr()
+    }
+
+    /// Endereço físico da lista de buffers (`period_count` entradas de 16 bytes).
+    pub fn bdl_addr(&self) -> PhysAddr {
+        self.bdl.phys_addr()
+    }
+
+    /// Bytes do período `index`.
+    pub fn period_mut(&mut self, index: usize) -> &mut [u8] {
+        let start = index * self.period_bytes;
+        &mut self.buffer.as_slice_mut()[start..start + self.period_bytes]
+    }
+}
+
+// ------------------------------------------------------------------------
+// --- Fila de Escrita (SPSC, sem Locks) ---
+// ------------------------------------------------------------------------
+
+/// 📥 Fila de bytes de um produtor (quem chama `write`) e um consumidor (o reabastecimento).
+pub struct ByteQueue {
+    storage: Box<[UnsafeCell<u8>]>,
+    /// Total de bytes escritos (só o produtor altera).
+    head: AtomicUsize,
+    /// Total de bytes lidos (só o consumidor altera).
+    tail: AtomicUsize,
+}
+
+// # SAFETY: Produtor e consumidor só tocam faixas disjuntas do armazenamento,
+// delimitadas por `head`/`tail` com ordem Acquire/Release.
+unsafe impl Sync for ByteQueue {}
+
+impl ByteQueue {
+    /// 🏭 Cria uma fila com capacidade `capacity` (arredondada para potência de 2).
+    pub fn new(capacity: usize) -> Self {
+        let capacity = capacity.next_power_of_two();
+        let storage = (0..capacity).map(|_| UnsafeCell::new(0)).collect::<Vec<_>>().into_boxed_slice();
+        ByteQueue { storage, head: AtomicUsize::new(0), tail: AtomicUsize::new(0) }
+    }
+
+    pub fn capacity(&self) -> usize {
+        self.storage.len()
+    }
+
+    /// Bytes aguardando consumo.
+    pub fn len(&self) -> usize {
+        self.head.load(Ordering::Acquire).wrapping_sub(self.tail.load(Ordering::Acquire))
+    }
+
+    fn slot(&self, position: usize) -> *mut u8 {
+        self.storage[position & (self.storage.len() - 1)].get()
+    }
+
+    /// ➕ Copia o quanto couber de `data`. Retorna os bytes aceitos.
+    pub fn push(&self, data: &[u8]) -> usize {
+        let head = self.head.load(Ordering::Relaxed);
+        let tail = self.tail.load(Ordering::Acquire);
+        let count = data.len().min(self.capacity() - head.wrapping_sub(tail));
+        for (i, &byte) in data[..count].iter().enumerate() {
+            // # SAFETY: A faixa [head, head + count) é livre (ainda não publicada).
+            unsafe { *self.slot(head.wrapping_add(i)) = byte };
+        }
+        self.head.store(head.wrapping_add(count), Ordering::Release);
+        count
+    }
+
+    /// ➖ Move até `dst.len()` bytes para `dst`. Retorna os bytes lidos.
+    pub fn pop_into(&self, dst: &mut [u8]) -> usize {
+        let tail = self.tail.load(Ordering::Relaxed);
+        let head = self.head.load(Ordering::Acquire);
+        let count = dst.len().min(head.wrapping_sub(tail));
+        for (i, byte) in dst[..count].iter_mut().enumerate() {
+            // # SAFETY: A faixa [tail, tail + count) foi publicada pelo produtor.
+            *byte = unsafe { *self.slot(tail.wrapping_add(i)) };
+        }
+        self.tail.store(tail.wrapping_add(count), Ordering::Release);
+        count
+    }
+}
+
+// ------------------------------------------------------------------------
+// --- Estatísticas ---
+// ------------------------------------------------------------------------
+
+/// 📊 Contadores do pipeline.
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct AudioStats {
+    /// Períodos reabastecidos desde o início.
+    pub periods: u64,
+    /// Períodos que não puderam ser preenchidos por inteiro com dados do produtor.
+    pub underruns: u64,
+    /// Bytes de áudio (não silêncio) entregues ao DMA.
+    pub bytes_played: u64,
+    /// Bytes recusados por `write` com a fila cheia.
+    pub bytes_dropped: u64,
+}
+
+#[derive(Default)]
+struct AtomicStats {
+    periods: AtomicU64,
+    underruns: AtomicU64,
+    bytes_played: AtomicU64,
+    bytes_dropped: AtomicU64,
+    /// TSC do último top half que reconheceu o dispositivo.
+    last_irq_tsc: AtomicU64,
+    /// Intervalo entre interrupções consecutivas (regularidade do DMA).
+    irq_interval: CycleStats,
+    /// Do top half ao início do reabastecimento (agendamento do bottom half).
+    refill_delay: CycleStats,
+    /// Duração do reabastecimento (mixagem incluída).
+    refill_cost: CycleStats,
+}
+
+/// ⏱️ Mínimo/média/máximo de uma duração, em ciclos de TSC.
+struct CycleStats {
+    samples: AtomicU64,
+    total: AtomicU64,
+    min: AtomicU64,
+    max: AtomicU64,
+}
+
+impl Default for CycleStats {
+    fn default() -> Self {
+        CycleStats { samples: AtomicU64::new(0), total: AtomicU64::new(0), min: AtomicU64::new(u64::MAX), max: AtomicU64::new(0) }
+    }
+}
+
+impl CycleStats {
+    fn record(&self, cycles: u64) {
+        self.samples.fetch_add(1, Ordering::Relaxed);
+        self.total.fetch_add(cycles, Ordering::Relaxed);
+        self.min.fetch_min(cycles, Ordering::Relaxed);
+        self.max.fetch_max(cycles, Ordering::Relaxed);
+    }
+
+    fn reset(&self) {
+        self.samples.store(0, Ordering::Relaxed);
+        self.total.store(0, Ordering::Relaxed);
+        self.min.store(u64::MAX, Ordering::Relaxed);
+        self.max.store(0, Ordering::Relaxed);
+    }
+
+    fn summary(&self) -> CycleSummary {
+        let samples = self.samples.load(Ordering::Relaxed);
+        CycleSummary {
+            samples,
+            min: if samples == 0 { 0 } else { self.min.load(Ordering::Relaxed) },
+            avg: self.total.load(Ordering::Relaxed).checked_div(samples).unwrap_or(0),
+            max: self.max.load(Ordering::Relaxed),
+            total: self.total.load(Ordering::Relaxed),
+        }
+    }
+}
+
+/// 📋 Resumo de uma medida de tempo (ciclos de TSC).
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+#[repr(C)]
+pub struct CycleSummary {
+    pub samples: u64,
+    pub min: u64,
+    pub avg: u64,
+    pub max: u64,
+    pub total: u64,
+}
+
+/// 📡 Estado instantâneo do pipeline (ABI da syscall `AudioTelemetry`).
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+#[repr(C)]
+pub struct AudioTelemetry {
+    pub sample_rate: u32,
+    pub channels: u32,
+    pub bits_per_sample: u32,
+    pub period_bytes: u32,
+    pub period_count: u32,
+    /// Fluxos abertos no mixer.
+    pub streams: u32,
+    /// Posição do DMA no anel, em bytes.
+    pub dma_position: u64,
+    /// Bytes já mixados à frente do DMA (o que toca antes de qualquer dado novo).
+    pub ring_fill_bytes: u64,
+    /// Bytes aguardando o mixer, somando todos os fluxos (no formato de cada um).
+    pub queued_bytes: u64,
+    /// Latência estimada de `write` até o som, em µs: anel à frente do DMA mais a
+    /// maior fila entre os fluxos abertos (padrão e anéis).
+    pub latency_us: u64,
+    pub periods: u64,
+    /// Underruns (xruns de reprodução).
+    pub underruns: u64,
+    pub bytes_played: u64,
+    pub bytes_dropped: u64,
+    pub irq_interval: CycleSummary,
+    pub refill_delay: CycleSummary,
+    pub refill_cost: CycleSummary,
+}
+
+// ------------------------------------------------------------------------
+// --- Pipeline Global ---
+// ------------------------------------------------------------------------
+
+/// 🎛️ Dispositivo + anel + fila de um fluxo de reprodução.
+struct AudioPipeline {
+    /// Travado também pelo top half: só trave com interrupções desabilitadas.
+    device: Mutex<Box<dyn SoundDevice>>,
+    ring: Mutex<PeriodRing>,
+    mixer: Mixer,
+    /// Fluxo de `write`, no formato do pipeline. A fila do fluxo tem um único
+    /// produtor: o lock serializa os chamadores de `write`.
+    default_stream: Mutex<StreamHandle>,
+    format: AudioFormat,
+    /// Quadros (na taxa do pipeline) que cabem na fila de cada fluxo.
+    queue_frames: usize,
+    stats: AtomicStats,
+}
+
+static PIPELINE: Once<AudioPipeline> = Once::new();
+
+impl AudioPipeline {
+    /// Reabastece o período `index` com a mistura dos fluxos.
+    fn fill_period(&self, ring: &mut PeriodRing, index: usize) {
+        let report = self.mixer.mix(ring.period_mut(index));
+        self.stats.periods.fetch_add(1, Ordering::Relaxed);
+        self.stats.bytes_played.fetch_add((report.frames * self.format.bytes_per_frame()) as u64, Ordering::Relaxed);
+        if report.underrun {
+            self.stats.underruns.fetch_add(1, Ordering::Relaxed);
+        }
+    }
+
+    /// Bytes mixados à frente do DMA em `position`.
+    fn ring_fill(ring: &PeriodRing, position: usize) -> usize {
+        let total = ring.total_bytes();
+        match (ring.next_fill * ring.period_bytes() + total - position % total) % total {
+            // `next_fill` alcançou o período em reprodução: o anel inteiro está à frente.
+            0 => total,
+            fill => fill,
+        }
+    }
+
+    /// Reabastece todos os períodos que o DMA já deixou para trás.
+    fn refill(&self) {
+        let position = interrupts::without_interrupts(|| self.device.lock().position());
+        let mut ring = self.ring.lock();
+        let playing = (position / ring.period_bytes()) % ring.period_count();
+        while ring.next_fill != playing {
+            let index = ring.next_fill;
+            self.fill_period(&mut ring, index);
+            ring.next_fill = (index + 1) % ring.period_count();
+        }
+    }
+}
+
+/// ⚡ Top half: só reconhece o dispositivo.
+fn audio_top_half(_vector: u8) -> IrqReturn {
+    let pipeline = match PIPELINE.get() {
+        Some(pipeline) => pipeline,
+        None => return IrqReturn::None,
+    };
+    // Interrupções já estão desabilitadas aqui; `try_lock` evita esperar por uma
+    // CPU que esteja no meio de `position`.
+    match pipeline.device.try_lock() {
+        Some(mut device) if device.ack_interrupt() => {
+            let now = read_tsc();
+            let previous = pipeline.stats.last_irq_tsc.swap(now, Ordering::Relaxed);
+            if previous != 0 {
+                pipeline.stats.irq_interval.record(now.wrapping_sub(previous));
+            }
+            IrqReturn::WakeThread
+        }
+        Some(_) => IrqReturn::None,
+        None => IrqReturn::WakeThread,
+    }
+}
+
+/// 🧵 Bottom half: reabastece os períodos tocados (coalescidos ou não).
+fn audio_bottom_half(_vector: u8, _coalesced: u32) {
+    if let Some(pipeline) = PIPELINE.get() {
+        let start = read_tsc();
+        let irq = pipeline.stats.last_irq_tsc.load(Ordering::Relaxed);
+        if irq != 0 {
+            pipeline.stats.refill_delay.record(start.wrapping_sub(irq));
+        }
+        pipeline.refill();
+        pipeline.stats.refill_cost.record(read_tsc().wrapping_sub(start));
+    }
+}
+
+/// 🚀 Inicia a reprodução contínua em `device`, interrompendo em `vector`.
+/// * O formato é negociado com o dispositivo a partir de `wanted`.
+/// * `period_frames * period_count` quadros definem a latência máxima do anel.
+/// * A fila de cada fluxo comporta `queue_periods` períodos adicionais.
+pub fn start(
+    mut device: Box<dyn SoundDevice>,
+    wanted: AudioFormat,
+    vector: u8,
+    period_frames: usize,
+    period_count: usize,
+    queue_periods: usize,
+) -> Result<(), SoundError> {
+    if PIPELINE.get().is_some() {
+        return Err(SoundError::Busy);
+    }
+    let format = device.negotiate(wanted)?;
+    let period_bytes = format.period_bytes(period_frames);
+    let ring = PeriodRing::new(period_bytes, period_count)?;
+    let queue_frames = period_frames * queue_periods.max(1);
+    let mixer = Mixer::new(format);
+    let default_stream = mixer.open_stream(format, queue_frames * format.bytes_per_frame())?;
+
+    // A IRQ e o dispositivo vêm antes do `PIPELINE`: se qualquer um falhar, a IRQ
+    // é liberada, nada foi publicado e `start` pode ser tentado de novo. Até lá o
+    // top half não acha o pipeline (e a INTx segue mascarada).
+    threaded::request_threaded_irq(vector, audio_top_half, audio_bottom_half, Coalescing::NONE, false)
+        .map_err(|_| SoundError::InitializationFailed)?;
+    if let Err(e) = interrupts::without_interrupts(|| device.start(&ring)) {
+        let _ = threaded::free_threaded_irq(vector);
+        return Err(e);
+    }
+    PIPELINE.call_once(|| AudioPipeline {
+        device: Mutex::new(device),
+        ring: Mutex::new(ring),
+        mixer,
+        default_stream: Mutex::new(default_stream),
+        format,
+        queue_frames,
+        stats: AtomicStats::default(),
+    });
+
+    // Uma INTx roteada pelo IO-APIC chega mascarada (`route_pci_intx`).
+    crate::interrupts::unmask_vector(vector);
+    crate::println!(
+        "INFO: Áudio: {} Hz, {} canais, {} períodos de {} bytes.",
+        format.sample_rate, format.channels, period_count, period_bytes
+    );
+    Ok(())
+}
+
+/// 🎵 Enfileira PCM no formato do pipeline (fluxo padrão). Não espera o
+/// hardware, só outros chamadores de `write`: retorna quantos bytes couberam
+/// (o restante deve ser reenviado).
+pub fn write(data: &[u8]) -> Result<usize, SoundError> {
+    let pipeline = PIPELINE.get().ok_or(SoundError::DeviceNotFound)?;
+    let accepted = pipeline.default_stream.lock().write(data);
+    pipeline.stats.bytes_dropped.fetch_add((data.len() - accepted) as u64, Ordering::Relaxed);
+    Ok(accepted)
+}
+
+/// ➕ Abre um fluxo em `format` (convertido e reamostrado pelo mixer). A fila
+/// cobre o mesmo tempo que a do fluxo padrão.
+pub fn open_stream(format: AudioFormat) -> Result<StreamHandle, SoundError> {
+    let pipeline = PIPELINE.get().ok_or(SoundError::DeviceNotFound)?;
+    let frames = (pipeline.queue_frames as u64 * format.sample_rate as u64 / pipeline.format.sample_rate as u64) as usize;
+    pipeline.mixer.open_stream(format, frames * format.bytes_per_frame())
+}
+
+/// ➕ Conecta um anel compartilhado (`pcm_ring`) ao mixer como um fluxo.
+pub fn open_ring(ring: PcmRing) -> Result<StreamHandle, SoundError> {
+    let pipeline = PIPELINE.get().ok_or(SoundError::DeviceNotFound)?;
+    pipeline.mixer.open_ring(ring)
+}
+
+/// ⏹️ Para a reprodução (o anel e a fila são mantidos).
+pub fn stop() {
+    if let Some(pipeline) = PIPELINE.get() {
+        interrupts::without_interrupts(|| pipeline.device.lock().stop());
+    }
+}
+
+/// Formato do pipeline em execução.
+pub fn format() -> Option<AudioFormat> {
+    PIPELINE.get().map(|p| p.format)
+}
+
+/// 📊 Contadores atuais.
+pub fn stats() -> AudioStats {
+    PIPELINE.get().map_or(AudioStats::default(), |p| AudioStats {
+        periods: p.stats.periods.load(Ordering::Relaxed),
+        underruns: p.stats.underruns.load(Ordering::Relaxed),
+        bytes_played: p.stats.bytes_played.load(Ordering::Relaxed),
+        bytes_dropped: p.stats.bytes_dropped.load(Ordering::Relaxed),
+    })
+}
+
+/// 📡 Nível do anel, posição do DMA, latência estimada, xruns e tempos do
+/// caminho de reabastecimento.
+pub fn telemetry() -> Option<AudioTelemetry> {
+    let pipeline = PIPELINE.get()?;
+    let position = interrupts::without_interrupts(|| pipeline.device.lock().position());
+    let (period_bytes, period_count, ring_fill) = {
+        let ring = pipeline.ring.lock();
+        (ring.period_bytes(), ring.period_count(), AudioPipeline::ring_fill(&ring, position))
+    };
+    let format = pipeline.format;
+    let ring_us = ring_fill as u64 * 1_000_000 / format.bytes_per_second().max(1) as u64;
+    let stats = &pipeline.stats;
+    Some(AudioTelemetry {
+        sample_rate: format.sample_rate,
+        channels: format.channels as u32,
+        bits_per_sample: format.bits_per_sample as u32,
+        period_bytes: period_bytes as u32,
+        period_count: period_count as u32,
+        streams: pipeline.mixer.stream_count() as u32,
+        dma_position: position as u64,
+        ring_fill_bytes: ring_fill as u64,
+        queued_bytes: pipeline.mixer.queued_bytes() as u64,
+        latency_us: ring_us + pipeline.mixer.max_queued_us(),
+        periods: stats.periods.load(Ordering::Relaxed),
+        underruns: stats.underruns.load(Ordering::Relaxed),
+        bytes_played: stats.bytes_played.load(Ordering::Relaxed),
+        bytes_dropped: stats.bytes_dropped.load(Ordering::Relaxed),
+        irq_interval: stats.irq_interval.summary(),
+        refill_delay: stats.refill_delay.summary(),
+        refill_cost: stats.refill_cost.summary(),
+    })
+}
+
+/// 🔄 Zera as medidas de tempo (início de uma medição).
+pub fn reset_timing() {
+    if let Some(pipeline) = PIPELINE.get() {
+        pipeline.stats.last_irq_tsc.store(0, Ordering::Relaxed);
+        pipeline.stats.irq_interval.reset();
+        pipeline.stats.refill_delay.reset();
+        pipeline.stats.refill_cost.reset();
+    }
+}
@@ -0,0 +1,181 @@
+// src/kernel/drivers/audio_bench.rs
+
+//! Benchmark de Tom do Pipeline de Áudio.
+//!
+//! Toca uma senoide por um número fixo de períodos através de um fluxo do
+//! mixer e mede, com a telemetria de `audio`:
+//! * A regularidade das interrupções de período (intervalo mínimo/médio/máximo).
+//! * O jitter de agendamento do reabastecimento (top half → bottom half).
+//! * O custo de CPU do reabastecimento (mixagem incluída).
+//! * A latência estimada de escrita → som e os underruns.
+//!
+//! No QEMU, o tom pode ser gravado com `-audiodev wav,id=snd0,path=tone.wav` e
+//! conferido fora da VM (o "loopback"): frequência constante e sem cliques
+//! confirmam a ausência de underruns que a telemetria não veja.
+
+use alloc::vec::Vec;
+
+use super::audio::{self, AudioFormat, AudioTelemetry, CycleSummary};
+use super::sound::SoundError;
+use crate::interrupts::{self, stats::read_tsc};
+use crate::RustKernelConfig::TIMER_FREQUENCY_HZ;
+
+/// Quadros escritos por vez.
+const BLOCK_FRAMES: usize = 256;
+/// Tiques do temporizador usados na calibração do TSC.
+const CALIBRATION_TICKS: u64 = 10;
+/// Amplitude do tom (-6 dBFS).
+const TONE_AMPLITUDE: i64 = i16::MAX as i64 / 2;
+/// Meia volta da fase do oscilador (π).
+const HALF_TURN: u32 = 1 << 15;
+
+/// 📋 Resultado de uma execução.
+#[derive(Debug, Clone, Copy, Default)]
+pub struct ToneBenchReport {
+    pub periods: u64,
+    pub underruns: u64,
+    /// Frequência estimada do TSC.
+    pub tsc_hz: u64,
+    pub irq_interval: CycleSummary,
+    pub refill_delay: CycleSummary,
+    pub refill_cost: CycleSummary,
+    /// Fração de uma CPU gasta reabastecendo, em milésimos.
+    pub cpu_permille: u64,
+    pub min_latency_us: u64,
+    pub max_latency_us: u64,
+}
+
+/// 🎵 Oscilador senoidal inteiro (aproximação de Bhaskara I, erro < 0,2%).
+struct ToneGenerator {
+    /// Fase em [0, 2·HALF_TURN).
+    phase: u32,
+    /// Incremento de fase por quadro, em 1/2^16 de unidade de fase.
+    step_fixed: u64,
+    accumulator: u64,
+}
+
+impl ToneGenerator {
+    fn new(frequency_hz: u32, sample_rate: u32) -> Self {
+        let step_fixed = ((2 * HALF_TURN) as u64 * frequency_hz as u64) << 16;
+        ToneGenerator { phase: 0, step_fixed: step_fixed / sample_rate.max(1) as u64, accumulator: 0 }
+    }
+
+    /// sin(π·p/HALF_TURN) ≈ 16·p·(H−p) / (5·H² − 4·p·(H−p)), espelhada na segunda meia volta.
+    fn sample(&self) -> i16 {
+        let (p, sign) = if self.phase < HALF_TURN { (self.phase as i64, 1) } else { ((self.phase - HALF_TURN) as i64, -1) };
+        let h = HALF_TURN as i64;
+        let product = p * (h - p);
+        (sign * TONE_AMPLITUDE * 16 * product / (5 * h * h - 4 * product)) as i16
+    }
+
+    /// Preenche `block` com quadros estéreo de 16 bits.
+    fn fill(&mut self, block: &mut [u8]) {
+        for frame in block.chunks_exact_mut(4) {
+            let value = self.sample().to_le_bytes();
+            frame[..2].copy_from_slice(&value);
+            frame[2..].copy_from_slice(&value);
+            self.accumulator += self.step_fixed;
+            self.phase = ((self.phase as u64 + (self.accumulator >> 16)) % (2 * HALF_TURN) as u64) as u32;
+            self.accumulator &= 0xFFFF;
+        }
+    }
+}
+
+/// ⏱️ Ciclos de TSC por segundo, medidos contra o temporizador.
+fn calibrate_tsc() -> u64 {
+    let wait_tick_change = || {
+        let tick = interrupts::current_tick();
+        while interrupts::current_tick() == tick {
+            crate::task::yield_now();
+        }
+    };
+    wait_tick_change();
+    let (tick0, tsc0) = (interrupts::current_tick(), read_tsc());
+    while interrupts::current_tick() - tick0 < CALIBRATION_TICKS {
+        crate::task::yield_now();
+    }
+    wait_tick_change();
+    let (tick1, tsc1) = (interrupts::current_tick(), read_tsc());
+    (tsc1 - tsc0) * TIMER_FREQUENCY_HZ as u64 / (tick1 - tick0).max(1)
+}
+
+fn to_us(cycles: u64, tsc_hz: u64) -> u64 {
+    cycles * 1_000_000 / tsc_hz.max(1)
+}
+
+/// 🚀 Toca `frequency_hz` por `periods` períodos e mede o caminho de reabastecimento.
+/// * Deve rodar em uma tarefa (cede a CPU enquanto a fila está cheia).
+pub fn run_tone_benchmark(periods: u64, frequency_hz: u32) -> Result<ToneBenchReport, SoundError> {
+    let output = audio::format().ok_or(SoundError::DeviceNotFound)?;
+    let format = AudioFormat { sample_rate: output.sample_rate, channels: 2, bits_per_sample: 16 };
+    let mut stream = audio::open_stream(format)?;
+    let tsc_hz = calibrate_tsc();
+
+    let mut block = Vec::new();
+    block.try_reserve_exact(BLOCK_FRAMES * format.bytes_per_frame()).map_err(|_| SoundError::OutOfMemory)?;
+    block.resize(BLOCK_FRAMES * format.bytes_per_frame(), 0);
+    let mut tone = ToneGenerator::new(frequency_hz, format.sample_rate);
+
+    audio::reset_timing();
+    let before = audio::telemetry().ok_or(SoundError::DeviceNotFound)?;
+    let start = read_tsc();
+    let (mut min_latency, mut max_latency) = (u64::MAX, 0);
+    let mut pending = 0..0;
+    let mut now: AudioTelemetry = before;
+
+    while now.periods - before.periods < periods {
+        if pending.is_empty() {
+            tone.fill(&mut block);
+            pending = 0..block.len();
+        }
+        pending.start += stream.write(&block[pending.clone()]);
+        if !pending.is_empty() {
+            // Fila cheia: amostra a latência e espera o mixer consumir.
+            now = audio::telemetry().ok_or(SoundError::DeviceNotFound)?;
+            min_latency = min_latency.min(now.latency_us);
+            max_latency = max_latency.max(now.latency_us);
+            crate::task::yield_now();
+        }
+    }
+    let elapsed = read_tsc() - start;
+    drop(stream);
+
+    let report = ToneBenchReport {
+        periods: now.periods - before.periods,
+        underruns: now.underruns - before.underruns,
+        tsc_hz,
+        irq_interval: now.irq_interval,
+        refill_delay: now.refill_delay,
+        refill_cost: now.refill_cost,
+        cpu_permille: now.refill_cost.total * 1000 / elapsed.max(1),
+        min_latency_us: if min_latency == u64::MAX { 0 } else { min_latency },
+        max_latency_us: max_latency,
+    };
+    print_report(&report, frequency_hz);
+    Ok(report)
+}
+
+fn print_report(r: &ToneBenchReport, frequency_hz: u32) {
+    let us = |c| to_us(c, r.tsc_hz);
+    crate::println!("--- Áudio: Benchmark de Tom ({} Hz, {} períodos) ---", frequency_hz, r.periods);
+    crate::println!("Underruns: {}   TSC: {} MHz", r.underruns, r.tsc_hz / 1_000_000);
+    crate::println!("Intervalo entre IRQs (us): min={} avg={} max={}",
+        us(r.irq_interval.min), us(r.irq_interval.avg), us(r.irq_interval.max));
+    crate::println!("IRQ -> reabastecimento (us): min={} avg={} max={}",
+        us(r.refill_delay.min), us(r.refill_delay.avg), us(r.refill_delay.max));
+    crate::println!("Custo do reabastecimento (us): avg={} max={}  CPU: {}.{}%",
+        us(r.refill_cost.avg), us(r.refill_cost.max), r.cpu_permille / 10, r.cpu_permille % 10);
+    crate::println!("Latência escrita -> som (us): min={} max={}", r.min_latency_us, r.max_latency_us);
+    crate::println!("------------------------------------------------------");
+}
+
+/// 🧵 Tarefa de kernel que roda o benchmark uma vez (habilitada por
+/// `AUDIO_BENCHMARK_AT_BOOT`) e depois termina.
+pub extern "C" fn benchmark_task() {
+    use crate::RustKernelConfig::{AUDIO_BENCHMARK_PERIODS, AUDIO_BENCHMARK_TONE_HZ};
+
+    if let Err(e) = run_tone_benchmark(AUDIO_BENCHMARK_PERIODS, AUDIO_BENCHMARK_TONE_HZ) {
+        crate::println!("WARN: Benchmark de áudio falhou: {:?}", e);
+    }
+    crate::task::exit_current()
+}
@@ -0,0 +1,650 @@
+// src/kernel/drivers/blit.rs
+
+//! Motor 2D do LightOS: preenchimento, cópia e blit de retângulos.
+//!
+//! Cada operação é decomposta em linhas, e cada linha é escrita com o maior
+//! store disponível:
+//! * `Scalar`: stores de 32/64 bits.
+//! * `Sse2`: stores de 128 bits (`movdqa`/`movntdq`).
+//! * `Avx2`: stores de 256 bits (`vmovdqa`/`vmovntdq`).
+//!
+//! O caminho é escolhido em tempo de execução (`crate::simd::features`). Em
+//! superfícies `StoreHint::Streaming` (o framebuffer) e em operações grandes,
+//! os stores são não-temporais: não poluem a cache e combinam linhas inteiras
+//! no write-combining buffer.
+
+use core::arch::x86_64::*;
+use core::ptr;
+
+use super::pixel::{with_pixel_kernel, PixelFormat, PixelKernel};
+use crate::simd;
+
+/// Operações acima deste tamanho usam stores não-temporais mesmo em RAM com cache.
+const NON_TEMPORAL_THRESHOLD_BYTES: usize = 256 * 1024;
+
+// ------------------------------------------------------------------------
+// --- Retângulos e Superfícies ---
+// ------------------------------------------------------------------------
+
+/// 📐 Retângulo em pixels (`x`/`y` inclusivos, `width`/`height` em pixels).
+#[derive(Debug, Default, Clone, Copy, PartialEq, Eq)]
+pub struct Rect {
+    pub x: u32,
+    pub y: u32,
+    pub width: u32,
+    pub height: u32,
+}
+
+impl Rect {
+    /// 🏭 Cria um retângulo.
+    pub const fn new(x: u32, y: u32, width: u32, height: u32) -> Self {
+        Rect { x, y, width, height }
+    }
+
+    /// `true` se o retângulo não cobre nenhum pixel.
+    pub fn is_empty(&self) -> bool {
+        self.width == 0 || self.height == 0
+    }
+
+    /// Coordenada X logo após a borda direita (exclusiva).
+    pub fn right(&self) -> u32 {
+        self.x.saturating_add(self.width)
+    }
+
+    /// Coordenada Y logo após a borda inferior (exclusiva).
+    pub fn bottom(&self) -> u32 {
+        self.y.saturating_add(self.height)
+    }
+
+    /// Número de pixels cobertos.
+    pub fn area(&self) -> u64 {
+        self.width as u64 * self.height as u64
+    }
+
+    /// ✂️ Interseção com `other` (`None` se for vazia).
+    pub fn intersect(&self, other: &Rect) -> Option<Rect> {
+        let x = self.x.max(other.x);
+        let y = self.y.max(other.y);
+        let right = self.right().min(other.right());
+        let bottom = self.bottom().min(other.bottom());
+        if right <= x || bottom <= y {
+            return None;
+        }
+        Some(Rect::new(x, y, right - x, bottom - y))
+    }
+
+    /// ➕ Menor retângulo que contém `self` e `other`.
+    pub fn union(&self, other: &Rect) -> Rect {
+        if self.is_empty() {
+            return *other;
+        }
+        if other.is_empty() {
+            return *self;
+        }
+        let x = self.x.min(other.x);
+        let y = self.y.min(other.y);
+        Rect::new(x, y, self.right().max(other.right()) - x, self.bottom().max(other.bottom()) - y)
+    }
+}
+
+/// 🧭 Como os stores em uma superfície devem tratar a cache.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum StoreHint {
+    /// RAM comum, relida em breve (ex: back buffer): stores normais.
+    Cached,
+    /// Memória de vídeo (UC/WC) ou nunca relida pela CPU: stores não-temporais.
+    Streaming,
+}
+
+/// 🖼️ Descreve um bloco de pixels na memória (framebuffer ou buffer em RAM).
+#[derive(Debug, Clone, Copy)]
+pub struct Surface {
+    ptr: *mut u8,
+    /// Largura em pixels.
+    pub width: u32,
+    /// Altura em pixels.
+    pub height: u32,
+    /// Bytes por linha (pode ser maior que `width * bytes_per_pixel`).
+    pub pitch: usize,
+    /// Formato dos pixels.
+    pub format: PixelFormat,
+    /// Bytes por pixel (derivado de `format`).
+    pub bytes_per_pixel: usize,
+    /// Política de cache dos stores nesta superfície.
+    pub store_hint: StoreHint,
+}
+
+impl Surface {
+    /// 🏭 Descreve uma superfície.
+    ///
+    /// # Safety
+    /// `ptr` deve apontar para `pitch * height` bytes graváveis, válidos enquanto a
+    /// superfície (e suas cópias) for usada. Para 16 e 32 bpp, `ptr` e `pitch`
+    /// devem ser alinhados ao pixel (os kernels usam loads/stores tipados).
+    pub unsafe fn new(
+        ptr: *mut u8,
+        width: u32,
+        height: u32,
+        pitch: usize,
+        format: PixelFormat,
+        store_hint: StoreHint,
+    ) -> Self {
+        Surface { ptr, width, height, pitch, format, bytes_per_pixel: format.bytes_per_pixel(), store_hint }
+    }
+
+    /// Retângulo que cobre a superfície inteira.
+    pub fn bounds(&self) -> Rect {
+        Rect::new(0, 0, self.width, self.height)
+    }
+
+    /// Ponteiro para o primeiro byte da superfície.
+    pub fn as_ptr(&self) -> *mut u8 {
+        self.ptr
+    }
+
+    /// Ponteiro para o pixel (x, y). Não verifica limites.
+    #[inline]
+    unsafe fn pixel_ptr(&self, x: u32, y: u32) -> *mut u8 {
+        self.ptr.add(y as usize * self.pitch + x as usize * self.bytes_per_pixel)
+    }
+
+    /// 📌 Escreve um único pixel, já no formato da superfície (ignorado fora dos limites).
+    pub fn put_pixel(&self, x: u32, y: u32, pixel: u32) {
+        if x >= self.width || y >= self.height {
+            return;
+        }
+        // # SAFETY: (x, y) está dentro dos limites da superfície.
+        unsafe {
+            let p = self.pixel_ptr(x, y);
+            with_pixel_kernel!(self.format, F => F::write(p, pixel), else ())
+        }
+    }
+
+    fn streaming_for(&self, bytes: usize) -> bool {
+        self.store_hint == StoreHint::Streaming || bytes >= NON_TEMPORAL_THRESHOLD_BYTES
+    }
+}
+
+/// 🚨 Erros das operações de blit.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum BlitError {
+    /// Origem e destino têm profundidades de cor diferentes.
+    FormatMismatch,
+    /// Formato de pixel sem kernel especializado (ver `PixelFormat::kind`).
+    UnsupportedFormat,
+}
+
+// ------------------------------------------------------------------------
+// --- Seleção do Caminho (Runtime) ---
+// ------------------------------------------------------------------------
+
+/// 🚀 Largura de store usada pelo motor.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum BlitPath {
+    Scalar,
+    Sse2,
+    Avx2,
+}
+
+/// Caminho mais largo habilitado nesta CPU.
+pub fn active_path() -> BlitPath {
+    let features = simd::features();
+    if features.avx2 {
+        BlitPath::Avx2
+    } else if features.sse2 {
+        BlitPath::Sse2
+    } else {
+        BlitPath::Scalar
+    }
+}
+
+/// Executa o trabalho de uma linha; os caminhos SIMD rodam sem preempção.
+#[inline]
+fn run_row(path: BlitPath, row: impl FnOnce()) {
+    match path {
+        BlitPath::Scalar => row(),
+        _ => simd::with_simd(row),
+    }
+}
+
+/// Ordena os stores não-temporais antes de qualquer leitura/escrita posterior.
+#[inline]
+fn finish(path: BlitPath, streaming: bool) {
+    if streaming && path != BlitPath::Scalar {
+        // # SAFETY: SFENCE existe em toda CPU com SSE.
+        unsafe { _mm_sfence() };
+    }
+}
+
+// ------------------------------------------------------------------------
+// --- API Pública ---
+// ------------------------------------------------------------------------
+
+/// 🎨 Preenche `rect` (recortado aos limites) com `pixel`, já no formato da superfície.
+pub fn fill_rect(dst: &Surface, rect: Rect, pixel: u32) -> Result<(), BlitError> {
+    with_pixel_kernel!(dst.format, F => {
+        fill_rect_as::<F>(dst, rect, pixel);
+        Ok(())
+    }, else Err(BlitError::UnsupportedFormat))
+}
+
+fn fill_rect_as<F: PixelKernel>(dst: &Surface, rect: Rect, pixel: u32) {
+    let rect = match rect.intersect(&dst.bounds()) {
+        Some(rect) => rect,
+        None => return,
+    };
+    let path = active_path();
+    let streaming = dst.streaming_for(rect.area() as usize * F::BYTES);
+
+    for y in rect.y..rect.bottom() {
+        // # SAFETY: `rect` foi recortado aos limites da superfície.
+        let row = unsafe { dst.pixel_ptr(rect.x, y) };
+        let count = rect.width as usize;
+        // `F::BYTES` é constante: o `match` some em cada instanciação.
+        match F::BYTES {
+            4 => run_row(path, || unsafe { fill_row32(path, row, count, pixel, streaming) }),
+            3 => unsafe { fill_row24(row, count, pixel) },
+            _ => run_row(path, || unsafe { fill_row16(path, row, count, pixel, streaming) }),
+        }
+    }
+    finish(path, streaming);
+}
+
+/// 📋 Copia `src` para (`dst_x`, `dst_y`) dentro da mesma superfície.
+/// * Seguro para regiões sobrepostas (rolagem de tela, arrastar janelas).
+pub fn copy_rect(surface: &Surface, src: Rect, dst_x: u32, dst_y: u32) {
+    let bounds = surface.bounds();
+    let src = match src.intersect(&bounds) {
+        Some(src) => src,
+        None => return,
+    };
+    // Recorta o destino e ajusta a origem na mesma medida.
+    let dst = match Rect::new(dst_x, dst_y, src.width, src.height).intersect(&bounds) {
+        Some(dst) => dst,
+        None => return,
+    };
+    let (width, height) = (dst.width, dst.height);
+    let row_bytes = width as usize * surface.bytes_per_pixel;
+    let path = active_path();
+    let streaming = surface.streaming_for(row_bytes * height as usize);
+
+    // Destino abaixo da origem: copia de baixo para cima para não sobrescrever
+    // linhas ainda não lidas.
+    let bottom_up = dst.y > src.y;
+    for i in 0..height {
+        let row = if bottom_up { height - 1 - i } else { i };
+        // # SAFETY: Origem e destino foram recortados aos limites da superfície.
+        let (s, d) = unsafe {
+            (surface.pixel_ptr(src.x, src.y + row), surface.pixel_ptr(dst.x, dst.y + row))
+        };
+        let overlaps = (s as usize) < d as usize + row_bytes && (d as usize) < s as usize + row_bytes;
+        if overlaps {
+            // Mesma linha deslocada na horizontal: memmove.
+            // # SAFETY: Ambos os intervalos estão dentro da superfície.
+            unsafe { ptr::copy(s, d, row_bytes) };
+        } else {
+            run_row(path, || unsafe { copy_row(path, d, s, row_bytes, streaming) });
+        }
+    }
+    finish(path, streaming);
+}
+
+/// 🖌️ Copia `src_rect` de `src` para (`dst_x`, `dst_y`) em `dst` (sem sobreposição).
+pub fn blit(dst: &Surface, dst_x: u32, dst_y: u32, src: &Surface, src_rect: Rect) -> Result<(), BlitError> {
+    if dst.format != src.format {
+        return Err(BlitError::FormatMismatch);
+    }
+    let src_rect = match src_rect.intersect(&src.bounds()) {
+        Some(rect) => rect,
+        None => return Ok(()),
+    };
+    let dst_rect = match Rect::new(dst_x, dst_y, src_rect.width, src_rect.height).intersect(&dst.bounds()) {
+        Some(rect) => rect,
+        None => return Ok(()),
+    };
+    let row_bytes = dst_rect.width as usize * dst.bytes_per_pixel;
+    let path = active_path();
+    let streaming = dst.streaming_for(row_bytes * dst_rect.height as usize);
+
+    for row in 0..dst_rect.height {
+        // # SAFETY: Ambos os retângulos foram recortados aos limites das superfícies.
+        let (s, d) = unsafe {
+            (src.pixel_ptr(src_rect.x, src_rect.y + row), dst.pixel_ptr(dst_rect.x, dst_rect.y + row))
+        };
+        run_row(path, || unsafe { copy_row(path, d, s, row_bytes, streaming) });
+    }
+    finish(path, streaming);
+    Ok(())
+}
+
+/// 🖼️ Converte e copia pixels ARGB8888 (`0xAARRGGBB`, formato dos buffers de
+/// aplicação) para `dst`, em qualquer formato suportado.
+/// * `src` tem `src_stride` pixels por linha; `src_rect` é recortado a `src_height` linhas.
+pub fn blit_argb(
+    dst: &Surface,
+    dst_x: u32,
+    dst_y: u32,
+    src: &[u32],
+    src_stride: usize,
+    src_rect: Rect,
+) -> Result<(), BlitError> {
+    let src_height = if src_stride == 0 { 0 } else { (src.len() / src_stride) as u32 };
+    let src_bounds = Rect::new(0, 0, src_stride as u32, src_height);
+    let src_rect = match src_rect.intersect(&src_bounds) {
+        Some(rect) => rect,
+        None => return Ok(()),
+    };
+    let dst_rect = match Rect::new(dst_x, dst_y, src_rect.width, src_rect.height).intersect(&dst.bounds()) {
+        Some(rect) => rect,
+        None => return Ok(()),
+    };
+
+    with_pixel_kernel!(dst.format, F => {
+        for row in 0..dst_rect.height {
+            let start = (src_rect.y + row) as usize * src_stride + src_rect.x as usize;
+            let line = &src[start..start + dst_rect.width as usize];
+            // # SAFETY: `dst_rect` foi recortado aos limites de `dst`.
+            unsafe { convert_row::<F>(dst.pixel_ptr(dst_rect.x, dst_rect.y + row), line) };
+        }
+        Ok(())
+    }, else Err(BlitError::UnsupportedFormat))
+}
+
+/// 🌗 Compõe pixels ARGB8888 sobre `dst` (operador "source over", alfa não
+/// pré-multiplicado). Pixels totalmente opacos/transparentes não leem o destino.
+/// * Lê o destino: use apenas em superfícies com cache (back buffer).
+pub fn blend_argb(
+    dst: &Surface,
+    dst_x: u32,
+    dst_y: u32,
+    src: &[u32],
+    src_stride: usize,
+    src_rect: Rect,
+) -> Result<(), BlitError> {
+    let src_height = if src_stride == 0 { 0 } else { (src.len() / src_stride) as u32 };
+    let src_rect = match src_rect.intersect(&Rect::new(0, 0, src_stride as u32, src_height)) {
+        Some(rect) => rect,
+        None => return Ok(()),
+    };
+    let dst_rect = match Rect::new(dst_x, dst_y, src_rect.width, src_rect.height).intersect(&dst.bounds()) {
+        Some(rect) => rect,
+        None => return Ok(()),
+    };
+
+    with_pixel_kernel!(dst.format, F => {
+        for row in 0..dst_rect.height {
+            let start = (src_rect.y + row) as usize * src_stride + src_rect.x as usize;
+            let line = &src[start..start + dst_rect.width as usize];
+            // # SAFETY: `dst_rect` foi recortado aos limites de `dst`.
+            unsafe { blend_row::<F>(dst.pixel_ptr(dst_rect.x, dst_rect.y + row), line) };
+        }
+        Ok(())
+    }, else Err(BlitError::UnsupportedFormat))
+}
+
+/// Mistura um canal: `(s * a + d * (255 - a)) / 255`, com arredondamento exato.
+#[inline(always)]
+fn mix(s: u8, d: u8, a: u32) -> u8 {
+    let v = s as u32 * a + d as u32 * (255 - a) + 128;
+    ((v + (v >> 8)) >> 8) as u8
+}
+
+/// Compõe uma linha ARGB8888 sobre o formato `F`.
+#[inline]
+unsafe fn blend_row<F: PixelKernel>(dst: *mut u8, line: &[u32]) {
+    let mut p = dst;
+    for &argb in line {
+        match argb >> 24 {
+            0 => {}
+            255 => F::write(p, F::from_argb(argb)),
+            a => {
+                let (dr, dg, db) = F::unpack(F::read(p));
+                let (sr, sg, sb) = ((argb >> 16) as u8, (argb >> 8) as u8, argb as u8);
+                F::write(p, F::pack(mix(sr, dr, a), mix(sg, dg, a), mix(sb, db, a)));
+            }
+        }
+        p = p.add(F::BYTES);
+    }
+}
+
+/// Converte uma linha ARGB8888 para o formato `F` (sem testes de formato no laço).
+#[inline]
+unsafe fn convert_row<F: PixelKernel>(dst: *mut u8, line: &[u32]) {
+    let mut p = dst;
+    for &argb in line {
+        F::write(p, F::from_argb(argb));
+        p = p.add(F::BYTES);
+    }
+}
+
+// ------------------------------------------------------------------------
+// --- Kernels de Linha: Preenchimento ---
+// ------------------------------------------------------------------------
+
+/// Preenche `count` pixels de 32 bits a partir de `dst`.
+unsafe fn fill_row32(path: BlitPath, dst: *mut u8, count: usize, pixel: u32, streaming: bool) {
+    // Os caminhos SIMD alinham por pixel até a fronteira do vetor: exigem 4 bytes.
+    if dst as usize & 3 != 0 {
+        return fill_row32_scalar(dst, count, pixel);
+    }
+    match path {
+        BlitPath::Avx2 => fill_row32_avx2(dst, count, pixel, streaming),
+        BlitPath::Sse2 => fill_row32_sse2(dst, count, pixel, streaming),
+        BlitPath::Scalar => fill_row32_scalar(dst, count, pixel),
+    }
+}
+
+unsafe fn fill_row32_scalar(dst: *mut u8, count: usize, pixel: u32) {
+    let mut p = dst;
+    let end = dst.add(count * 4);
+    if p as usize & 7 != 0 && p < end {
+        ptr::write_unaligned(p as *mut u32, pixel);
+        p = p.add(4);
+    }
+    let pair = pixel as u64 | (pixel as u64) << 32;
+    while end as usize - p as usize >= 8 {
+        ptr::write_unaligned(p as *mut u64, pair);
+        p = p.add(8);
+    }
+    if p < end {
+        ptr::write_unaligned(p as *mut u32, pixel);
+    }
+}
+
+#[target_feature(enable = "sse2")]
+unsafe fn fill_row32_sse2(dst: *mut u8, count: usize, pixel: u32, streaming: bool) {
+    let mut p = dst;
+    let end = dst.add(count * 4);
+    while p as usize & 15 != 0 && p < end {
+        ptr::write_volatile(p as *mut u32, pixel);
+        p = p.add(4);
+    }
+
+    let v = _mm_set1_epi32(pixel as i32);
+    if streaming {
+        while end as usize - p as usize >= 64 {
+            _mm_stream_si128(p as *mut __m128i, v);
+            _mm_stream_si128(p.add(16) as *mut __m128i, v);
+            _mm_stream_si128(p.add(32) as *mut __m128i, v);
+            _mm_stream_si128(p.add(48) as *mut __m128i, v);
+            p = p.add(64);
+        }
+    } else {
+        while end as usize - p as usize >= 64 {
+            _mm_store_si128(p as *mut __m128i, v);
+            _mm_store_si128(p.add(16) as *mut __m128i, v);
+            _mm_store_si128(p.add(32) as *mut __m128i, v);
+            _mm_store_si128(p.add(48) as *mut __m128i, v);
+            p = p.add(64);
+        }
+    }
+    while end as usize - p as usize >= 16 {
+        _mm_store_si128(p as *mut __m128i, v);
+        p = p.add(16);
+    }
+    while p < end {
+        ptr::write_volatile(p as *mut u32, pixel);
+        p = p.add(4);
+    }
+}
+
+#[target_feature(enable = "avx2")]
+unsafe fn fill_row32_avx2(dst: *mut u8, count: usize, pixel: u32, streaming: bool) {
+    let mut p = dst;
+    let end = dst.add(count * 4);
+    while p as usize & 31 != 0 && p < end {
+        ptr::write_volatile(p as *mut u32, pixel);
+        p = p.add(4);
+    }
+
+    let v = _mm256_set1_epi32(pixel as i32);
+    if streaming {
+        while end as usize - p as usize >= 128 {
+            _mm256_stream_si256(p as *mut __m256i, v);
+            _mm256_stream_si256(p.add(32) as *mut __m256i, v);
+            _mm256_stream_si256(p.add(64) as *mut __m256i, v);
+            _mm256_stream_si256(p.add(96) as *mut __m256i, v);
+            p = p.add(128);
+        }
+    } else {
+        while end as usize - p as usize >= 128 {
+            _mm256_store_si256(p as *mut __m256i, v);
+            _mm256_store_si256(p.add(32) as *mut __m256i, v);
+            _mm256_store_si256(p.add(64) as *mut __m256i, v);
+            _mm256_store_si256(p.add(96) as *mut __m256i, v);
+            p = p.add(128);
+        }
+    }
+    while end as usize - p as usize >= 32 {
+        _mm256_store_si256(p as *mut __m256i, v);
+        p = p.add(32);
+    }
+    while p < end {
+        ptr::write_volatile(p as *mut u32, pixel);
+        p = p.add(4);
+    }
+}
+
+/// Preenche `count` pixels de 24 bits: 4 pixels (12 bytes) por três stores de 32 bits.
+unsafe fn fill_row24(dst: *mut u8, count: usize, pixel: u32) {
+    let [c0, c1, c2, _] = pixel.to_le_bytes();
+    let words = [
+        u32::from_le_bytes([c0, c1, c2, c0]),
+        u32::from_le_bytes([c1, c2, c0, c1]),
+        u32::from_le_bytes([c2, c0, c1, c2]),
+    ];
+
+    let mut p = dst;
+    for _ in 0..count / 4 {
+        ptr::write_unaligned(p as *mut u32, words[0]);
+        ptr::write_unaligned(p.add(4) as *mut u32, words[1]);
+        ptr::write_unaligned(p.add(8) as *mut u32, words[2]);
+        p = p.add(12);
+    }
+    for _ in 0..count % 4 {
+        ptr::write_volatile(p, c0);
+        ptr::write_volatile(p.add(1), c1);
+        ptr::write_volatile(p.add(2), c2);
+        p = p.add(3);
+    }
+}
+
+/// Preenche `count` pixels de 16 bits: pares de pixels pelo kernel de 32 bits.
+unsafe fn fill_row16(path: BlitPath, dst: *mut u8, count: usize, pixel: u32, streaming: bool) {
+    let pixel = pixel as u16;
+    let (mut p, mut left) = (dst, count);
+    if p as usize & 3 != 0 && left > 0 {
+        ptr::write_volatile(p as *mut u16, pixel);
+        p = p.add(2);
+        left -= 1;
+    }
+    let pair = pixel as u32 | (pixel as u32) << 16;
+    fill_row32(path, p, left / 2, pair, streaming);
+    if left % 2 != 0 {
+        ptr::write_volatile(p.add((left - 1) * 2) as *mut u16, pixel);
+    }
+}
+
+// ------------------------------------------------------------------------
+// --- Kernels de Linha: Cópia ---
+// ------------------------------------------------------------------------
+
+/// Copia `bytes` de `src` para `dst` (intervalos sem sobreposição).
+unsafe fn copy_row(path: BlitPath, dst: *mut u8, src: *const u8, bytes: usize, streaming: bool) {
+    match path {
+        BlitPath::Avx2 => copy_row_avx2(dst, src, bytes, streaming),
+        BlitPath::Sse2 => copy_row_sse2(dst, src, bytes, streaming),
+        BlitPath::Scalar => ptr::copy_nonoverlapping(src, dst, bytes),
+    }
+}
+
+#[target_feature(enable = "sse2")]
+unsafe fn copy_row_sse2(dst: *mut u8, src: *const u8, bytes: usize, streaming: bool) {
+    // Alinha o destino (os stores alinhados/não-temporais exigem 16 bytes).
+    let head = (dst.align_offset(16)).min(bytes);
+    ptr::copy_nonoverlapping(src, dst, head);
+    let (mut d, mut s, mut left) = (dst.add(head), src.add(head), bytes - head);
+
+    while left >= 64 {
+        let a = _mm_loadu_si128(s as *const __m128i);
+        let b = _mm_loadu_si128(s.add(16) as *const __m128i);
+        let c = _mm_loadu_si128(s.add(32) as *const __m128i);
+        let e = _mm_loadu_si128(s.add(48) as *const __m128i);
+        if streaming {
+            _mm_stream_si128(d as *mut __m128i, a);
+            _mm_stream_si128(d.add(16) as *mut __m128i, b);
+            _mm_stream_si128(d.add(32) as *mut __m128i, c);
+            _mm_stream_si128(d.add(48) as *mut __m128i, e);
+        } else {
+            _mm_store_si128(d as *mut __m128i, a);
+            _mm_store_si128(d.add(16) as *mut __m128i, b);
+            _mm_store_si128(d.add(32) as *mut __m128i, c);
+            _mm_store_si128(d.add(48) as *mut __m128i, e);
+        }
+        d = d.add(64);
+        s = s.add(64);
+        left -= 64;
+    }
+    while left >= 16 {
+        _mm_store_si128(d as *mut __m128i, _mm_loadu_si128(s as *const __m128i));
+        d = d.add(16);
+        s = s.add(16);
+        left -= 16;
+    }
+    ptr::copy_nonoverlapping(s, d, left);
+}
+
+#[target_feature(enable = "avx2")]
+unsafe fn copy_row_avx2(dst: *mut u8, src: *const u8, bytes: usize, streaming: bool) {
+    let head = (dst.align_offset(32)).min(bytes);
+    ptr::copy_nonoverlapping(src, dst, head);
+    let (mut d, mut s, mut left) = (dst.add(head), src.add(head), bytes - head);
+
+    while left >= 128 {
+        let a = _mm256_loadu_si256(s as *const __m256i);
+        let b = _mm256_loadu_si256(s.add(32) as *const __m256i);
+        let c = _mm256_loadu_si256(s.add(64) as *const __m256i);
+        let e = _mm256_loadu_si256(s.add(96) as *const __m256i);
+        if streaming {
+            _mm256_stream_si256(d as *mut __m256i, a);
+            _mm256_stream_si256(d.add(32) as *mut __m256i, b);
+            _mm256_stream_si256(d.add(64) as *mut __m256i, c);
+            _mm256_stream_si256(d.add(96) as *mut __m256i, e);
+        } else {
+            _mm256_store_si256(d as *mut __m256i, a);
+            _mm256_store_si256(d.add(32) as *mut __m256i, b);
+            _mm256_store_si256(d.add(64) as *mut __m256i, c);
+            _mm256_store_si256(d.add(96) as *mut __m256i, e);
+        }
+        d = d.add(128);
+        s = s.add(128);
+        left -= 128;
+    }
+    while left >= 32 {
+        _mm256_store_si256(d as *mut __m256i, _mm256_loadu_si256(s as *const __m256i));
+        d = d.add(32);
+        s = s.add(32);
+        left -= 32;
+    }
+    ptr::copy_nonoverlapping(s, d, left);
+}
@@ -0,0 +1,353 @@
+// src/kernel/drivers/compositor.rs
+
+//! Compositor de Superfícies do LightOS.
+//!
+//! Cada aplicação desenha em uma superfície ARGB8888 própria, alocada em memória
+//! compartilhada (`memory::shared`) e mapeada no seu espaço de endereçamento. Ela
+//! só informa ao compositor QUAIS retângulos mudaram (`commit`); os pixels nunca
+//! passam por payloads de IPC.
+//!
+//! A thread `lightos-compositor` compõe, em ordem de Z, apenas as regiões
+//! danificadas no back buffer do `DISPLAY` e chama `present` (com vsync).
+
+use alloc::vec::Vec;
+use core::sync::atomic::{AtomicBool, AtomicU32, Ordering};
+use spin::{Mutex, Once};
+use x86_64::instructions::interrupts;
+use x86_64::registers::control::Cr3;
+use x86_64::{PhysAddr, VirtAddr};
+
+use super::blit::{self, Rect};
+use super::damage::DamageTracker;
+use super::display::{DisplayDriver, DISPLAY};
+use crate::memory::shared::{self, SharedRegionId};
+use crate::task::TaskId;
+
+/// Maior dimensão aceita para uma superfície (pixels).
+pub const MAX_SURFACE_DIMENSION: u32 = 8192;
+
+/// 🆔 Identificador de uma superfície.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+#[repr(transparent)]
+pub struct SurfaceId(pub u32);
+
+/// 🌗 Como a superfície é composta sobre o que está abaixo dela.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum BlendMode {
+    /// O canal alfa é ignorado (cópia direta, mais rápida).
+    Opaque,
+    /// Composição "source over" usando o canal alfa.
+    Alpha,
+}
+
+/// 🚨 Erros do compositor.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum CompositorError {
+    /// Dimensões zero ou acima de `MAX_SURFACE_DIMENSION`.
+    InvalidSize,
+    /// Sem memória compartilhada para os pixels.
+    OutOfMemory,
+    /// Superfície inexistente.
+    NotFound,
+    /// Não há display (ou back buffer) para compor.
+    NoDisplay,
+    /// Falha ao mapear a superfície no espaço da tarefa.
+    MappingFailed,
+}
+
+/// 🖼️ Superfície de um cliente.
+struct ClientSurface {
+    id: SurfaceId,
+    /// Tarefa que criou a superfície: só ela pode mapeá-la, configurá-la e destruí-la.
+    owner: TaskId,
+    region: SharedRegionId,
+    width: u32,
+    height: u32,
+    x: u32,
+    y: u32,
+    z: i32,
+    visible: bool,
+    blend: BlendMode,
+}
+
+impl ClientSurface {
+    /// Retângulo ocupado na tela.
+    fn screen_rect(&self) -> Rect {
+        Rect::new(self.x, self.y, self.width, self.height)
+    }
+
+    /// Pixels da superfície (visão do kernel da memória compartilhada).
+    fn pixels(&self) -> Option<&[u32]> {
+        let (ptr, size) = shared::kernel_view(self.region)?;
+        let len = (self.width as usize * self.height as usize).min(size / 4);
+        // # SAFETY: A região vive enquanto a superfície existir; o cliente pode
+        // escrevê-la concorrentemente (no pior caso, um quadro mistura conteúdos).
+        Some(unsafe { core::slice::from_raw_parts(ptr as *const u32, len) })
+    }
+}
+
+/// 🎬 Estado do compositor.
+pub struct Compositor {
+    /// Superfícies ordenadas por Z crescente (a última fica por cima).
+    surfaces: Vec<ClientSurface>,
+    /// Regiões da TELA a recompor.
+    damage: DamageTracker,
+    /// Cor de fundo (ARGB8888) onde nenhuma superfície opaca cobre.
+    background: u32,
+    /// Sincronizar `present` com o retraço vertical (padrão: se o display o suporta).
+    vsync: bool,
+}
+
+static COMPOSITOR: Once<Mutex<Compositor>> = Once::new();
+static NEXT_SURFACE_ID: AtomicU32 = AtomicU32::new(1);
+/// Há dano pendente: acorda a thread do compositor.
+static FRAME_PENDING: AtomicBool = AtomicBool::new(false);
+
+fn compositor() -> Result<&'static Mutex<Compositor>, CompositorError> {
+    COMPOSITOR.get().ok_or(CompositorError::NoDisplay)
+}
+
+/// Executa `f` com o compositor travado e sinaliza um quadro se houver dano.
+fn with_compositor<R>(f: impl FnOnce(&mut Compositor) -> Result<R, CompositorError>) -> Result<R, CompositorError> {
+    let mut compositor = compositor()?.lock();
+    let result = f(&mut compositor);
+    if !compositor.damage.is_empty() {
+        FRAME_PENDING.store(true, Ordering::Release);
+    }
+    result
+}
+
+impl Compositor {
+    /// Superfície `id`, se pertence a `owner`. A de outra tarefa é tratada como
+    /// inexistente (o id não revela nada sobre as superfícies alheias).
+    fn find(&mut self, id: SurfaceId, owner: TaskId) -> Result<&mut ClientSurface, CompositorError> {
+        self.surfaces.iter_mut().find(|s| s.id == id && s.owner == owner).ok_or(CompositorError::NotFound)
+    }
+
+    fn sort_by_z(&mut self) {
+        // Ordenação estável: superfícies com o mesmo Z mantêm a ordem de criação.
+        self.surfaces.sort_by_key(|s| s.z);
+    }
+
+    /// 🎨 Recompõe as regiões danificadas no back buffer do display.
+    /// Retorna o número de pixels compostos.
+    fn compose(&mut self, display: &mut DisplayDriver) -> Result<u64, CompositorError> {
+        let back = display.back_surface().ok_or(CompositorError::NoDisplay)?;
+        let mut composed = 0;
+
+        for &area in self.damage.rects() {
+            // Começa pela superfície opaca mais alta que cobre toda a área:
+            // nada abaixo dela é visível (nem o fundo).
+            let first = self
+                .surfaces
+                .iter()
+                .rposition(|s| {
+                    s.visible
+                        && s.blend == BlendMode::Opaque
+                        && s.screen_rect().intersect(&area) == Some(area)
+                })
+                .unwrap_or_else(|| {
+                    let _ = blit::fill_rect(&back, area, back.format.pack(
+                        (self.background >> 16) as u8,
+                        (self.background >> 8) as u8,
+                        self.background as u8,
+                    ));
+                    0
+                });
+
+            for surface in self.surfaces[first..].iter().filter(|s| s.visible) {
+                let visible = match surface.screen_rect().intersect(&area) {
+                    Some(visible) => visible,
+                    None => continue,
+                };
+                let pixels = match surface.pixels() {
+                    Some(pixels) => pixels,
+                    None => continue,
+                };
+                let local = Rect::new(visible.x - surface.x, visible.y - surface.y, visible.width, visible.height);
+                let stride = surface.width as usize;
+                let _ = match surface.blend {
+                    BlendMode::Opaque => blit::blit_argb(&back, visible.x, visible.y, pixels, stride, local),
+                    BlendMode::Alpha => blit::blend_argb(&back, visible.x, visible.y, pixels, stride, local),
+                };
+            }
+
+            display.mark_damaged(area);
+            composed += area.area();
+        }
+
+        self.damage.clear();
+        Ok(composed)
+    }
+}
+
+// ------------------------------------------------------------------------
+// --- API de Superfícies (usada pelas Syscalls) ---
+// ------------------------------------------------------------------------
+
+/// ➕ Cria uma superfície `width` x `height` de `owner` (invisível até `configure`).
+pub fn create_surface(owner: TaskId, width: u32, height: u32, blend: BlendMode) -> Result<SurfaceId, CompositorError> {
+    if width == 0 || height == 0 || width > MAX_SURFACE_DIMENSION || height > MAX_SURFACE_DIMENSION {
+        return Err(CompositorError::InvalidSize);
+    }
+    let region = shared::create(width as usize * height as usize * 4).map_err(|_| CompositorError::OutOfMemory)?;
+    let id = SurfaceId(NEXT_SURFACE_ID.fetch_add(1, Ordering::Relaxed));
+
+    with_compositor(|c| {
+        c.surfaces.push(ClientSurface { id, owner, region, width, height, x: 0, y: 0, z: 0, visible: false, blend });
+        c.sort_by_z();
+        Ok(id)
+    })
+}
+
+/// ➖ Destrói a superfície e libera sua memória compartilhada.
+pub fn destroy_surface(id: SurfaceId, owner: TaskId) -> Result<(), CompositorError> {
+    let region = with_compositor(|c| {
+        let index = c
+            .surfaces
+            .iter()
+            .position(|s| s.id == id && s.owner == owner)
+            .ok_or(CompositorError::NotFound)?;
+        let surface = c.surfaces.remove(index);
+        if surface.visible {
+            c.damage.add(surface.screen_rect());
+        }
+        Ok(surface.region)
+    })?;
+    let _ = shared::release(region);
+    Ok(())
+}
+
+/// 🗺️ Mapeia os pixels da superfície no espaço de endereçamento `p4_phys`.
+pub fn map_surface(id: SurfaceId, owner: TaskId, p4_phys: PhysAddr) -> Result<VirtAddr, CompositorError> {
+    let region = with_compositor(|c| Ok(c.find(id, owner)?.region))?;
+    shared::map_into(region, p4_phys).map_err(|_| CompositorError::MappingFailed)
+}
+
+/// 📍 Posiciona a superfície na tela, define seu Z e visibilidade.
+pub fn configure(id: SurfaceId, owner: TaskId, x: u32, y: u32, z: i32, visible: bool) -> Result<(), CompositorError> {
+    with_compositor(|c| {
+        let surface = c.find(id, owner)?;
+        let before = surface.visible.then(|| surface.screen_rect());
+        let z_changed = surface.z != z;
+        surface.x = x;
+        surface.y = y;
+        surface.z = z;
+        surface.visible = visible;
+        let after = visible.then(|| surface.screen_rect());
+
+        // Recompõe onde ela estava e onde passou a estar.
+        if let Some(rect) = before {
+            c.damage.add(rect);
+        }
+        if let Some(rect) = after {
+            c.damage.add(rect);
+        }
+        if z_changed {
+            c.sort_by_z();
+        }
+        Ok(())
+    })
+}
+
+/// 📤 Informa que `damage` (em coordenadas da superfície) foi redesenhado.
+pub fn commit(id: SurfaceId, owner: TaskId, damage: Rect) -> Result<(), CompositorError> {
+    with_compositor(|c| {
+        let surface = c.find(id, owner)?;
+        if !surface.visible {
+            return Ok(());
+        }
+        let local = match damage.intersect(&Rect::new(0, 0, surface.width, surface.height)) {
+            Some(local) => local,
+            None => return Ok(()),
+        };
+        // `x`/`y` vêm do usuário sem limite: fora da tela, o dano é recortado pelo rastreador.
+        let screen = Rect::new(
+            surface.x.saturating_add(local.x),
+            surface.y.saturating_add(local.y),
+            local.width,
+            local.height,
+        );
+        c.damage.add(screen);
+        Ok(())
+    })
+}
+
+/// 🎨 Define a cor de fundo (ARGB8888) e recompõe a tela inteira.
+pub fn set_background(argb: u32) -> Result<(), CompositorError> {
+    with_compositor(|c| {
+        c.background = argb;
+        c.damage.add_all();
+        Ok(())
+    })
+}
+
+/// 🔄 Liga/desliga a sincronização dos quadros com o retraço vertical
+/// (sem efeito se o display não o detectou).
+pub fn set_vsync(enabled: bool) -> Result<(), CompositorError> {
+    with_compositor(|c| {
+        c.vsync = enabled;
+        Ok(())
+    })
+}
+
+// ------------------------------------------------------------------------
+// --- Thread do Compositor ---
+// ------------------------------------------------------------------------
+
+/// 🖥️ Compõe e apresenta um quadro, se houver dano pendente.
+/// Retorna o número de pixels compostos.
+pub fn compose_frame() -> Result<u64, CompositorError> {
+    if !FRAME_PENDING.swap(false, Ordering::AcqRel) {
+        return Ok(0);
+    }
+    let mut compositor = compositor()?.lock();
+    let mut display = DISPLAY.get().ok_or(CompositorError::NoDisplay)?.lock();
+    let composed = compositor.compose(&mut display)?;
+    let vsync = compositor.vsync;
+    drop(compositor);
+
+    display.present(vsync).map_err(|_| CompositorError::NoDisplay)?;
+    Ok(composed)
+}
+
+/// 🔁 Laço principal da thread de kernel `lightos-compositor`.
+extern "C" fn compositor_main() {
+    loop {
+        if let Err(e) = compose_frame() {
+            crate::println!("WARN: Compositor: {:?}", e);
+        }
+        // Dorme até a próxima interrupção (o temporizador limita a taxa de quadros).
+        interrupts::disable();
+        if !FRAME_PENDING.load(Ordering::Acquire) {
+            interrupts::enable_and_hlt();
+        } else {
+            interrupts::enable();
+        }
+    }
+}
+
+/// 🚀 Cria o compositor sobre o `DISPLAY` (com back buffer) e sua thread.
+/// * Chamado do kernel_main, após o display e o Scheduler.
+pub fn initialize() -> Result<(), CompositorError> {
+    let display = DISPLAY.get().ok_or(CompositorError::NoDisplay)?;
+    let (bounds, vsync) = {
+        let mut display = display.lock();
+        display.enable_double_buffering().map_err(|_| CompositorError::OutOfMemory)?;
+        (display.bounds(), display.has_vsync())
+    };
+
+    COMPOSITOR.call_once(|| {
+        Mutex::new(Compositor {
+            surfaces: Vec::new(),
+            damage: DamageTracker::new(bounds),
+            background: 0xFF00_0000,
+            vsync,
+        })
+    });
+
+    let (kernel_p4, _) = Cr3::read();
+    crate::task::spawn_task(compositor_main, kernel_p4.start_address());
+    crate::println!("INFO: Compositor (lightos-compositor) iniciado em {}x{}.", bounds.width, bounds.height);
+    Ok(())
+}
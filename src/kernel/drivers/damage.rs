@@ -0,0 +1,106 @@
+// src/kernel/drivers/damage.rs
+
+//! Rastreamento de Regiões Danificadas (Dirty Rectangles) para o LightOS.
+//!
+//! Cada operação de desenho no back buffer registra o retângulo que alterou.
+//! Retângulos que se sobrepõem (ou cuja união desperdiça poucos pixels) são
+//! fundidos, mantendo uma lista curta e sem pixels copiados duas vezes por
+//! `DisplayDriver::present`.
+
+use super::blit::Rect;
+
+/// Número máximo de retângulos mantidos separadamente.
+pub const MAX_DAMAGE_RECTS: usize = 16;
+
+/// Pixels extras aceitos ao fundir dois retângulos: copiar uma pequena faixa
+/// intacta custa menos que o overhead por retângulo (setup de linha, SFENCE).
+const MERGE_SLACK_PIXELS: u64 = 4096;
+
+/// 🩹 Conjunto de regiões alteradas desde o último `present`.
+#[derive(Debug, Clone)]
+pub struct DamageTracker {
+    rects: [Rect; MAX_DAMAGE_RECTS],
+    len: usize,
+    /// Limites da superfície; todo retângulo é recortado a eles.
+    bounds: Rect,
+}
+
+impl DamageTracker {
+    /// 🏭 Cria um rastreador vazio para uma superfície com os `bounds` dados.
+    pub const fn new(bounds: Rect) -> Self {
+        DamageTracker { rects: [Rect::new(0, 0, 0, 0); MAX_DAMAGE_RECTS], len: 0, bounds }
+    }
+
+    /// `true` se nada foi alterado.
+    pub fn is_empty(&self) -> bool {
+        self.len == 0
+    }
+
+    /// Retângulos pendentes (disjuntos após as fusões).
+    pub fn rects(&self) -> &[Rect] {
+        &self.rects[..self.len]
+    }
+
+    /// Total de pixels pendentes.
+    pub fn damaged_pixels(&self) -> u64 {
+        self.rects().iter().map(Rect::area).sum()
+    }
+
+    /// 🖥️ Marca a superfície inteira como alterada.
+    pub fn add_all(&mut self) {
+        self.rects[0] = self.bounds;
+        self.len = 1;
+    }
+
+    /// ➕ Registra `rect` como alterado.
+    pub fn add(&mut self, rect: Rect) {
+        let mut rect = match rect.intersect(&self.bounds) {
+            Some(rect) => rect,
+            None => return,
+        };
+
+        loop {
+            // Funde com qualquer retângulo pendente que valha a pena; a união pode
+            // passar a tocar outros, então recomeça até estabilizar.
+            match self.rects().iter().position(|r| Self::should_merge(r, &rect)) {
+                Some(index) => {
+                    rect = rect.union(&self.rects[index]);
+                    self.remove(index);
+                }
+                None if self.len == MAX_DAMAGE_RECTS => {
+                    // Lista cheia: funde com o retângulo cuja união cresce menos.
+                    let index = self.cheapest_merge(&rect);
+                    rect = rect.union(&self.rects[index]);
+                    self.remove(index);
+                }
+                None => break,
+            }
+        }
+
+        self.rects[self.len] = rect;
+        self.len += 1;
+    }
+
+    /// 🧹 Esvazia a lista (após o `present`).
+    pub fn clear(&mut self) {
+        self.len = 0;
+    }
+
+    fn should_merge(a: &Rect, b: &Rect) -> bool {
+        a.intersect(b).is_some() || a.union(b).area() <= a.area() + b.area() + MERGE_SLACK_PIXELS
+    }
+
+    fn cheapest_merge(&self, rect: &Rect) -> usize {
+        self.rects()
+            .iter()
+            .enumerate()
+            .min_by_key(|(_, r)| r.union(rect).area() - r.area())
+            .map(|(index, _)| index)
+            .unwrap_or(0)
+    }
+
+    fn remove(&mut self, index: usize) {
+        self.len -= 1;
+        self.rects[index] = self.rects[self.len];
+    }
+}
@@ -1,11 +1,37 @@
 // src/kernel/drivers/display.rs
 
+use alloc::boxed::Box;
+use alloc::vec::Vec;
 use core::{
     ptr,
     slice,
 };
+use spin::{Mutex, Once};
+use x86_64::instructions::port::Port;
+use x86_64::PhysAddr;
 use crate::RustKernelConfig::arch_hal::VGA_WIDTH; // Exemplo: Importa do módulo HAL
 use crate::RustKernelConfig::VGA_TEXT_BUFFER_ADDR; // Importa endereço do HAL
+use crate::RustKernelConfig::arch_hal::VGA_INPUT_STATUS_PORT;
+use super::blit::{self, BlitError, Rect, StoreHint, Surface};
+use super::damage::DamageTracker;
+use super::overlay::{OverlayId, OverlayPlane};
+use super::pixel::{ChannelMask, PixelFormat};
+use crate::memory::dma::DmaBuffer;
+use crate::memory::paging::{self, CacheMode};
+use crate::multiboot2::{FramebufferKind, FramebufferTag};
+
+/// Bit 3 do Input Status Register #1: retraço vertical em andamento.
+const VGA_STATUS_VRETRACE: u8 = 1 << 3;
+/// Limite de leituras de porta ao esperar o retraço (só uma guarda: a espera
+/// acontece apenas se `detect_vsync` viu o bit alternar).
+const VSYNC_SPIN_LIMIT: u32 = 1_000_000;
+/// Leituras de porta em `detect_vsync` (~100 ms: alguns quadros a 60 Hz).
+const VSYNC_PROBE_READS: u32 = 100_000;
+
+/// Palavras de 32 bits que cobrem `bytes` bytes de pixels.
+fn pixel_words(bytes: usize) -> usize {
+    (bytes + 3) / 4
+}
 
 /// 🚨 Códigos de Erro Específicos para o Driver de Display
 #[derive(Debug, Clone, Copy, PartialEq, Eq)]
@@ -16,6 +42,12 @@ pub enum DisplayError {
     UnsupportedFormat,
     /// Parâmetros de MMIO inválidos.
     InvalidMmio,
+    /// Id, dimensões ou imagem de overlay inválidos.
+    InvalidOverlay,
+    /// O `Scanout` não conseguiu publicar as regiões alteradas.
+    ScanoutFailed,
+    /// Não há memória para o back buffer.
+    OutOfMemory,
 }
 
 /// 🖥️ Estrutura de Configuração do Framebuffer
@@ -32,6 +64,15 @@ pub struct FramebufferInfo {
     pub pitch: u32,
     /// Profundidade de cor em bits por pixel (ex: 24, 32).
     pub bpp: u8, 
+    /// Layout dos canais de cor (máscaras reportadas pelo bootloader).
+    pub format: PixelFormat,
+}
+
+/// 📡 Destino que precisa ser avisado das regiões alteradas do framebuffer
+/// (ex.: VirtIO-GPU, onde o host faz a varredura a partir da sua própria cópia).
+pub trait Scanout: Send {
+    /// Publica `rects` do framebuffer na tela.
+    fn flush(&mut self, rects: &[Rect]) -> Result<(), DisplayError>;
 }
 
 /// 🎨 Driver de Display Principal do LightOS
@@ -40,6 +81,20 @@ pub struct DisplayDriver {
     info: FramebufferInfo,
     /// Um ponteiro seguro para a área de memória do framebuffer.
     framebuffer_ptr: *mut u8,
+    /// Back buffer em RAM com cache (mesmo layout/pitch do framebuffer), se habilitado.
+    /// * Frames contíguos do PMM vistos pelo mapa linear: o Heap do kernel não
+    ///   comporta uma tela inteira. Alinhado a 4 KiB (loads/stores tipados).
+    back_buffer: Option<DmaBuffer>,
+    /// Regiões do back buffer ainda não copiadas para o framebuffer.
+    damage: DamageTracker,
+    /// Planos desenhados por cima do back buffer, só no framebuffer (cursor).
+    overlays: Vec<OverlayPlane>,
+    /// Rascunho (RAM com cache) onde `repaint_front` monta back buffer + overlays.
+    overlay_scratch: Vec<u32>,
+    /// Publicação explícita das regiões alteradas, se o framebuffer não é varrido direto.
+    scanout: Option<Box<dyn Scanout>>,
+    /// O retraço vertical do VGA foi observado em `initialize` (sem isso, `present` não espera).
+    vsync: bool,
 }
 
 impl DisplayDriver {
@@ -52,6 +107,15 @@ impl DisplayDriver {
         if info.address == 0 {
             return Err(DisplayError::FramebufferNotFound);
         }
+        // Apenas formatos com kernels especializados (ver `PixelFormat::kind`).
+        if info.format.bits_per_pixel != info.bpp || info.format.kind().is_none() {
+            return Err(DisplayError::UnsupportedFormat);
+        }
+        // Os kernels de 16/32 bpp acessam pixels inteiros: linhas alinhadas ao pixel.
+        let bytes = info.format.bytes_per_pixel();
+        if bytes != 3 && (info.pitch as usize % bytes != 0 || info.address % bytes != 0) {
+            return Err(DisplayError::UnsupportedFormat);
+        }
 
         let total_size = info.pitch * info.height;
         
@@ -59,6 +123,12 @@ impl DisplayDriver {
             info,
             // Cria um ponteiro mutável para o endereço do framebuffer
             framebuffer_ptr: info.address as *mut u8,
+            back_buffer: None,
+            damage: DamageTracker::new(Rect::new(0, 0, info.width, info.height)),
+            overlays: Vec::new(),
+            overlay_scratch: Vec::new(),
+            scanout: None,
+            vsync: false,
         })
     }
 
@@ -73,6 +143,9 @@ impl DisplayDriver {
 
         // Limpa o framebuffer, preenchendo-o com zeros (preto)
         self.clear_screen(0x00, 0x00, 0x00);
+
+        // Com `Scanout` o dispositivo troca a imagem inteira: não há retraço a esperar.
+        self.vsync = self.scanout.is_none() && Self::detect_vsync();
         
         crate::println!("INFO: Display Driver inicializado em {}x{} @ {} bpp.", 
             self.info.width, self.info.height, self.info.bpp);
@@ -80,54 +153,390 @@ impl DisplayDriver {
         Ok(())
     }
     
-    /// 🧹 Preenche toda a tela com uma cor RGB específica.
-    pub fn clear_screen(&self, r: u8, g: u8, b: u8) {
-        let total_bytes = (self.info.pitch * self.info.height) as usize;
-        let bytes_per_pixel = (self.info.bpp / 8) as usize;
-
-        // Cria a cor de preenchimento (assumindo formato RGB ou BGR)
-        let color_bytes: [u8; 4] = match bytes_per_pixel {
-            3 => [b, g, r, 0], // RGB 24-bit (sem byte alfa)
-            4 => [b, g, r, 0], // RGB 32-bit (byte alfa opcional em 0)
-            _ => return, // Não suportado
-        };
+    /// 📡 Liga um `Scanout`: a partir daqui o framebuffer só aparece na tela em
+    /// `present`, que publica apenas as regiões alteradas.
+    pub fn attach_scanout(&mut self, scanout: Box<dyn Scanout>) {
+        self.scanout = Some(scanout);
+        self.vsync = false;
+        self.damage.add_all();
+    }
+
+    /// `true` se `present(true)` realmente sincroniza com o retraço vertical.
+    pub fn has_vsync(&self) -> bool {
+        self.vsync
+    }
+
+    /// 📐 Retângulo da tela inteira.
+    pub fn bounds(&self) -> Rect {
+        Rect::new(0, 0, self.info.width, self.info.height)
+    }
+
+    // --- Double Buffering ---
+
+    /// 🧮 Habilita o back buffer: a partir daqui todo desenho vai para a RAM e só
+    /// aparece na tela em `present`.
+    /// * Falha com `OutOfMemory` (sem abortar) se o PMM não tem `pitch * height` bytes contíguos.
+    pub fn enable_double_buffering(&mut self) -> Result<(), DisplayError> {
+        if self.back_buffer.is_some() {
+            return Ok(());
+        }
+        let bytes = self.info.pitch as usize * self.info.height as usize;
+        let buffer = DmaBuffer::new(bytes).map_err(|_| DisplayError::OutOfMemory)?;
+        self.back_buffer = Some(buffer);
+
+        // O back buffer começa preto: o primeiro `present` sincroniza a tela inteira.
+        self.damage.add_all();
+        Ok(())
+    }
+
+    /// `true` se o desenho está indo para o back buffer.
+    pub fn is_double_buffered(&self) -> bool {
+        self.back_buffer.is_some()
+    }
+
+    /// 🖼️ Superfície do back buffer (RAM com cache, segura para leitura/blending).
+    pub fn back_surface(&mut self) -> Option<Surface> {
+        let (width, height, pitch, format) =
+            (self.info.width, self.info.height, self.info.pitch as usize, self.info.format);
+        self.back_buffer.as_mut().map(|buffer| {
+            // # SAFETY: O buffer tem `pitch * height` bytes e vive enquanto o driver existir.
+            unsafe { Surface::new(buffer.as_mut_ptr(), width, height, pitch, format, StoreHint::Cached) }
+        })
+    }
+
+    /// 🩹 Marca uma região do back buffer como alterada (para desenho feito
+    /// diretamente em `back_surface`).
+    pub fn mark_damaged(&mut self, rect: Rect) {
+        if self.back_buffer.is_some() || self.scanout.is_some() {
+            self.damage.add(rect);
+        }
+    }
 
-        // Itera sobre a memória e escreve a cor
-        for i in 0..total_bytes / bytes_per_pixel {
-            let offset = i * bytes_per_pixel;
-            // # SAFETY: Esta é a operação mais perigosa, escrevendo diretamente no MMIO.
-            // É seguro aqui porque está encapsulado e o tamanho total é verificado.
-            unsafe {
-                ptr::write_volatile(self.framebuffer_ptr.add(offset) as *mut u8, color_bytes[0]);
-                ptr::write_volatile(self.framebuffer_ptr.add(offset + 1) as *mut u8, color_bytes[1]);
-                ptr::write_volatile(self.framebuffer_ptr.add(offset + 2) as *mut u8, color_bytes[2]);
-                if bytes_per_pixel == 4 {
-                    ptr::write_volatile(self.framebuffer_ptr.add(offset + 3) as *mut u8, color_bytes[3]);
+    /// 🚀 Copia as regiões alteradas do back buffer para o framebuffer e as
+    /// publica no `Scanout`, se houver.
+    /// * Com `vsync`, espera o início do retraço vertical antes da cópia (sem tearing
+    ///   quando a cópia cabe no intervalo de retraço). Ignorado se o retraço não foi
+    ///   detectado em `initialize` (ex: com `Scanout`, ou sem VGA).
+    /// * Retorna o número de pixels copiados.
+    pub fn present(&mut self, vsync: bool) -> Result<u64, DisplayError> {
+        if self.damage.is_empty() {
+            return Ok(0);
+        }
+
+        if let Some(back) = self.back_surface() {
+            if vsync && self.vsync {
+                Self::wait_for_vsync();
+            }
+            let front = self.surface();
+            for i in 0..self.damage.rects().len() {
+                let rect = self.damage.rects()[i];
+                // Sob um overlay, compõe no rascunho e escreve cada pixel uma única
+                // vez (copiar o back buffer e redesenhar o overlay por cima piscaria).
+                let under_overlay = self
+                    .overlays
+                    .iter()
+                    .any(|overlay| overlay.visible && overlay.rect().intersect(&rect).is_some());
+                if under_overlay {
+                    self.compose_front(rect)?;
+                } else {
+                    blit::blit(&front, rect.x, rect.y, &back, rect).map_err(|_| DisplayError::UnsupportedFormat)?;
                 }
             }
         }
-    }
 
-    /// 📌 Desenha um único pixel em uma coordenada (x, y).
-    pub fn draw_pixel(&self, x: u32, y: u32, r: u8, g: u8, b: u8) {
-        if x >= self.info.width || y >= self.info.height {
-            return; // Fora dos limites
+        if let Some(scanout) = self.scanout.as_mut() {
+            scanout.flush(self.damage.rects())?;
         }
+        let flushed = self.damage.damaged_pixels();
+        self.damage.clear();
+        Ok(flushed)
+    }
 
-        let bytes_per_pixel = (self.info.bpp / 8) as u32;
-        let offset = (y * self.info.pitch + x * bytes_per_pixel) as usize;
-        
-        let color_bytes: [u8; 4] = [b, g, r, 0]; // Simples BGR/RGB
+    /// 🔍 `true` se o bit de retraço do Input Status Register #1 alterna.
+    /// * Sem VGA a porta lê um valor fixo (tipicamente 0xFF): esperar por ela
+    ///   custaria `VSYNC_SPIN_LIMIT` leituras a cada quadro.
+    fn detect_vsync() -> bool {
+        let mut status: Port<u8> = Port::new(VGA_INPUT_STATUS_PORT);
+        // # SAFETY: Leitura de um registrador de status VGA, sem efeitos colaterais.
+        unsafe {
+            let first = status.read() & VGA_STATUS_VRETRACE;
+            (0..VSYNC_PROBE_READS).any(|_| status.read() & VGA_STATUS_VRETRACE != first)
+        }
+    }
 
-        // # SAFETY: A segurança do ponteiro é verificada pelos limites (x, y).
+    /// ⏳ Espera o início do próximo retraço vertical (Input Status Register #1).
+    fn wait_for_vsync() {
+        let mut status: Port<u8> = Port::new(VGA_INPUT_STATUS_PORT);
+        // # SAFETY: Leitura de um registrador de status VGA, sem efeitos colaterais.
         unsafe {
-            let pixel_ptr = self.framebuffer_ptr.add(offset);
-            ptr::write_volatile(pixel_ptr, color_bytes[0]);
-            ptr::write_volatile(pixel_ptr.add(1), color_bytes[1]);
-            ptr::write_volatile(pixel_ptr.add(2), color_bytes[2]);
-            if bytes_per_pixel == 4 {
-                ptr::write_volatile(pixel_ptr.add(3), color_bytes[3]);
+            // Se já estamos no meio de um retraço, espera ele acabar para pegar um inteiro.
+            let mut spins = 0;
+            while status.read() & VGA_STATUS_VRETRACE != 0 && spins < VSYNC_SPIN_LIMIT {
+                spins += 1;
+            }
+            spins = 0;
+            while status.read() & VGA_STATUS_VRETRACE == 0 && spins < VSYNC_SPIN_LIMIT {
+                spins += 1;
             }
         }
     }
+
+    // --- Overlays (Cursor) ---
+
+    /// ➕ Cria um overlay ARGB8888 invisível (habilita o back buffer, que guarda
+    /// os pixels sob ele).
+    pub fn create_overlay(&mut self, width: u32, height: u32, image: &[u32]) -> Result<OverlayId, DisplayError> {
+        self.enable_double_buffering()?;
+        self.overlays.push(OverlayPlane::new(width, height, image)?);
+        Ok(OverlayId(self.overlays.len() - 1))
+    }
+
+    fn overlay_mut(&mut self, id: OverlayId) -> Result<&mut OverlayPlane, DisplayError> {
+        self.overlays.get_mut(id.0).ok_or(DisplayError::InvalidOverlay)
+    }
+
+    /// 🔄 Troca a imagem do overlay (mesmas dimensões).
+    pub fn set_overlay_image(&mut self, id: OverlayId, image: &[u32]) -> Result<(), DisplayError> {
+        let overlay = self.overlay_mut(id)?;
+        if image.len() != overlay.image.len() {
+            return Err(DisplayError::InvalidOverlay);
+        }
+        overlay.image.copy_from_slice(image);
+        let (visible, rect) = (overlay.visible, overlay.rect());
+        if visible {
+            self.repaint_front(rect)?;
+        }
+        Ok(())
+    }
+
+    /// 👁️ Mostra ou esconde o overlay.
+    pub fn set_overlay_visible(&mut self, id: OverlayId, visible: bool) -> Result<(), DisplayError> {
+        let overlay = self.overlay_mut(id)?;
+        if overlay.visible == visible {
+            return Ok(());
+        }
+        overlay.visible = visible;
+        let rect = overlay.rect();
+        self.repaint_front(rect)
+    }
+
+    /// 🖱️ Move o overlay para (`x`, `y`).
+    /// * Redesenha apenas a posição antiga e a nova: O(área do overlay).
+    pub fn move_overlay(&mut self, id: OverlayId, x: u32, y: u32) -> Result<(), DisplayError> {
+        let overlay = self.overlay_mut(id)?;
+        if (overlay.x, overlay.y) == (x, y) {
+            return Ok(());
+        }
+        let before = overlay.rect();
+        overlay.x = x;
+        overlay.y = y;
+        let (visible, after) = (overlay.visible, overlay.rect());
+        if !visible {
+            return Ok(());
+        }
+
+        // Movimentos curtos (o caso comum) se sobrepõem: um único retângulo.
+        if before.intersect(&after).is_some() {
+            self.repaint_front(before.union(&after))
+        } else {
+            self.repaint_front(before)?;
+            self.repaint_front(after)
+        }
+    }
+
+    /// 🩹 Reconstrói `rect` na tela (e o publica no `Scanout`, se houver).
+    fn repaint_front(&mut self, rect: Rect) -> Result<(), DisplayError> {
+        self.compose_front(rect)?;
+        let visible = rect.intersect(&self.bounds());
+        match (self.scanout.as_mut(), visible) {
+            (Some(scanout), Some(visible)) => scanout.flush(&[visible]),
+            _ => Ok(()),
+        }
+    }
+
+    /// Reconstrói `rect` no framebuffer: back buffer + overlays visíveis por cima.
+    /// * A composição acontece no rascunho com cache (a memória de vídeo nunca é
+    ///   lida) e vai para o framebuffer em uma única cópia por linha.
+    fn compose_front(&mut self, rect: Rect) -> Result<(), DisplayError> {
+        let rect = match rect.intersect(&self.bounds()) {
+            Some(rect) => rect,
+            None => return Ok(()),
+        };
+        let back = match self.back_surface() {
+            Some(back) => back,
+            None => return Ok(()),
+        };
+        let front = self.surface();
+
+        let pitch = rect.width as usize * self.info.format.bytes_per_pixel();
+        let words = pixel_words(pitch * rect.height as usize);
+        if self.overlay_scratch.len() < words {
+            let extra = words - self.overlay_scratch.len();
+            self.overlay_scratch.try_reserve(extra).map_err(|_| DisplayError::OutOfMemory)?;
+            self.overlay_scratch.resize(words, 0);
+        }
+        // # SAFETY: O rascunho tem pelo menos `pitch * height` bytes e não é
+        // realocado até o fim desta função.
+        let scratch = unsafe {
+            Surface::new(
+                self.overlay_scratch.as_mut_ptr() as *mut u8,
+                rect.width,
+                rect.height,
+                pitch,
+                self.info.format,
+                StoreHint::Cached,
+            )
+        };
+
+        let to_display = |_| DisplayError::UnsupportedFormat;
+        blit::blit(&scratch, 0, 0, &back, rect).map_err(to_display)?;
+        for overlay in self.overlays.iter().filter(|o| o.visible) {
+            let hit = match overlay.rect().intersect(&rect) {
+                Some(hit) => hit,
+                None => continue,
+            };
+            let local = Rect::new(hit.x - overlay.x, hit.y - overlay.y, hit.width, hit.height);
+            blit::blend_argb(&scratch, hit.x - rect.x, hit.y - rect.y, &overlay.image, overlay.width as usize, local)
+                .map_err(to_display)?;
+        }
+        blit::blit(&front, rect.x, rect.y, &scratch, scratch.bounds()).map_err(to_display)
+    }
+
+    // --- Desenho ---
+
+    /// Superfície onde o desenho acontece: o back buffer, se habilitado, ou a tela.
+    fn target(&mut self) -> Surface {
+        self.back_surface().unwrap_or_else(|| self.surface())
+    }
+
+    /// 🖼️ Descreve o framebuffer como uma `Surface` do motor 2D.
+    /// * A memória de vídeo não é relida pela CPU: stores não-temporais.
+    pub fn surface(&self) -> Surface {
+        // # SAFETY: O framebuffer cobre `pitch * height` bytes (garantido em `new`).
+        unsafe {
+            Surface::new(
+                self.framebuffer_ptr,
+                self.info.width,
+                self.info.height,
+                self.info.pitch as usize,
+                self.info.format,
+                StoreHint::Streaming,
+            )
+        }
+    }
+
+    /// 🎨 Converte uma cor RGB para o valor de pixel no formato do framebuffer.
+    #[inline]
+    pub fn pack_color(&self, r: u8, g: u8, b: u8) -> u32 {
+        self.info.format.pack(r, g, b)
+    }
+
+    /// 🧹 Preenche toda a tela com uma cor RGB específica.
+    pub fn clear_screen(&mut self, r: u8, g: u8, b: u8) {
+        let target = self.target();
+        // O formato foi validado em `new`: o preenchimento não falha.
+        let _ = blit::fill_rect(&target, target.bounds(), self.pack_color(r, g, b));
+        self.mark_damaged(target.bounds());
+    }
+
+    /// 🟥 Preenche um retângulo (recortado aos limites da tela).
+    pub fn fill_rect(&mut self, rect: Rect, r: u8, g: u8, b: u8) -> Result<(), DisplayError> {
+        let pixel = self.pack_color(r, g, b);
+        blit::fill_rect(&self.target(), rect, pixel)
+            .map_err(|_| DisplayError::UnsupportedFormat)?;
+        self.mark_damaged(rect);
+        Ok(())
+    }
+
+    /// 📋 Move um retângulo da tela para (`dst_x`, `dst_y`); regiões podem se sobrepor.
+    pub fn copy_rect(&mut self, src: Rect, dst_x: u32, dst_y: u32) {
+        blit::copy_rect(&self.target(), src, dst_x, dst_y);
+        self.mark_damaged(Rect::new(dst_x, dst_y, src.width, src.height));
+    }
+
+    /// 🖌️ Copia `src_rect` de um buffer de pixels (mesmo formato) para a tela.
+    pub fn blit(&mut self, dst_x: u32, dst_y: u32, src: &Surface, src_rect: Rect) -> Result<(), DisplayError> {
+        blit::blit(&self.target(), dst_x, dst_y, src, src_rect).map_err(|e| match e {
+            BlitError::FormatMismatch | BlitError::UnsupportedFormat => DisplayError::UnsupportedFormat,
+        })?;
+        self.mark_damaged(Rect::new(dst_x, dst_y, src_rect.width, src_rect.height));
+        Ok(())
+    }
+
+    /// 🖼️ Copia pixels ARGB8888 de um buffer de aplicação para a tela, convertendo
+    /// para o formato do framebuffer.
+    pub fn blit_argb(&mut self, dst_x: u32, dst_y: u32, src: &[u32], src_stride: usize, src_rect: Rect) -> Result<(), DisplayError> {
+        blit::blit_argb(&self.target(), dst_x, dst_y, src, src_stride, src_rect)
+            .map_err(|_| DisplayError::UnsupportedFormat)?;
+        self.mark_damaged(Rect::new(dst_x, dst_y, src_rect.width, src_rect.height));
+        Ok(())
+    }
+
+    /// 🌗 Compõe pixels ARGB8888 sobre a tela usando o canal alfa ("source over").
+    pub fn blend_argb(&mut self, dst_x: u32, dst_y: u32, src: &[u32], src_stride: usize, src_rect: Rect) -> Result<(), DisplayError> {
+        blit::blend_argb(&self.target(), dst_x, dst_y, src, src_stride, src_rect)
+            .map_err(|_| DisplayError::UnsupportedFormat)?;
+        self.mark_damaged(Rect::new(dst_x, dst_y, src_rect.width, src_rect.height));
+        Ok(())
+    }
+
+    /// 📌 Desenha um único pixel em uma coordenada (x, y).
+    pub fn draw_pixel(&mut self, x: u32, y: u32, r: u8, g: u8, b: u8) {
+        let pixel = self.pack_color(r, g, b);
+        self.target().put_pixel(x, y, pixel);
+        self.mark_damaged(Rect::new(x, y, 1, 1));
+    }
+}
+
+// ------------------------------------------------------------------------
+// --- Display de Boot (Framebuffer do Firmware) ---
+// ------------------------------------------------------------------------
+
+// # SAFETY: O driver é o único dono do framebuffer e do back buffer; o acesso
+// entre tarefas é serializado pelo Mutex de `DISPLAY`.
+unsafe impl Send for DisplayDriver {}
+
+/// 🌐 Display principal, criado a partir do framebuffer do bootloader.
+pub static DISPLAY: Once<Mutex<DisplayDriver>> = Once::new();
+
+impl FramebufferInfo {
+    /// 🔄 Converte a tag do Multiboot2 (endereço físico) usando o endereço virtual
+    /// onde o framebuffer foi mapeado.
+    pub fn from_boot_tag(tag: &FramebufferTag, virt_address: usize) -> Result<Self, DisplayError> {
+        let (red, green, blue) = match tag.kind {
+            FramebufferKind::Rgb { red, green, blue } => (red, green, blue),
+            // Paleta e modo texto não são suportados pelo motor 2D.
+            FramebufferKind::Indexed | FramebufferKind::EgaText => return Err(DisplayError::UnsupportedFormat),
+        };
+        let mask = |field: crate::multiboot2::ColorField| ChannelMask::new(field.position, field.size);
+
+        Ok(FramebufferInfo {
+            address: virt_address,
+            width: tag.width,
+            height: tag.height,
+            pitch: tag.pitch,
+            bpp: tag.bpp,
+            format: PixelFormat { bits_per_pixel: tag.bpp, red: mask(red), green: mask(green), blue: mask(blue) },
+        })
+    }
+}
+
+/// 🚀 Mapeia o framebuffer configurado pelo firmware (Write-Combining) e cria o `DISPLAY`.
+/// * Chamado do kernel_main, após o Paging. Funciona em qualquer modo que o
+///   firmware tenha escolhido, desde que o formato tenha um kernel de pixel.
+pub fn init_boot_display(tag: Option<FramebufferTag>) -> Result<(), DisplayError> {
+    let tag = tag.ok_or(DisplayError::FramebufferNotFound)?;
+    if tag.phys_addr == 0 || tag.size() == 0 {
+        return Err(DisplayError::InvalidMmio);
+    }
+
+    let virt = paging::map_mmio_region(PhysAddr::new(tag.phys_addr), tag.size(), CacheMode::WriteCombining)
+        .map_err(|_| DisplayError::InvalidMmio)?;
+    let info = FramebufferInfo::from_boot_tag(&tag, virt.as_u64() as usize)?;
+
+    // # SAFETY: `virt` mapeia exatamente `pitch * height` bytes do framebuffer.
+    let mut driver = unsafe { DisplayDriver::new(info)? };
+    driver.initialize()?;
+    DISPLAY.call_once(|| Mutex::new(driver));
+    Ok(())
 }
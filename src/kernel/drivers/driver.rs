@@ -0,0 +1,49 @@
+// src/kernel/drivers/driver.rs
+
+//! Modelo Unificado de Drivers do LightOS.
+//!
+//! Todo driver de dispositivo segue o mesmo ciclo de vida:
+//! * `probe`: constrói o driver a partir do recurso do dispositivo (função PCI,
+//!   janela de MMIO) e confirma a presença do hardware.
+//! * `init`: programa o dispositivo; chamado de novo, não refaz nada.
+//! * `irq`: top half, em contexto de interrupção (reconhece o dispositivo).
+//! * `suspend`/`resume`: para DMA e interrupções, e volta ao estado de `init`.
+//!
+//! Os registradores de MMIO são acessados por blocos tipados (`drivers::mmio`).
+
+use core::fmt::Debug;
+
+use crate::interrupts::threaded::IrqReturn;
+
+/// 🚗 Ciclo de vida de um driver de dispositivo.
+pub trait Driver: Sized {
+    /// Recurso de onde o driver é construído (ex: `PciDevice`, `Mmio<Bloco>`).
+    type Resource;
+    type Error: Debug;
+
+    /// Nome curto (logs).
+    const NAME: &'static str;
+
+    /// 🔍 Constrói o driver e confirma a presença do hardware.
+    fn probe(resource: Self::Resource) -> Result<Self, Self::Error>;
+
+    /// ⚙️ Programa o dispositivo.
+    fn init(&mut self) -> Result<(), Self::Error>;
+
+    /// 💤 Para DMA e interrupções. Padrão: nada a parar.
+    fn suspend(&mut self) -> Result<(), Self::Error> {
+        Ok(())
+    }
+
+    /// ⏯️ Volta do `suspend`. Padrão: `init` de novo.
+    fn resume(&mut self) -> Result<(), Self::Error> {
+        self.init()
+    }
+
+    /// ⚡ Top half: reconhece a interrupção no dispositivo.
+    /// * `&self`: o MMIO já é mutável por dentro, e o driver pode estar
+    ///   compartilhado com leitores fora da interrupção.
+    fn irq(&self) -> IrqReturn {
+        IrqReturn::None
+    }
+}
@@ -0,0 +1,359 @@
+// src/kernel/drivers/font.rs
+
+//! Fontes Bitmap do LightOS (PSF1, PSF2 e BDF).
+//!
+//! Todas as fontes são monoespaçadas: cada glifo ocupa uma célula
+//! `width` x `height`, armazenada com 1 bit por pixel (MSB à esquerda) e
+//! `bytes_per_row` bytes por linha.
+//! * PSF1/PSF2 são usadas diretamente da memória onde foram carregadas (zero cópia).
+//! * BDF (texto) é convertida para o mesmo layout na carga.
+//!
+//! A fonte do sistema vem de um módulo do Multiboot2 (`module2 /boot/font.psf font`).
+
+use alloc::borrow::Cow;
+use alloc::boxed::Box;
+use alloc::collections::BTreeMap;
+use alloc::vec::Vec;
+use spin::Once;
+
+use crate::multiboot2::BootInfo;
+
+const PSF1_MAGIC: [u8; 2] = [0x36, 0x04];
+const PSF1_MODE_512: u8 = 0x01;
+const PSF1_MODE_HASTAB: u8 = 0x02;
+const PSF1_MODE_SEQ: u8 = 0x04;
+const PSF1_SEPARATOR: u16 = 0xFFFF;
+const PSF1_START_SEQ: u16 = 0xFFFE;
+
+const PSF2_MAGIC: [u8; 4] = [0x72, 0xB5, 0x4A, 0x86];
+const PSF2_HAS_UNICODE_TABLE: u32 = 0x01;
+const PSF2_SEPARATOR: u8 = 0xFF;
+const PSF2_START_SEQ: u8 = 0xFE;
+
+/// Maior célula aceita (pixels), para limitar o cache de glifos.
+pub const MAX_GLYPH_DIMENSION: u32 = 64;
+
+/// 🚨 Erros de carga de fonte.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum FontError {
+    /// Assinatura desconhecida (nem PSF1, nem PSF2, nem BDF).
+    InvalidMagic,
+    /// Dados terminam antes do que o cabeçalho declara.
+    Truncated,
+    /// Célula vazia ou acima de `MAX_GLYPH_DIMENSION`.
+    InvalidGlyphSize,
+    /// Arquivo BDF malformado.
+    ParseError,
+}
+
+/// 🔤 Uma fonte bitmap monoespaçada.
+pub struct BitmapFont {
+    width: u32,
+    height: u32,
+    bytes_per_row: usize,
+    bytes_per_glyph: usize,
+    glyph_count: u32,
+    glyphs: Cow<'static, [u8]>,
+    /// Código → glifo para U+0000..U+00FF (acesso direto, o caso comum).
+    latin1: [u32; 256],
+    /// Código → glifo para o resto do Unicode.
+    unicode: BTreeMap<u32, u32>,
+    /// Glifo usado para caracteres ausentes (`?`, ou o glifo 0).
+    fallback: u32,
+}
+
+/// Marca "sem glifo" em `latin1`.
+const NO_GLYPH: u32 = u32::MAX;
+
+impl BitmapFont {
+    fn with_glyphs(width: u32, height: u32, glyph_count: u32, glyphs: Cow<'static, [u8]>) -> Result<Self, FontError> {
+        if width == 0 || height == 0 || width > MAX_GLYPH_DIMENSION || height > MAX_GLYPH_DIMENSION || glyph_count == 0 {
+            return Err(FontError::InvalidGlyphSize);
+        }
+        let bytes_per_row = ((width + 7) / 8) as usize;
+        let bytes_per_glyph = bytes_per_row * height as usize;
+        if glyphs.len() < bytes_per_glyph * glyph_count as usize {
+            return Err(FontError::Truncated);
+        }
+        Ok(BitmapFont {
+            width,
+            height,
+            bytes_per_row,
+            bytes_per_glyph,
+            glyph_count,
+            glyphs,
+            latin1: [NO_GLYPH; 256],
+            unicode: BTreeMap::new(),
+            fallback: 0,
+        })
+    }
+
+    fn map(&mut self, codepoint: u32, glyph: u32) {
+        if glyph >= self.glyph_count {
+            return;
+        }
+        match self.latin1.get_mut(codepoint as usize) {
+            Some(slot) => *slot = glyph,
+            None => {
+                self.unicode.insert(codepoint, glyph);
+            }
+        }
+    }
+
+    /// Sem tabela Unicode, o índice do glifo é o código do caractere.
+    fn map_identity(&mut self) {
+        for glyph in 0..self.glyph_count {
+            self.map(glyph, glyph);
+        }
+    }
+
+    fn finish(mut self) -> Self {
+        self.fallback = self.lookup('?' as u32).unwrap_or(0);
+        self
+    }
+
+    /// 🏭 Carrega uma fonte PSF1 ou PSF2 (detectada pela assinatura), sem copiar os glifos.
+    pub fn from_psf(data: &'static [u8]) -> Result<Self, FontError> {
+        if data.starts_with(&PSF2_MAGIC) {
+            Self::from_psf2(data)
+        } else if data.starts_with(&PSF1_MAGIC) {
+            Self::from_psf1(data)
+        } else {
+            Err(FontError::InvalidMagic)
+        }
+    }
+
+    fn from_psf1(data: &'static [u8]) -> Result<Self, FontError> {
+        let (mode, height) = (*data.get(2).ok_or(FontError::Truncated)?, *data.get(3).ok_or(FontError::Truncated)?);
+        let count: u32 = if mode & PSF1_MODE_512 != 0 { 512 } else { 256 };
+        let glyphs_end = 4 + count as usize * height as usize;
+        let glyphs = data.get(4..glyphs_end).ok_or(FontError::Truncated)?;
+        let mut font = Self::with_glyphs(8, height as u32, count, Cow::Borrowed(glyphs))?;
+
+        if mode & (PSF1_MODE_HASTAB | PSF1_MODE_SEQ) == 0 {
+            font.map_identity();
+            return Ok(font.finish());
+        }
+
+        // Tabela: para cada glifo, códigos UCS-2 até 0xFFFF; após 0xFFFE vêm
+        // sequências (combinações), que não são suportadas e são ignoradas.
+        let mut glyph = 0;
+        let mut in_sequence = false;
+        for entry in data[glyphs_end..].chunks_exact(2) {
+            match u16::from_le_bytes([entry[0], entry[1]]) {
+                PSF1_SEPARATOR => {
+                    glyph += 1;
+                    in_sequence = false;
+                }
+                PSF1_START_SEQ => in_sequence = true,
+                code if !in_sequence => font.map(code as u32, glyph),
+                _ => {}
+            }
+        }
+        Ok(font.finish())
+    }
+
+    fn from_psf2(data: &'static [u8]) -> Result<Self, FontError> {
+        let field = |index: usize| -> Result<u32, FontError> {
+            let bytes = data.get(4 * index..4 * index + 4).ok_or(FontError::Truncated)?;
+            Ok(u32::from_le_bytes([bytes[0], bytes[1], bytes[2], bytes[3]]))
+        };
+        let (header_size, flags, count, glyph_size, height, width) =
+            (field(2)? as usize, field(3)?, field(4)?, field(5)? as usize, field(6)?, field(7)?);
+        if glyph_size != ((width as usize + 7) / 8) * height as usize {
+            return Err(FontError::InvalidGlyphSize);
+        }
+        let glyphs_end = header_size + count as usize * glyph_size;
+        let glyphs = data.get(header_size..glyphs_end).ok_or(FontError::Truncated)?;
+        let mut font = Self::with_glyphs(width, height, count, Cow::Borrowed(glyphs))?;
+
+        if flags & PSF2_HAS_UNICODE_TABLE == 0 {
+            font.map_identity();
+            return Ok(font.finish());
+        }
+
+        // Tabela: para cada glifo, caracteres UTF-8 até 0xFF; após 0xFE vêm sequências.
+        let table = &data[glyphs_end..];
+        for (glyph, entry) in table.split(|&b| b == PSF2_SEPARATOR).enumerate().take(count as usize) {
+            let singles = entry.split(|&b| b == PSF2_START_SEQ).next().unwrap_or(&[]);
+            if let Ok(text) = core::str::from_utf8(singles) {
+                for ch in text.chars() {
+                    font.map(ch as u32, glyph as u32);
+                }
+            }
+        }
+        Ok(font.finish())
+    }
+
+    /// 🏭 Carrega uma fonte BDF (texto), convertendo cada glifo para a célula
+    /// do `FONTBOUNDINGBOX`.
+    pub fn from_bdf(text: &str) -> Result<Self, FontError> {
+        let numbers = |rest: &str| -> Vec<i32> { rest.split_whitespace().filter_map(|n| n.parse().ok()).collect() };
+
+        let mut lines = text.lines().map(str::trim);
+        if !lines.next().map_or(false, |l| l.starts_with("STARTFONT")) {
+            return Err(FontError::InvalidMagic);
+        }
+
+        let mut cell: Option<(i32, i32, i32, i32)> = None;
+        let mut glyphs: Vec<u8> = Vec::new();
+        let mut codes: Vec<u32> = Vec::new();
+        let (mut encoding, mut bbx) = (-1i32, (0i32, 0i32, 0i32, 0i32));
+
+        while let Some(line) = lines.next() {
+            let (keyword, rest) = line.split_once(' ').unwrap_or((line, ""));
+            match keyword {
+                "FONTBOUNDINGBOX" => match numbers(rest)[..] {
+                    [w, h, x, y] => cell = Some((w, h, x, y)),
+                    _ => return Err(FontError::ParseError),
+                },
+                "ENCODING" => encoding = numbers(rest).first().copied().unwrap_or(-1),
+                "BBX" => match numbers(rest)[..] {
+                    [w, h, x, y] => bbx = (w, h, x, y),
+                    _ => return Err(FontError::ParseError),
+                },
+                "BITMAP" => {
+                    let (cell_w, cell_h, cell_x, cell_y) = cell.ok_or(FontError::ParseError)?;
+                    if cell_w <= 0 || cell_h <= 0 || cell_w as u32 > MAX_GLYPH_DIMENSION || cell_h as u32 > MAX_GLYPH_DIMENSION {
+                        return Err(FontError::InvalidGlyphSize);
+                    }
+                    let row_bytes = ((cell_w + 7) / 8) as usize;
+                    let base = glyphs.len();
+                    glyphs.resize(base + row_bytes * cell_h as usize, 0);
+
+                    // Posição do BBX do glifo dentro da célula (linha 0 = topo).
+                    let (w, h, x, y) = bbx;
+                    let top = (cell_h + cell_y) - (h + y);
+                    let left = x - cell_x;
+                    for row in 0..h {
+                        let hex = lines.next().ok_or(FontError::ParseError)?;
+                        let bits = u64::from_str_radix(hex, 16).map_err(|_| FontError::ParseError)?;
+                        let width_bits = hex.len() as i32 * 4;
+                        for col in 0..w.min(width_bits) {
+                            let (cy, cx) = (top + row, left + col);
+                            if bits >> (width_bits - 1 - col) & 1 == 0 || cy < 0 || cy >= cell_h || cx < 0 || cx >= cell_w {
+                                continue;
+                            }
+                            glyphs[base + cy as usize * row_bytes + cx as usize / 8] |= 0x80 >> (cx % 8);
+                        }
+                    }
+                    codes.push(encoding as u32);
+                }
+                "ENDCHAR" => {
+                    encoding = -1;
+                    bbx = (0, 0, 0, 0);
+                }
+                _ => {}
+            }
+        }
+
+        let (cell_w, cell_h, _, _) = cell.ok_or(FontError::ParseError)?;
+        let mut font = Self::with_glyphs(cell_w as u32, cell_h as u32, codes.len() as u32, Cow::Owned(glyphs))?;
+        for (glyph, &code) in codes.iter().enumerate() {
+            // ENCODING -1: glifo sem código padrão, acessível só pelo índice.
+            if code != u32::MAX {
+                font.map(code, glyph as u32);
+            }
+        }
+        Ok(font.finish())
+    }
+
+    /// Largura da célula em pixels.
+    pub fn width(&self) -> u32 {
+        self.width
+    }
+
+    /// Altura da célula em pixels.
+    pub fn height(&self) -> u32 {
+        self.height
+    }
+
+    /// Número de glifos.
+    pub fn glyph_count(&self) -> u32 {
+        self.glyph_count
+    }
+
+    fn lookup(&self, codepoint: u32) -> Option<u32> {
+        match self.latin1.get(codepoint as usize) {
+            Some(&NO_GLYPH) => None,
+            Some(&glyph) => Some(glyph),
+            None => self.unicode.get(&codepoint).copied(),
+        }
+    }
+
+    /// 🔍 Índice do glifo de `ch` (o glifo de fallback se a fonte não o tiver).
+    #[inline]
+    pub fn glyph_index(&self, ch: char) -> u32 {
+        self.lookup(ch as u32).unwrap_or(self.fallback)
+    }
+
+    /// Bits do glifo `index`: `height` linhas de `bytes_per_row` bytes.
+    pub fn glyph_bits(&self, index: u32) -> &[u8] {
+        let start = index.min(self.glyph_count - 1) as usize * self.bytes_per_glyph;
+        &self.glyphs[start..start + self.bytes_per_glyph]
+    }
+}
+
+// ------------------------------------------------------------------------
+// --- Cache de Glifos ---
+// ------------------------------------------------------------------------
+
+/// 🗃️ Glifos expandidos para cobertura de 8 bits (0 ou 255 por pixel).
+/// * A expansão bit → byte acontece uma vez por glifo; o renderizador só
+///   combina a cobertura com a cor do texto.
+pub struct GlyphCache {
+    width: u32,
+    height: u32,
+    glyphs: Vec<Option<Box<[u8]>>>,
+}
+
+impl GlyphCache {
+    /// 🏭 Cria um cache vazio para `font`.
+    pub fn new(font: &BitmapFont) -> Self {
+        let mut glyphs = Vec::new();
+        glyphs.resize_with(font.glyph_count() as usize, || None);
+        GlyphCache { width: font.width(), height: font.height(), glyphs }
+    }
+
+    /// 🔍 Cobertura do glifo `index` (`width * height` bytes, linha a linha).
+    pub fn coverage(&mut self, font: &BitmapFont, index: u32) -> &[u8] {
+        let (width, height) = (self.width as usize, self.height as usize);
+        let slot = &mut self.glyphs[index.min(font.glyph_count() - 1) as usize];
+        slot.get_or_insert_with(|| {
+            let bits = font.glyph_bits(index);
+            let row_bytes = (width + 7) / 8;
+            let mut coverage = alloc::vec![0u8; width * height].into_boxed_slice();
+            for y in 0..height {
+                for x in 0..width {
+                    if bits[y * row_bytes + x / 8] & (0x80 >> (x % 8)) != 0 {
+                        coverage[y * width + x] = 0xFF;
+                    }
+                }
+            }
+            coverage
+        })
+    }
+}
+
+// ------------------------------------------------------------------------
+// --- Fonte do Sistema ---
+// ------------------------------------------------------------------------
+
+/// 🌐 Fonte usada pelo console gráfico e pela UI.
+pub static SYSTEM_FONT: Once<BitmapFont> = Once::new();
+
+/// 🚀 Carrega a fonte do sistema do primeiro módulo de boot que seja PSF
+/// (preferindo um com `font` na linha de comando).
+pub fn load_boot_font(boot_info: &BootInfo) -> Result<&'static BitmapFont, FontError> {
+    let mut result = Err(FontError::InvalidMagic);
+    let preferred = boot_info.modules().filter(|m| m.cmdline.contains("font"));
+    for module in preferred.chain(boot_info.modules()) {
+        result = BitmapFont::from_psf(module.data());
+        if result.is_ok() {
+            break;
+        }
+    }
+    let font = result?;
+    crate::println!("INFO: Fonte do sistema: {}x{}, {} glifos.", font.width(), font.height(), font.glyph_count());
+    Ok(SYSTEM_FONT.call_once(|| font))
+}
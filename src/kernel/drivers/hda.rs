@@ -0,0 +1,619 @@
+// src/kernel/drivers/hda.rs
+
+//! Controlador Intel High Definition Audio (HDA) do LightOS.
+//!
+//! Implementa `Driver` e `SoundDevice` para o pipeline de `audio`:
+//! * O controlador é encontrado no PCI (classe 0x04, subclasse 0x03) e o BAR0
+//!   é mapeado sem cache, acessado pelos blocos tipados `HdaRegs`/`StreamRegs`.
+//! * Os verbos dos codecs trafegam pelos anéis CORB/RIRB (com polling).
+//! * O caminho de saída (pino → mixers/seletores → DAC) é descoberto a partir da
+//!   configuração padrão dos pinos, e o formato é negociado com as taxas e
+//!   tamanhos de amostra suportados pelo DAC.
+//! * O primeiro stream de saída toca o `PeriodRing` em laço: a BDL do anel é
+//!   exatamente a BDL do HDA, e o IOC de cada entrada gera a interrupção.
+
+use core::ptr;
+use x86_64::PhysAddr;
+
+use super::audio::{AudioFormat, PeriodRing, SoundDevice, BDL_ENTRY_SIZE};
+use super::driver::Driver;
+use super::mmio::{register_block, Mmio};
+use super::pci::{PciDevice, PciMatch};
+use super::sound::SoundError;
+use crate::interrupts::{self, apic, dispatch, threaded::IrqReturn};
+use crate::memory::dma::DmaBuffer;
+use crate::memory::paging::CacheMode;
+
+/// Classe/subclasse PCI de um controlador HDA.
+const PCI_CLASS_MULTIMEDIA: u8 = 0x04;
+const PCI_SUBCLASS_HDA: u8 = 0x03;
+
+// ------------------------------------------------------------------------
+// --- Registradores do Controlador ---
+// ------------------------------------------------------------------------
+
+/// Descritores de stream: 0x20 bytes cada, a partir de 0x80 (entradas primeiro).
+const STREAM_BASE: usize = 0x80;
+const STREAM_STRIDE: usize = 0x20;
+/// Descritores possíveis (GCAP: até 15 de entrada, 15 de saída).
+const MAX_STREAMS: usize = 30;
+
+register_block! {
+    /// Registradores globais do controlador (BAR0).
+    pub struct HdaRegs[STREAM_BASE + MAX_STREAMS * STREAM_STRIDE] {
+        GCAP: u16 = 0x00,
+        GCTL: u32 = 0x08,
+        STATESTS: u16 = 0x0E,
+        INTCTL: u32 = 0x20,
+        CORBLBASE: u32 = 0x40,
+        CORBUBASE: u32 = 0x44,
+        CORBWP: u16 = 0x48,
+        CORBRP: u16 = 0x4A,
+        CORBCTL: u8 = 0x4C,
+        CORBSIZE: u8 = 0x4E,
+        RIRBLBASE: u32 = 0x50,
+        RIRBUBASE: u32 = 0x54,
+        RIRBWP: u16 = 0x58,
+        RINTCNT: u16 = 0x5A,
+        RIRBCTL: u8 = 0x5C,
+        RIRBSIZE: u8 = 0x5E,
+    }
+}
+
+register_block! {
+    /// Um descritor de stream.
+    pub struct StreamRegs[STREAM_STRIDE] {
+        CTL: u8 = 0x00,
+        CTL_TAG: u8 = 0x02,
+        STS: u8 = 0x03,
+        LPIB: u32 = 0x04,
+        CBL: u32 = 0x08,
+        LVI: u16 = 0x0C,
+        FMT: u16 = 0x12,
+        BDPL: u32 = 0x18,
+        BDPU: u32 = 0x1C,
+    }
+}
+
+const GCTL_CRST: u32 = 1 << 0;
+/// GCAP.64OK: o controlador aceita endereços de DMA de 64 bits.
+const GCAP_64OK: u16 = 1 << 0;
+/// Sem 64OK, todo endereço de DMA precisa ficar abaixo de 4 GiB.
+const DMA_32BIT_LIMIT: u64 = 1 << 32;
+const INTCTL_GIE: u32 = 1 << 31;
+/// Bit 15 dos ponteiros de leitura/escrita dos anéis: reset do ponteiro.
+const RING_PTR_RESET: u16 = 1 << 15;
+const RING_DMA_RUN: u8 = 1 << 1;
+/// Tamanho 256 entradas nos registradores CORBSIZE/RIRBSIZE.
+const RING_SIZE_256: u8 = 0x2;
+const CORB_ENTRIES: usize = 256;
+const RIRB_ENTRIES: usize = 256;
+
+const SD_CTL_SRST: u8 = 1 << 0;
+const SD_CTL_RUN: u8 = 1 << 1;
+const SD_CTL_IOCE: u8 = 1 << 2;
+/// Buffer Completion Interrupt Status (escrever 1 limpa).
+const SD_STS_BCIS: u8 = 1 << 2;
+/// Tag do stream usada pelo DAC (1-15; 0 é reservado).
+const STREAM_TAG: u8 = 1;
+
+/// Iterações máximas de polling (reset, anéis, respostas).
+const SPIN_LIMIT: usize = 1_000_000;
+
+// ------------------------------------------------------------------------
+// --- Verbos e Parâmetros dos Codecs ---
+// ------------------------------------------------------------------------
+
+const VERB_GET_PARAMETER: u32 = 0xF00;
+const VERB_GET_CONNECTION_LIST: u32 = 0xF02;
+const VERB_GET_CONFIG_DEFAULT: u32 = 0xF1C;
+const VERB_SET_CONNECTION_SELECT: u32 = 0x701;
+const VERB_SET_POWER_STATE: u32 = 0x705;
+const VERB_SET_CHANNEL_STREAMID: u32 = 0x706;
+const VERB_SET_PIN_WIDGET_CONTROL: u32 = 0x707;
+const VERB_SET_EAPD: u32 = 0x70C;
+/// Verbos de 4 bits (carga de 16 bits).
+const VERB_SET_STREAM_FORMAT: u32 = 0x2;
+const VERB_SET_AMP_GAIN_MUTE: u32 = 0x3;
+
+const PARAM_NODE_COUNT: u32 = 0x04;
+const PARAM_FUNCTION_TYPE: u32 = 0x05;
+const PARAM_WIDGET_CAPS: u32 = 0x09;
+const PARAM_PCM_FORMATS: u32 = 0x0A;
+const PARAM_PIN_CAPS: u32 = 0x0C;
+const PARAM_CONNECTION_LENGTH: u32 = 0x0E;
+const PARAM_OUTPUT_AMP_CAPS: u32 = 0x12;
+
+const FUNCTION_GROUP_AUDIO: u32 = 0x01;
+const WIDGET_OUTPUT: u32 = 0x0;
+const WIDGET_MIXER: u32 = 0x2;
+const WIDGET_SELECTOR: u32 = 0x3;
+const WIDGET_PIN: u32 = 0x4;
+const PIN_CAP_OUTPUT: u32 = 1 << 4;
+const PIN_CAP_EAPD: u32 = 1 << 16;
+const PIN_CTL_OUT_ENABLE: u32 = 0x40;
+const PIN_CTL_HP_ENABLE: u32 = 0x80;
+/// Amplificador de saída, canais esquerdo e direito.
+const AMP_SET_OUTPUT_BOTH: u32 = 0xB000;
+
+/// Taxas indicadas pelos bits 0-11 de `PARAM_PCM_FORMATS`.
+const SUPPORTED_RATES: [u32; 12] =
+    [8_000, 11_025, 16_000, 22_050, 32_000, 44_100, 48_000, 88_200, 96_000, 176_400, 192_000, 384_000];
+/// Bits de `PARAM_PCM_FORMATS` para amostras de 16 e 32 bits (as que o pipeline
+/// representa sem contêiner: 20/24 bits ocupariam 32 bits na memória).
+const PCM_16BIT: u32 = 1 << 17;
+const PCM_32BIT: u32 = 1 << 20;
+
+/// Dispositivo padrão (bits 23:20 da configuração do pino).
+const DEFAULT_DEVICE_LINE_OUT: u32 = 0x0;
+const DEFAULT_DEVICE_SPEAKER: u32 = 0x1;
+const DEFAULT_DEVICE_HP_OUT: u32 = 0x2;
+/// Conectividade "sem conexão física" (bits 31:30).
+const PORT_CONNECTIVITY_NONE: u32 = 0x1;
+
+/// Profundidade máxima do percurso pino → DAC.
+const MAX_PATH_DEPTH: usize = 4;
+
+// ------------------------------------------------------------------------
+// --- Controlador ---
+// ------------------------------------------------------------------------
+
+/// 🎧 Caminho de saída escolhido no codec.
+#[derive(Debug, Clone, Copy)]
+struct OutputPath {
+    dac: u8,
+    pin: Option<u8>,
+}
+
+/// 🔊 Um controlador HDA com um codec e um stream de saída.
+pub struct HdaController {
+    device: PciDevice,
+    regs: Mmio<HdaRegs>,
+    /// Descritor do stream de saída (`stream`).
+    stream_regs: Mmio<StreamRegs>,
+    /// CORB (1 KiB) seguido da RIRB (2 KiB).
+    rings: DmaBuffer,
+    corb_wp: u16,
+    rirb_rp: u16,
+    codec: u8,
+    afg: u8,
+    path: OutputPath,
+    /// Índice do primeiro descritor de stream de saída.
+    stream: usize,
+    /// GCAP.64OK (senão, DMA só abaixo de 4 GiB).
+    dma64: bool,
+    format: AudioFormat,
+    format_bits: u16,
+}
+
+/// 🔍 Funções PCI atendidas pelo driver (qualquer controlador HDA).
+pub const PCI_MATCHES: &[PciMatch] = &[PciMatch::class(PCI_CLASS_MULTIMEDIA, PCI_SUBCLASS_HDA)];
+
+impl HdaController {
+    /// ⚡ Configura a interrupção do controlador e retorna o vetor.
+    /// * Com o x2APIC ativo: MSI em um vetor dinâmico.
+    /// * Sem ele: a linha INTx, se for uma IRQ ISA roteada.
+    pub fn setup_interrupt(&self) -> Result<u8, SoundError> {
+        if apic::is_active() {
+            let vector = dispatch::allocate_vector().map_err(|_| SoundError::InitializationFailed)?;
+            let enabled = apic::msi_message(vector, apic::LocalApic::id())
+                .map_or(false, |message| self.device.enable_msi(message).is_ok());
+            if enabled {
+                return Ok(vector);
+            }
+            // Sem MSI: o vetor volta para a faixa dinâmica e a INTx é usada.
+            dispatch::free_vector(vector);
+        }
+        // INTx: nível no IO-APIC, mascarada até o `audio::start` desmascarar.
+        interrupts::route_pci_intx(self.device.interrupt_line).ok_or(SoundError::InitializationFailed)
+    }
+
+    /// 📏 Confere que `len` bytes de DMA em `addr` são alcançáveis pelo
+    /// controlador (abaixo de 4 GiB sem GCAP.64OK).
+    fn check_dma(&self, addr: PhysAddr, len: usize) -> Result<u64, SoundError> {
+        let addr = addr.as_u64();
+        if !self.dma64 && addr + len as u64 > DMA_32BIT_LIMIT {
+            crate::println!("WARN: HDA: DMA em {:#x} fora do alcance de 32 bits do controlador.", addr);
+            return Err(SoundError::OutOfMemory);
+        }
+        Ok(addr)
+    }
+
+    /// Espera `done` ficar verdadeiro (no máximo `SPIN_LIMIT` iterações).
+    fn wait(&self, mut done: impl FnMut(&Self) -> bool) -> Result<(), SoundError> {
+        for _ in 0..SPIN_LIMIT {
+            if done(self) {
+                return Ok(());
+            }
+            core::hint::spin_loop();
+        }
+        Err(SoundError::HardwareError)
+    }
+
+    // --- Inicialização do Controlador ---
+
+    /// 🔄 Reset do controlador (CRST 0 → 1) e espera a enumeração dos codecs.
+    fn reset(&mut self) -> Result<(), SoundError> {
+        self.regs.clear_bits(HdaRegs::GCTL, GCTL_CRST);
+        self.wait(|hda| hda.regs.read(HdaRegs::GCTL) & GCTL_CRST == 0)?;
+        self.regs.set_bits(HdaRegs::GCTL, GCTL_CRST);
+        self.wait(|hda| hda.regs.read(HdaRegs::GCTL) & GCTL_CRST != 0)?;
+        // Os codecs se anunciam em STATESTS até 521 µs após o reset.
+        let _ = self.wait(|hda| hda.regs.read(HdaRegs::STATESTS) != 0);
+        Ok(())
+    }
+
+    /// 📨 Programa e liga os anéis CORB/RIRB (256 entradas cada).
+    fn setup_rings(&mut self) -> Result<(), SoundError> {
+        let corb = self.check_dma(self.rings.phys_addr(), self.rings.len())?;
+        let rirb = corb + (CORB_ENTRIES * 4) as u64;
+
+        self.regs.write(HdaRegs::CORBCTL, 0);
+        self.regs.write(HdaRegs::RIRBCTL, 0);
+        self.wait(|hda| hda.regs.read(HdaRegs::CORBCTL) & RING_DMA_RUN == 0 && hda.regs.read(HdaRegs::RIRBCTL) & RING_DMA_RUN == 0)?;
+
+        self.regs.write(HdaRegs::CORBLBASE, corb as u32);
+        self.regs.write(HdaRegs::CORBUBASE, (corb >> 32) as u32);
+        self.regs.write(HdaRegs::CORBSIZE, RING_SIZE_256);
+        // Reset do ponteiro de leitura; alguns controladores não ecoam o bit, então
+        // a confirmação é opcional.
+        self.regs.write(HdaRegs::CORBRP, RING_PTR_RESET);
+        let _ = self.wait(|hda| hda.regs.read(HdaRegs::CORBRP) & RING_PTR_RESET != 0);
+        self.regs.write(HdaRegs::CORBRP, 0);
+        let _ = self.wait(|hda| hda.regs.read(HdaRegs::CORBRP) & RING_PTR_RESET == 0);
+        self.regs.write(HdaRegs::CORBWP, 0);
+        self.corb_wp = 0;
+
+        self.regs.write(HdaRegs::RIRBLBASE, rirb as u32);
+        self.regs.write(HdaRegs::RIRBUBASE, (rirb >> 32) as u32);
+        self.regs.write(HdaRegs::RIRBSIZE, RING_SIZE_256);
+        self.regs.write(HdaRegs::RIRBWP, RING_PTR_RESET);
+        self.regs.write(HdaRegs::RINTCNT, 1);
+        self.rirb_rp = 0;
+
+        self.regs.write(HdaRegs::CORBCTL, RING_DMA_RUN);
+        self.regs.write(HdaRegs::RIRBCTL, RING_DMA_RUN);
+        Ok(())
+    }
+
+    // --- Verbos ---
+
+    /// 📤 Envia um verbo de 12 bits (carga de 8 bits) e espera a resposta.
+    fn verb(&mut self, nid: u8, verb: u32, payload: u8) -> Result<u32, SoundError> {
+        self.command((self.codec as u32) << 28 | (nid as u32) << 20 | verb << 8 | payload as u32)
+    }
+
+    /// 📤 Envia um verbo de 4 bits (carga de 16 bits) e espera a resposta.
+    fn verb16(&mut self, nid: u8, verb: u32, payload: u16) -> Result<u32, SoundError> {
+        self.command((self.codec as u32) << 28 | (nid as u32) << 20 | verb << 16 | payload as u32)
+    }
+
+    fn parameter(&mut self, nid: u8, param: u32) -> Result<u32, SoundError> {
+        self.verb(nid, VERB_GET_PARAMETER, param as u8)
+    }
+
+    /// Coloca `command` no CORB e lê a resposta correspondente da RIRB.
+    fn command(&mut self, command: u32) -> Result<u32, SoundError> {
+        let slot = (self.corb_wp as usize + 1) % CORB_ENTRIES;
+        // # SAFETY: `slot` < 256: dentro do CORB.
+        unsafe { ptr::write_volatile((self.rings.as_mut_ptr() as *mut u32).add(slot), command) };
+        self.corb_wp = slot as u16;
+        self.regs.write(HdaRegs::CORBWP, self.corb_wp);
+
+        let expected = (self.rirb_rp as usize + 1) % RIRB_ENTRIES;
+        self.wait(|hda| hda.regs.read(HdaRegs::RIRBWP) as usize % RIRB_ENTRIES == expected)?;
+        self.rirb_rp = expected as u16;
+        // # SAFETY: A RIRB começa após o CORB; entradas de 8 bytes (resposta, info).
+        let response = unsafe {
+            let rirb = self.rings.as_mut_ptr().add(CORB_ENTRIES * 4) as *const u32;
+            ptr::read_volatile(rirb.add(expected * 2))
+        };
+        Ok(response)
+    }
+
+    // --- Descoberta do Codec ---
+
+    /// Nós filhos de `nid`: (primeiro, quantidade).
+    fn sub_nodes(&mut self, nid: u8) -> Result<(u8, u8), SoundError> {
+        let count = self.parameter(nid, PARAM_NODE_COUNT)?;
+        Ok(((count >> 16) as u8, count as u8))
+    }
+
+    fn find_audio_function_group(&mut self) -> Result<u8, SoundError> {
+        let (start, count) = self.sub_nodes(0)?;
+        for nid in start..start.saturating_add(count) {
+            if self.parameter(nid, PARAM_FUNCTION_TYPE)? & 0xFF == FUNCTION_GROUP_AUDIO {
+                return Ok(nid);
+            }
+        }
+        Err(SoundError::DeviceNotFound)
+    }
+
+    fn widget_type(&mut self, nid: u8) -> Result<u32, SoundError> {
+        Ok((self.parameter(nid, PARAM_WIDGET_CAPS)? >> 20) & 0xF)
+    }
+
+    /// Primeira entrada da lista de conexões de `nid` (forma curta).
+    fn first_connection(&mut self, nid: u8) -> Result<Option<u8>, SoundError> {
+        if self.parameter(nid, PARAM_CONNECTION_LENGTH)? & 0x7F == 0 {
+            return Ok(None);
+        }
+        let entries = self.verb(nid, VERB_GET_CONNECTION_LIST, 0)?;
+        self.verb(nid, VERB_SET_CONNECTION_SELECT, 0)?;
+        Ok(Some(entries as u8))
+    }
+
+    /// 🧭 Pino de saída conectado (alto-falante, fone ou line out) e o DAC que o alimenta.
+    /// * Sem pino utilizável, usa o primeiro DAC do grupo.
+    fn find_output_path(&mut self) -> Result<OutputPath, SoundError> {
+        let (start, count) = self.sub_nodes(self.afg)?;
+        let mut first_dac = None;
+
+        for nid in start..start.saturating_add(count) {
+            match self.widget_type(nid)? {
+                WIDGET_OUTPUT if first_dac.is_none() => first_dac = Some(nid),
+                WIDGET_PIN => {
+                    let config = self.verb(nid, VERB_GET_CONFIG_DEFAULT, 0)?;
+                    let device = (config >> 20) & 0xF;
+                    let usable = config >> 30 != PORT_CONNECTIVITY_NONE
+                        && matches!(device, DEFAULT_DEVICE_LINE_OUT | DEFAULT_DEVICE_SPEAKER | DEFAULT_DEVICE_HP_OUT)
+                        && self.parameter(nid, PARAM_PIN_CAPS)? & PIN_CAP_OUTPUT != 0;
+                    if !usable {
+                        continue;
+                    }
+                    if let Some(dac) = self.trace_to_dac(nid)? {
+                        return Ok(OutputPath { dac, pin: Some(nid) });
+                    }
+                }
+                _ => {}
+            }
+        }
+        first_dac.map(|dac| OutputPath { dac, pin: None }).ok_or(SoundError::DeviceNotFound)
+    }
+
+    /// Segue a primeira conexão a partir do pino, atravessando mixers/seletores
+    /// (com os amplificadores de saída ligados) até um DAC.
+    fn trace_to_dac(&mut self, pin: u8) -> Result<Option<u8>, SoundError> {
+        let mut node = pin;
+        for _ in 0..MAX_PATH_DEPTH {
+            node = match self.first_connection(node)? {
+                Some(next) => next,
+                None => return Ok(None),
+            };
+            match self.widget_type(node)? {
+                WIDGET_OUTPUT => return Ok(Some(node)),
+                WIDGET_MIXER | WIDGET_SELECTOR => self.unmute_output(node)?,
+                _ => return Ok(None),
+            }
+        }
+        Ok(None)
+    }
+
+    /// Amplificador de saída em 0 dB (o offset indicado pelo codec), sem mute.
+    fn unmute_output(&mut self, nid: u8) -> Result<(), SoundError> {
+        let gain = self.parameter(nid, PARAM_OUTPUT_AMP_CAPS)? & 0x7F;
+        self.verb16(nid, VERB_SET_AMP_GAIN_MUTE, (AMP_SET_OUTPUT_BOTH | gain) as u16)?;
+        Ok(())
+    }
+
+    /// ⚙️ D0 no grupo e no caminho; habilita a saída do pino (e o EAPD, se houver).
+    fn power_up_path(&mut self) -> Result<(), SoundError> {
+        self.verb(self.afg, VERB_SET_POWER_STATE, 0)?;
+        self.verb(self.path.dac, VERB_SET_POWER_STATE, 0)?;
+        self.unmute_output(self.path.dac)?;
+        if let Some(pin) = self.path.pin {
+            self.verb(pin, VERB_SET_POWER_STATE, 0)?;
+            self.verb(pin, VERB_SET_PIN_WIDGET_CONTROL, (PIN_CTL_OUT_ENABLE | PIN_CTL_HP_ENABLE) as u8)?;
+            self.unmute_output(pin)?;
+            if self.parameter(pin, PARAM_PIN_CAPS)? & PIN_CAP_EAPD != 0 {
+                self.verb(pin, VERB_SET_EAPD, 0x2)?;
+            }
+        }
+        Ok(())
+    }
+
+    // --- Stream ---
+
+    /// 🔄 Reset do descritor de stream (SRST 1 → 0).
+    fn reset_stream(&self) -> Result<(), SoundError> {
+        self.stream_regs.write(StreamRegs::CTL, 0);
+        self.wait(|hda| hda.stream_regs.read(StreamRegs::CTL) & SD_CTL_RUN == 0)?;
+        self.stream_regs.write(StreamRegs::CTL, SD_CTL_SRST);
+        self.wait(|hda| hda.stream_regs.read(StreamRegs::CTL) & SD_CTL_SRST != 0)?;
+        self.stream_regs.write(StreamRegs::CTL, 0);
+        self.wait(|hda| hda.stream_regs.read(StreamRegs::CTL) & SD_CTL_SRST == 0)?;
+        // Limpa status pendentes.
+        self.stream_regs.write(StreamRegs::STS, 0xFF);
+        Ok(())
+    }
+}
+
+impl Driver for HdaController {
+    type Resource = PciDevice;
+    type Error = SoundError;
+    const NAME: &'static str = "hda";
+
+    /// 🔍 Mapeia o BAR0, reinicia o controlador e descobre o codec e o caminho de saída.
+    fn probe(device: PciDevice) -> Result<Self, SoundError> {
+        device.enable();
+        let (mmio, len) = device.map_bar(0, CacheMode::Uncached).map_err(|_| SoundError::DeviceNotFound)?;
+        // # SAFETY: `mmio` é o BAR0 mapeado Uncached, com `len` bytes.
+        let regs = unsafe { Mmio::<HdaRegs>::from_region(mmio, len) }.ok_or(SoundError::DeviceNotFound)?;
+        // O primeiro stream de saída vem depois dos de entrada (GCAP.ISS).
+        let gcap = regs.read(HdaRegs::GCAP);
+        let stream = ((gcap >> 8) & 0xF) as usize;
+        let stream_regs = regs.sub_block(STREAM_BASE + stream * STREAM_STRIDE).ok_or(SoundError::DeviceNotFound)?;
+        let rings = DmaBuffer::new(CORB_ENTRIES * 4 + RIRB_ENTRIES * 8).map_err(|_| SoundError::OutOfMemory)?;
+
+        let mut hda = HdaController {
+            device,
+            regs,
+            stream_regs,
+            rings,
+            corb_wp: 0,
+            rirb_rp: 0,
+            codec: 0,
+            afg: 0,
+            path: OutputPath { dac: 0, pin: None },
+            stream,
+            dma64: gcap & GCAP_64OK != 0,
+            format: AudioFormat::DEFAULT,
+            format_bits: 0,
+        };
+        hda.reset()?;
+        hda.setup_rings()?;
+
+        // Primeiro codec presente (um bit por endereço em STATESTS).
+        let present = hda.regs.read(HdaRegs::STATESTS);
+        if present == 0 {
+            return Err(SoundError::DeviceNotFound);
+        }
+        hda.codec = present.trailing_zeros() as u8;
+        hda.afg = hda.find_audio_function_group()?;
+        hda.path = hda.find_output_path()?;
+
+        crate::println!(
+            "INFO: HDA {:04x}:{:04x}, codec {}, DAC {} -> pino {:?}.",
+            hda.device.vendor_id, hda.device.device_id, hda.codec, hda.path.dac, hda.path.pin
+        );
+        Ok(hda)
+    }
+
+    /// ⚙️ Liga o caminho de saída no codec.
+    fn init(&mut self) -> Result<(), SoundError> {
+        self.power_up_path()
+    }
+
+    /// 💤 Para o stream, as interrupções e o DMA dos anéis CORB/RIRB.
+    fn suspend(&mut self) -> Result<(), SoundError> {
+        self.stop();
+        self.regs.clear_bits(HdaRegs::INTCTL, INTCTL_GIE);
+        self.regs.write(HdaRegs::CORBCTL, 0);
+        self.regs.write(HdaRegs::RIRBCTL, 0);
+        self.wait(|hda| {
+            hda.regs.read(HdaRegs::CORBCTL) & RING_DMA_RUN == 0 && hda.regs.read(HdaRegs::RIRBCTL) & RING_DMA_RUN == 0
+        })
+    }
+
+    /// ⏯️ Reset, anéis e caminho de saída de novo; o codec perde o formato no reset.
+    /// * O stream volta a tocar com o próximo `start` do pipeline.
+    fn resume(&mut self) -> Result<(), SoundError> {
+        self.reset()?;
+        self.setup_rings()?;
+        self.init()?;
+        if self.format_bits != 0 {
+            self.verb16(self.path.dac, VERB_SET_STREAM_FORMAT, self.format_bits)?;
+        }
+        Ok(())
+    }
+
+    /// ⚡ Reconhece o fim de buffer (BCIS) do stream de saída.
+    fn irq(&self) -> IrqReturn {
+        if self.stream_regs.read(StreamRegs::STS) & SD_STS_BCIS == 0 {
+            return IrqReturn::None;
+        }
+        self.stream_regs.write(StreamRegs::STS, SD_STS_BCIS);
+        IrqReturn::Handled
+    }
+}
+
+/// 🎚️ Codifica um formato no registrador SDnFMT / verbo SET_STREAM_FORMAT.
+/// * Base 48 kHz ou 44,1 kHz (bit 14), multiplicador (13:11) e divisor (10:8).
+fn encode_format(format: AudioFormat) -> Option<u16> {
+    let (base, mult, div) = match format.sample_rate {
+        8_000 => (0, 1, 6),
+        11_025 => (1, 1, 4),
+        16_000 => (0, 1, 3),
+        22_050 => (1, 1, 2),
+        32_000 => (0, 2, 3),
+        44_100 => (1, 1, 1),
+        48_000 => (0, 1, 1),
+        88_200 => (1, 2, 1),
+        96_000 => (0, 2, 1),
+        176_400 => (1, 4, 1),
+        192_000 => (0, 4, 1),
+        _ => return None,
+    };
+    let bits = match format.bits_per_sample {
+        8 => 0,
+        16 => 1,
+        32 => 4,
+        _ => return None,
+    };
+    if !(1..=16).contains(&format.channels) {
+        return None;
+    }
+    Some(base << 14 | (mult - 1) << 11 | (div - 1) << 8 | bits << 4 | (format.channels as u16 - 1))
+}
+
+impl SoundDevice for HdaController {
+    /// Taxa pedida se o DAC a suportar; senão 48 kHz, 44,1 kHz ou a primeira
+    /// suportada. Amostras de 16 bits salvo pedido explícito de 32 suportado.
+    fn negotiate(&mut self, wanted: AudioFormat) -> Result<AudioFormat, SoundError> {
+        let mut formats = self.parameter(self.path.dac, PARAM_PCM_FORMATS)?;
+        if formats == 0 {
+            // O DAC herda os formatos do grupo de funções.
+            formats = self.parameter(self.afg, PARAM_PCM_FORMATS)?;
+        }
+        let supported = |rate: u32| {
+            SUPPORTED_RATES.iter().position(|&r| r == rate).map_or(false, |bit| formats & (1 << bit) != 0)
+        };
+
+        let sample_rate = [wanted.sample_rate, 48_000, 44_100]
+            .into_iter()
+            .find(|&rate| supported(rate))
+            .or_else(|| SUPPORTED_RATES.into_iter().find(|&rate| supported(rate)))
+            .ok_or(SoundError::InitializationFailed)?;
+        let bits_per_sample = if wanted.bits_per_sample == 32 && formats & PCM_32BIT != 0 {
+            32
+        } else if formats & PCM_16BIT != 0 {
+            16
+        } else {
+            return Err(SoundError::InitializationFailed);
+        };
+        let format = AudioFormat { sample_rate, channels: wanted.channels.clamp(1, 2), bits_per_sample };
+
+        let bits = encode_format(format).ok_or(SoundError::InitializationFailed)?;
+        self.verb16(self.path.dac, VERB_SET_STREAM_FORMAT, bits)?;
+        self.format = format;
+        self.format_bits = bits;
+        Ok(format)
+    }
+
+    fn start(&mut self, ring: &PeriodRing) -> Result<(), SoundError> {
+        if self.format_bits == 0 {
+            return Err(SoundError::InitializationFailed);
+        }
+        self.reset_stream()?;
+
+        // A BDL e os períodos que ela aponta são lidos pelo controlador.
+        self.check_dma(ring.buffer_addr(), ring.total_bytes())?;
+        let bdl = self.check_dma(ring.bdl_addr(), ring.period_count() * BDL_ENTRY_SIZE)?;
+        self.stream_regs.write(StreamRegs::BDPL, bdl as u32);
+        self.stream_regs.write(StreamRegs::BDPU, (bdl >> 32) as u32);
+        self.stream_regs.write(StreamRegs::CBL, ring.total_bytes() as u32);
+        self.stream_regs.write(StreamRegs::LVI, (ring.period_count() - 1) as u16);
+        self.stream_regs.write(StreamRegs::FMT, self.format_bits);
+        self.stream_regs.write(StreamRegs::CTL_TAG, STREAM_TAG << 4);
+
+        // O DAC escuta a tag do stream, canal 0.
+        self.verb(self.path.dac, VERB_SET_CHANNEL_STREAMID, STREAM_TAG << 4)?;
+
+        self.regs.modify(HdaRegs::INTCTL, |intctl| intctl | INTCTL_GIE | 1 << self.stream);
+        self.stream_regs.write(StreamRegs::CTL, SD_CTL_RUN | SD_CTL_IOCE);
+        Ok(())
+    }
+
+    fn stop(&mut self) {
+        self.stream_regs.write(StreamRegs::CTL, 0);
+        self.regs.clear_bits(HdaRegs::INTCTL, 1 << self.stream);
+    }
+
+    fn ack_interrupt(&mut self) -> bool {
+        self.irq() != IrqReturn::None
+    }
+
+    fn position(&self) -> usize {
+        self.stream_regs.read(StreamRegs::LPIB) as usize
+    }
+}
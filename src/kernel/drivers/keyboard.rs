@@ -0,0 +1,154 @@
+// src/kernel/drivers/keyboard.rs
+
+//! Driver de Teclado do LightOS: fila de eventos de tecla sem locks.
+//!
+//! O handler de IRQ (produtor único) decodifica o scancode e publica um
+//! `KeyEvent`; o consumidor (console/UI) o retira com `read_key`. Nenhum dos
+//! lados toma locks, então o handler de IRQ nunca espera por uma tarefa.
+//! * Cada fonte de teclas tem a sua fila SPSC (PS/2 e virtio-input): as duas
+//!   podem produzir ao mesmo tempo em CPUs diferentes.
+
+#![allow(dead_code)] // Permite código não usado para fins de demonstração
+
+use core::sync::atomic::{AtomicBool, AtomicU32, AtomicUsize, Ordering};
+
+/// ⌨️ Um evento de tecla.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct KeyEvent {
+    /// Código da tecla. PS/2: scancode set 1 (com 0xE000 para teclas estendidas).
+    pub code: u16,
+    /// `true` ao pressionar, `false` ao soltar.
+    pub pressed: bool,
+}
+
+impl KeyEvent {
+    fn pack(self) -> u32 {
+        self.code as u32 | ((self.pressed as u32) << 16)
+    }
+
+    fn unpack(raw: u32) -> Self {
+        KeyEvent { code: raw as u16, pressed: raw & (1 << 16) != 0 }
+    }
+}
+
+/// Capacidade da fila (potência de 2).
+const QUEUE_CAPACITY: usize = 128;
+
+/// 📥 Fila SPSC (um produtor, um consumidor) de eventos de tecla.
+pub struct KeyQueue {
+    slots: [AtomicU32; QUEUE_CAPACITY],
+    /// Próxima posição a escrever (só o produtor altera).
+    head: AtomicUsize,
+    /// Próxima posição a ler (só o consumidor altera).
+    tail: AtomicUsize,
+    /// Eventos descartados por fila cheia.
+    dropped: AtomicUsize,
+}
+
+impl KeyQueue {
+    /// 🏭 Cria uma fila vazia.
+    pub const fn new() -> Self {
+        const EMPTY: AtomicU32 = AtomicU32::new(0);
+        KeyQueue {
+            slots: [EMPTY; QUEUE_CAPACITY],
+            head: AtomicUsize::new(0),
+            tail: AtomicUsize::new(0),
+            dropped: AtomicUsize::new(0),
+        }
+    }
+
+    /// ➕ Publica um evento (lado do produtor). Descarta-o se a fila estiver cheia.
+    pub fn push(&self, event: KeyEvent) -> bool {
+        let head = self.head.load(Ordering::Relaxed);
+        let tail = self.tail.load(Ordering::Acquire);
+        if head.wrapping_sub(tail) >= QUEUE_CAPACITY {
+            self.dropped.fetch_add(1, Ordering::Relaxed);
+            return false;
+        }
+        self.slots[head % QUEUE_CAPACITY].store(event.pack(), Ordering::Relaxed);
+        self.head.store(head.wrapping_add(1), Ordering::Release);
+        true
+    }
+
+    /// ➖ Retira o evento mais antigo (lado do consumidor).
+    pub fn pop(&self) -> Option<KeyEvent> {
+        let tail = self.tail.load(Ordering::Relaxed);
+        let head = self.head.load(Ordering::Acquire);
+        if tail == head {
+            return None;
+        }
+        let raw = self.slots[tail % QUEUE_CAPACITY].load(Ordering::Relaxed);
+        self.tail.store(tail.wrapping_add(1), Ordering::Release);
+        Some(KeyEvent::unpack(raw))
+    }
+
+    /// Eventos descartados por fila cheia desde o boot.
+    pub fn dropped(&self) -> usize {
+        self.dropped.load(Ordering::Relaxed)
+    }
+}
+
+/// 🔑 Fila de teclas do PS/2 (produtor: handler da IRQ 1).
+pub static KEY_QUEUE: KeyQueue = KeyQueue::new();
+/// 🔑 Fila de teclas do virtio-input (produtor: a drenagem dos dispositivos,
+/// serializada pelo lock da lista de dispositivos).
+pub static EVDEV_KEY_QUEUE: KeyQueue = KeyQueue::new();
+
+/// Prefixo de scancode estendido (set 1) recebido e aguardando o próximo byte.
+static PS2_EXTENDED: AtomicBool = AtomicBool::new(false);
+
+/// ⚡ Decodifica um byte do PS/2 (scancode set 1) e publica o evento.
+/// * Chamado pelo handler da IRQ 1, em contexto de interrupção.
+pub fn handle_ps2_scancode(scancode: u8) {
+    if scancode == 0xE0 {
+        PS2_EXTENDED.store(true, Ordering::Relaxed);
+        return;
+    }
+
+    let extended = PS2_EXTENDED.swap(false, Ordering::Relaxed);
+    let code = (scancode & 0x7F) as u16 | if extended { 0xE000 } else { 0 };
+    KEY_QUEUE.push(KeyEvent { code, pressed: scancode & 0x80 == 0 });
+}
+
+/// 📡 Lê o próximo evento de tecla, se houver.
+/// * As fontes são teclados distintos: não há ordem entre as duas filas.
+pub fn read_key() -> Option<KeyEvent> {
+    KEY_QUEUE.pop().or_else(|| EVDEV_KEY_QUEUE.pop())
+}
+
+/// Teclas estendidas do evdev (códigos do Linux) e seus scancodes set 1.
+/// * Do `KEY_ESC` (1) ao `KEY_F12` (88), o código evdev já é o scancode set 1.
+const EVDEV_EXTENDED: [(u16, u16); 17] = [
+    (96, 0xE01C),  // KEY_KPENTER
+    (97, 0xE01D),  // KEY_RIGHTCTRL
+    (98, 0xE035),  // KEY_KPSLASH
+    (100, 0xE038), // KEY_RIGHTALT
+    (102, 0xE047), // KEY_HOME
+    (103, 0xE048), // KEY_UP
+    (104, 0xE049), // KEY_PAGEUP
+    (105, 0xE04B), // KEY_LEFT
+    (106, 0xE04D), // KEY_RIGHT
+    (107, 0xE04F), // KEY_END
+    (108, 0xE050), // KEY_DOWN
+    (109, 0xE051), // KEY_PAGEDOWN
+    (110, 0xE052), // KEY_INSERT
+    (111, 0xE053), // KEY_DELETE
+    (125, 0xE05B), // KEY_LEFTMETA
+    (126, 0xE05C), // KEY_RIGHTMETA
+    (127, 0xE05D), // KEY_COMPOSE
+];
+
+/// ⚡ Publica uma tecla recebida como código evdev (ex: virtio-input), no mesmo
+/// espaço de códigos do PS/2. Teclas sem equivalente no set 1 são ignoradas.
+/// * Fora do contexto de interrupção, com um único chamador por vez (o único
+///   produtor da `EVDEV_KEY_QUEUE`).
+pub fn handle_evdev_key(code: u16, pressed: bool) {
+    let code = match code {
+        1..=88 => code,
+        _ => match EVDEV_EXTENDED.iter().find(|(evdev, _)| *evdev == code) {
+            Some(&(_, set1)) => set1,
+            None => return,
+        },
+    };
+    EVDEV_KEY_QUEUE.push(KeyEvent { code, pressed });
+}
@@ -0,0 +1,725 @@
+// src/kernel/drivers/mixer.rs
+
+//! Mixer de Áudio do LightOS.
+//!
+//! Vários fluxos PCM (cada um no seu formato e taxa) são somados no período de
+//! DMA do pipeline (`audio`):
+//! * Conversão de formato: 8/16/32 bits, mono/estéreo → 16 bits estéreo.
+//! * Conversão de taxa: resampler polifásico racional (L/M), com o filtro
+//!   protótipo (sinc janelado por Kaiser) em tabela. Na redução de taxa o
+//!   filtro é esticado para cortar em `fs_saída / 2`.
+//! * Ganho por fluxo em ponto fixo Q15.
+//! * Entrada por fila (`StreamHandle::write`, uma cópia) ou direto de um anel
+//!   de períodos compartilhado com a tarefa (`pcm_ring`, sem cópia).
+//! * Soma com saturação em 16 bits (`paddsw`), e produtos escalares do FIR
+//!   com `pmaddwd`, em SSE2 ou AVX2 conforme `crate::simd::features`.
+//!
+//! Toda a aritmética é inteira: o kernel é compilado sem ponto flutuante.
+//! O mixer roda no bottom half do áudio, um período por vez, dentro de
+//! `simd::with_simd`.
+
+use alloc::sync::Arc;
+use alloc::vec::Vec;
+use core::arch::x86_64::*;
+use core::sync::atomic::{AtomicBool, AtomicU32, AtomicU64, Ordering};
+use spin::Mutex;
+
+use super::audio::{AudioFormat, ByteQueue};
+use super::pcm_ring::PcmRing;
+use super::sound::SoundError;
+use crate::simd;
+
+/// Ganho unitário (Q15).
+pub const UNITY_GAIN: u32 = 1 << 15;
+/// Maior ganho aceito: +6 dB.
+pub const MAX_GAIN: u32 = 2 * UNITY_GAIN;
+/// Máximo de fluxos simultâneos.
+pub const MAX_STREAMS: usize = 16;
+
+/// Cruzamentos por zero de cada lado do filtro protótipo.
+const SINC_ZERO_CROSSINGS: usize = 8;
+/// Amostras da tabela por cruzamento por zero.
+const SINC_RESOLUTION: usize = 32;
+/// Maior número de fases (L reduzido) do resampler.
+const MAX_PHASES: u32 = 1024;
+/// Maior meia-janela do FIR, em amostras de entrada (redução de até ~8:1).
+const MAX_HALF_TAPS: usize = 64;
+/// Coeficientes em Q14: 1.0 ainda cabe em `i16`.
+const COEF_SHIFT: u32 = 14;
+
+/// Metade direita de sinc(x)·kaiser(x, β = 8), x em [0, 8], Q15.
+static SINC_TABLE: [i16; SINC_ZERO_CROSSINGS * SINC_RESOLUTION + 1] = [
+    32767, 32713, 32549, 32279, 31902, 31422, 30841, 30164, 29393, 28535, 27593, 26575,
+    25486, 24332, 23122, 21861, 20557, 19219, 17852, 16467, 15069, 13668, 12270, 10883,
+    9515, 8172, 6861, 5589, 4361, 3184, 2061, 999, 0, -931, -1792, -2580,
+    -3294, -3931, -4492, -4975, -5382, -5714, -5971, -6155, -6270, -6317, -6301, -6224,
+    -6090, -5903, -5669, -5391, -5074, -4723, -4343, -3940, -3516, -3079, -2632, -2181,
+    -1729, -1281, -841, -413, 0, 394, 766, 1114, 1436, 1729, 1993, 2225,
+    2425, 2592, 2726, 2828, 2897, 2935, 2942, 2920, 2870, 2794, 2694, 2571,
+    2428, 2267, 2091, 1902, 1702, 1493, 1279, 1062, 843, 626, 411, 202,
+    0, -193, -376, -548, -706, -851, -980, -1095, -1193, -1275, -1341, -1390,
+    -1424, -1441, -1444, -1432, -1406, -1367, -1317, -1255, -1184, -1104, -1017, -923,
+    -825, -723, -618, -512, -406, -300, -197, -97, 0, 92, 179, 259,
+    334, 401, 461, 513, 557, 594, 623, 644, 657, 663, 662, 654,
+    640, 620, 595, 565, 531, 494, 453, 409, 364, 318, 271, 223,
+    176, 130, 85, 41, 0, -39, -75, -109, -140, -167, -191, -211,
+    -228, -242, -252, -259, -263, -264, -262, -258, -251, -241, -230, -217,
+    -203, -187, -171, -153, -135, -117, -99, -81, -64, -47, -30, -15,
+    0, 14, 26, 37, 47, 56, 64, 70, 75, 79, 81, 83,
+    83, 82, 81, 79, 76, 72, 68, 64, 59, 53, 48, 43,
+    37, 32, 27, 21, 17, 12, 8, 4, 0, -3, -6, -9,
+    -11, -13, -14, -15, -16, -16, -17, -16, -16, -16, -15, -14,
+    -13, -12, -11, -10, -9, -8, -7, -6, -5, -4, -3, -3,
+    -2, -1, -1, 0, 0,
+];
+
+// ------------------------------------------------------------------------
+// --- Caminhos SIMD ---
+// ------------------------------------------------------------------------
+
+/// 🧮 Conjunto de instruções usado pelo mixer.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+enum MixPath {
+    Scalar,
+    Sse2,
+    Avx2,
+}
+
+fn select_path() -> MixPath {
+    let features = simd::features();
+    if features.avx2 {
+        MixPath::Avx2
+    } else if features.sse2 {
+        MixPath::Sse2
+    } else {
+        MixPath::Scalar
+    }
+}
+
+/// Produto escalar de dois vetores `i16` de mesmo tamanho (múltiplo de 8).
+#[inline]
+fn dot(path: MixPath, a: &[i16], b: &[i16]) -> i32 {
+    debug_assert!(a.len() == b.len() && a.len() % 8 == 0);
+    match path {
+        // # SAFETY: O caminho só é escolhido com a extensão habilitada, e o
+        // chamador está dentro de `with_simd`.
+        MixPath::Avx2 => unsafe { dot_avx2(a, b) },
+        MixPath::Sse2 => unsafe { dot_sse2(a, b) },
+        MixPath::Scalar => a.iter().zip(b).map(|(&x, &y)| x as i32 * y as i32).sum(),
+    }
+}
+
+#[target_feature(enable = "sse2")]
+unsafe fn dot_sse2(a: &[i16], b: &[i16]) -> i32 {
+    let mut acc = _mm_setzero_si128();
+    for i in (0..a.len()).step_by(8) {
+        let x = _mm_loadu_si128(a.as_ptr().add(i) as *const __m128i);
+        let y = _mm_loadu_si128(b.as_ptr().add(i) as *const __m128i);
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(x, y));
+    }
+    horizontal_sum_sse2(acc)
+}
+
+#[target_feature(enable = "sse2")]
+unsafe fn horizontal_sum_sse2(v: __m128i) -> i32 {
+    let v = _mm_add_epi32(v, _mm_shuffle_epi32(v, 0b01_00_11_10));
+    let v = _mm_add_epi32(v, _mm_shuffle_epi32(v, 0b10_11_00_01));
+    _mm_cvtsi128_si32(v)
+}
+
+#[target_feature(enable = "avx2")]
+unsafe fn dot_avx2(a: &[i16], b: &[i16]) -> i32 {
+    let mut acc = _mm256_setzero_si256();
+    let mut i = 0;
+    while i + 16 <= a.len() {
+        let x = _mm256_loadu_si256(a.as_ptr().add(i) as *const __m256i);
+        let y = _mm256_loadu_si256(b.as_ptr().add(i) as *const __m256i);
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(x, y));
+        i += 16;
+    }
+    let mut sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    if i < a.len() {
+        let x = _mm_loadu_si128(a.as_ptr().add(i) as *const __m128i);
+        let y = _mm_loadu_si128(b.as_ptr().add(i) as *const __m128i);
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(x, y));
+    }
+    horizontal_sum_sse2(sum)
+}
+
+/// `dst[i] = sat(dst[i] + src[i])`.
+#[inline]
+fn add_saturating(path: MixPath, dst: &mut [i16], src: &[i16]) {
+    let len = dst.len().min(src.len());
+    match path {
+        // # SAFETY: Ver `dot`.
+        MixPath::Avx2 => unsafe { add_saturating_avx2(&mut dst[..len], &src[..len]) },
+        MixPath::Sse2 => unsafe { add_saturating_sse2(&mut dst[..len], &src[..len]) },
+        MixPath::Scalar => dst.iter_mut().zip(src).for_each(|(d, &s)| *d = d.saturating_add(s)),
+    }
+}
+
+#[target_feature(enable = "sse2")]
+unsafe fn add_saturating_sse2(dst: &mut [i16], src: &[i16]) {
+    let mut i = 0;
+    while i + 8 <= dst.len() {
+        let d = dst.as_mut_ptr().add(i) as *mut __m128i;
+        let s = _mm_loadu_si128(src.as_ptr().add(i) as *const __m128i);
+        _mm_storeu_si128(d, _mm_adds_epi16(_mm_loadu_si128(d), s));
+        i += 8;
+    }
+    for j in i..dst.len() {
+        dst[j] = dst[j].saturating_add(src[j]);
+    }
+}
+
+#[target_feature(enable = "avx2")]
+unsafe fn add_saturating_avx2(dst: &mut [i16], src: &[i16]) {
+    let mut i = 0;
+    while i + 16 <= dst.len() {
+        let d = dst.as_mut_ptr().add(i) as *mut __m256i;
+        let s = _mm256_loadu_si256(src.as_ptr().add(i) as *const __m256i);
+        _mm256_storeu_si256(d, _mm256_adds_epi16(_mm256_loadu_si256(d), s));
+        i += 16;
+    }
+    add_saturating_sse2(&mut dst[i..], &src[i..]);
+}
+
+/// Aplica o ganho Q15 e satura em 16 bits.
+#[inline(always)]
+fn apply_gain(sample: i32, gain: u32) -> i16 {
+    ((sample as i64 * gain as i64) >> 15).clamp(i16::MIN as i64, i16::MAX as i64) as i16
+}
+
+// ------------------------------------------------------------------------
+// --- Conversão de Formato ---
+// ------------------------------------------------------------------------
+
+/// Formatos de entrada aceitos por um fluxo.
+fn validate_input(format: AudioFormat) -> Result<(), SoundError> {
+    let bits_ok = matches!(format.bits_per_sample, 8 | 16 | 32);
+    if !bits_ok || format.channels == 0 || format.sample_rate == 0 {
+        return Err(SoundError::UnsupportedFormat);
+    }
+    Ok(())
+}
+
+/// Uma amostra de `bits` bits (8 sem sinal; 16/32 com sinal) → `i16`.
+#[inline(always)]
+fn decode_sample(bytes: &[u8], bits: u8) -> i16 {
+    match bits {
+        8 => ((bytes[0] as i16) - 128) << 8,
+        16 => i16::from_le_bytes([bytes[0], bytes[1]]),
+        _ => (i32::from_le_bytes([bytes[0], bytes[1], bytes[2], bytes[3]]) >> 16) as i16,
+    }
+}
+
+/// Um quadro de entrada → (esquerdo, direito). Mono é duplicado; canais além do
+/// segundo são descartados.
+#[inline(always)]
+fn decode_frame(frame: &[u8], format: AudioFormat) -> (i16, i16) {
+    let size = format.bits_per_sample as usize / 8;
+    let left = decode_sample(frame, format.bits_per_sample);
+    let right = if format.channels > 1 { decode_sample(&frame[size..], format.bits_per_sample) } else { left };
+    (left, right)
+}
+
+// ------------------------------------------------------------------------
+// --- Resampler Polifásico ---
+// ------------------------------------------------------------------------
+
+fn gcd(mut a: u32, mut b: u32) -> u32 {
+    while b != 0 {
+        let r = a % b;
+        a = b;
+        b = r;
+    }
+    a
+}
+
+/// Tabela protótipo interpolada linearmente em `x` = `num / den` cruzamentos por zero.
+fn prototype(num: u64, den: u64) -> i32 {
+    let scaled = num * SINC_RESOLUTION as u64;
+    let index = (scaled / den) as usize;
+    if index + 1 >= SINC_TABLE.len() {
+        return 0;
+    }
+    let frac = (scaled % den) as i64;
+    let (a, b) = (SINC_TABLE[index] as i64, SINC_TABLE[index + 1] as i64);
+    (a + (b - a) * frac / den as i64) as i32
+}
+
+/// 🔁 Conversor L/M de um fluxo (estado do consumidor).
+///
+/// A saída `j` fica no instante `j·M/L` da entrada: amostra `pos` mais a fase
+/// `phase/L`. Cada fase tem o seu conjunto de `2·half` coeficientes.
+struct Resampler {
+    up: u32,
+    down: u32,
+    half: usize,
+    /// `up` fases × `2·half` coeficientes Q14 (soma de cada fase = 1.0).
+    bank: Vec<i16>,
+    /// Histórico da entrada já convertida, um vetor por canal.
+    left: Vec<i16>,
+    right: Vec<i16>,
+    pos: usize,
+    phase: u32,
+}
+
+impl Resampler {
+    /// 🏭 Conversor de `from` Hz para `to` Hz (identidade se forem iguais).
+    fn new(from: u32, to: u32) -> Result<Self, SoundError> {
+        let g = gcd(from, to);
+        let (up, down) = (to / g, from / g);
+        if up == down {
+            return Ok(Resampler { up: 1, down: 1, half: 0, bank: Vec::new(), left: Vec::new(), right: Vec::new(), pos: 0, phase: 0 });
+        }
+        if up > MAX_PHASES {
+            return Err(SoundError::UnsupportedFormat);
+        }
+
+        // Na redução o filtro é esticado por M/L (corte em fs_saída/2); a meia
+        // janela cresce na mesma proporção e é arredondada para múltiplo de 4
+        // (2·half múltiplo de 8, o passo dos produtos escalares).
+        let widest = up.max(down) as usize;
+        let half = ((SINC_ZERO_CROSSINGS * widest + up as usize - 1) / up as usize + 3) & !3;
+        if half > MAX_HALF_TAPS {
+            return Err(SoundError::UnsupportedFormat);
+        }
+        let taps = 2 * half;
+
+        let mut bank = Vec::new();
+        bank.try_reserve_exact(up as usize * taps).map_err(|_| SoundError::OutOfMemory)?;
+        let mut row = [0i32; 2 * MAX_HALF_TAPS];
+        for phase in 0..up as i64 {
+            // Distância da saída à amostra k da janela: phase/L + (half - 1 - k).
+            let mut sum = 0i64;
+            for (k, coef) in row[..taps].iter_mut().enumerate() {
+                let num = (phase + (half as i64 - 1 - k as i64) * up as i64).unsigned_abs();
+                *coef = prototype(num, widest as u64);
+                sum += *coef as i64;
+            }
+            let sum = sum.max(1);
+            bank.extend(row[..taps].iter().map(|&c| ((c as i64) << COEF_SHIFT) / sum).map(|c| c as i16));
+        }
+
+        // A janela da primeira saída começa em `pos + 1 - half`: histórico
+        // inicial em silêncio.
+        let mut left = Vec::new();
+        let mut right = Vec::new();
+        left.try_reserve(4 * taps).map_err(|_| SoundError::OutOfMemory)?;
+        right.try_reserve(4 * taps).map_err(|_| SoundError::OutOfMemory)?;
+        left.resize(half - 1, 0);
+        right.resize(half - 1, 0);
+        Ok(Resampler { up, down, half, bank, left, right, pos: half - 1, phase: 0 })
+    }
+
+    fn is_identity(&self) -> bool {
+        self.up == self.down
+    }
+
+    /// Quadros de entrada necessários, além do histórico, para `frames` saídas.
+    fn input_needed(&self, frames: usize) -> usize {
+        if self.is_identity() {
+            return frames;
+        }
+        let advance = (self.phase as usize + frames.saturating_sub(1) * self.down as usize) / self.up as usize;
+        (self.pos + advance + self.half + 1).saturating_sub(self.left.len())
+    }
+
+    /// Descarta o histórico que nenhuma saída futura usa.
+    fn compact(&mut self) {
+        let drop = (self.pos + 1).saturating_sub(self.half);
+        if drop > 0 {
+            self.left.drain(..drop);
+            self.right.drain(..drop);
+            self.pos -= drop;
+        }
+    }
+
+    /// Acrescenta quadros de entrada ao histórico.
+    fn push_input(&mut self, raw: &[u8], format: AudioFormat) -> Result<(), SoundError> {
+        let frame = format.bytes_per_frame();
+        let count = raw.len() / frame;
+        self.left.try_reserve(count).map_err(|_| SoundError::OutOfMemory)?;
+        self.right.try_reserve(count).map_err(|_| SoundError::OutOfMemory)?;
+        for chunk in raw.chunks_exact(frame) {
+            let (l, r) = decode_frame(chunk, format);
+            self.left.push(l);
+            self.right.push(r);
+        }
+        Ok(())
+    }
+
+    /// Gera até `out.len() / 2` quadros estéreo com ganho. Retorna os quadros gerados.
+    fn render(&mut self, path: MixPath, out: &mut [i16], gain: u32) -> usize {
+        let taps = 2 * self.half;
+        let mut produced = 0;
+        for frame in out.chunks_exact_mut(2) {
+            if self.pos + self.half >= self.left.len() {
+                break;
+            }
+            let start = self.pos + 1 - self.half;
+            let coefs = &self.bank[self.phase as usize * taps..][..taps];
+            let l = dot(path, coefs, &self.left[start..start + taps]);
+            let r = dot(path, coefs, &self.right[start..start + taps]);
+            let round = 1 << (COEF_SHIFT - 1);
+            frame[0] = apply_gain((l + round) >> COEF_SHIFT, gain);
+            frame[1] = apply_gain((r + round) >> COEF_SHIFT, gain);
+            produced += 1;
+
+            self.phase += self.down;
+            self.pos += (self.phase / self.up) as usize;
+            self.phase %= self.up;
+        }
+        produced
+    }
+}
+
+// ------------------------------------------------------------------------
+// --- Fluxos ---
+// ------------------------------------------------------------------------
+
+/// 📥 De onde vêm os quadros de um fluxo.
+enum StreamInput {
+    /// Fila alimentada por `StreamHandle::write`.
+    Queue(ByteQueue),
+    /// Anel compartilhado: lido no lugar, sem cópia intermediária.
+    Ring(PcmRing),
+}
+
+impl StreamInput {
+    /// Bytes prontos para consumo.
+    fn available(&self) -> usize {
+        match self {
+            StreamInput::Queue(queue) => queue.len(),
+            StreamInput::Ring(ring) => ring.available(),
+        }
+    }
+
+    /// Entrega até `max` bytes a `sink` e os consome. `scratch` recebe os dados
+    /// da fila (o anel é entregue direto da região compartilhada).
+    fn consume(&self, max: usize, scratch: &mut Vec<u8>, mut sink: impl FnMut(&[u8])) -> usize {
+        match self {
+            StreamInput::Queue(queue) => {
+                if scratch.len() < max {
+                    if scratch.try_reserve(max - scratch.len()).is_err() {
+                        return 0;
+                    }
+                    scratch.resize(max, 0);
+                }
+                let got = queue.pop_into(&mut scratch[..max]);
+                sink(&scratch[..got]);
+                got
+            }
+            StreamInput::Ring(ring) => ring.consume(max, sink),
+        }
+    }
+}
+
+/// 🎼 Lado compartilhado de um fluxo: entrada e controles.
+struct StreamShared {
+    input: StreamInput,
+    format: AudioFormat,
+    gain: AtomicU32,
+    /// O produtor escreveu desde que a fila secou (falta de dados = underrun).
+    active: AtomicBool,
+    closed: AtomicBool,
+    dropped: AtomicU64,
+}
+
+/// 🎫 Um fluxo aberto no mixer. Fechado no `Drop`.
+/// * Um produtor por fluxo (a fila é SPSC).
+pub struct StreamHandle {
+    shared: Arc<StreamShared>,
+}
+
+impl StreamHandle {
+    /// 🎵 Enfileira PCM no formato do fluxo. Nunca bloqueia: retorna quantos bytes
+    /// couberam (somente quadros inteiros; sempre 0 em fluxos de anel).
+    /// * `&mut self`: a fila é SPSC; um handle compartilhado precisa de um lock.
+    pub fn write(&mut self, data: &[u8]) -> usize {
+        let shared = &self.shared;
+        let frame = shared.format.bytes_per_frame();
+        let whole = data.len() - data.len() % frame;
+        let queue = match &shared.input {
+            StreamInput::Queue(queue) => queue,
+            StreamInput::Ring(_) => return 0,
+        };
+        let free = queue.capacity() - queue.len();
+        let accepted = queue.push(&data[..whole.min(free - free % frame)]);
+        if accepted > 0 {
+            shared.active.store(true, Ordering::Release);
+        }
+        shared.dropped.fetch_add((data.len() - accepted) as u64, Ordering::Relaxed);
+        accepted
+    }
+
+    /// 🎚️ Ganho Q15 (`UNITY_GAIN` = 0 dB), limitado a `MAX_GAIN`.
+    pub fn set_gain(&self, gain: u32) {
+        self.shared.gain.store(gain.min(MAX_GAIN), Ordering::Relaxed);
+    }
+
+    pub fn format(&self) -> AudioFormat {
+        self.shared.format
+    }
+
+    /// Bytes aguardando o mixer.
+    pub fn queued(&self) -> usize {
+        self.shared.input.available()
+    }
+
+    /// Anel compartilhado do fluxo, se for um fluxo de anel.
+    pub fn ring(&self) -> Option<&PcmRing> {
+        match &self.shared.input {
+            StreamInput::Ring(ring) => Some(ring),
+            StreamInput::Queue(_) => None,
+        }
+    }
+
+    /// Bytes recusados por falta de espaço na fila.
+    pub fn dropped(&self) -> u64 {
+        self.shared.dropped.load(Ordering::Relaxed)
+    }
+}
+
+impl Drop for StreamHandle {
+    fn drop(&mut self) {
+        self.shared.closed.store(true, Ordering::Release);
+    }
+}
+
+/// Fluxo do ponto de vista do mixer.
+struct Channel {
+    shared: Arc<StreamShared>,
+    resampler: Resampler,
+}
+
+// ------------------------------------------------------------------------
+// --- Mixer ---
+// ------------------------------------------------------------------------
+
+/// 📈 Resultado da mixagem de um período.
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct MixReport {
+    /// Maior número de quadros com dados entregue por um fluxo.
+    pub frames: usize,
+    /// Algum fluxo ativo não tinha dados suficientes.
+    pub underrun: bool,
+}
+
+struct MixerState {
+    channels: Vec<Channel>,
+    /// Quadros estéreo de um fluxo antes da soma.
+    stream_buf: Vec<i16>,
+    /// Soma estéreo quando a saída não é 16 bits estéreo.
+    mix_buf: Vec<i16>,
+    /// Bytes retirados das filas antes da conversão.
+    raw: Vec<u8>,
+}
+
+/// 🎛️ Mixer de vários fluxos para um formato de saída.
+pub struct Mixer {
+    output: AudioFormat,
+    state: Mutex<MixerState>,
+}
+
+impl Mixer {
+    /// 🏭 Mixer que produz `output` (o formato negociado com o dispositivo).
+    pub fn new(output: AudioFormat) -> Self {
+        Mixer {
+            output,
+            state: Mutex::new(MixerState { channels: Vec::new(), stream_buf: Vec::new(), mix_buf: Vec::new(), raw: Vec::new() }),
+        }
+    }
+
+    pub fn output_format(&self) -> AudioFormat {
+        self.output
+    }
+
+    /// ➕ Abre um fluxo em `format` com fila de `queue_bytes` bytes.
+    pub fn open_stream(&self, format: AudioFormat, queue_bytes: usize) -> Result<StreamHandle, SoundError> {
+        validate_input(format)?;
+        self.attach(format, StreamInput::Queue(ByteQueue::new(queue_bytes.max(format.bytes_per_frame()))))
+    }
+
+    /// ➕ Abre um fluxo que lê os períodos de `ring` no lugar.
+    pub fn open_ring(&self, ring: PcmRing) -> Result<StreamHandle, SoundError> {
+        let format = ring.format();
+        validate_input(format)?;
+        self.attach(format, StreamInput::Ring(ring))
+    }
+
+    fn attach(&self, format: AudioFormat, input: StreamInput) -> Result<StreamHandle, SoundError> {
+        // O banco de coeficientes é calculado fora do lock do mixer.
+        let resampler = Resampler::new(format.sample_rate, self.output.sample_rate)?;
+        let shared = Arc::new(StreamShared {
+            input,
+            format,
+            gain: AtomicU32::new(UNITY_GAIN),
+            active: AtomicBool::new(false),
+            closed: AtomicBool::new(false),
+            dropped: AtomicU64::new(0),
+        });
+
+        let mut state = self.state.lock();
+        state.channels.retain(|c| !c.shared.closed.load(Ordering::Acquire));
+        if state.channels.len() >= MAX_STREAMS {
+            return Err(SoundError::Busy);
+        }
+        state.channels.try_reserve(1).map_err(|_| SoundError::OutOfMemory)?;
+        state.channels.push(Channel { shared: shared.clone(), resampler });
+        Ok(StreamHandle { shared })
+    }
+
+    /// Fluxos abertos.
+    pub fn stream_count(&self) -> usize {
+        self.state.lock().channels.iter().filter(|c| !c.shared.closed.load(Ordering::Acquire)).count()
+    }
+
+    /// Bytes aguardando mixagem em todos os fluxos.
+    pub fn queued_bytes(&self) -> usize {
+        self.state.lock().channels.iter().map(|c| c.shared.input.available()).sum()
+    }
+
+    /// ⏳ Maior fila entre os fluxos abertos, em µs do formato de cada fluxo
+    /// (os fluxos tocam em paralelo: o mais atrasado define a latência).
+    pub fn max_queued_us(&self) -> u64 {
+        self.state
+            .lock()
+            .channels
+            .iter()
+            .filter(|c| !c.shared.closed.load(Ordering::Acquire))
+            .map(|c| c.shared.input.available() as u64 * 1_000_000 / c.shared.format.bytes_per_second().max(1) as u64)
+            .max()
+            .unwrap_or(0)
+    }
+
+    /// 🎚️ Mistura todos os fluxos em `period` (bytes no formato de saída).
+    /// * Fluxos sem dados contribuem com silêncio.
+    pub fn mix(&self, period: &mut [u8]) -> MixReport {
+        let frames = period.len() / self.output.bytes_per_frame();
+        let native = self.output.channels == 2 && self.output.bits_per_sample == 16;
+        let mut state = self.state.lock();
+        state.channels.retain(|c| !c.shared.closed.load(Ordering::Acquire));
+
+        // Buffers de trabalho: crescem só na primeira chamada de cada tamanho.
+        let samples = frames * 2;
+        if state.stream_buf.len() < samples {
+            if state.stream_buf.try_reserve(samples - state.stream_buf.len()).is_err()
+                || (!native && state.mix_buf.try_reserve(samples.saturating_sub(state.mix_buf.len())).is_err())
+            {
+                period.fill(0);
+                return MixReport::default();
+            }
+            state.stream_buf.resize(samples, 0);
+        }
+        if !native && state.mix_buf.len() < samples {
+            state.mix_buf.resize(samples, 0);
+        }
+
+        period.fill(0);
+        let output = self.output;
+        let path = select_path();
+        let MixerState { channels, stream_buf, mix_buf, raw } = &mut *state;
+        let target: &mut [i16] = if native {
+            // # SAFETY: O período está alinhado a 128 bytes (anel de DMA) e tem
+            // `frames * 4` bytes: cabe exatamente `samples` amostras i16.
+            unsafe { core::slice::from_raw_parts_mut(period.as_mut_ptr() as *mut i16, samples) }
+        } else {
+            mix_buf[..samples].fill(0);
+            &mut mix_buf[..samples]
+        };
+
+        let mut report = MixReport::default();
+        for channel in channels.iter_mut() {
+            let got = render_channel(path, channel, &mut stream_buf[..samples], raw);
+            if got > 0 {
+                simd_section(path, || add_saturating(path, target, &stream_buf[..got * 2]));
+            }
+            report.frames = report.frames.max(got);
+            if got < frames && channel.shared.active.load(Ordering::Acquire) {
+                report.underrun = true;
+                if let StreamInput::Ring(ring) = &channel.shared.input {
+                    ring.note_underrun();
+                }
+                if got == 0 {
+                    // A fila secou: o silêncio daqui em diante não é underrun.
+                    channel.shared.active.store(false, Ordering::Release);
+                }
+            }
+        }
+
+        if !native {
+            store(output, &mix_buf[..samples], period);
+        }
+        report
+    }
+}
+
+/// Executa `f` dentro de `with_simd` quando o caminho usa registradores XMM/YMM.
+#[inline]
+fn simd_section<R>(path: MixPath, f: impl FnOnce() -> R) -> R {
+    match path {
+        MixPath::Scalar => f(),
+        _ => simd::with_simd(f),
+    }
+}
+
+/// Consome da entrada o que `out` precisa, converte e reamostra. Retorna quadros gerados.
+fn render_channel(path: MixPath, channel: &mut Channel, out: &mut [i16], raw: &mut Vec<u8>) -> usize {
+    let shared = &channel.shared;
+    let format = shared.format;
+    let gain = shared.gain.load(Ordering::Relaxed);
+    let frames = out.len() / 2;
+    let resampler = &mut channel.resampler;
+
+    let frame_bytes = format.bytes_per_frame();
+    let available = shared.input.available();
+    if available > 0 {
+        // Um anel não passa por `write`: dados submetidos ativam o fluxo aqui.
+        shared.active.store(true, Ordering::Release);
+    }
+    let take = (resampler.input_needed(frames) * frame_bytes).min(available - available % frame_bytes);
+
+    if resampler.is_identity() {
+        // Mesma taxa: só conversão de formato e ganho.
+        let mut written = 0;
+        shared.input.consume(take, raw, |chunk| {
+            for (frame, bytes) in out[written * 2..].chunks_exact_mut(2).zip(chunk.chunks_exact(frame_bytes)) {
+                let (l, r) = decode_frame(bytes, format);
+                frame[0] = apply_gain(l as i32, gain);
+                frame[1] = apply_gain(r as i32, gain);
+                written += 1;
+            }
+        });
+        return written;
+    }
+
+    resampler.compact();
+    let mut failed = false;
+    shared.input.consume(take, raw, |chunk| failed |= resampler.push_input(chunk, format).is_err());
+    if failed {
+        return 0;
+    }
+    simd_section(path, || resampler.render(path, out, gain))
+}
+
+/// Converte a soma estéreo `i16` para o formato de saída.
+fn store(output: AudioFormat, mix: &[i16], period: &mut [u8]) {
+    let sample_bytes = output.bits_per_sample as usize / 8;
+    for (stereo, frame) in mix.chunks_exact(2).zip(period.chunks_exact_mut(output.bytes_per_frame())) {
+        let values: [i16; 2] = if output.channels == 1 {
+            [((stereo[0] as i32 + stereo[1] as i32) / 2) as i16, 0]
+        } else {
+            [stereo[0], stereo[1]]
+        };
+        for (ch, sample) in frame.chunks_exact_mut(sample_bytes).enumerate() {
+            let value = values[ch.min(1)];
+            match sample_bytes {
+                1 => sample[0] = ((value >> 8) + 128) as u8,
+                2 => sample.copy_from_slice(&value.to_le_bytes()),
+                _ => sample.copy_from_slice(&((value as i32) << 16).to_le_bytes()),
+            }
+        }
+    }
+}
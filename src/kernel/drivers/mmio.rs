@@ -0,0 +1,191 @@
+// src/kernel/drivers/mmio.rs
+
+//! Acesso Tipado a Registradores de MMIO.
+//!
+//! Cada dispositivo declara seus registradores uma vez, com `register_block!`:
+//! o tamanho da janela e, para cada registrador, o tipo e o offset.
+//! * Os offsets são verificados em tempo de compilação: alinhados ao tipo e
+//!   dentro do bloco.
+//! * `Mmio<B>` só aceita registradores do próprio bloco `B`.
+//! * Cada leitura/escrita é um único acesso volátil do tamanho do registrador:
+//!   o mesmo código que o ponteiro cru, sem checagens em tempo de execução.
+//! * `modify` combina a atualização de vários campos em uma leitura e uma escrita.
+//!
+//! Arrays de estruturas iguais (ex: descritores de stream) são sub-blocos,
+//! obtidos com `Mmio::sub_block` (a única checagem de limite em execução).
+
+use core::marker::PhantomData;
+use core::mem::size_of;
+use core::ops::{BitAnd, BitOr, Not};
+use core::ptr::{self, NonNull};
+
+mod sealed {
+    pub trait Sealed {}
+}
+
+/// Tipos de registrador: acessos de 8, 16, 32 ou 64 bits.
+pub trait RegisterValue:
+    sealed::Sealed + Copy + BitAnd<Output = Self> + BitOr<Output = Self> + Not<Output = Self>
+{
+}
+
+macro_rules! register_values {
+    ($($ty:ty),*) => {
+        $(
+            impl sealed::Sealed for $ty {}
+            impl RegisterValue for $ty {}
+        )*
+    };
+}
+register_values!(u8, u16, u32, u64);
+
+/// 🧱 Um bloco de registradores: uma janela de `SIZE` bytes.
+pub trait RegisterBlock {
+    const SIZE: usize;
+}
+
+/// 📍 Um registrador de tipo `T` no bloco `B`.
+pub struct Register<T, B> {
+    offset: usize,
+    _marker: PhantomData<fn() -> (T, B)>,
+}
+
+impl<T, B> Clone for Register<T, B> {
+    fn clone(&self) -> Self {
+        *self
+    }
+}
+
+impl<T, B> Copy for Register<T, B> {}
+
+impl<T: RegisterValue, B: RegisterBlock> Register<T, B> {
+    /// Registrador em `offset`. Numa constante, um offset desalinhado ou fora
+    /// do bloco é erro de compilação.
+    pub const fn at(offset: usize) -> Self {
+        assert!(offset % size_of::<T>() == 0, "registrador desalinhado");
+        assert!(offset + size_of::<T>() <= B::SIZE, "registrador fora do bloco");
+        Register { offset, _marker: PhantomData }
+    }
+
+    /// Offset no bloco.
+    pub const fn offset(self) -> usize {
+        self.offset
+    }
+}
+
+/// 🧱 Declara um bloco de registradores: um tipo marcador que implementa
+/// `RegisterBlock` e uma constante `Register` por registrador.
+///
+/// ```ignore
+/// register_block! {
+///     /// Registradores do dispositivo.
+///     pub struct DeviceRegs[0x20] {
+///         STATUS: u32 = 0x00,
+///         CONTROL: u8 = 0x04,
+///     }
+/// }
+/// ```
+macro_rules! register_block {
+    (
+        $(#[$meta:meta])*
+        $vis:vis struct $name:ident[$size:expr] {
+            $($(#[$reg_meta:meta])* $reg:ident: $ty:ty = $offset:expr,)*
+        }
+    ) => {
+        $(#[$meta])*
+        $vis struct $name;
+
+        impl $crate::drivers::mmio::RegisterBlock for $name {
+            const SIZE: usize = $size;
+        }
+
+        impl $name {
+            $(
+                $(#[$reg_meta])*
+                pub const $reg: $crate::drivers::mmio::Register<$ty, $name> =
+                    $crate::drivers::mmio::Register::at($offset);
+            )*
+        }
+    };
+}
+pub(crate) use register_block;
+
+/// 🔌 Janela mapeada de um bloco de registradores.
+pub struct Mmio<B> {
+    base: NonNull<u8>,
+    _block: PhantomData<B>,
+}
+
+// # SAFETY: A janela é MMIO do dispositivo; o acesso é serializado pelo dono do driver.
+unsafe impl<B> Send for Mmio<B> {}
+
+impl<B: RegisterBlock> Mmio<B> {
+    /// 🏭 Janela em `base` (`None` se nulo).
+    ///
+    /// # Safety
+    /// `base` deve apontar para um mapeamento Uncached de pelo menos `B::SIZE`
+    /// bytes dos registradores do dispositivo, válido enquanto o `Mmio` existir.
+    pub unsafe fn new(base: *mut u8) -> Option<Self> {
+        NonNull::new(base).map(|base| Mmio { base, _block: PhantomData })
+    }
+
+    /// 🏭 Janela sobre uma região de `len` bytes (ex: o devolvido por `map_bar`);
+    /// `None` se o bloco não cabe nela.
+    ///
+    /// # Safety
+    /// Ver `new`.
+    pub unsafe fn from_region(base: *mut u8, len: usize) -> Option<Self> {
+        if len < B::SIZE {
+            return None;
+        }
+        Self::new(base)
+    }
+
+    /// Endereço virtual da janela.
+    pub fn base(&self) -> *mut u8 {
+        self.base.as_ptr()
+    }
+
+    /// 📥 Lê o registrador (um acesso volátil).
+    #[inline(always)]
+    pub fn read<T: RegisterValue>(&self, register: Register<T, B>) -> T {
+        // # SAFETY: `at` garante o offset alinhado e dentro do bloco, e `new`
+        // garante a janela mapeada com pelo menos `B::SIZE` bytes.
+        unsafe { ptr::read_volatile(self.base.as_ptr().add(register.offset) as *const T) }
+    }
+
+    /// 📤 Escreve o registrador (um acesso volátil).
+    #[inline(always)]
+    pub fn write<T: RegisterValue>(&self, register: Register<T, B>, value: T) {
+        // # SAFETY: Ver `read`.
+        unsafe { ptr::write_volatile(self.base.as_ptr().add(register.offset) as *mut T, value) }
+    }
+
+    /// ✏️ Lê, aplica `update` e escreve: vários campos em dois acessos.
+    #[inline(always)]
+    pub fn modify<T: RegisterValue>(&self, register: Register<T, B>, update: impl FnOnce(T) -> T) {
+        self.write(register, update(self.read(register)));
+    }
+
+    /// Liga os bits de `mask` (leitura-modificação-escrita).
+    #[inline(always)]
+    pub fn set_bits<T: RegisterValue>(&self, register: Register<T, B>, mask: T) {
+        self.modify(register, |value| value | mask);
+    }
+
+    /// Desliga os bits de `mask` (leitura-modificação-escrita).
+    #[inline(always)]
+    pub fn clear_bits<T: RegisterValue>(&self, register: Register<T, B>, mask: T) {
+        self.modify(register, |value| value & !mask);
+    }
+
+    /// 🧩 Sub-bloco `S` em `offset` (ex: um elemento de um array de descritores).
+    /// `None` se não cabe no bloco ou se `offset` não é alinhado a 8.
+    pub fn sub_block<S: RegisterBlock>(&self, offset: usize) -> Option<Mmio<S>> {
+        if offset % 8 != 0 || offset + S::SIZE > B::SIZE {
+            return None;
+        }
+        // # SAFETY: O sub-bloco está dentro desta janela.
+        Some(Mmio { base: unsafe { NonNull::new_unchecked(self.base.as_ptr().add(offset)) }, _block: PhantomData })
+    }
+}
@@ -0,0 +1,24 @@
+// src/kernel/drivers/mod.rs
+
+//! Drivers de Dispositivos do LightOS.
+
+pub mod audio;
+pub mod audio_bench;
+pub mod blit;
+pub mod compositor;
+pub mod damage;
+pub mod display;
+pub mod driver;
+pub mod font;
+pub mod hda;
+pub mod mixer;
+pub mod mmio;
+pub mod overlay;
+pub mod pcm_ring;
+pub mod pci;
+pub mod pixel;
+pub mod sound;
+pub mod text;
+pub mod touchscreen;
+pub mod virtio;
+pub mod keyboard;
@@ -0,0 +1,121 @@
+// src/kernel/drivers/overlay.rs
+
+//! Planos de Overlay (Cursor) Emulados para o LightOS.
+//!
+//! Um overlay é uma pequena imagem ARGB8888 desenhada POR CIMA da tela, fora do
+//! back buffer: mover ou trocar um overlay não gera dano para o compositor.
+//!
+//! O back buffer já guarda os pixels que estão sob cada overlay, então não há
+//! "save-under" separado: para restaurar, o `DisplayDriver` recompõe apenas o
+//! retângulo afetado (back buffer + overlays que o tocam) em um buffer de
+//! rascunho com cache e o copia para o framebuffer. Mover o cursor custa
+//! O(área do cursor), nunca O(tela), e nunca lê a memória de vídeo.
+
+use alloc::vec::Vec;
+use spin::Once;
+
+use super::blit::Rect;
+use super::display::{DisplayError, DISPLAY};
+use super::touchscreen::TouchEvent;
+
+/// 🆔 Identificador de um overlay (índice no `DisplayDriver`).
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+#[repr(transparent)]
+pub struct OverlayId(pub usize);
+
+/// 🪟 Um plano de overlay.
+pub struct OverlayPlane {
+    /// Pixels ARGB8888, `width` por linha.
+    pub(super) image: Vec<u32>,
+    pub(super) width: u32,
+    pub(super) height: u32,
+    pub(super) x: u32,
+    pub(super) y: u32,
+    pub(super) visible: bool,
+}
+
+impl OverlayPlane {
+    /// 🏭 Cria um overlay invisível na origem.
+    pub fn new(width: u32, height: u32, image: &[u32]) -> Result<Self, DisplayError> {
+        if width == 0 || height == 0 || image.len() != width as usize * height as usize {
+            return Err(DisplayError::InvalidOverlay);
+        }
+        Ok(OverlayPlane { image: image.to_vec(), width, height, x: 0, y: 0, visible: false })
+    }
+
+    /// Retângulo ocupado na tela.
+    pub fn rect(&self) -> Rect {
+        Rect::new(self.x, self.y, self.width, self.height)
+    }
+}
+
+// ------------------------------------------------------------------------
+// --- Cursor (Ponteiro) ---
+// ------------------------------------------------------------------------
+
+/// Largura do cursor padrão.
+const CURSOR_WIDTH: u32 = 12;
+/// Altura do cursor padrão.
+const CURSOR_HEIGHT: u32 = 19;
+
+/// Seta padrão: `#` = contorno preto, `.` = preenchimento branco, ` ` = transparente.
+const CURSOR_SHAPE: [&[u8; CURSOR_WIDTH as usize]; CURSOR_HEIGHT as usize] = [
+    b"#           ",
+    b"##          ",
+    b"#.#         ",
+    b"#..#        ",
+    b"#...#       ",
+    b"#....#      ",
+    b"#.....#     ",
+    b"#......#    ",
+    b"#.......#   ",
+    b"#........#  ",
+    b"#.........# ",
+    b"#..........#",
+    b"#......#####",
+    b"#...#..#    ",
+    b"#..# #..#   ",
+    b"#.#  #..#   ",
+    b"##    #..#  ",
+    b"      #..#  ",
+    b"       ##   ",
+];
+
+/// 🖱️ Imagem ARGB8888 da seta padrão.
+pub fn default_cursor_image() -> Vec<u32> {
+    CURSOR_SHAPE
+        .iter()
+        .flat_map(|row| row.iter())
+        .map(|&c| match c {
+            b'#' => 0xFF00_0000,
+            b'.' => 0xFFFF_FFFF,
+            _ => 0x0000_0000,
+        })
+        .collect()
+}
+
+/// Overlay do ponteiro do sistema.
+static POINTER: Once<OverlayId> = Once::new();
+
+/// 🚀 Cria o overlay do ponteiro no `DISPLAY` (chamado após o compositor).
+pub fn init_pointer() -> Result<OverlayId, DisplayError> {
+    let mut display = DISPLAY.get().ok_or(DisplayError::FramebufferNotFound)?.lock();
+    let id = display.create_overlay(CURSOR_WIDTH, CURSOR_HEIGHT, &default_cursor_image())?;
+    let center = display.bounds();
+    display.move_overlay(id, center.width / 2, center.height / 2)?;
+    display.set_overlay_visible(id, true)?;
+    Ok(*POINTER.call_once(|| id))
+}
+
+/// 👆 Move o ponteiro para a posição de um evento de toque.
+/// * Custa O(área do cursor): não passa pelo compositor nem pelo back buffer.
+pub fn on_touch_event(event: &TouchEvent) {
+    let (id, display) = match (POINTER.get(), DISPLAY.get()) {
+        (Some(id), Some(display)) => (*id, display),
+        _ => return,
+    };
+    // Não espera por um quadro em composição: o próximo evento trará a posição nova.
+    if let Some(mut display) = display.try_lock() {
+        let _ = display.move_overlay(id, event.x as u32, event.y as u32);
+    }
+}
@@ -0,0 +1,767 @@
+// src/kernel/drivers/pci.rs
+
+//! Barramento PCI do LightOS.
+//!
+//! Enumeração dos dispositivos, registro de drivers, mapeamento de BARs,
+//! percurso da lista de capabilities e interrupções MSI/MSI-X.
+//!
+//! O espaço de configuração é acessado:
+//! * Por ECAM (PCIe, 4 KiB por função), nas janelas da tabela ACPI MCFG. Cada
+//!   barramento (1 MiB) é mapeado Uncached no primeiro acesso.
+//! * Senão, pelas portas `CONFIG_ADDRESS`/`CONFIG_DATA` (mecanismo #1, 256 bytes
+//!   por função; o espaço estendido lê como 0xFFFF_FFFF).
+//!
+//! A enumeração segue as pontes PCI-PCI a partir do barramento 0 e é feita uma
+//! única vez; os drivers se registram com uma tabela de `PciMatch` e são ligados
+//! aos dispositivos correspondentes ainda livres.
+
+use alloc::vec::Vec;
+use core::ptr;
+use core::sync::atomic::{AtomicUsize, Ordering};
+use spin::{Mutex, Once};
+use x86_64::instructions::port::Port;
+use x86_64::PhysAddr;
+
+use crate::acpi;
+use crate::interrupts::apic::{self, MsiMessage};
+use crate::interrupts::{self, dispatch, VectorSource};
+use crate::memory::paging::{self, CacheMode};
+use crate::RustKernelConfig::arch_hal::{PCI_CONFIG_ADDRESS_PORT, PCI_CONFIG_DATA_PORT};
+
+/// Offsets do cabeçalho de configuração (tipo 0).
+const REG_VENDOR_ID: u16 = 0x00;
+const REG_DEVICE_ID: u16 = 0x02;
+const REG_COMMAND: u16 = 0x04;
+const REG_STATUS: u16 = 0x06;
+const REG_REVISION: u16 = 0x08;
+const REG_HEADER_TYPE: u16 = 0x0E;
+const REG_BAR0: u16 = 0x10;
+const REG_SECONDARY_BUS: u16 = 0x19;
+const REG_SUBSYSTEM_ID: u16 = 0x2E;
+const REG_CAPABILITIES: u16 = 0x34;
+const REG_INTERRUPT_LINE: u16 = 0x3C;
+
+const COMMAND_IO_SPACE: u16 = 1 << 0;
+const COMMAND_MEMORY_SPACE: u16 = 1 << 1;
+const COMMAND_BUS_MASTER: u16 = 1 << 2;
+const COMMAND_INTX_DISABLE: u16 = 1 << 10;
+const STATUS_CAPABILITIES: u16 = 1 << 4;
+
+/// Ponte PCI-PCI (classe 0x06, subclasse 0x04): leva a um barramento secundário.
+const CLASS_BRIDGE: u8 = 0x06;
+const SUBCLASS_PCI_BRIDGE: u8 = 0x04;
+
+/// Espaço de configuração acessível pelas portas (mecanismo #1).
+const LEGACY_CONFIG_SIZE: u16 = 0x100;
+/// Janela ECAM de um barramento: 32 dispositivos x 8 funções x 4 KiB.
+const ECAM_BUS_SIZE: usize = 1 << 20;
+
+/// ID da capability MSI e bits do seu Message Control.
+pub const CAP_ID_MSI: u8 = 0x05;
+const MSI_CONTROL_ENABLE: u16 = 1 << 0;
+const MSI_CONTROL_MULTI_ENABLE: u16 = 0x7 << 4;
+const MSI_CONTROL_64BIT: u16 = 1 << 7;
+/// A MSI tem máscara por vetor (registrador Mask Bits após o dado).
+const MSI_CONTROL_PER_VECTOR_MASK: u16 = 1 << 8;
+
+/// ID da capability MSI-X e bits do seu Message Control.
+pub const CAP_ID_MSIX: u8 = 0x11;
+const MSIX_CONTROL_TABLE_SIZE: u16 = 0x7FF;
+const MSIX_CONTROL_FUNCTION_MASK: u16 = 1 << 14;
+const MSIX_CONTROL_ENABLE: u16 = 1 << 15;
+/// Entrada da tabela MSI-X: endereço (64 bits), dado, controle do vetor.
+const MSIX_ENTRY_SIZE: usize = 16;
+const MSIX_VECTOR_MASKED: u32 = 1;
+
+/// Vendor ID de um slot vazio.
+const VENDOR_NONE: u16 = 0xFFFF;
+
+/// 🚨 Erros do barramento PCI.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum PciError {
+    /// Índice de BAR fora de 0..=5 (ou a metade alta de um BAR de 64 bits).
+    InvalidBar,
+    /// O BAR não está implementado (tamanho zero).
+    BarNotPresent,
+    /// O BAR é de I/O, não de memória.
+    NotMemoryBar,
+    /// Falha ao mapear o BAR na janela de MMIO.
+    MappingFailed,
+    /// A função não tem a capability MSI.
+    MsiUnsupported,
+    /// A função não tem a capability MSI-X.
+    MsixUnsupported,
+    /// Entrada fora da tabela MSI-X.
+    InvalidMsixEntry,
+    /// Sem vetor livre (ou sem x2APIC) para a interrupção.
+    NoFreeVector,
+    /// O BAR já está mapeado com outro tipo de cache (aliasing proibido pelo PAT).
+    CacheModeConflict,
+    /// Já existe um driver com este nome registrado.
+    DriverAlreadyRegistered,
+    /// Sem memória para as tabelas do barramento.
+    OutOfMemory,
+}
+
+/// 📍 Endereço de uma função no barramento.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, PartialOrd, Ord)]
+pub struct PciAddress {
+    pub bus: u8,
+    pub device: u8,
+    pub function: u8,
+}
+
+/// Serializa o par CONFIG_ADDRESS/CONFIG_DATA entre CPUs.
+static CONFIG_LOCK: Mutex<()> = Mutex::new(());
+
+// ------------------------------------------------------------------------
+// --- ECAM ---
+// ------------------------------------------------------------------------
+
+/// 🧱 Uma janela ECAM da MCFG, mapeada um barramento por vez.
+struct EcamWindow {
+    base: u64,
+    start_bus: u8,
+    end_bus: u8,
+    /// Endereço virtual de cada barramento (0 = ainda não mapeado).
+    buses: [AtomicUsize; 256],
+}
+
+static ECAM: Once<Vec<EcamWindow>> = Once::new();
+/// Serializa o mapeamento de barramentos (o caminho mapeado não toma lock).
+static ECAM_MAP_LOCK: Mutex<()> = Mutex::new(());
+
+/// ⚙️ Lê as janelas ECAM da MCFG (só o segmento 0: `PciAddress` não tem segmento).
+/// * Chamado do kernel_main depois de `acpi::init` e antes da primeira enumeração.
+/// Retorna o número de janelas; sem MCFG, o acesso continua pelas portas.
+pub fn init_ecam() -> usize {
+    ECAM.call_once(|| {
+        acpi::mcfg_entries()
+            .into_iter()
+            .filter(|entry| entry.segment == 0 && entry.start_bus <= entry.end_bus)
+            .map(|entry| {
+                const UNMAPPED: AtomicUsize = AtomicUsize::new(0);
+                EcamWindow { base: entry.base, start_bus: entry.start_bus, end_bus: entry.end_bus, buses: [UNMAPPED; 256] }
+            })
+            .collect()
+    })
+    .len()
+}
+
+impl PciAddress {
+    /// Função + offset de configuração em um `u64` (contexto das máscaras de vetor).
+    fn pack(&self, offset: u16) -> u64 {
+        (self.bus as u64) << 32 | (self.device as u64) << 24 | (self.function as u64) << 16 | offset as u64
+    }
+
+    fn unpack(context: u64) -> (PciAddress, u16) {
+        let address = PciAddress { bus: (context >> 32) as u8, device: (context >> 24) as u8, function: (context >> 16) as u8 };
+        (address, context as u16)
+    }
+
+    /// Registrador ECAM que contém `offset`, se a função está numa janela ECAM.
+    fn ecam_register(&self, offset: u16) -> Option<*mut u32> {
+        let window = ECAM.get()?.iter().find(|w| (w.start_bus..=w.end_bus).contains(&self.bus))?;
+        let slot = &window.buses[self.bus as usize];
+        let mut base = slot.load(Ordering::Acquire);
+        if base == 0 {
+            let _guard = ECAM_MAP_LOCK.lock();
+            base = slot.load(Ordering::Acquire);
+            if base == 0 {
+                let phys = PhysAddr::new(window.base + ((self.bus as u64) << 20));
+                base = paging::map_mmio_region(phys, ECAM_BUS_SIZE, CacheMode::Uncached).ok()?.as_u64() as usize;
+                slot.store(base, Ordering::Release);
+            }
+        }
+        let function = (self.device as usize) << 15 | (self.function as usize) << 12;
+        Some((base + function + (offset as usize & 0xFFC)) as *mut u32)
+    }
+
+    fn config_address(&self, offset: u16) -> u32 {
+        0x8000_0000
+            | (self.bus as u32) << 16
+            | (self.device as u32) << 11
+            | (self.function as u32) << 8
+            | (offset as u32 & 0xFC)
+    }
+
+    /// 📥 Lê o dword alinhado que contém `offset`.
+    pub fn read_u32(&self, offset: u16) -> u32 {
+        if let Some(register) = self.ecam_register(offset) {
+            // # SAFETY: O registrador está na janela ECAM mapeada da função.
+            return unsafe { ptr::read_volatile(register) };
+        }
+        if offset >= LEGACY_CONFIG_SIZE {
+            return 0xFFFF_FFFF;
+        }
+        // Sem interrupções com o lock: o top half também acessa a configuração
+        // (máscara da MSI) e esperaria para sempre por um lock da própria CPU.
+        x86_64::instructions::interrupts::without_interrupts(|| {
+            let _guard = CONFIG_LOCK.lock();
+            // # SAFETY: Acesso padrão ao espaço de configuração; o lock mantém o par de
+            // portas consistente.
+            unsafe {
+                Port::<u32>::new(PCI_CONFIG_ADDRESS_PORT).write(self.config_address(offset));
+                Port::<u32>::new(PCI_CONFIG_DATA_PORT).read()
+            }
+        })
+    }
+
+    /// 📤 Escreve o dword alinhado em `offset`.
+    pub fn write_u32(&self, offset: u16, value: u32) {
+        if let Some(register) = self.ecam_register(offset) {
+            // # SAFETY: Ver `read_u32`.
+            return unsafe { ptr::write_volatile(register, value) };
+        }
+        if offset >= LEGACY_CONFIG_SIZE {
+            return;
+        }
+        // Ver `read_u32` (lock tomado com interrupções desabilitadas).
+        x86_64::instructions::interrupts::without_interrupts(|| {
+            let _guard = CONFIG_LOCK.lock();
+            // # SAFETY: Ver `read_u32`.
+            unsafe {
+                Port::<u32>::new(PCI_CONFIG_ADDRESS_PORT).write(self.config_address(offset));
+                Port::<u32>::new(PCI_CONFIG_DATA_PORT).write(value);
+            }
+        })
+    }
+
+    pub fn read_u16(&self, offset: u16) -> u16 {
+        (self.read_u32(offset) >> ((offset & 2) * 8)) as u16
+    }
+
+    pub fn read_u8(&self, offset: u16) -> u8 {
+        (self.read_u32(offset) >> ((offset & 3) * 8)) as u8
+    }
+
+    /// 📤 Escreve 16 bits (leitura-modificação-escrita do dword).
+    pub fn write_u16(&self, offset: u16, value: u16) {
+        let shift = (offset & 2) * 8;
+        let dword = self.read_u32(offset) & !(0xFFFF << shift) | (value as u32) << shift;
+        self.write_u32(offset, dword);
+    }
+}
+
+/// 🗺️ Um BAR decodificado.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum Bar {
+    /// Janela de memória.
+    Memory { base: u64, size: u64, prefetchable: bool },
+    /// Janela de portas de I/O.
+    Io { port: u16, size: u32 },
+}
+
+/// 🔌 Uma função PCI encontrada na enumeração.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct PciDevice {
+    pub address: PciAddress,
+    pub vendor_id: u16,
+    pub device_id: u16,
+    pub subsystem_id: u16,
+    pub class: u8,
+    pub subclass: u8,
+    pub prog_if: u8,
+    pub revision: u8,
+    /// Linha INTx configurada pelo firmware (0xFF = nenhuma).
+    pub interrupt_line: u8,
+}
+
+impl PciDevice {
+    fn probe(address: PciAddress) -> Option<Self> {
+        let id = address.read_u32(REG_VENDOR_ID);
+        if id as u16 == VENDOR_NONE {
+            return None;
+        }
+        let class = address.read_u32(REG_REVISION);
+        Some(PciDevice {
+            address,
+            vendor_id: id as u16,
+            device_id: (id >> 16) as u16,
+            subsystem_id: address.read_u16(REG_SUBSYSTEM_ID),
+            class: (class >> 24) as u8,
+            subclass: (class >> 16) as u8,
+            prog_if: (class >> 8) as u8,
+            revision: class as u8,
+            interrupt_line: address.read_u8(REG_INTERRUPT_LINE),
+        })
+    }
+
+    /// ⚙️ Habilita a decodificação de memória/I/O e o bus mastering (DMA).
+    pub fn enable(&self) {
+        let command = self.address.read_u16(REG_COMMAND);
+        self.address.write_u16(REG_COMMAND, command | COMMAND_MEMORY_SPACE | COMMAND_IO_SPACE | COMMAND_BUS_MASTER);
+    }
+
+    /// 🛑 Desliga o bus mastering: o dispositivo não faz mais DMA (último recurso
+    /// quando ele não aceita um reset).
+    pub fn disable_bus_master(&self) {
+        let command = self.address.read_u16(REG_COMMAND);
+        self.address.write_u16(REG_COMMAND, command & !COMMAND_BUS_MASTER);
+    }
+
+    /// 🔇 Desliga a interrupção INTx legada (ao usar MSI/MSI-X ou polling).
+    pub fn disable_intx(&self) {
+        let command = self.address.read_u16(REG_COMMAND);
+        self.address.write_u16(REG_COMMAND, command | COMMAND_INTX_DISABLE);
+    }
+
+    /// 🔊 Religa a interrupção INTx legada (ao desistir da MSI/MSI-X).
+    pub fn enable_intx(&self) {
+        let command = self.address.read_u16(REG_COMMAND);
+        self.address.write_u16(REG_COMMAND, command & !COMMAND_INTX_DISABLE);
+    }
+
+    /// 📨 Programa e habilita a MSI com um único vetor (`message` vem de
+    /// `apic::msi_message`) e desliga a INTx.
+    /// * Com máscara por vetor, o vetor passa a ser mascarado na função
+    ///   (`interrupts::mask_vector`).
+    pub fn enable_msi(&self, message: MsiMessage) -> Result<(), PciError> {
+        let (_, cap) = self.capabilities().find(|&(id, _)| id == CAP_ID_MSI).ok_or(PciError::MsiUnsupported)?;
+        let control = self.address.read_u16(cap + 2);
+
+        // Desligada enquanto o endereço/dado são trocados.
+        self.address.write_u16(cap + 2, control & !(MSI_CONTROL_ENABLE | MSI_CONTROL_MULTI_ENABLE));
+        self.address.write_u32(cap + 4, message.address as u32);
+        let mask_bits = if control & MSI_CONTROL_64BIT != 0 {
+            self.address.write_u32(cap + 8, (message.address >> 32) as u32);
+            self.address.write_u16(cap + 12, message.data as u16);
+            cap + 16
+        } else {
+            self.address.write_u16(cap + 8, message.data as u16);
+            cap + 12
+        };
+        if control & MSI_CONTROL_PER_VECTOR_MASK != 0 {
+            interrupts::set_vector_source(
+                message.data as u8,
+                VectorSource::Device { mask: mask_msi, context: self.address.pack(mask_bits) },
+            );
+        }
+        self.address.write_u16(cap + 2, control & !MSI_CONTROL_MULTI_ENABLE | MSI_CONTROL_ENABLE);
+        self.disable_intx();
+        Ok(())
+    }
+
+    /// 🔍 Lê e dimensiona o BAR `index` (0..=5).
+    /// * O dimensionamento escreve 1s no BAR com a decodificação desligada.
+    pub fn bar(&self, index: u8) -> Result<Bar, PciError> {
+        if index > 5 {
+            return Err(PciError::InvalidBar);
+        }
+        let offset = REG_BAR0 + index as u16 * 4;
+        let addr = self.address;
+        let original = addr.read_u32(offset);
+
+        let command = addr.read_u16(REG_COMMAND);
+        addr.write_u16(REG_COMMAND, command & !(COMMAND_MEMORY_SPACE | COMMAND_IO_SPACE));
+
+        let bar = if original & 1 == 1 {
+            addr.write_u32(offset, 0xFFFF_FFFF);
+            let mask = addr.read_u32(offset) & !0x3;
+            addr.write_u32(offset, original);
+            let size = (!mask).wrapping_add(1) & 0xFFFF;
+            Bar::Io { port: (original & !0x3) as u16, size }
+        } else {
+            let is_64 = (original >> 1) & 0x3 == 0x2;
+            if is_64 && index == 5 {
+                addr.write_u16(REG_COMMAND, command);
+                return Err(PciError::InvalidBar);
+            }
+            let original_high = if is_64 { addr.read_u32(offset + 4) } else { 0 };
+
+            addr.write_u32(offset, 0xFFFF_FFFF);
+            let mut mask = (addr.read_u32(offset) & !0xF) as u64;
+            addr.write_u32(offset, original);
+            if is_64 {
+                addr.write_u32(offset + 4, 0xFFFF_FFFF);
+                mask |= (addr.read_u32(offset + 4) as u64) << 32;
+                addr.write_u32(offset + 4, original_high);
+            } else {
+                mask |= 0xFFFF_FFFF_0000_0000;
+            }
+
+            Bar::Memory {
+                base: (original & !0xF) as u64 | (original_high as u64) << 32,
+                size: (!mask).wrapping_add(1),
+                prefetchable: original & 0x8 != 0,
+            }
+        };
+
+        addr.write_u16(REG_COMMAND, command);
+        match bar {
+            Bar::Memory { size: 0, .. } | Bar::Io { size: 0, .. } => Err(PciError::BarNotPresent),
+            bar => Ok(bar),
+        }
+    }
+
+    /// 🗺️ Mapeia o BAR de memória `index` na janela de MMIO do kernel.
+    /// * Registradores ficam Uncached; só BARs prefetchable aceitam Write-Combining
+    ///   (o pedido cai para Uncached nos demais).
+    /// * Cada BAR é mapeado uma única vez: chamadas seguintes devolvem o mesmo
+    ///   mapeamento, sem redimensionar o BAR de um dispositivo já ativo.
+    pub fn map_bar(&self, index: u8, cache: CacheMode) -> Result<(*mut u8, usize), PciError> {
+        let mut mappings = BAR_MAPPINGS.lock();
+        if let Some(mapping) = mappings.iter().find(|m| m.address == self.address && m.index == index) {
+            let cache = if mapping.prefetchable { cache } else { CacheMode::Uncached };
+            if cache != mapping.cache {
+                return Err(PciError::CacheModeConflict);
+            }
+            return Ok((mapping.virt as *mut u8, mapping.size));
+        }
+
+        match self.bar(index)? {
+            Bar::Memory { base, size, prefetchable } => {
+                let cache = if prefetchable { cache } else { CacheMode::Uncached };
+                mappings.try_reserve(1).map_err(|_| PciError::OutOfMemory)?;
+                let virt = paging::map_mmio_region(PhysAddr::new(base), size as usize, cache)
+                    .map_err(|_| PciError::MappingFailed)?;
+                let mapping = BarMapping {
+                    address: self.address,
+                    index,
+                    prefetchable,
+                    cache,
+                    virt: virt.as_u64() as usize,
+                    size: size as usize,
+                };
+                mappings.push(mapping);
+                Ok((virt.as_mut_ptr(), size as usize))
+            }
+            Bar::Io { .. } => Err(PciError::NotMemoryBar),
+        }
+    }
+
+    /// 📨 Liga a MSI-X com todas as entradas mascaradas e desliga a INTx.
+    /// * As entradas são programadas depois, com `MsixTable::route_entry`; se o
+    ///   dispositivo recusar o vetor, `disable_msix` volta à INTx.
+    pub fn enable_msix(&self) -> Result<MsixTable, PciError> {
+        let (_, cap) = self.capabilities().find(|&(id, _)| id == CAP_ID_MSIX).ok_or(PciError::MsixUnsupported)?;
+        let control = self.address.read_u16(cap + 2);
+        let entries = (control & MSIX_CONTROL_TABLE_SIZE) + 1;
+        // Tabela: BAR nos 3 bits baixos (BIR), offset no resto.
+        let location = self.address.read_u32(cap + 4);
+        let offset = (location & !0x7) as usize;
+        let (bar, size) = self.map_bar((location & 0x7) as u8, CacheMode::Uncached)?;
+        if offset + entries as usize * MSIX_ENTRY_SIZE > size {
+            return Err(PciError::InvalidBar);
+        }
+        // # SAFETY: A tabela está dentro do BAR mapeado (verificado acima).
+        let table = MsixTable { address: self.address, table: unsafe { bar.add(offset) } as *mut u32, entries };
+
+        // Função inteira mascarada enquanto as entradas são mascaradas uma a uma.
+        self.address.write_u16(cap + 2, control | MSIX_CONTROL_ENABLE | MSIX_CONTROL_FUNCTION_MASK);
+        for entry in 0..entries {
+            table.set_masked(entry, true);
+        }
+        self.address.write_u16(cap + 2, (control | MSIX_CONTROL_ENABLE) & !MSIX_CONTROL_FUNCTION_MASK);
+        self.disable_intx();
+        Ok(table)
+    }
+
+    /// ↩️ Desfaz `enable_msix`: desliga a MSI-X e religa a INTx.
+    /// * Os vetores das entradas são devolvidos pelo chamador (`dispatch::free_vector`).
+    pub fn disable_msix(&self) {
+        if let Some((_, cap)) = self.capabilities().find(|&(id, _)| id == CAP_ID_MSIX) {
+            let control = self.address.read_u16(cap + 2);
+            self.address.write_u16(cap + 2, control & !(MSIX_CONTROL_ENABLE | MSIX_CONTROL_FUNCTION_MASK));
+        }
+        self.enable_intx();
+    }
+
+    /// 🧩 Percorre a lista de capabilities: (id, offset no espaço de configuração).
+    pub fn capabilities(&self) -> impl Iterator<Item = (u8, u16)> {
+        let addr = self.address;
+        let mut next = if addr.read_u16(REG_STATUS) & STATUS_CAPABILITIES != 0 {
+            addr.read_u8(REG_CAPABILITIES) & !0x3
+        } else {
+            0
+        };
+        // Limite contra listas circulares em hardware defeituoso.
+        let mut remaining = 48;
+        core::iter::from_fn(move || {
+            if next == 0 || remaining == 0 {
+                return None;
+            }
+            remaining -= 1;
+            let offset = next as u16;
+            let header = addr.read_u16(offset);
+            next = (header >> 8) as u8 & !0x3;
+            Some((header as u8, offset))
+        })
+    }
+}
+
+// ------------------------------------------------------------------------
+// --- Mapeamentos de BAR ---
+// ------------------------------------------------------------------------
+
+/// 🗺️ Um BAR já mapeado (a janela de MMIO nunca é liberada).
+struct BarMapping {
+    address: PciAddress,
+    index: u8,
+    prefetchable: bool,
+    cache: CacheMode,
+    virt: usize,
+    size: usize,
+}
+
+static BAR_MAPPINGS: Mutex<Vec<BarMapping>> = Mutex::new(Vec::new());
+
+// ------------------------------------------------------------------------
+// --- MSI-X ---
+// ------------------------------------------------------------------------
+
+/// 📨 Tabela MSI-X de uma função (no BAR indicado pela capability).
+pub struct MsixTable {
+    address: PciAddress,
+    table: *mut u32,
+    entries: u16,
+}
+
+// # SAFETY: A tabela é MMIO da própria função; cada entrada é escrita pelo dono do driver.
+unsafe impl Send for MsixTable {}
+
+impl MsixTable {
+    /// Número de entradas (vetores) da função.
+    pub fn len(&self) -> u16 {
+        self.entries
+    }
+
+    /// Dword `word` da `entry` (0-1: endereço, 2: dado, 3: controle).
+    fn word(&self, entry: u16, word: usize) -> *mut u32 {
+        // # SAFETY: `entry < entries`: dentro da tabela (verificado pelos chamadores).
+        unsafe { self.table.add(entry as usize * MSIX_ENTRY_SIZE / 4 + word) }
+    }
+
+    fn set_masked(&self, entry: u16, masked: bool) {
+        let control = self.word(entry, 3);
+        // # SAFETY: Registrador de controle da entrada.
+        unsafe {
+            let value = ptr::read_volatile(control) & !MSIX_VECTOR_MASKED;
+            ptr::write_volatile(control, value | if masked { MSIX_VECTOR_MASKED } else { 0 });
+        }
+    }
+
+    /// 📨 Programa a `entry` com `message` (de `apic::msi_message`) e a desmascara.
+    /// * Chamado de novo com outro destino, muda a afinidade da entrada.
+    pub fn set_entry(&self, entry: u16, message: MsiMessage) -> Result<(), PciError> {
+        if entry >= self.entries {
+            return Err(PciError::InvalidMsixEntry);
+        }
+        // Mascarada enquanto endereço/dado são trocados (a mensagem nunca sai pela metade).
+        self.set_masked(entry, true);
+        // # SAFETY: Palavras da entrada, dentro da tabela.
+        unsafe {
+            ptr::write_volatile(self.word(entry, 0), message.address as u32);
+            ptr::write_volatile(self.word(entry, 1), (message.address >> 32) as u32);
+            ptr::write_volatile(self.word(entry, 2), message.data);
+        }
+        self.set_masked(entry, false);
+        Ok(())
+    }
+
+    /// 🔇 Mascara a `entry` (a função guarda a interrupção como pendente no PBA).
+    pub fn mask(&self, entry: u16) {
+        if entry < self.entries {
+            self.set_masked(entry, true);
+        }
+    }
+
+    /// 🔊 Desmascara a `entry`.
+    pub fn unmask(&self, entry: u16) {
+        if entry < self.entries {
+            self.set_masked(entry, false);
+        }
+    }
+
+    /// 🎟️ Reserva um vetor dinâmico e o entrega, pela `entry`, ao APIC `dest_apic_id`.
+    /// * Entradas diferentes podem mirar CPUs diferentes (uma fila por CPU).
+    /// * O vetor é mascarado na própria entrada (`interrupts::mask_vector`).
+    /// * Exige o x2APIC ativo. Retorna o vetor para `request_threaded_irq`.
+    pub fn route_entry(&self, entry: u16, dest_apic_id: u32) -> Result<u8, PciError> {
+        if !apic::is_active() {
+            return Err(PciError::NoFreeVector);
+        }
+        if entry >= self.entries {
+            return Err(PciError::InvalidMsixEntry);
+        }
+        let vector = dispatch::allocate_vector().map_err(|_| PciError::NoFreeVector)?;
+        let message = match apic::msi_message(vector, dest_apic_id) {
+            Ok(message) => message,
+            Err(_) => {
+                dispatch::free_vector(vector);
+                return Err(PciError::NoFreeVector);
+            }
+        };
+        interrupts::set_vector_source(
+            vector,
+            VectorSource::Device { mask: mask_msix_entry, context: self.word(entry, 3) as u64 },
+        );
+        self.set_entry(entry, message)?;
+        Ok(vector)
+    }
+}
+
+/// 🔇 Máscara de uma entrada MSI-X (`context`: endereço do seu dword de controle).
+fn mask_msix_entry(context: u64, masked: bool) {
+    let control = context as *mut u32;
+    // # SAFETY: `context` vem de `route_entry`: o controle de uma entrada da tabela
+    // mapeada (o mapeamento de BAR nunca é desfeito).
+    unsafe {
+        let value = ptr::read_volatile(control) & !MSIX_VECTOR_MASKED;
+        ptr::write_volatile(control, value | if masked { MSIX_VECTOR_MASKED } else { 0 });
+    }
+}
+
+/// 🔇 Máscara por vetor da MSI (`context`: função + offset do registrador Mask Bits).
+fn mask_msi(context: u64, masked: bool) {
+    let (address, offset) = PciAddress::unpack(context);
+    let bits = address.read_u32(offset) & !1;
+    address.write_u32(offset, bits | masked as u32);
+}
+
+// ------------------------------------------------------------------------
+// --- Enumeração ---
+// ------------------------------------------------------------------------
+
+/// Funções encontradas na (única) enumeração.
+static DEVICES: Once<Vec<PciDevice>> = Once::new();
+
+/// Percorre `bus` e, recursivamente, os barramentos atrás das suas pontes.
+fn scan_bus(bus: u8, devices: &mut Vec<PciDevice>, visited: &mut [bool; 256]) {
+    if core::mem::replace(&mut visited[bus as usize], true) {
+        return;
+    }
+    for device in 0..32u8 {
+        let first = PciAddress { bus, device, function: 0 };
+        if PciDevice::probe(first).is_none() {
+            continue;
+        }
+        // Bit 7 do Header Type: dispositivo com várias funções.
+        let functions = if first.read_u8(REG_HEADER_TYPE) & 0x80 != 0 { 8 } else { 1 };
+        for function in 0..functions {
+            let address = PciAddress { bus, device, function };
+            let dev = match PciDevice::probe(address) {
+                Some(dev) => dev,
+                None => continue,
+            };
+            devices.push(dev);
+            if dev.class == CLASS_BRIDGE && dev.subclass == SUBCLASS_PCI_BRIDGE {
+                let secondary = address.read_u8(REG_SECONDARY_BUS);
+                if secondary != 0 {
+                    scan_bus(secondary, devices, visited);
+                }
+            }
+        }
+    }
+}
+
+/// 🔎 Funções presentes no barramento.
+/// * A varredura (a partir do barramento 0, seguindo as pontes) é feita na primeira chamada.
+pub fn enumerate() -> Vec<PciDevice> {
+    DEVICES
+        .call_once(|| {
+            let mut devices = Vec::new();
+            let mut visited = [false; 256];
+            // Host bridge com várias funções: a função N é a raiz do barramento N.
+            let host = PciAddress { bus: 0, device: 0, function: 0 };
+            if host.read_u8(REG_HEADER_TYPE) & 0x80 != 0 {
+                for function in 0..8u8 {
+                    if PciDevice::probe(PciAddress { bus: 0, device: 0, function }).is_some() {
+                        scan_bus(function, &mut devices, &mut visited);
+                    }
+                }
+            } else {
+                scan_bus(0, &mut devices, &mut visited);
+            }
+            // Barramentos raiz adicionais declarados na MCFG.
+            for window in ECAM.get().into_iter().flatten() {
+                if PciDevice::probe(PciAddress { bus: window.start_bus, device: 0, function: 0 }).is_some() {
+                    scan_bus(window.start_bus, &mut devices, &mut visited);
+                }
+            }
+            devices
+        })
+        .clone()
+}
+
+/// 🔍 Primeiro dispositivo com o par vendor/device dado.
+pub fn find_device(vendor_id: u16, device_id: u16) -> Option<PciDevice> {
+    enumerate().into_iter().find(|d| d.vendor_id == vendor_id && d.device_id == device_id)
+}
+
+// ------------------------------------------------------------------------
+// --- Registro de Drivers ---
+// ------------------------------------------------------------------------
+
+/// 🪪 Critério de correspondência de um driver (campos `None` aceitam qualquer valor).
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct PciMatch {
+    pub vendor_id: Option<u16>,
+    pub device_id: Option<u16>,
+    pub class: Option<u8>,
+    pub subclass: Option<u8>,
+}
+
+impl PciMatch {
+    /// Par vendor/device exato.
+    pub const fn device(vendor_id: u16, device_id: u16) -> Self {
+        PciMatch { vendor_id: Some(vendor_id), device_id: Some(device_id), class: None, subclass: None }
+    }
+
+    /// Qualquer função da classe/subclasse dadas.
+    pub const fn class(class: u8, subclass: u8) -> Self {
+        PciMatch { vendor_id: None, device_id: None, class: Some(class), subclass: Some(subclass) }
+    }
+
+    pub fn matches(&self, device: &PciDevice) -> bool {
+        self.vendor_id.map_or(true, |v| v == device.vendor_id)
+            && self.device_id.map_or(true, |d| d == device.device_id)
+            && self.class.map_or(true, |c| c == device.class)
+            && self.subclass.map_or(true, |s| s == device.subclass)
+    }
+}
+
+/// 🚗 Um driver PCI.
+pub struct PciDriver {
+    pub name: &'static str,
+    pub matches: &'static [PciMatch],
+    /// Inicializa o dispositivo; `true` se o driver o assumiu.
+    pub probe: fn(PciDevice) -> bool,
+}
+
+/// Drivers registrados e a qual driver cada função está ligada.
+static DRIVERS: Mutex<Vec<&'static PciDriver>> = Mutex::new(Vec::new());
+static BOUND: Mutex<Vec<(PciAddress, &'static str)>> = Mutex::new(Vec::new());
+
+/// ➕ Registra `driver` e o liga a cada função correspondente ainda sem driver.
+/// Retorna quantas funções ele assumiu.
+/// * `probe` roda sem nenhum lock do registro (pode enumerar e mapear BARs).
+pub fn register_driver(driver: &'static PciDriver) -> Result<usize, PciError> {
+    {
+        let mut drivers = DRIVERS.lock();
+        if drivers.iter().any(|d| d.name == driver.name) {
+            return Err(PciError::DriverAlreadyRegistered);
+        }
+        drivers.try_reserve(1).map_err(|_| PciError::OutOfMemory)?;
+        drivers.push(driver);
+    }
+
+    let mut bound = 0;
+    for device in enumerate() {
+        if !driver.matches.iter().any(|m| m.matches(&device)) || bound_driver(device.address).is_some() {
+            continue;
+        }
+        if (driver.probe)(device) {
+            let mut table = BOUND.lock();
+            table.try_reserve(1).map_err(|_| PciError::OutOfMemory)?;
+            table.push((device.address, driver.name));
+            bound += 1;
+        }
+    }
+    Ok(bound)
+}
+
+/// Nome do driver ligado à função `address`, se houver.
+pub fn bound_driver(address: PciAddress) -> Option<&'static str> {
+    BOUND.lock().iter().find(|(a, _)| *a == address).map(|&(_, name)| name)
+}
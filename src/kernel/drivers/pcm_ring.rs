@@ -0,0 +1,269 @@
+// src/kernel/drivers/pcm_ring.rs
+
+//! Anéis de Períodos PCM Compartilhados com Userspace.
+//!
+//! Uma tarefa que toca áudio continuamente não precisa de uma syscall (nem de
+//! uma cópia para a fila do kernel) por período:
+//! * O anel é uma região de `memory::shared`: um cabeçalho de uma página seguido
+//!   de `period_count` períodos no formato do fluxo.
+//! * A tarefa preenche o período `write_index % period_count` e incrementa
+//!   `write_index` (Release).
+//! * O mixer lê os períodos submetidos diretamente da região, avança
+//!   `read_index` ao terminar cada um e, se a tarefa registrou um endpoint,
+//!   envia uma notificação IPC coalescida (`ipc::notify`) com o novo índice.
+//!
+//! A tarefa só pode reescrever um período depois que `read_index` passar dele.
+
+use alloc::collections::BTreeMap;
+use core::sync::atomic::{AtomicU32, AtomicU64, Ordering};
+use spin::Mutex;
+use x86_64::{PhysAddr, VirtAddr};
+
+use super::audio::{self, AudioFormat};
+use super::mixer::StreamHandle;
+use super::sound::SoundError;
+use crate::ipc::{self, Endpoint};
+use crate::memory::shared::{self, SharedRegionId};
+use crate::task::TaskId;
+
+/// "PCMR" em little-endian.
+pub const PCM_RING_MAGIC: u32 = 0x524D_4350;
+pub const PCM_RING_VERSION: u32 = 1;
+/// Os períodos começam após a página do cabeçalho.
+pub const PCM_RING_DATA_OFFSET: usize = 4096;
+/// Limites do anel.
+pub const MIN_RING_PERIODS: usize = 2;
+pub const MAX_RING_PERIODS: usize = 64;
+pub const MAX_RING_BYTES: usize = 1024 * 1024;
+
+/// Remetente das notificações (o kernel).
+const KERNEL_SENDER: Endpoint = Endpoint(0);
+/// Endpoint 0: nenhuma notificação registrada.
+const NO_ENDPOINT: u64 = 0;
+
+/// 🔢 Índice em uma linha de cache própria (produtor e consumidor não disputam a linha).
+#[repr(C, align(64))]
+pub struct RingIndex {
+    pub value: AtomicU64,
+}
+
+/// 📋 Cabeçalho no início da região (ABI com userspace).
+#[repr(C)]
+pub struct PcmRingHeader {
+    pub magic: u32,
+    pub version: u32,
+    pub sample_rate: u32,
+    pub channels: u32,
+    pub bits_per_sample: u32,
+    pub period_bytes: u32,
+    pub period_count: u32,
+    pub data_offset: u32,
+    /// Períodos submetidos pela tarefa (só ela escreve).
+    pub write_index: RingIndex,
+    /// Períodos consumidos pelo mixer (só o kernel escreve).
+    pub read_index: RingIndex,
+    /// Períodos em que o mixer encontrou o anel vazio com o fluxo ativo.
+    pub underruns: RingIndex,
+}
+
+/// 💿 Visão do kernel de um anel (lado consumidor).
+pub struct PcmRing {
+    region: SharedRegionId,
+    header: *mut PcmRingHeader,
+    data: *const u8,
+    format: AudioFormat,
+    period_bytes: usize,
+    period_count: usize,
+    /// Bytes consumidos desde a criação (só o mixer altera).
+    consumed: AtomicU64,
+    notify: AtomicU64,
+}
+
+// # SAFETY: O cabeçalho só é acessado por atômicos (índices) ou lido após a
+// inicialização (campos fixos); os períodos são lidos somente depois de
+// submetidos pela tarefa.
+unsafe impl Send for PcmRing {}
+unsafe impl Sync for PcmRing {}
+
+impl PcmRing {
+    /// 🏭 Aloca e inicializa um anel de `period_count` períodos de `period_frames` quadros.
+    pub fn new(format: AudioFormat, period_frames: usize, period_count: usize) -> Result<Self, SoundError> {
+        let period_bytes = period_frames * format.bytes_per_frame();
+        let total = period_bytes * period_count;
+        if period_bytes == 0 || !(MIN_RING_PERIODS..=MAX_RING_PERIODS).contains(&period_count) || total > MAX_RING_BYTES {
+            return Err(SoundError::InvalidBuffer);
+        }
+        let region = shared::create(PCM_RING_DATA_OFFSET + total).map_err(|_| SoundError::OutOfMemory)?;
+        let (base, _) = shared::kernel_view(region).ok_or(SoundError::OutOfMemory)?;
+
+        let header = base as *mut PcmRingHeader;
+        // # SAFETY: A região tem pelo menos uma página, zerada, exclusiva deste anel.
+        unsafe {
+            header.write(PcmRingHeader {
+                magic: PCM_RING_MAGIC,
+                version: PCM_RING_VERSION,
+                sample_rate: format.sample_rate,
+                channels: format.channels as u32,
+                bits_per_sample: format.bits_per_sample as u32,
+                period_bytes: period_bytes as u32,
+                period_count: period_count as u32,
+                data_offset: PCM_RING_DATA_OFFSET as u32,
+                write_index: RingIndex { value: AtomicU64::new(0) },
+                read_index: RingIndex { value: AtomicU64::new(0) },
+                underruns: RingIndex { value: AtomicU64::new(0) },
+            });
+        }
+        Ok(PcmRing {
+            region,
+            header,
+            // # SAFETY: Os períodos ficam dentro da região.
+            data: unsafe { base.add(PCM_RING_DATA_OFFSET) },
+            format,
+            period_bytes,
+            period_count,
+            consumed: AtomicU64::new(0),
+            notify: AtomicU64::new(NO_ENDPOINT),
+        })
+    }
+
+    fn header(&self) -> &PcmRingHeader {
+        // # SAFETY: O cabeçalho vive enquanto a região existir (até o `Drop`).
+        unsafe { &*self.header }
+    }
+
+    pub fn format(&self) -> AudioFormat {
+        self.format
+    }
+
+    pub fn region(&self) -> SharedRegionId {
+        self.region
+    }
+
+    /// 🔔 Endpoint notificado a cada período consumido (`None` desliga).
+    pub fn set_notify(&self, endpoint: Option<Endpoint>) {
+        self.notify.store(endpoint.map_or(NO_ENDPOINT, |e| e.0), Ordering::Relaxed);
+    }
+
+    /// Limite de bytes submetidos. Uma tarefa que avança `write_index` mais de um
+    /// anel à frente tem o excesso ignorado (seriam períodos sobrescritos).
+    fn submitted_bytes(&self, consumed: u64) -> u64 {
+        let written = self.header().write_index.value.load(Ordering::Acquire);
+        let read = consumed / self.period_bytes as u64;
+        written.min(read + self.period_count as u64) * self.period_bytes as u64
+    }
+
+    /// Bytes submetidos e ainda não consumidos.
+    pub fn available(&self) -> usize {
+        let consumed = self.consumed.load(Ordering::Relaxed);
+        self.submitted_bytes(consumed).saturating_sub(consumed) as usize
+    }
+
+    /// 📥 Entrega até `max` bytes submetidos a `sink`, direto da região (em até
+    /// duas fatias, na volta do anel), e os marca como consumidos.
+    /// * `write_index` é escrito pela tarefa: um valor abaixo do já consumido
+    ///   não entrega nada, e nunca mais de um anel é entregue por chamada.
+    pub fn consume(&self, max: usize, mut sink: impl FnMut(&[u8])) -> usize {
+        let start = self.consumed.load(Ordering::Relaxed);
+        let total = (self.period_bytes * self.period_count) as u64;
+        let mut position = start;
+        let submitted = self.submitted_bytes(start);
+        let end = start + submitted.saturating_sub(start).min(total).min(max as u64);
+
+        while position < end {
+            let offset = position % total;
+            let len = (end - position).min(total - offset);
+            // # SAFETY: `offset + len <= total`: dentro dos períodos; os bytes foram
+            // submetidos (Acquire em `submitted_bytes`) e a tarefa não os altera
+            // até `read_index` avançar.
+            sink(unsafe { core::slice::from_raw_parts(self.data.add(offset as usize), len as usize) });
+            position += len;
+        }
+        self.consumed.store(end, Ordering::Relaxed);
+
+        let finished = end / self.period_bytes as u64;
+        if finished > start / self.period_bytes as u64 {
+            self.header().read_index.value.store(finished, Ordering::Release);
+            let endpoint = self.notify.load(Ordering::Relaxed);
+            if endpoint != NO_ENDPOINT {
+                let _ = ipc::notify(Endpoint(endpoint), KERNEL_SENDER, finished);
+            }
+        }
+        (end - start) as usize
+    }
+
+    /// Conta um underrun no cabeçalho (visível à tarefa).
+    pub fn note_underrun(&self) {
+        self.header().underruns.value.fetch_add(1, Ordering::Relaxed);
+    }
+}
+
+impl Drop for PcmRing {
+    fn drop(&mut self) {
+        let _ = shared::release(self.region);
+    }
+}
+
+// ------------------------------------------------------------------------
+// --- Registro (usado pelas Syscalls) ---
+// ------------------------------------------------------------------------
+
+/// 🆔 Identificador de um anel aberto.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, PartialOrd, Ord)]
+#[repr(transparent)]
+pub struct PcmRingId(pub u32);
+
+/// 📌 Um anel aberto e a tarefa que o criou (a única que pode usá-lo).
+struct RingEntry {
+    owner: TaskId,
+    stream: StreamHandle,
+}
+
+static RINGS: Mutex<BTreeMap<PcmRingId, RingEntry>> = Mutex::new(BTreeMap::new());
+static NEXT_ID: AtomicU32 = AtomicU32::new(1);
+
+/// ➕ Cria um anel de `owner` e o conecta ao mixer como um fluxo.
+pub fn create(owner: TaskId, format: AudioFormat, period_frames: usize, period_count: usize) -> Result<PcmRingId, SoundError> {
+    let ring = PcmRing::new(format, period_frames, period_count)?;
+    let stream = audio::open_ring(ring)?;
+    let id = PcmRingId(NEXT_ID.fetch_add(1, Ordering::Relaxed));
+    RINGS.lock().insert(id, RingEntry { owner, stream });
+    Ok(id)
+}
+
+/// 🗺️ Mapeia o anel no espaço de endereçamento `p4_phys`; retorna o endereço do cabeçalho.
+pub fn map(id: PcmRingId, owner: TaskId, p4_phys: PhysAddr) -> Result<VirtAddr, SoundError> {
+    let region = with_ring(id, owner, |ring| ring.region())?;
+    shared::map_into(region, p4_phys).map_err(|_| SoundError::OutOfMemory)
+}
+
+/// 🔔 Registra (ou remove, com `None`) o endpoint notificado pelo anel.
+pub fn set_notify(id: PcmRingId, owner: TaskId, endpoint: Option<Endpoint>) -> Result<(), SoundError> {
+    with_ring(id, owner, |ring| ring.set_notify(endpoint))
+}
+
+/// 🎚️ Ganho Q15 do fluxo do anel.
+pub fn set_gain(id: PcmRingId, owner: TaskId, gain: u32) -> Result<(), SoundError> {
+    let rings = RINGS.lock();
+    let entry = owned(&rings, id, owner)?;
+    entry.stream.set_gain(gain);
+    Ok(())
+}
+
+/// ➖ Fecha o anel: o mixer solta o fluxo no próximo período e a região é liberada.
+pub fn destroy(id: PcmRingId, owner: TaskId) -> Result<(), SoundError> {
+    let mut rings = RINGS.lock();
+    owned(&rings, id, owner)?;
+    rings.remove(&id);
+    Ok(())
+}
+
+/// Entrada `id`, se pertence a `owner`. Um anel de outra tarefa é tratado como
+/// inexistente (o id não revela nada sobre os anéis alheios).
+fn owned(rings: &BTreeMap<PcmRingId, RingEntry>, id: PcmRingId, owner: TaskId) -> Result<&RingEntry, SoundError> {
+    rings.get(&id).filter(|entry| entry.owner == owner).ok_or(SoundError::InvalidBuffer)
+}
+
+fn with_ring<R>(id: PcmRingId, owner: TaskId, f: impl FnOnce(&PcmRing) -> R) -> Result<R, SoundError> {
+    let rings = RINGS.lock();
+    owned(&rings, id, owner)?.stream.ring().map(f).ok_or(SoundError::InvalidBuffer)
+}
@@ -0,0 +1,256 @@
+// src/kernel/drivers/pixel.rs
+
+//! Formatos de Pixel do LightOS.
+//!
+//! * `PixelFormat` descreve o framebuffer como o bootloader o reporta
+//!   (bits por pixel + posição/tamanho de cada canal).
+//! * `PixelKernel` é implementado por um tipo vazio por formato conhecido. O
+//!   código de desenho é genérico sobre ele: cada laço interno é instanciado
+//!   (monomorfizado) por formato e não contém nenhum teste de formato.
+//! * `with_pixel_kernel!` faz o único `match` de formato, fora dos laços.
+
+use core::ptr;
+
+/// 🎚️ Posição e largura de um canal de cor dentro do pixel.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct ChannelMask {
+    /// Bit menos significativo do canal.
+    pub shift: u8,
+    /// Número de bits do canal.
+    pub size: u8,
+}
+
+impl ChannelMask {
+    pub const fn new(shift: u8, size: u8) -> Self {
+        ChannelMask { shift, size }
+    }
+}
+
+/// 🧬 Descritor do formato de pixel de uma superfície.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct PixelFormat {
+    pub bits_per_pixel: u8,
+    pub red: ChannelMask,
+    pub green: ChannelMask,
+    pub blue: ChannelMask,
+}
+
+/// 📋 Formatos com kernels especializados.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum FormatKind {
+    /// 32 bpp, bytes B, G, R, X na memória (o mais comum em GOP/VBE).
+    Xrgb8888,
+    /// 32 bpp, bytes R, G, B, X na memória.
+    Xbgr8888,
+    /// 24 bpp, bytes B, G, R.
+    Rgb888,
+    /// 24 bpp, bytes R, G, B.
+    Bgr888,
+    /// 16 bpp, R:5 G:6 B:5.
+    Rgb565,
+}
+
+impl PixelFormat {
+    pub const XRGB8888: PixelFormat = PixelFormat::new(32, 16, 8, 0, 8);
+    pub const XBGR8888: PixelFormat = PixelFormat::new(32, 0, 8, 16, 8);
+    pub const RGB888: PixelFormat = PixelFormat::new(24, 16, 8, 0, 8);
+    pub const BGR888: PixelFormat = PixelFormat::new(24, 0, 8, 16, 8);
+    pub const RGB565: PixelFormat = PixelFormat {
+        bits_per_pixel: 16,
+        red: ChannelMask::new(11, 5),
+        green: ChannelMask::new(5, 6),
+        blue: ChannelMask::new(0, 5),
+    };
+
+    /// Formato com canais de mesma largura.
+    const fn new(bits_per_pixel: u8, red_shift: u8, green_shift: u8, blue_shift: u8, size: u8) -> Self {
+        PixelFormat {
+            bits_per_pixel,
+            red: ChannelMask::new(red_shift, size),
+            green: ChannelMask::new(green_shift, size),
+            blue: ChannelMask::new(blue_shift, size),
+        }
+    }
+
+    /// Bytes por pixel.
+    pub const fn bytes_per_pixel(&self) -> usize {
+        (self.bits_per_pixel as usize + 7) / 8
+    }
+
+    /// 🔍 Kernel especializado para este formato (`None` se não suportado).
+    pub fn kind(&self) -> Option<FormatKind> {
+        match *self {
+            f if f == Self::XRGB8888 => Some(FormatKind::Xrgb8888),
+            f if f == Self::XBGR8888 => Some(FormatKind::Xbgr8888),
+            f if f == Self::RGB888 => Some(FormatKind::Rgb888),
+            f if f == Self::BGR888 => Some(FormatKind::Bgr888),
+            f if f == Self::RGB565 => Some(FormatKind::Rgb565),
+            _ => None,
+        }
+    }
+
+    /// 🎨 Empacota uma cor RGB neste formato (uso fora de laços: uma cor de preenchimento).
+    pub fn pack(&self, r: u8, g: u8, b: u8) -> u32 {
+        fn channel(value: u8, mask: ChannelMask) -> u32 {
+            ((value as u32) >> (8 - mask.size.min(8))) << mask.shift
+        }
+        channel(r, self.red) | channel(g, self.green) | channel(b, self.blue)
+    }
+}
+
+/// ⚙️ Operações de pixel de um formato, resolvidas em tempo de compilação.
+pub trait PixelKernel {
+    /// Formato descrito por este kernel.
+    const FORMAT: PixelFormat;
+    /// Bytes por pixel (constante: os laços são desenrolados por formato).
+    const BYTES: usize;
+
+    /// Empacota uma cor RGB.
+    fn pack(r: u8, g: u8, b: u8) -> u32;
+
+    /// Extrai (r, g, b) de um pixel.
+    fn unpack(pixel: u32) -> (u8, u8, u8);
+
+    /// Converte de ARGB8888 (`0xAARRGGBB`, o formato dos buffers de aplicação).
+    #[inline(always)]
+    fn from_argb(argb: u32) -> u32 {
+        Self::pack((argb >> 16) as u8, (argb >> 8) as u8, argb as u8)
+    }
+
+    /// Escreve um pixel em `p`.
+    ///
+    /// # Safety
+    /// `p` deve apontar para `BYTES` bytes graváveis.
+    unsafe fn write(p: *mut u8, pixel: u32);
+
+    /// Lê o pixel em `p`.
+    ///
+    /// # Safety
+    /// `p` deve apontar para `BYTES` bytes legíveis.
+    unsafe fn read(p: *const u8) -> u32;
+}
+
+/// Kernel de 32 bpp com os canais R/B nos deslocamentos dados.
+macro_rules! kernel_32bpp {
+    ($name:ident, $format:expr, $r:expr, $b:expr) => {
+        pub struct $name;
+
+        impl PixelKernel for $name {
+            const FORMAT: PixelFormat = $format;
+            const BYTES: usize = 4;
+
+            #[inline(always)]
+            fn pack(r: u8, g: u8, b: u8) -> u32 {
+                (r as u32) << $r | (g as u32) << 8 | (b as u32) << $b
+            }
+            #[inline(always)]
+            fn unpack(pixel: u32) -> (u8, u8, u8) {
+                ((pixel >> $r) as u8, (pixel >> 8) as u8, (pixel >> $b) as u8)
+            }
+            #[inline(always)]
+            unsafe fn write(p: *mut u8, pixel: u32) {
+                ptr::write_volatile(p as *mut u32, pixel);
+            }
+            #[inline(always)]
+            unsafe fn read(p: *const u8) -> u32 {
+                ptr::read(p as *const u32)
+            }
+        }
+    };
+}
+
+/// Kernel de 24 bpp com os canais R/B nos deslocamentos dados.
+macro_rules! kernel_24bpp {
+    ($name:ident, $format:expr, $r:expr, $b:expr) => {
+        pub struct $name;
+
+        impl PixelKernel for $name {
+            const FORMAT: PixelFormat = $format;
+            const BYTES: usize = 3;
+
+            #[inline(always)]
+            fn pack(r: u8, g: u8, b: u8) -> u32 {
+                (r as u32) << $r | (g as u32) << 8 | (b as u32) << $b
+            }
+            #[inline(always)]
+            fn unpack(pixel: u32) -> (u8, u8, u8) {
+                ((pixel >> $r) as u8, (pixel >> 8) as u8, (pixel >> $b) as u8)
+            }
+            #[inline(always)]
+            unsafe fn write(p: *mut u8, pixel: u32) {
+                let [c0, c1, c2, _] = pixel.to_le_bytes();
+                ptr::write_volatile(p, c0);
+                ptr::write_volatile(p.add(1), c1);
+                ptr::write_volatile(p.add(2), c2);
+            }
+            #[inline(always)]
+            unsafe fn read(p: *const u8) -> u32 {
+                u32::from_le_bytes([*p, *p.add(1), *p.add(2), 0])
+            }
+        }
+    };
+}
+
+kernel_32bpp!(Xrgb8888, PixelFormat::XRGB8888, 16, 0);
+kernel_32bpp!(Xbgr8888, PixelFormat::XBGR8888, 0, 16);
+kernel_24bpp!(Rgb888, PixelFormat::RGB888, 16, 0);
+kernel_24bpp!(Bgr888, PixelFormat::BGR888, 0, 16);
+
+pub struct Rgb565;
+
+impl PixelKernel for Rgb565 {
+    const FORMAT: PixelFormat = PixelFormat::RGB565;
+    const BYTES: usize = 2;
+
+    #[inline(always)]
+    fn pack(r: u8, g: u8, b: u8) -> u32 {
+        ((r as u32 >> 3) << 11) | ((g as u32 >> 2) << 5) | (b as u32 >> 3)
+    }
+    #[inline(always)]
+    fn unpack(pixel: u32) -> (u8, u8, u8) {
+        // Replica os bits altos nos baixos para que 0x1F vire 0xFF.
+        let r = (pixel >> 11) as u8 & 0x1F;
+        let g = (pixel >> 5) as u8 & 0x3F;
+        let b = pixel as u8 & 0x1F;
+        (r << 3 | r >> 2, g << 2 | g >> 4, b << 3 | b >> 2)
+    }
+    #[inline(always)]
+    unsafe fn write(p: *mut u8, pixel: u32) {
+        ptr::write_volatile(p as *mut u16, pixel as u16);
+    }
+    #[inline(always)]
+    unsafe fn read(p: *const u8) -> u32 {
+        ptr::read(p as *const u16) as u32
+    }
+}
+
+/// 🔀 Avalia `$body` com `$F` = kernel do formato `$format`, ou `$unsupported`
+/// se o formato não tem kernel especializado.
+macro_rules! with_pixel_kernel {
+    ($format:expr, $F:ident => $body:expr, else $unsupported:expr) => {
+        match $format.kind() {
+            Some($crate::drivers::pixel::FormatKind::Xrgb8888) => {
+                type $F = $crate::drivers::pixel::Xrgb8888;
+                $body
+            }
+            Some($crate::drivers::pixel::FormatKind::Xbgr8888) => {
+                type $F = $crate::drivers::pixel::Xbgr8888;
+                $body
+            }
+            Some($crate::drivers::pixel::FormatKind::Rgb888) => {
+                type $F = $crate::drivers::pixel::Rgb888;
+                $body
+            }
+            Some($crate::drivers::pixel::FormatKind::Bgr888) => {
+                type $F = $crate::drivers::pixel::Bgr888;
+                $body
+            }
+            Some($crate::drivers::pixel::FormatKind::Rgb565) => {
+                type $F = $crate::drivers::pixel::Rgb565;
+                $body
+            }
+            None => $unsupported,
+        }
+    };
+}
+pub(crate) use with_pixel_kernel;
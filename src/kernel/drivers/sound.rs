@@ -2,29 +2,67 @@
 
 #![allow(dead_code)] // Permite código não usado para fins de demonstração
 
-use core::{
-    ptr::{self, NonNull},
-    fmt,
-};
+use alloc::boxed::Box;
+use core::fmt;
+
+use super::audio::{self, AudioFormat, PeriodRing, SoundDevice};
+use super::driver::Driver;
+use super::hda::{self, HdaController};
+use super::mmio::{register_block, Mmio};
+use super::pci::{self, PciDevice, PciDriver};
+use crate::interrupts::threaded::IrqReturn;
 
 // #![no_std]
 // No contexto de um Kernel (como o LightOS), geralmente o 'no_std' é aplicado no 
 // 'lib.rs' ou 'main.rs' principal do Kernel, e os módulos usam 'core'.
 
 /// 🌊 Constantes e Endereços de MMIO (Exemplo Simplificado - Adapte ao Hardware Real)
-// Para um driver real (ex: Intel HDA ou VirtIO-Sound), estes seriam lidos do PCI BARs.
-const SOUND_DEVICE_MMIO_BASE: usize = 0xFED0_0000;
-const REG_STATUS: usize = SOUND_DEVICE_MMIO_BASE + 0x00;
-const REG_CONTROL: usize = SOUND_DEVICE_MMIO_BASE + 0x04;
-const REG_BUFFER_PTR: usize = SOUND_DEVICE_MMIO_BASE + 0x08;
+// O `SoundDriver` é um modelo de dispositivo com DMA em anel, sem endereço fixo:
+// quem o constrói fornece a janela (`Mmio<SoundRegs>`). O hardware real é o HDA.
+/// Janela de registradores do dispositivo legado.
+const SOUND_DEVICE_MMIO_SIZE: usize = 0x1000;
+
+register_block! {
+    /// Registradores do dispositivo legado.
+    pub struct SoundRegs[SOUND_DEVICE_MMIO_SIZE] {
+        STATUS: u32 = 0x00,
+        CONTROL: u32 = 0x04,
+        /// Endereço físico da lista de buffers (BDL), 32 bits baixos / altos.
+        BUFFER_PTR: u32 = 0x08,
+        BUFFER_PTR_HI: u32 = 0x0C,
+        /// Número de entradas da BDL.
+        BDL_COUNT: u32 = 0x10,
+        /// Posição do DMA no anel, em bytes.
+        POSITION: u32 = 0x14,
+        /// Status de interrupção (escrever 1 limpa).
+        INT_STATUS: u32 = 0x18,
+    }
+}
+
+const CONTROL_RUN: u32 = 1 << 0;
+const CONTROL_IRQ_ENABLE: u32 = 1 << 1;
+const INT_PERIOD_COMPLETE: u32 = 1 << 0;
+
+/// Tamanho do período: 10 ms a 48 kHz (1920 bytes em estéreo, 16 bits).
+const PERIOD_FRAMES: usize = 480;
+/// Períodos no anel de DMA (latência máxima do anel: 40 ms).
+const PERIOD_COUNT: usize = 4;
+/// Períodos extras na fila de escrita.
+const QUEUE_PERIODS: usize = 8;
 
 /// ✨ Tipo de Erro Específico para o Driver de Som
-#[derive(Debug)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
 pub enum SoundError {
     DeviceNotFound,
     InitializationFailed,
     InvalidBuffer,
     HardwareError,
+    /// Sem memória de DMA para o anel de períodos.
+    OutOfMemory,
+    /// Já existe um fluxo de reprodução ativo (ou o mixer está cheio).
+    Busy,
+    /// Formato ou taxa de amostragem que o mixer não converte.
+    UnsupportedFormat,
 }
 
 impl fmt::Display for SoundError {
@@ -35,119 +73,144 @@ impl fmt::Display for SoundError {
 
 /// 🔊 Estrutura Principal do Driver de Som LightOS
 pub struct SoundDriver {
-    // Endereço base do dispositivo de hardware, encapsulado de forma segura
-    mmio_base: NonNull<u8>,
+    // Registradores do dispositivo (janela mapeada Uncached)
+    regs: Mmio<SoundRegs>,
     // Flag simples de inicialização
     initialized: bool,
 }
 
 impl SoundDriver {
-    /// 📝 Tenta criar uma nova instância do driver, checando a presença do hardware.
+    /// 🎵 Toca um buffer de áudio raw (PCM no formato do pipeline).
     ///
-    /// # Safety
-    /// Esta função assume que o endereço MMIO fornecido é válido e mapeado
-    /// na memória do Kernel.
-    pub const unsafe fn new(mmio_base: usize) -> Result<Self, SoundError> {
-        let ptr = NonNull::new(mmio_base as *mut u8)
-            .ok_or(SoundError::DeviceNotFound)?;
-
-        Ok(SoundDriver {
-            mmio_base: ptr,
-            initialized: false,
-        })
+    /// O buffer é copiado para a fila de escrita do pipeline (`audio::write`) e
+    /// tocado pelo anel de DMA; a chamada não espera o hardware. Retorna quantos
+    /// bytes foram aceitos (o restante não coube na fila).
+    pub fn play_buffer(&mut self, buffer: &[u8]) -> Result<usize, SoundError> {
+        if !self.initialized {
+            return Err(SoundError::HardwareError);
+        }
+
+        if buffer.len() == 0 {
+            return Err(SoundError::InvalidBuffer);
+        }
+
+        audio::write(buffer)
+    }
+}
+
+impl Driver for SoundDriver {
+    type Resource = Mmio<SoundRegs>;
+    type Error = SoundError;
+    const NAME: &'static str = "sound";
+
+    /// 📝 Cria o driver sobre a janela de registradores, se o dispositivo
+    /// responde com o status de pronto.
+    fn probe(regs: Mmio<SoundRegs>) -> Result<Self, SoundError> {
+        if regs.read(SoundRegs::STATUS) != 0x01 {
+            return Err(SoundError::DeviceNotFound);
+        }
+        Ok(SoundDriver { regs, initialized: false })
     }
 
     /// ⚙️ Inicializa o hardware de som.
-    pub fn init(&mut self) -> Result<(), SoundError> {
+    fn init(&mut self) -> Result<(), SoundError> {
         if self.initialized {
             return Ok(());
         }
 
         // 1. Reset do Dispositivo (Exemplo: Escrever 0 no registro de controle)
-        self.write_reg_u32(REG_CONTROL, 0x00)?;
-
-        // 2. Esperar pelo Status de Pronto (Simulação)
-        let status = self.read_reg_u32(REG_STATUS)?;
-        if status != 0x01 {
-            // Em um kernel real, haveria um loop de polling ou espera de interrupção aqui.
-            return Err(SoundError::InitializationFailed);
-        }
+        self.regs.write(SoundRegs::CONTROL, 0x00);
 
-        // 3. Configurar Formato de Áudio (Exemplo: 44.1kHz, 16-bit estéreo)
+        // 2. Configurar Formato de Áudio (Exemplo: 44.1kHz, 16-bit estéreo)
         // ... Lógica de configuração ...
 
         self.initialized = true;
         Ok(())
     }
 
-    /// 🎵 Toca um buffer de áudio raw.
-    ///
-    /// # Parameters
-    /// * `buffer`: Slice de bytes do buffer de áudio a ser tocado.
-    ///
-    /// # Safety
-    /// Em um Kernel real, esta função faria o seguinte:
-    /// 1. Garantir que o `buffer` está em memória física contígua e acessível
-    ///    pelo hardware (DMA).
-    /// 2. Programar o DMA para transferir o `buffer` para o hardware.
-    pub fn play_buffer(&mut self, buffer: &[u8]) -> Result<(), SoundError> {
-        if !self.initialized {
-            return Err(SoundError::HardwareError);
-        }
+    /// 💤 Para o DMA; `resume` refaz o reset de `init`.
+    fn suspend(&mut self) -> Result<(), SoundError> {
+        self.regs.write(SoundRegs::CONTROL, 0);
+        self.initialized = false;
+        Ok(())
+    }
 
-        if buffer.len() == 0 {
-            return Err(SoundError::InvalidBuffer);
+    /// ⚡ Reconhece o fim de período.
+    fn irq(&self) -> IrqReturn {
+        if self.regs.read(SoundRegs::INT_STATUS) & INT_PERIOD_COMPLETE == 0 {
+            return IrqReturn::None;
         }
+        self.regs.write(SoundRegs::INT_STATUS, INT_PERIOD_COMPLETE);
+        IrqReturn::Handled
+    }
+}
 
-        // 1. Mapear o endereço físico do buffer para o hardware (Lógica de DMA)
-        let buffer_phys_addr = buffer.as_ptr() as usize; // Simplificação! Endereço virtual.
-
-        // 2. Programar o registro do ponteiro de buffer do dispositivo
-        self.write_reg_u32(REG_BUFFER_PTR, buffer_phys_addr as u32)?;
-
-        // 3. Iniciar a reprodução (Exemplo: Escrever flag de 'Play' no registro de controle)
-        let mut control = self.read_reg_u32(REG_CONTROL)?;
-        control |= 0b001; // Seta o bit de 'Play'
-        self.write_reg_u32(REG_CONTROL, control)?;
+impl SoundDevice for SoundDriver {
+    /// O dispositivo legado só toca o formato nativo do pipeline.
+    fn negotiate(&mut self, _wanted: AudioFormat) -> Result<AudioFormat, SoundError> {
+        Ok(AudioFormat::DEFAULT)
+    }
 
+    fn start(&mut self, ring: &PeriodRing) -> Result<(), SoundError> {
+        if !self.initialized {
+            return Err(SoundError::HardwareError);
+        }
+        let bdl = ring.bdl_addr().as_u64();
+        self.regs.write(SoundRegs::CONTROL, 0);
+        self.regs.write(SoundRegs::BUFFER_PTR, bdl as u32);
+        self.regs.write(SoundRegs::BUFFER_PTR_HI, (bdl >> 32) as u32);
+        self.regs.write(SoundRegs::BDL_COUNT, ring.period_count() as u32);
+        self.regs.write(SoundRegs::INT_STATUS, INT_PERIOD_COMPLETE);
+        self.regs.write(SoundRegs::CONTROL, CONTROL_RUN | CONTROL_IRQ_ENABLE);
         Ok(())
     }
 
-    // --- Funções de MMIO Seguras (Memória Mapeada I/O) ---
+    fn stop(&mut self) {
+        self.regs.write(SoundRegs::CONTROL, 0);
+    }
 
-    /// 📥 Lê um valor de 32 bits de um registro de hardware.
-    fn read_reg_u32(&self, offset: usize) -> Result<u32, SoundError> {
-        let reg_addr = self.mmio_base.as_ptr().wrapping_add(offset) as *mut u32;
-        // Uso de 'read_volatile' para evitar que o compilador otimize a leitura de hardware
-        Ok(unsafe { ptr::read_volatile(reg_addr) })
+    fn ack_interrupt(&mut self) -> bool {
+        self.irq() != IrqReturn::None
     }
 
-    /// 📤 Escreve um valor de 32 bits em um registro de hardware.
-    fn write_reg_u32(&self, offset: usize, value: u32) -> Result<(), SoundError> {
-        let reg_addr = self.mmio_base.as_ptr().wrapping_add(offset) as *mut u32;
-        // Uso de 'write_volatile' para evitar que o compilador otimize a escrita de hardware
-        unsafe { ptr::write_volatile(reg_addr, value) };
-        Ok(())
+    fn position(&self) -> usize {
+        self.regs.read(SoundRegs::POSITION) as usize
+    }
+}
+
+/// 🚗 Driver HDA no registro PCI.
+static HDA_DRIVER: PciDriver = PciDriver {
+    name: "hda",
+    matches: hda::PCI_MATCHES,
+    probe: probe_hda,
+};
+
+/// 🔌 Probe do registro PCI: liga o controlador e inicia o pipeline sobre ele.
+/// * O pipeline é único: um segundo controlador é recusado (`Busy`).
+fn probe_hda(device: PciDevice) -> bool {
+    match start_hda(device) {
+        Ok(()) => true,
+        Err(e) => {
+            crate::println!("WARN: HDA {:?}: {:?}", device.address, e);
+            false
+        }
     }
 }
 
-// --- Exemplo de Uso (apenas para referência de Kernel) ---
+fn start_hda(device: PciDevice) -> Result<(), SoundError> {
+    let mut hda = HdaController::probe(device)?;
+    hda.init()?;
+    let vector = hda.setup_interrupt()?;
+    audio::start(Box::new(hda), AudioFormat::DEFAULT, vector, PERIOD_FRAMES, PERIOD_COUNT, QUEUE_PERIODS)
+}
 
-/*
-// Essa função seria chamada pela parte C ou por um módulo Rust de nível superior
+/// 🚀 Registra o driver HDA no PCI e inicia o pipeline de reprodução contínua
+/// no primeiro controlador que subir.
+/// * Sem HDA, retorna `DeviceNotFound`: não há dispositivo de som em endereço
+///   fixo (0xFED0_0000, o antigo "legado", é a janela do HPET nos PCs).
 pub fn initialize_sound_subsystem() -> Result<(), SoundError> {
-    // 1. Encontrar o Dispositivo (Lógica de PCI/VirtIO)
-    // Supondo que o endereço base MMIO foi encontrado
-    let mmio_addr = SOUND_DEVICE_MMIO_BASE; 
-
-    // 2. Criar e Inicializar o Driver
-    let mut driver = unsafe { SoundDriver::new(mmio_addr)? };
-    driver.init()?;
-    
-    // 3. Exemplo de uso
-    let audio_data: [u8; 1024] = [0xAA; 1024]; // Buffer de 1KB de silêncio (ou ruído)
-    driver.play_buffer(&audio_data)?;
-
-    Ok(())
+    match pci::register_driver(&HDA_DRIVER).map_err(|_| SoundError::InitializationFailed)? {
+        0 => Err(SoundError::DeviceNotFound),
+        _ => Ok(()),
+    }
 }
-*/
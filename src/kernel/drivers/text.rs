@@ -0,0 +1,244 @@
+// src/kernel/drivers/text.rs
+
+//! Layout e Renderização de Texto do LightOS.
+//!
+//! O texto passa por duas etapas:
+//! 1. `layout`: quebra o texto em linhas (quebras explícitas, quebra por palavra
+//!    na largura máxima e tabulações), sem tocar em pixels.
+//! 2. `TextRenderer`: monta cada linha inteira em um buffer ARGB8888 (a partir do
+//!    `GlyphCache`) e a envia com UM blit por linha, em vez de um por glifo.
+//!
+//! Com cor de fundo, a linha é opaca (`blit_argb`); sem ela, é composta com alfa
+//! sobre o que já está na tela (`blend_argb`).
+
+use alloc::vec::Vec;
+
+use super::blit::{self, BlitError, Rect, Surface};
+use super::display::{DisplayDriver, DisplayError};
+use super::font::{BitmapFont, GlyphCache};
+
+/// Colunas entre paradas de tabulação.
+pub const TAB_WIDTH: u32 = 4;
+
+/// 📏 Uma linha do layout: `text[start..end]`, em coordenadas de célula.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct LineRun {
+    /// Início da linha (índice de byte no texto).
+    pub start: usize,
+    /// Fim da linha (exclusivo; não inclui a quebra).
+    pub end: usize,
+    /// Número da linha (0 = primeira).
+    pub row: u32,
+    /// Largura em colunas (tabulações já expandidas).
+    pub columns: u32,
+}
+
+/// Colunas ocupadas por `ch` quando começa na coluna `column`.
+#[inline]
+fn advance(ch: char, column: u32) -> u32 {
+    if ch == '\t' {
+        TAB_WIDTH - column % TAB_WIDTH
+    } else {
+        1
+    }
+}
+
+/// 📐 Quebra `text` em linhas de no máximo `max_columns` colunas (0 = sem limite).
+/// * Quebra depois do último espaço que caiba; palavras maiores que a linha
+///   são cortadas na coluna limite.
+pub fn layout(text: &str, max_columns: u32) -> Vec<LineRun> {
+    let mut lines = Vec::new();
+    let (mut start, mut column, mut row) = (0, 0, 0);
+    // Última oportunidade de quebra na linha atual: (fim da linha, início da próxima, colunas).
+    let mut last_break: Option<(usize, usize, u32)> = None;
+
+    for (index, ch) in text.char_indices() {
+        if ch == '\n' {
+            lines.push(LineRun { start, end: index, row, columns: column });
+            start = index + 1;
+            column = 0;
+            row += 1;
+            last_break = None;
+            continue;
+        }
+
+        let mut width = advance(ch, column);
+        if max_columns != 0 && column + width > max_columns && column > 0 {
+            if ch == ' ' {
+                // O espaço que não cabe vira a própria quebra.
+                lines.push(LineRun { start, end: index, row, columns: column });
+                start = index + 1;
+                column = 0;
+                row += 1;
+                last_break = None;
+                continue;
+            }
+            // Não cabe: quebra no último espaço ou aqui mesmo.
+            let (end, next, columns) = last_break.unwrap_or((index, index, column));
+            lines.push(LineRun { start, end, row, columns });
+            start = next;
+            row += 1;
+            column = text[start..index].chars().fold(0, |col, c| col + advance(c, col));
+            width = advance(ch, column);
+            last_break = None;
+        }
+
+        if ch == ' ' || ch == '\t' {
+            last_break = Some((index, index + 1, column));
+        }
+        column += width;
+    }
+    if start < text.len() || lines.is_empty() {
+        lines.push(LineRun { start, end: text.len(), row, columns: column });
+    }
+    lines
+}
+
+/// 🎨 Estilo do texto.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct TextStyle {
+    /// Cor do texto (ARGB8888; alfa < 255 deixa o texto translúcido).
+    pub color: u32,
+    /// Cor de fundo das células (ARGB8888). `None` = fundo transparente.
+    pub background: Option<u32>,
+}
+
+/// ✍️ Renderizador de texto com cache de glifos e buffer de linha reutilizável.
+pub struct TextRenderer {
+    font: &'static BitmapFont,
+    cache: GlyphCache,
+    /// Buffer ARGB8888 de uma linha (`columns * width` x `height`).
+    line: Vec<u32>,
+}
+
+impl TextRenderer {
+    /// 🏭 Cria um renderizador para `font`.
+    pub fn new(font: &'static BitmapFont) -> Self {
+        TextRenderer { font, cache: GlyphCache::new(font), line: Vec::new() }
+    }
+
+    /// Fonte em uso.
+    pub fn font(&self) -> &'static BitmapFont {
+        self.font
+    }
+
+    /// 📐 Tamanho em pixels que `text` ocupa com largura máxima `max_width` (0 = sem limite).
+    pub fn measure(&self, text: &str, max_width: u32) -> (u32, u32) {
+        let lines = layout(text, max_width / self.font.width());
+        let columns = lines.iter().map(|l| l.columns).max().unwrap_or(0);
+        (columns * self.font.width(), lines.len() as u32 * self.font.height())
+    }
+
+    /// Monta a linha `run` em `self.line`. Retorna a largura em pixels.
+    fn render_line(&mut self, text: &str, run: &LineRun, style: TextStyle) -> u32 {
+        let (glyph_w, glyph_h) = (self.font.width() as usize, self.font.height() as usize);
+        let stride = run.columns as usize * glyph_w;
+        self.line.clear();
+        self.line.resize(stride * glyph_h, style.background.unwrap_or(0));
+
+        // Cobertura 255 → cor do texto; 0 → fundo (ou transparente).
+        let alpha = style.color >> 24;
+        let ink = match style.background {
+            Some(_) => style.color | 0xFF00_0000,
+            None => style.color,
+        };
+
+        let mut column = 0;
+        for ch in text[run.start..run.end].chars() {
+            let width = advance(ch, column);
+            if ch != ' ' && ch != '\t' {
+                let coverage = self.cache.coverage(self.font, self.font.glyph_index(ch));
+                let origin = column as usize * glyph_w;
+                for (y, row) in coverage.chunks_exact(glyph_w).enumerate() {
+                    let dst = &mut self.line[y * stride + origin..y * stride + origin + glyph_w];
+                    for (pixel, &c) in dst.iter_mut().zip(row) {
+                        if c != 0 {
+                            *pixel = match style.background {
+                                // Fundo opaco: mistura aqui mesmo, o blit final é uma cópia.
+                                Some(bg) if alpha < 255 => mix_argb(ink, bg, alpha),
+                                _ => ink,
+                            };
+                        }
+                    }
+                }
+            }
+            column += width;
+        }
+        stride as u32
+    }
+
+    /// 🖊️ Desenha `text` com o canto superior esquerdo em (`x`, `y`), quebrando
+    /// linhas em `max_width` pixels (0 = sem limite).
+    /// * Chama `sink(x, y, linha, stride, retângulo, com_alfa)` uma vez por linha.
+    /// * Retorna o retângulo ocupado.
+    fn render<E>(
+        &mut self,
+        x: u32,
+        y: u32,
+        text: &str,
+        style: TextStyle,
+        max_width: u32,
+        mut sink: impl FnMut(u32, u32, &[u32], usize, Rect, bool) -> Result<(), E>,
+    ) -> Result<Rect, E> {
+        let (glyph_w, glyph_h) = (self.font.width(), self.font.height());
+        let lines = layout(text, max_width / glyph_w);
+        let mut drawn_width = 0;
+
+        for run in lines.iter().filter(|run| run.columns > 0) {
+            let width = self.render_line(text, run, style);
+            let line_y = y + run.row * glyph_h;
+            let rect = Rect::new(0, 0, width, glyph_h);
+            sink(x, line_y, &self.line, width as usize, rect, style.background.is_none())?;
+            drawn_width = drawn_width.max(width);
+        }
+        Ok(Rect::new(x, y, drawn_width, lines.len() as u32 * glyph_h))
+    }
+
+    /// 🖊️ Desenha texto no `DisplayDriver` (vai para o back buffer, se houver).
+    pub fn draw(
+        &mut self,
+        display: &mut DisplayDriver,
+        x: u32,
+        y: u32,
+        text: &str,
+        style: TextStyle,
+        max_width: u32,
+    ) -> Result<Rect, DisplayError> {
+        self.render(x, y, text, style, max_width, |x, y, line, stride, rect, blend| {
+            if blend {
+                display.blend_argb(x, y, line, stride, rect)
+            } else {
+                display.blit_argb(x, y, line, stride, rect)
+            }
+        })
+    }
+
+    /// 🖊️ Desenha texto em qualquer `Surface` (ex.: superfície de uma aplicação).
+    pub fn draw_to_surface(
+        &mut self,
+        surface: &Surface,
+        x: u32,
+        y: u32,
+        text: &str,
+        style: TextStyle,
+        max_width: u32,
+    ) -> Result<Rect, BlitError> {
+        self.render(x, y, text, style, max_width, |x, y, line, stride, rect, blend| {
+            if blend {
+                blit::blend_argb(surface, x, y, line, stride, rect)
+            } else {
+                blit::blit_argb(surface, x, y, line, stride, rect)
+            }
+        })
+    }
+}
+
+/// Mistura `fg` sobre `bg` com alfa `alpha` (resultado opaco).
+#[inline]
+fn mix_argb(fg: u32, bg: u32, alpha: u32) -> u32 {
+    let channel = |shift: u32| {
+        let (f, b) = ((fg >> shift) & 0xFF, (bg >> shift) & 0xFF);
+        ((f * alpha + b * (255 - alpha) + 127) / 255) << shift
+    };
+    0xFF00_0000 | channel(16) | channel(8) | channel(0)
+}
@@ -1,11 +1,33 @@
 // src/kernel/drivers/touchscreen.rs
 
+//! Driver de Touchscreen do LightOS, orientado a interrupções e multi-toque.
+//!
+//! * O top half da IRQ drena todas as varreduras pendentes do controlador. Cada
+//!   varredura vira um `TouchFrame` (protocolo MT-B do evdev): todos os contatos
+//!   do quadro, cada um em um slot estável e com um ID de rastreamento único do
+//!   toque ao levantamento.
+//! * Os quadros vão para `TOUCH_QUEUE`, uma fila SPSC sem locks: nenhum quadro
+//!   espera por uma tarefa e nenhum é perdido entre duas leituras.
+//! * Entre duas leituras, varreduras que só movem os contatos são coalescidas
+//!   no último quadro não lido (bordas down/up ficam exatas), com histórico
+//!   opcional e velocidade suavizada para predição (`TouchFrame::predict`).
+//! * O bottom half (coalescido) acorda o leitor registrado com uma notificação
+//!   IPC por lote e move o ponteiro do overlay para o contato primário.
+//! * Leitores retiram quadros inteiros com `read_frame`; não há polling do hardware.
+
 #![allow(dead_code)] // Permite código não usado para fins de demonstração
 
 use core::{
-    fmt, 
-    ptr::{self, NonNull}
+    cell::UnsafeCell,
+    fmt,
+    sync::atomic::{AtomicBool, AtomicU64, AtomicU8, AtomicUsize, Ordering},
 };
+use spin::{Mutex, Once};
+
+use super::driver::Driver;
+use super::mmio::{register_block, Mmio};
+use crate::interrupts::{self, stats::read_tsc, threaded::{self, Coalescing, IrqReturn}, PIC_1_OFFSET};
+use crate::ipc::{self, Endpoint};
 
 /// 🚨 Códigos de Erro Específicos para o Driver Touchscreen
 #[derive(Debug, Clone, Copy, PartialEq, Eq)]
@@ -18,6 +40,10 @@ pub enum TouchscreenError {
     HardwareFault,
     /// Tempo limite (timeout) ao esperar por dados do dispositivo.
     ReadTimeout,
+    /// Já existe um touchscreen registrado.
+    AlreadyRegistered,
+    /// A linha de IRQ é inválida ou não pôde ser registrada.
+    IrqUnavailable,
 }
 
 impl fmt::Display for TouchscreenError {
@@ -27,7 +53,7 @@ impl fmt::Display for TouchscreenError {
 }
 
 /// 👆 Estrutura de Evento de Toque
-/// Define os dados brutos de um evento de toque.
+/// Define os dados brutos de um evento de toque (um único contato).
 #[derive(Debug, Clone, Copy, PartialEq, Eq)]
 pub struct TouchEvent {
     /// Coordenada X na tela.
@@ -40,113 +66,788 @@ pub struct TouchEvent {
     pub down: bool,
 }
 
-/// 🔌 Estrutura Principal do Driver Touchscreen LightOS
-/// Simula um driver que se comunica via Registros de MMIO (Memory-Mapped I/O).
-pub struct TouchscreenDriver {
-    /// Endereço base do controlador (simulando I2C/SPI via MMIO).
-    mmio_base: NonNull<u8>,
-    /// Estado de inicialização.
-    is_ready: bool,
+impl TouchEvent {
+    fn pack(self) -> u64 {
+        self.x as u64 | (self.y as u64) << 16 | (self.pressure as u64) << 32 | (self.down as u64) << 40
+    }
+
+    fn unpack(raw: u64) -> Self {
+        TouchEvent { x: raw as u16, y: (raw >> 16) as u16, pressure: (raw >> 32) as u8, down: raw & (1 << 40) != 0 }
+    }
 }
 
 // ------------------------------------------------------------------------
-// --- Lógica de Comunicação de Baixo Nível (Insegura, mas Encapsulada) ---
+// --- Quadros Multi-Toque (MT-B) ---
 // ------------------------------------------------------------------------
 
-impl TouchscreenDriver {
-    /// 📥 Lê um valor de 8 bits de um registro de hardware.
-    fn read_reg_u8(&self, offset: usize) -> u8 {
-        let reg_addr = self.mmio_base.as_ptr().wrapping_add(offset) as *const u8;
-        // Uso de 'read_volatile' para garantir que a leitura de hardware não seja otimizada.
-        unsafe { ptr::read_volatile(reg_addr) }
+/// Número máximo de contatos simultâneos (slots).
+pub const MAX_CONTACTS: usize = 10;
+/// Amostras anteriores guardadas em um quadro coalescido (com o histórico ligado).
+pub const HISTORY_LEN: usize = 4;
+/// Horizonte máximo da predição, em intervalos de varredura.
+const MAX_PREDICTION_SCANS: u64 = 3;
+/// Fração da velocidade/intervalo novos na média exponencial (1/2^SHIFT).
+const VELOCITY_SMOOTHING_SHIFT: u32 = 1;
+const INTERVAL_SMOOTHING_SHIFT: u32 = 2;
+
+/// ✋ Um contato em um quadro multi-toque.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+#[repr(C)]
+pub struct TouchContact {
+    /// Slot MT-B (0..MAX_CONTACTS): estável enquanto o contato existir.
+    pub slot: u8,
+    /// Pressão do toque (0 a 255).
+    pub pressure: u8,
+    /// `false`: o contato terminou neste quadro e seu ID de rastreamento foi liberado.
+    pub down: bool,
+    /// ID de rastreamento: único por toque, do down até o up.
+    pub tracking_id: u16,
+    pub x: u16,
+    pub y: u16,
+    /// Velocidade suavizada, em 1/16 de unidade de coordenada por varredura.
+    pub vx: i16,
+    pub vy: i16,
+}
+
+impl TouchContact {
+    const EMPTY: TouchContact = TouchContact { slot: 0, pressure: 0, down: false, tracking_id: 0, x: 0, y: 0, vx: 0, vy: 0 };
+
+    /// Visão de contato único (compatível com `TouchEvent`).
+    pub fn event(&self) -> TouchEvent {
+        TouchEvent { x: self.x, y: self.y, pressure: self.pressure, down: self.down }
+    }
+}
+
+/// 🕘 Posições de uma varredura absorvida por um quadro coalescido
+/// (na mesma ordem de `TouchFrame::contacts`).
+#[derive(Debug, Clone, Copy)]
+#[repr(C)]
+pub struct TouchSample {
+    /// TSC da varredura.
+    pub timestamp: u64,
+    pub x: [u16; MAX_CONTACTS],
+    pub y: [u16; MAX_CONTACTS],
+}
+
+impl TouchSample {
+    const EMPTY: TouchSample = TouchSample { timestamp: 0, x: [0; MAX_CONTACTS], y: [0; MAX_CONTACTS] };
+}
+
+/// 🖐️ Um quadro: todos os contatos de uma varredura do hardware, ordenados por
+/// slot (equivale a uma sequência de `ABS_MT_SLOT` ... `SYN_REPORT`).
+///
+/// Um quadro só de movimento ainda não lido absorve as varreduras seguintes
+/// que também só movem os mesmos contatos: o leitor recebe a posição mais
+/// recente (e, com o histórico ligado, as anteriores em `history`). Quadros com
+/// uma borda (contato novo ou levantado) nunca são coalescidos.
+#[derive(Debug, Clone, Copy)]
+#[repr(C)]
+pub struct TouchFrame {
+    /// Número sequencial da varredura mais recente do quadro.
+    pub sequence: u32,
+    /// Intervalo suavizado entre varreduras, em ciclos de TSC.
+    pub scan_interval: u32,
+    /// TSC da varredura mais recente.
+    pub timestamp: u64,
+    /// Varreduras absorvidas por este quadro além da mais recente.
+    pub coalesced: u16,
+    /// Contatos válidos em `contacts`.
+    pub count: u8,
+    /// Amostras válidas em `history`.
+    pub history_count: u8,
+    pub contacts: [TouchContact; MAX_CONTACTS],
+    /// Varreduras absorvidas mais recentes, da mais antiga para a mais nova.
+    pub history: [TouchSample; HISTORY_LEN],
+}
+
+impl TouchFrame {
+    const EMPTY: TouchFrame = TouchFrame {
+        sequence: 0,
+        scan_interval: 0,
+        timestamp: 0,
+        coalesced: 0,
+        count: 0,
+        history_count: 0,
+        contacts: [TouchContact::EMPTY; MAX_CONTACTS],
+        history: [TouchSample::EMPTY; HISTORY_LEN],
+    };
+
+    /// Os contatos do quadro (inclui os que terminaram nele, com `down == false`).
+    pub fn contacts(&self) -> &[TouchContact] {
+        &self.contacts[..self.count as usize]
+    }
+
+    /// As varreduras absorvidas guardadas, da mais antiga para a mais nova.
+    pub fn history(&self) -> &[TouchSample] {
+        &self.history[..self.history_count as usize]
+    }
+
+    /// Contato primário (o de menor slot), como um evento de contato único.
+    pub fn primary(&self) -> Option<TouchEvent> {
+        self.contacts().first().map(TouchContact::event)
+    }
+
+    /// 🔮 Posição estimada de `contact` no instante `at_tsc` (ex: a próxima
+    /// varredura do display), extrapolando a velocidade suavizada.
+    /// * O horizonte é limitado a `MAX_PREDICTION_SCANS` varreduras, e contatos
+    ///   levantados não se movem.
+    pub fn predict(&self, contact: &TouchContact, at_tsc: u64) -> (u16, u16) {
+        if !contact.down || self.scan_interval == 0 {
+            return (contact.x, contact.y);
+        }
+        let interval = self.scan_interval as i64;
+        let ahead = at_tsc.saturating_sub(self.timestamp).min(MAX_PREDICTION_SCANS * interval as u64) as i64;
+        let extrapolate = |position: u16, velocity: i16| {
+            let delta = velocity as i64 * ahead / (16 * interval);
+            (position as i64 + delta).clamp(0, u16::MAX as i64) as u16
+        };
+        (extrapolate(contact.x, contact.vx), extrapolate(contact.y, contact.vy))
+    }
+
+    /// 🔗 Absorve `older` (um quadro de movimento dos mesmos contatos, ainda não
+    /// lido): este quadro mantém as posições novas e herda a contagem e o histórico.
+    fn absorb(&mut self, older: &TouchFrame, keep_history: bool) {
+        self.coalesced = older.coalesced.saturating_add(1);
+        if !keep_history {
+            return;
+        }
+        let mut sample = TouchSample { timestamp: older.timestamp, ..TouchSample::EMPTY };
+        for (index, contact) in older.contacts().iter().enumerate() {
+            sample.x[index] = contact.x;
+            sample.y[index] = contact.y;
+        }
+        let kept = (older.history_count as usize).min(HISTORY_LEN - 1);
+        let skip = older.history_count as usize - kept;
+        self.history[..kept].copy_from_slice(&older.history[skip..skip + kept]);
+        self.history[kept] = sample;
+        self.history_count = (kept + 1) as u8;
+    }
+}
+
+/// 🔌 Uma fonte de toque (controlador MMIO ou um virtio-input). Os IDs de
+/// contato de cada fonte são independentes.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct TouchSource(u8);
+
+/// Fonte do controlador MMIO (`register`).
+const MMIO_SOURCE: TouchSource = TouchSource(0);
+
+/// 🎯 Atribuição de slots e IDs de rastreamento aos contatos do hardware.
+/// * Só é alterado com interrupções desabilitadas (top half ou `submit_scan`).
+/// * Os slots são compartilhados pelas fontes; cada varredura só levanta os
+///   contatos da sua própria fonte.
+struct SlotTracker {
+    /// Fonte e ID (na fonte) do contato que ocupa cada slot.
+    hw_id: [Option<(TouchSource, u8)>; MAX_CONTACTS],
+    /// Último estado de cada slot ocupado.
+    last: [TouchContact; MAX_CONTACTS],
+    next_tracking_id: u16,
+    next_sequence: u32,
+    /// TSC da varredura anterior e intervalo suavizado entre varreduras.
+    last_scan_tsc: u64,
+    scan_interval: u32,
+}
+
+/// 📍 Um contato como lido da fonte (controlador MMIO, virtio-input), antes da
+/// atribuição de slot.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct ScanContact {
+    /// ID do contato na fonte, estável enquanto o dedo estiver na tela.
+    pub id: u8,
+    /// Coordenadas na tela.
+    pub x: u16,
+    pub y: u16,
+    pub pressure: u8,
+}
+
+impl ScanContact {
+    const EMPTY: ScanContact = ScanContact { id: 0, x: 0, y: 0, pressure: 0 };
+}
+
+/// Média exponencial da velocidade (1/16 por varredura) com o deslocamento novo.
+fn smooth_velocity(previous: i16, from: u16, to: u16) -> i16 {
+    let instant = (to as i32 - from as i32) * 16;
+    let previous = previous as i32;
+    (previous + ((instant - previous) >> VELOCITY_SMOOTHING_SHIFT)).clamp(i16::MIN as i32, i16::MAX as i32) as i16
+}
+
+impl SlotTracker {
+    const fn new() -> Self {
+        SlotTracker {
+            hw_id: [None; MAX_CONTACTS],
+            last: [TouchContact::EMPTY; MAX_CONTACTS],
+            next_tracking_id: 0,
+            next_sequence: 0,
+            last_scan_tsc: 0,
+            scan_interval: 0,
+        }
     }
 
-    /// 📤 Escreve um valor de 8 bits em um registro de hardware.
-    fn write_reg_u8(&self, offset: usize, value: u8) {
-        let reg_addr = self.mmio_base.as_ptr().wrapping_add(offset) as *mut u8;
-        // Uso de 'write_volatile' para garantir que a escrita de hardware não seja otimizada.
-        unsafe { ptr::write_volatile(reg_addr, value) }
+    /// 🔁 Converte os contatos de uma varredura de `source` em um quadro MT-B.
+    /// * Contatos de `source` que sumiram da varredura saem com `down == false`.
+    /// * Um slot liberado neste quadro só é reutilizado no próximo, para que cada
+    ///   slot apareça no máximo uma vez por quadro.
+    /// * Retorna também se o quadro só move contatos já existentes (coalescível).
+    fn scan(&mut self, source: TouchSource, raw: &[ScanContact], timestamp: u64) -> (TouchFrame, bool) {
+        let mut entries: [Option<TouchContact>; MAX_CONTACTS] = [None; MAX_CONTACTS];
+        let was_free = self.hw_id.map(|id| id.is_none());
+        let mut edge = false;
+
+        for (slot, hw_id) in self.hw_id.iter_mut().enumerate() {
+            if let Some((owner, id)) = *hw_id {
+                if owner == source && !raw.iter().any(|c| c.id == id) {
+                    entries[slot] = Some(TouchContact { down: false, pressure: 0, vx: 0, vy: 0, ..self.last[slot] });
+                    *hw_id = None;
+                    edge = true;
+                }
+            }
+        }
+
+        for contact in raw {
+            let key = Some((source, contact.id));
+            let slot = match self.hw_id.iter().position(|id| *id == key) {
+                Some(slot) => slot,
+                None => match (0..MAX_CONTACTS).find(|&s| was_free[s] && self.hw_id[s].is_none()) {
+                    Some(slot) => {
+                        self.hw_id[slot] = key;
+                        self.last[slot] = TouchContact {
+                            tracking_id: self.next_tracking_id,
+                            x: contact.x,
+                            y: contact.y,
+                            ..TouchContact::EMPTY
+                        };
+                        self.next_tracking_id = self.next_tracking_id.wrapping_add(1);
+                        edge = true;
+                        slot
+                    }
+                    // Mais contatos que slots: o excedente é ignorado até um slot vagar.
+                    None => continue,
+                },
+            };
+            let last = self.last[slot];
+            let entry = TouchContact {
+                slot: slot as u8,
+                pressure: contact.pressure,
+                down: true,
+                tracking_id: last.tracking_id,
+                x: contact.x,
+                y: contact.y,
+                vx: smooth_velocity(last.vx, last.x, contact.x),
+                vy: smooth_velocity(last.vy, last.y, contact.y),
+            };
+            self.last[slot] = entry;
+            entries[slot] = Some(entry);
+        }
+
+        if self.last_scan_tsc != 0 {
+            let delta = timestamp.wrapping_sub(self.last_scan_tsc).min(u32::MAX as u64) as i64;
+            let previous = if self.scan_interval == 0 { delta } else { self.scan_interval as i64 };
+            self.scan_interval = (previous + ((delta - previous) >> INTERVAL_SMOOTHING_SHIFT)) as u32;
+        }
+        self.last_scan_tsc = timestamp;
+
+        let mut frame = TouchFrame {
+            sequence: self.next_sequence,
+            scan_interval: self.scan_interval,
+            timestamp,
+            ..TouchFrame::EMPTY
+        };
+        self.next_sequence = self.next_sequence.wrapping_add(1);
+        for entry in entries.iter().flatten() {
+            frame.contacts[frame.count as usize] = *entry;
+            frame.count += 1;
+        }
+        (frame, !edge && frame.count > 0)
     }
 }
 
 // ------------------------------------------------------------------------
-// --- Lógica de Driver (Segura) ---
+// --- Driver ---
 // ------------------------------------------------------------------------
 
-// Constantes de Registros de Exemplo (Adaptar ao Chip Touchscreen real)
-const REG_DEVICE_ID: usize = 0x00;
-const REG_CONTROL: usize = 0x04;
-const REG_EVENT_STATUS: usize = 0x08;
-const REG_X_COORD_MSB: usize = 0x10;
+// Registros de Exemplo (Adaptar ao Chip Touchscreen real)
+register_block! {
+    /// Registros do controlador.
+    pub struct TouchRegs[CONTACT_TABLE + MAX_CONTACTS * CONTACT_ENTRY_SIZE] {
+        DEVICE_ID: u8 = 0x00,
+        CONTROL: u8 = 0x04,
+        /// Status (bit 0: varredura pendente, bit 1: dedo para baixo), em +1 a pressão
+        /// e em +2 o número de contatos na tabela (0 em controladores de toque único).
+        EVENT_STATUS: u32 = 0x08,
+        /// Ack da varredura: escrever 0 no byte de status.
+        EVENT_ACK: u8 = 0x08,
+        /// X e Y do contato único, em big-endian: X MSB, X LSB, Y MSB, Y LSB.
+        X_COORD: u32 = 0x10,
+    }
+}
+
+register_block! {
+    /// Entrada da tabela de contatos da varredura.
+    pub struct ContactRegs[CONTACT_ENTRY_SIZE] {
+        /// ID no hardware, flags, pressão, reservado.
+        STATUS: u32 = 0x00,
+        /// X MSB, X LSB, Y MSB, Y LSB.
+        COORDS: u32 = 0x04,
+    }
+}
+
+/// Tabela de contatos: `MAX_CONTACTS` entradas `ContactRegs`.
+const CONTACT_TABLE: usize = 0x20;
+const CONTACT_ENTRY_SIZE: usize = 8;
 const EXPECTED_DEVICE_ID: u8 = 0x42;
 
-impl TouchscreenDriver {
-    /// 🏭 Constrói uma nova instância do driver.
-    /// 
-    /// # Safety
-    /// O chamador deve garantir que o `mmio_base` é um endereço MMIO válido e mapeado.
-    pub const unsafe fn new(mmio_base: usize) -> Result<Self, TouchscreenError> {
-        let ptr = NonNull::new(mmio_base as *mut u8)
-            .ok_or(TouchscreenError::DeviceNotFound)?;
-
-        Ok(TouchscreenDriver {
-            mmio_base: ptr,
-            is_ready: false,
-        })
-    }
-
-    /// 🔌 Inicializa e verifica a conectividade do dispositivo.
-    pub fn init(&mut self) -> Result<(), TouchscreenError> {
-        // 1. Verificar a ID do Dispositivo
-        let device_id = self.read_reg_u8(REG_DEVICE_ID);
-        if device_id != EXPECTED_DEVICE_ID {
+const STATUS_EVENT_PENDING: u8 = 0b0000_0001;
+const STATUS_DOWN: u8 = 0b0000_0010;
+/// Flag de "em contato" de uma entrada da tabela.
+const CONTACT_TOUCHING: u8 = 0b0000_0001;
+/// Bit de habilitação (eventos + interrupção) em `CONTROL`.
+const CONTROL_ENABLE: u8 = 0x01;
+
+/// 🔌 Estrutura Principal do Driver Touchscreen LightOS
+/// Simula um driver que se comunica via Registros de MMIO (Memory-Mapped I/O).
+pub struct TouchscreenDriver {
+    /// Registros do controlador (simulando I2C/SPI via MMIO).
+    regs: Mmio<TouchRegs>,
+    /// Estado de inicialização.
+    is_ready: bool,
+}
+
+// # SAFETY: Depois de registrado, o driver só acessa o MMIO no top half da sua
+// IRQ (com interrupções desabilitadas); os demais campos são imutáveis.
+unsafe impl Sync for TouchscreenDriver {}
+
+impl Driver for TouchscreenDriver {
+    type Resource = Mmio<TouchRegs>;
+    type Error = TouchscreenError;
+    const NAME: &'static str = "touchscreen";
+
+    /// 🏭 Constrói o driver e verifica a ID do dispositivo.
+    fn probe(regs: Mmio<TouchRegs>) -> Result<Self, TouchscreenError> {
+        if regs.read(TouchRegs::DEVICE_ID) != EXPECTED_DEVICE_ID {
             return Err(TouchscreenError::DeviceNotFound);
         }
+        Ok(TouchscreenDriver { regs, is_ready: false })
+    }
 
-        // 2. Configurar o Dispositivo (Ex: Habilitar Interrupções)
-        self.write_reg_u8(REG_CONTROL, 0x01);
+    /// 🔌 Habilita eventos e interrupções.
+    fn init(&mut self) -> Result<(), TouchscreenError> {
+        self.regs.set_bits(TouchRegs::CONTROL, CONTROL_ENABLE);
 
-        // 3. Checagem final (simulação)
-        let control_status = self.read_reg_u8(REG_CONTROL);
-        if (control_status & 0x01) != 0x01 {
+        // Checagem final (simulação)
+        if self.regs.read(TouchRegs::CONTROL) & CONTROL_ENABLE != CONTROL_ENABLE {
             return Err(TouchscreenError::CommunicationInitFailed);
         }
-        
+
         self.is_ready = true;
         Ok(())
     }
 
-    /// 📡 Lê o próximo evento de toque do hardware, se houver.
-    pub fn read_event(&self) -> Result<Option<TouchEvent>, TouchscreenError> {
-        if !self.is_ready {
-            return Err(TouchscreenError::CommunicationInitFailed);
+    /// 💤 Desliga eventos e interrupções.
+    fn suspend(&mut self) -> Result<(), TouchscreenError> {
+        self.regs.clear_bits(TouchRegs::CONTROL, CONTROL_ENABLE);
+        self.is_ready = false;
+        Ok(())
+    }
+
+    /// ⚡ Drena o hardware para a fila (o ack de cada varredura desce a linha).
+    fn irq(&self) -> IrqReturn {
+        if self.drain_into(&TOUCH_QUEUE) > 0 {
+            IrqReturn::WakeThread
+        } else {
+            IrqReturn::None
+        }
+    }
+}
+
+impl TouchscreenDriver {
+    /// 📡 Lê a próxima varredura pendente do hardware, se houver.
+    /// * Um acesso MMIO de 32 bits para o status, dois por contato e o ack.
+    fn take_scan(&self, raw: &mut [ScanContact; MAX_CONTACTS]) -> Option<usize> {
+        let [status, pressure, table_count, _] = self.regs.read(TouchRegs::EVENT_STATUS).to_le_bytes();
+        if status & STATUS_EVENT_PENDING == 0 {
+            return None;
         }
 
-        // Checar se há dados de evento disponíveis (bit 0 setado)
-        let status = self.read_reg_u8(REG_EVENT_STATUS);
-        if (status & 0b0000_0001) == 0 {
-            // Nenhum evento pendente
-            return Ok(None);
+        let mut count = 0;
+        if table_count == 0 {
+            // Controlador de toque único: um contato (ID 0) enquanto o dedo estiver para baixo.
+            if status & STATUS_DOWN != 0 {
+                let (x, y) = split_coords(self.regs.read(TouchRegs::X_COORD));
+                raw[0] = ScanContact { id: 0, x, y, pressure };
+                count = 1;
+            }
+        } else {
+            for index in 0..(table_count as usize).min(MAX_CONTACTS) {
+                let entry = match self.regs.sub_block::<ContactRegs>(CONTACT_TABLE + index * CONTACT_ENTRY_SIZE) {
+                    Some(entry) => entry,
+                    None => break,
+                };
+                let [hw_id, flags, pressure, _] = entry.read(ContactRegs::STATUS).to_le_bytes();
+                if flags & CONTACT_TOUCHING == 0 {
+                    continue;
+                }
+                let (x, y) = split_coords(entry.read(ContactRegs::COORDS));
+                raw[count] = ScanContact { id: hw_id, x, y, pressure };
+                count += 1;
+            }
         }
 
-        // 1. Ler as coordenadas X e Y
-        let x_msb = self.read_reg_u8(REG_X_COORD_MSB);
-        let x_lsb = self.read_reg_u8(REG_X_COORD_MSB + 1);
-        let y_msb = self.read_reg_u8(REG_X_COORD_MSB + 2);
-        let y_lsb = self.read_reg_u8(REG_X_COORD_MSB + 3);
+        // Ack: libera o controlador para a próxima varredura da sua FIFO.
+        self.regs.write(TouchRegs::EVENT_ACK, 0x00);
+        Some(count)
+    }
+
+    /// 🚰 Drena as varreduras pendentes do hardware para `queue`, um quadro por
+    /// varredura (ou coalescido no último quadro de movimento não lido).
+    /// * Limitado a `QUEUE_CAPACITY` por chamada: um controlador preso com o bit
+    ///   de pendência setado não trava o top half.
+    fn drain_into(&self, queue: &FrameQueue) -> usize {
+        // Todos os donos do lock desabilitam as interrupções: a espera é curta.
+        let mut tracker = TRACKER.lock();
+        let mut raw = [ScanContact::EMPTY; MAX_CONTACTS];
+        let mut drained = 0;
+        while drained < QUEUE_CAPACITY {
+            match self.take_scan(&mut raw) {
+                Some(count) => {
+                    let (frame, movement) = tracker.scan(MMIO_SOURCE, &raw[..count], read_tsc());
+                    queue.push(&frame, movement);
+                    drained += 1;
+                }
+                None => break,
+            }
+        }
+        drained
+    }
+}
 
-        // Reconstruir coordenadas de 16-bits
-        let x = u16::from_be_bytes([x_msb, x_lsb]);
-        let y = u16::from_be_bytes([y_msb, y_lsb]);
+/// Separa X e Y de um registro de coordenadas (big-endian, X nos dois primeiros bytes).
+fn split_coords(raw: u32) -> (u16, u16) {
+    let bytes = raw.to_le_bytes();
+    (u16::from_be_bytes([bytes[0], bytes[1]]), u16::from_be_bytes([bytes[2], bytes[3]]))
+}
+
+// ------------------------------------------------------------------------
+// --- Fila de Quadros (Sem Locks, com Coalescência) ---
+// ------------------------------------------------------------------------
+
+/// Capacidade da fila (potência de 2): ~0,25 s de varreduras a 240 Hz sem coalescência.
+const QUEUE_CAPACITY: usize = 64;
+
+/// Slots guardados para quadros de borda (down/up): um quadro de movimento
+/// não ocupa os últimos `EDGE_RESERVE` slots livres.
+const EDGE_RESERVE: usize = 8;
+
+/// Valor sentinela de "nenhum evento" em `FrameQueue::latest`.
+const NO_EVENT: u64 = u64::MAX;
+
+/// Estados de um slot da fila.
+const SLOT_EMPTY: u8 = 0;
+/// Publicado e não lido.
+const SLOT_READY: u8 = 1;
+/// O produtor está coalescendo uma varredura nova no quadro.
+const SLOT_WRITING: u8 = 2;
+/// O consumidor está copiando o quadro.
+const SLOT_READING: u8 = 3;
+
+/// Um quadro da fila e o estado que arbitra o acesso a ele.
+struct FrameSlot {
+    state: AtomicU8,
+    frame: UnsafeCell<TouchFrame>,
+}
+
+/// 📥 Fila SPSC de quadros (produtor: top half; consumidor: `read_frame`).
+/// * O quadro inteiro é publicado de uma vez: o leitor nunca vê um quadro parcial.
+/// * Um quadro de movimento publicado e ainda não lido é atualizado no lugar
+///   pelas varreduras de movimento seguintes. O produtor só o reescreve se
+///   vencer a troca `READY → WRITING`; se o consumidor já o tomou
+///   (`READY → READING`), a varredura vira um quadro novo. Nada se perde e as
+///   bordas (down/up) continuam em quadros próprios, na ordem, salvo com a
+///   fila cheia (ver `push`).
+pub struct FrameQueue {
+    slots: [FrameSlot; QUEUE_CAPACITY],
+    /// Próxima posição a escrever (só o produtor altera).
+    head: AtomicUsize,
+    /// Próxima posição a ler (só o consumidor altera).
+    tail: AtomicUsize,
+    /// O último quadro publicado é só de movimento (só o produtor usa).
+    newest_is_movement: AtomicBool,
+    /// Quadros de movimento descartados por fila cheia.
+    dropped: AtomicUsize,
+    /// Varreduras coalescidas em um quadro já publicado.
+    coalesced: AtomicUsize,
+    /// Contato primário do último quadro (para o ponteiro do overlay, que não consome a fila).
+    latest: AtomicU64,
+}
 
-        // 2. Ler Pressão e Estado do Toque
-        let pressure = self.read_reg_u8(REG_EVENT_STATUS + 1);
-        let down = (status & 0b0000_0010) != 0; // Exemplo: Bit 1 indica 'down'
+// # SAFETY: O conteúdo de cada slot só é acessado por quem levou o seu estado
+// para `WRITING`/`READING` (ou pelo produtor, com o slot `EMPTY` antes de publicar `head`).
+unsafe impl Sync for FrameQueue {}
 
-        // 3. Limpar a flag de evento no hardware (Ack)
-        // Normalmente, isso seria feito escrevendo de volta no REG_EVENT_STATUS, ou lendo todos os bytes.
-        self.write_reg_u8(REG_EVENT_STATUS, 0x00);
+/// Guardar o histórico nos quadros coalescidos (desligado por padrão).
+static HISTORY_ENABLED: AtomicBool = AtomicBool::new(false);
+
+impl FrameQueue {
+    /// 🏭 Cria uma fila vazia.
+    pub const fn new() -> Self {
+        const EMPTY: FrameSlot = FrameSlot { state: AtomicU8::new(SLOT_EMPTY), frame: UnsafeCell::new(TouchFrame::EMPTY) };
+        FrameQueue {
+            slots: [EMPTY; QUEUE_CAPACITY],
+            head: AtomicUsize::new(0),
+            tail: AtomicUsize::new(0),
+            newest_is_movement: AtomicBool::new(false),
+            dropped: AtomicUsize::new(0),
+            coalesced: AtomicUsize::new(0),
+            latest: AtomicU64::new(NO_EVENT),
+        }
+    }
+
+    /// ➕ Publica um quadro (lado do produtor). `movement` indica um quadro que
+    /// só move contatos existentes e pode ser coalescido.
+    /// * Um quadro de movimento é descartado se só restam os slots de `EDGE_RESERVE`.
+    /// * Um quadro de borda nunca é descartado: com a fila inteira cheia, ele
+    ///   substitui o quadro mais novo ainda não lido (o estado dos contatos
+    ///   entregue continua o atual).
+    pub fn push(&self, frame: &TouchFrame, movement: bool) -> bool {
+        if let Some(primary) = frame.primary() {
+            self.latest.store(primary.pack(), Ordering::Relaxed);
+        }
+        if movement && self.newest_is_movement.load(Ordering::Relaxed) && self.try_coalesce(frame) {
+            self.coalesced.fetch_add(1, Ordering::Relaxed);
+            return true;
+        }
+
+        let head = self.head.load(Ordering::Relaxed);
+        let tail = self.tail.load(Ordering::Acquire);
+        let limit = if movement { QUEUE_CAPACITY - EDGE_RESERVE } else { QUEUE_CAPACITY };
+        if head.wrapping_sub(tail) >= limit {
+            // O quadro mais novo não é mais o último estado: nada se coalesce nele.
+            self.newest_is_movement.store(false, Ordering::Relaxed);
+            // Com a fila cheia, o mais novo está `READY` (o consumidor lê outro slot).
+            if !movement && self.try_coalesce(frame) {
+                self.coalesced.fetch_add(1, Ordering::Relaxed);
+                return true;
+            }
+            self.dropped.fetch_add(1, Ordering::Relaxed);
+            return false;
+        }
+        let slot = &self.slots[head % QUEUE_CAPACITY];
+        // # SAFETY: O slot está `EMPTY` (o consumidor já passou dele) e só o produtor escreve.
+        unsafe { *slot.frame.get() = *frame; }
+        slot.state.store(SLOT_READY, Ordering::Release);
+        self.head.store(head.wrapping_add(1), Ordering::Release);
+        self.newest_is_movement.store(movement, Ordering::Relaxed);
+        true
+    }
+
+    /// Atualiza no lugar o último quadro publicado, se ainda não foi lido.
+    fn try_coalesce(&self, frame: &TouchFrame) -> bool {
+        let head = self.head.load(Ordering::Relaxed);
+        if head == self.tail.load(Ordering::Acquire) {
+            return false;
+        }
+        let slot = &self.slots[head.wrapping_sub(1) % QUEUE_CAPACITY];
+        if slot.state.compare_exchange(SLOT_READY, SLOT_WRITING, Ordering::Acquire, Ordering::Relaxed).is_err() {
+            return false;
+        }
+        // # SAFETY: O estado `WRITING` exclui o consumidor até a liberação abaixo.
+        unsafe {
+            let newest = &mut *slot.frame.get();
+            let mut merged = *frame;
+            merged.absorb(newest, HISTORY_ENABLED.load(Ordering::Relaxed));
+            *newest = merged;
+        }
+        slot.state.store(SLOT_READY, Ordering::Release);
+        true
+    }
+
+    /// ➖ Retira o quadro mais antigo (lado do consumidor).
+    pub fn pop(&self) -> Option<TouchFrame> {
+        let tail = self.tail.load(Ordering::Relaxed);
+        let head = self.head.load(Ordering::Acquire);
+        if tail == head {
+            return None;
+        }
+        let slot = &self.slots[tail % QUEUE_CAPACITY];
+        // O produtor só segura `WRITING` durante uma cópia, no top half.
+        while slot.state.compare_exchange_weak(SLOT_READY, SLOT_READING, Ordering::Acquire, Ordering::Relaxed).is_err() {
+            core::hint::spin_loop();
+        }
+        // # SAFETY: O estado `READING` exclui o produtor até o slot voltar a `EMPTY`.
+        let frame = unsafe { *slot.frame.get() };
+        slot.state.store(SLOT_EMPTY, Ordering::Release);
+        self.tail.store(tail.wrapping_add(1), Ordering::Release);
+        Some(frame)
+    }
+
+    /// Quadros publicados e ainda não lidos.
+    pub fn len(&self) -> usize {
+        self.head.load(Ordering::Acquire).wrapping_sub(self.tail.load(Ordering::Acquire))
+    }
+
+    /// Total de quadros publicados desde o boot (não muda ao coalescer).
+    pub fn published(&self) -> usize {
+        self.head.load(Ordering::Acquire)
+    }
+
+    /// Contato primário do último quadro com contatos, lido ou não.
+    pub fn latest(&self) -> Option<TouchEvent> {
+        match self.latest.load(Ordering::Relaxed) {
+            NO_EVENT => None,
+            raw => Some(TouchEvent::unpack(raw)),
+        }
+    }
+
+    /// Quadros de movimento descartados por fila cheia desde o boot.
+    pub fn dropped(&self) -> usize {
+        self.dropped.load(Ordering::Relaxed)
+    }
+
+    /// Varreduras coalescidas em quadros já publicados desde o boot.
+    pub fn coalesced(&self) -> usize {
+        self.coalesced.load(Ordering::Relaxed)
+    }
+}
+
+/// 👆 Fila global de quadros de toque do sistema.
+pub static TOUCH_QUEUE: FrameQueue = FrameQueue::new();
+
+// ------------------------------------------------------------------------
+// --- Registro Global e Caminho de Interrupção ---
+// ------------------------------------------------------------------------
+
+/// O driver registrado (um touchscreen MMIO por sistema).
+static TOUCHSCREEN: Once<TouchscreenDriver> = Once::new();
+
+/// Slots MT-B compartilhados pelas fontes de toque (o top half do MMIO e
+/// `submit_scan`), com os IDs de contato separados por fonte. Serializa os
+/// produtores da fila.
+static TRACKER: Mutex<SlotTracker> = Mutex::new(SlotTracker::new());
+
+/// Fontes de toque registradas (MMIO ou virtio-input).
+static SOURCES: AtomicUsize = AtomicUsize::new(0);
+/// Próximo ID de `attach_source` (o 0 é do MMIO).
+static NEXT_SOURCE: AtomicU8 = AtomicU8::new(1);
+
+/// Endpoint acordado quando há quadros novos (0 = nenhum).
+static READER: AtomicU64 = AtomicU64::new(NO_READER);
+const NO_READER: u64 = 0;
+/// Remetente das notificações (o kernel).
+const KERNEL_SENDER: Endpoint = Endpoint(0);
+
+/// Coalescência do bottom half: a 240 Hz, até 4 varreduras (~16 ms) por
+/// notificação, ou 1 tique se o fluxo parar antes disso. A fila guarda todos os quadros.
+const TOUCH_COALESCING: Coalescing = Coalescing { max_events: 4, max_delay_ticks: 1 };
+
+/// ⚡ Top half: `TouchscreenDriver::irq`.
+fn touch_top_half(_vector: u8) -> IrqReturn {
+    TOUCHSCREEN.get().map_or(IrqReturn::None, Driver::irq)
+}
+
+/// `FrameQueue::published` na última notificação: varreduras coalescidas em um
+/// quadro que o leitor ainda não leu não geram notificações novas.
+static NOTIFIED: AtomicUsize = AtomicUsize::new(0);
+
+/// 🧵 Bottom half: entrega os quadros novos.
+fn touch_bottom_half(_vector: u8, _coalesced: u32) {
+    publish();
+}
+
+/// 📣 Acorda o leitor (só se houver quadros novos desde a última notificação)
+/// e move o ponteiro do overlay. Chamado pelas fontes fora do contexto de interrupção.
+pub fn publish() {
+    let reader = READER.load(Ordering::Relaxed);
+    let published = TOUCH_QUEUE.published();
+    if reader != NO_READER && NOTIFIED.swap(published, Ordering::Relaxed) != published && TOUCH_QUEUE.len() > 0 {
+        // Mailbox cheia: o leitor ainda não acordou e vai drenar a fila inteira.
+        let _ = ipc::notify(Endpoint(reader), KERNEL_SENDER, TOUCH_QUEUE.len() as u64);
+    }
+    if let Some(event) = TOUCH_QUEUE.latest() {
+        super::overlay::on_touch_event(&event);
+    }
+}
+
+/// 🚀 Inicializa o controlador em `mmio_base` e o registra como o touchscreen
+/// do sistema, interrompendo na IRQ ISA `irq_line`.
+///
+/// # Safety
+/// `mmio_base` deve ser um endereço MMIO válido e mapeado durante toda a vida do kernel.
+pub unsafe fn register(mmio_base: usize, irq_line: u8) -> Result<(), TouchscreenError> {
+    if TOUCHSCREEN.get().is_some() {
+        return Err(TouchscreenError::AlreadyRegistered);
+    }
+    if irq_line >= 16 {
+        return Err(TouchscreenError::IrqUnavailable);
+    }
+    let regs = Mmio::new(mmio_base as *mut u8).ok_or(TouchscreenError::DeviceNotFound)?;
+    let mut driver = TouchscreenDriver::probe(regs)?;
+    driver.init()?;
+
+    // A IRQ é pedida antes de publicar o driver: o top half não faz nada até
+    // `TOUCHSCREEN` existir, e a linha só é desmascarada no fim.
+    let vector = PIC_1_OFFSET + irq_line;
+    if threaded::request_threaded_irq(vector, touch_top_half, touch_bottom_half, TOUCH_COALESCING, false).is_err() {
+        // O controlador já está varrendo: sem IRQ ninguém o atenderia.
+        let _ = driver.suspend();
+        return Err(TouchscreenError::IrqUnavailable);
+    }
+
+    let mut won = false;
+    let driver = TOUCHSCREEN.call_once(|| {
+        won = true;
+        driver
+    });
+    if !won {
+        let _ = threaded::free_threaded_irq(vector);
+        return Err(TouchscreenError::AlreadyRegistered);
+    }
+    SOURCES.fetch_add(1, Ordering::Relaxed);
+    interrupts::unmask_vector(vector);
+
+    // A linha ISA é de borda: uma varredura pendente desde antes do unmask não
+    // gera uma borda nova. Drena uma vez para baixar a linha.
+    let drained = x86_64::instructions::interrupts::without_interrupts(|| driver.drain_into(&TOUCH_QUEUE));
+    if drained > 0 {
+        publish();
+    }
+    crate::println!("INFO: Touchscreen registrado na IRQ {}.", irq_line);
+    Ok(())
+}
+
+/// 🔌 Declara uma fonte de toque além do controlador MMIO (ex: virtio-input).
+/// * Retorna a identidade da fonte, a passar em cada `submit_scan`.
+pub fn attach_source() -> TouchSource {
+    SOURCES.fetch_add(1, Ordering::Relaxed);
+    TouchSource(NEXT_SOURCE.fetch_add(1, Ordering::Relaxed))
+}
+
+/// ➕ Entrega uma varredura completa de uma fonte sem IRQ própria aqui
+/// (ex: o `SYN_REPORT` do virtio-input). Os contatos ausentes são levantados.
+/// * Não chamar em contexto de interrupção; depois do lote, chamar `publish`.
+pub fn submit_scan(source: TouchSource, contacts: &[ScanContact]) {
+    let contacts = &contacts[..contacts.len().min(MAX_CONTACTS)];
+    x86_64::instructions::interrupts::without_interrupts(|| {
+        let (frame, movement) = TRACKER.lock().scan(source, contacts, read_tsc());
+        TOUCH_QUEUE.push(&frame, movement);
+    });
+}
+
+/// 🔔 Registra (ou remove, com `None`) o endpoint acordado a cada lote de quadros.
+/// * A notificação carrega o número de quadros na fila; o leitor deve então
+///   chamar `read_frame` até `None`.
+pub fn set_reader(endpoint: Option<Endpoint>) {
+    READER.store(endpoint.map_or(NO_READER, |e| e.0), Ordering::Relaxed);
+}
+
+/// 🕘 Liga ou desliga o histórico das varreduras absorvidas por quadros coalescidos.
+pub fn set_history(enabled: bool) {
+    HISTORY_ENABLED.store(enabled, Ordering::Relaxed);
+}
 
-        Ok(Some(TouchEvent { x, y, pressure, down }))
+/// 📡 Retira o próximo quadro de toque, se houver (não toca o hardware).
+/// * Consumidor único: apenas o leitor registrado deve chamar.
+pub fn read_frame() -> Result<Option<TouchFrame>, TouchscreenError> {
+    if SOURCES.load(Ordering::Relaxed) == 0 {
+        return Err(TouchscreenError::DeviceNotFound);
     }
+    Ok(TOUCH_QUEUE.pop())
 }
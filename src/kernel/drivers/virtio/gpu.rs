@@ -0,0 +1,408 @@
+// src/kernel/drivers/virtio/gpu.rs
+
+//! Driver VirtIO-GPU (2D) do LightOS.
+//!
+//! O "framebuffer" é um buffer de DMA na RAM do convidado, anexado como backing
+//! de um recurso 2D do host. A cada `present`, só os retângulos danificados são
+//! transferidos (`TRANSFER_TO_HOST_2D`) e o host faz a varredura após
+//! `RESOURCE_FLUSH`: nenhuma escrita em memória de vídeo emulada.
+//!
+//! Os comandos de um `present` vão em lote: todas as transferências e um único
+//! flush entram na fila de controle antes de uma única notificação ao dispositivo.
+
+use alloc::boxed::Box;
+use core::mem::size_of;
+use core::ptr;
+use spin::Mutex;
+
+use super::queue::{Segment, Virtqueue};
+use super::{VirtioError, VirtioPci, DEVICE_GPU, VIRTQUEUE_FEATURES};
+use crate::drivers::blit::Rect;
+use crate::drivers::display::{DisplayDriver, DisplayError, FramebufferInfo, Scanout, DISPLAY};
+use crate::drivers::pixel::PixelFormat;
+use crate::memory::dma::DmaBuffer;
+
+// Comandos e respostas (virtio_gpu_ctrl_type).
+const CMD_GET_DISPLAY_INFO: u32 = 0x0100;
+const CMD_RESOURCE_CREATE_2D: u32 = 0x0101;
+const CMD_SET_SCANOUT: u32 = 0x0103;
+const CMD_RESOURCE_FLUSH: u32 = 0x0104;
+const CMD_TRANSFER_TO_HOST_2D: u32 = 0x0105;
+const CMD_RESOURCE_ATTACH_BACKING: u32 = 0x0106;
+const RESP_OK_NODATA: u32 = 0x1100;
+const RESP_OK_DISPLAY_INFO: u32 = 0x1101;
+
+/// Bytes B, G, R, X na memória = XRGB8888 little-endian.
+const FORMAT_B8G8R8X8_UNORM: u32 = 2;
+
+/// Número máximo de scanouts na resposta de GET_DISPLAY_INFO.
+const MAX_SCANOUTS: usize = 16;
+/// Recurso 2D usado como tela.
+const SCANOUT_RESOURCE_ID: u32 = 1;
+/// Resolução quando o host não informa um modo.
+const DEFAULT_WIDTH: u32 = 1024;
+const DEFAULT_HEIGHT: u32 = 768;
+
+/// Entradas da fila de controle pedidas ao dispositivo.
+const CONTROL_QUEUE_SIZE: u16 = 64;
+/// Comandos em voo por lote (cada um usa 2 descritores).
+const COMMAND_SLOTS: usize = 32;
+/// Bytes por slot: requisição na primeira metade, resposta na segunda.
+const SLOT_SIZE: usize = 1024;
+const RESPONSE_OFFSET: usize = SLOT_SIZE / 2;
+/// Leituras do anel used antes de declarar o dispositivo travado.
+const COMPLETION_SPIN_LIMIT: u32 = 50_000_000;
+
+/// Cabeçalho comum de comandos e respostas.
+#[repr(C)]
+#[derive(Debug, Clone, Copy, Default)]
+struct CtrlHeader {
+    kind: u32,
+    flags: u32,
+    fence_id: u64,
+    ctx_id: u32,
+    ring_idx: u8,
+    padding: [u8; 3],
+}
+
+impl CtrlHeader {
+    fn command(kind: u32) -> Self {
+        CtrlHeader { kind, ..Default::default() }
+    }
+}
+
+#[repr(C)]
+#[derive(Debug, Clone, Copy, Default)]
+struct GpuRect {
+    x: u32,
+    y: u32,
+    width: u32,
+    height: u32,
+}
+
+impl From<Rect> for GpuRect {
+    fn from(r: Rect) -> Self {
+        GpuRect { x: r.x, y: r.y, width: r.width, height: r.height }
+    }
+}
+
+#[repr(C)]
+#[derive(Clone, Copy)]
+struct DisplayOne {
+    rect: GpuRect,
+    enabled: u32,
+    flags: u32,
+}
+
+#[repr(C)]
+#[derive(Clone, Copy)]
+struct RespDisplayInfo {
+    header: CtrlHeader,
+    modes: [DisplayOne; MAX_SCANOUTS],
+}
+
+#[repr(C)]
+#[derive(Clone, Copy)]
+struct ResourceCreate2d {
+    header: CtrlHeader,
+    resource_id: u32,
+    format: u32,
+    width: u32,
+    height: u32,
+}
+
+#[repr(C)]
+#[derive(Clone, Copy)]
+struct AttachBacking {
+    header: CtrlHeader,
+    resource_id: u32,
+    nr_entries: u32,
+    // Uma única entrada: o backing é fisicamente contíguo.
+    addr: u64,
+    length: u32,
+    padding: u32,
+}
+
+#[repr(C)]
+#[derive(Clone, Copy)]
+struct SetScanout {
+    header: CtrlHeader,
+    rect: GpuRect,
+    scanout_id: u32,
+    resource_id: u32,
+}
+
+#[repr(C)]
+#[derive(Clone, Copy)]
+struct TransferToHost2d {
+    header: CtrlHeader,
+    rect: GpuRect,
+    offset: u64,
+    resource_id: u32,
+    padding: u32,
+}
+
+#[repr(C)]
+#[derive(Clone, Copy)]
+struct ResourceFlush {
+    header: CtrlHeader,
+    rect: GpuRect,
+    resource_id: u32,
+    padding: u32,
+}
+
+/// 🎮 Um dispositivo VirtIO-GPU com um scanout 2D.
+pub struct VirtioGpu {
+    /// Primeiro campo: o reset no `Drop` acontece antes de liberar fila e buffers.
+    transport: VirtioPci,
+    control: Virtqueue,
+    /// `COMMAND_SLOTS` pares requisição/resposta.
+    commands: DmaBuffer,
+    /// Comandos enfileirados no lote atual.
+    pending: usize,
+    width: u32,
+    height: u32,
+    /// Pixels da tela (backing do recurso), alocado em `create_scanout`.
+    backing: Option<DmaBuffer>,
+    /// O dispositivo foi reiniciado depois da criação do recurso: o host o perdeu.
+    scanout_lost: bool,
+}
+
+impl VirtioGpu {
+    /// 🔍 Encontra e inicializa o primeiro VirtIO-GPU do barramento.
+    pub fn probe() -> Result<Self, VirtioError> {
+        let transport = VirtioPci::find(DEVICE_GPU)?;
+        let commands = DmaBuffer::new(COMMAND_SLOTS * SLOT_SIZE).map_err(|_| VirtioError::OutOfMemory)?;
+        // Só as features de fila (VIRGL/EDID não são usadas no caminho 2D).
+        transport.negotiate(VIRTQUEUE_FEATURES)?;
+        let control = transport.setup_queue(0, CONTROL_QUEUE_SIZE)?;
+        // Daqui em diante qualquer erro descarta o `gpu`, que reinicia o dispositivo.
+        let mut gpu = VirtioGpu {
+            transport,
+            control,
+            commands,
+            pending: 0,
+            width: 0,
+            height: 0,
+            backing: None,
+            scanout_lost: false,
+        };
+        gpu.start_control();
+
+        let (width, height) = gpu.display_info()?.unwrap_or((DEFAULT_WIDTH, DEFAULT_HEIGHT));
+        gpu.width = width;
+        gpu.height = height;
+        Ok(gpu)
+    }
+
+    /// ✅ Libera o dispositivo para processar a fila de controle.
+    /// * O caminho 2D é síncrono (espera ativa pelo anel used): INTx não é usado
+    ///   e o dispositivo nem precisa sinalizar as devoluções.
+    fn start_control(&mut self) {
+        self.transport.driver_ok();
+        self.transport.pci_device().disable_intx();
+        self.control.disable_interrupts();
+    }
+
+    /// 🔄 Reinicia o dispositivo depois de um lote sem resposta: o reset tira do
+    /// dispositivo os descritores em voo e a fila de controle é recriada do zero.
+    /// * O host perde o recurso da tela: `flush_rects` o recria antes do próximo envio.
+    fn restart(&mut self) -> Result<(), VirtioError> {
+        self.pending = 0;
+        self.scanout_lost = self.backing.is_some();
+        if let Err(e) = self.transport.negotiate(VIRTQUEUE_FEATURES) {
+            // Sem reset o dispositivo ainda pode acessar a fila antiga.
+            self.transport.pci_device().disable_bus_master();
+            return Err(e);
+        }
+        // A fila antiga só é liberada aqui, com o dispositivo já reiniciado.
+        self.control = self.transport.setup_queue(0, CONTROL_QUEUE_SIZE)?;
+        self.start_control();
+        Ok(())
+    }
+
+    /// Resolução do scanout.
+    pub fn resolution(&self) -> (u32, u32) {
+        (self.width, self.height)
+    }
+
+    fn slot_ptr(&self, slot: usize) -> *mut u8 {
+        // # SAFETY: `slot < COMMAND_SLOTS`: dentro do buffer de comandos.
+        unsafe { self.commands.as_mut_ptr().add(slot * SLOT_SIZE) }
+    }
+
+    /// ➕ Enfileira um comando no lote atual (sem notificar o dispositivo).
+    fn queue<T: Copy>(&mut self, request: &T, response_len: usize) -> Result<(), VirtioError> {
+        if self.pending == COMMAND_SLOTS {
+            self.submit()?;
+        }
+        let slot = self.pending;
+        let base = self.slot_ptr(slot);
+        // # SAFETY: Requisição e resposta cabem em meio slot cada.
+        unsafe {
+            ptr::write_unaligned(base as *mut T, *request);
+            ptr::write_bytes(base.add(RESPONSE_OFFSET), 0, response_len);
+        }
+        let phys = self.commands.phys_addr() + (slot * SLOT_SIZE) as u64;
+        self.control.add(&[
+            Segment::read(phys, size_of::<T>() as u32),
+            Segment::write(phys + RESPONSE_OFFSET as u64, response_len as u32),
+        ])?;
+        self.pending += 1;
+        Ok(())
+    }
+
+    /// 🔔 Notifica o dispositivo uma vez e espera todo o lote.
+    /// * Falha se alguma resposta não for `OK_NODATA` (exceto GET_DISPLAY_INFO).
+    /// * Sem resposta a tempo, o lote é perdido e o dispositivo é reiniciado.
+    fn submit(&mut self) -> Result<(), VirtioError> {
+        if self.pending == 0 {
+            return Ok(());
+        }
+        self.control.kick();
+
+        let mut completed = 0;
+        let mut spins = 0;
+        while completed < self.pending {
+            if self.control.pop_used().is_some() {
+                completed += 1;
+                continue;
+            }
+            spins += 1;
+            if spins == COMPLETION_SPIN_LIMIT {
+                let _ = self.restart();
+                return Err(VirtioError::Timeout);
+            }
+            core::hint::spin_loop();
+        }
+
+        let count = core::mem::replace(&mut self.pending, 0);
+        for slot in 0..count {
+            // # SAFETY: A resposta do slot foi escrita pelo dispositivo (lote concluído).
+            let response = unsafe { ptr::read_unaligned(self.slot_ptr(slot).add(RESPONSE_OFFSET) as *const CtrlHeader) };
+            if response.kind != RESP_OK_NODATA && response.kind != RESP_OK_DISPLAY_INFO {
+                return Err(VirtioError::DeviceError);
+            }
+        }
+        Ok(())
+    }
+
+    /// 🖥️ Modo preferido do scanout 0, se o host informar um.
+    fn display_info(&mut self) -> Result<Option<(u32, u32)>, VirtioError> {
+        self.queue(&CtrlHeader::command(CMD_GET_DISPLAY_INFO), size_of::<RespDisplayInfo>())?;
+        self.submit()?;
+        // # SAFETY: O slot 0 contém a resposta recém-escrita.
+        let info = unsafe { ptr::read_unaligned(self.slot_ptr(0).add(RESPONSE_OFFSET) as *const RespDisplayInfo) };
+        let mode = info.modes[0];
+        Ok((mode.enabled != 0 && mode.rect.width != 0 && mode.rect.height != 0)
+            .then(|| (mode.rect.width, mode.rect.height)))
+    }
+
+    /// 🧱 Cria o recurso 2D da tela, anexa o backing e o liga ao scanout 0.
+    /// Retorna o ponteiro para os pixels (XRGB8888, pitch `width * 4`).
+    pub fn create_scanout(&mut self) -> Result<*mut u8, VirtioError> {
+        let size = self.width as usize * self.height as usize * 4;
+        let backing = DmaBuffer::new(size).map_err(|_| VirtioError::OutOfMemory)?;
+        let pixels = backing.as_mut_ptr();
+        self.backing = Some(backing);
+        self.attach_scanout_resource()?;
+        Ok(pixels)
+    }
+
+    /// 🔗 Cria o recurso 2D sobre o backing existente e o liga ao scanout 0.
+    fn attach_scanout_resource(&mut self) -> Result<(), VirtioError> {
+        let phys = self.backing.as_ref().ok_or(VirtioError::DeviceError)?.phys_addr();
+        let size = self.width as usize * self.height as usize * 4;
+        let full = GpuRect { x: 0, y: 0, width: self.width, height: self.height };
+        self.queue(&ResourceCreate2d {
+            header: CtrlHeader::command(CMD_RESOURCE_CREATE_2D),
+            resource_id: SCANOUT_RESOURCE_ID,
+            format: FORMAT_B8G8R8X8_UNORM,
+            width: self.width,
+            height: self.height,
+        }, size_of::<CtrlHeader>())?;
+        self.queue(&AttachBacking {
+            header: CtrlHeader::command(CMD_RESOURCE_ATTACH_BACKING),
+            resource_id: SCANOUT_RESOURCE_ID,
+            nr_entries: 1,
+            addr: phys.as_u64(),
+            length: size as u32,
+            padding: 0,
+        }, size_of::<CtrlHeader>())?;
+        self.queue(&SetScanout {
+            header: CtrlHeader::command(CMD_SET_SCANOUT),
+            rect: full,
+            scanout_id: 0,
+            resource_id: SCANOUT_RESOURCE_ID,
+        }, size_of::<CtrlHeader>())?;
+        self.submit()?;
+        self.scanout_lost = false;
+        Ok(())
+    }
+
+    /// 🚀 Transfere `rects` do backing para o host e pede um único flush da
+    /// área que os cobre.
+    pub fn flush_rects(&mut self, rects: &[Rect]) -> Result<(), VirtioError> {
+        let screen = Rect::new(0, 0, self.width, self.height);
+        // Depois de um reset o host perdeu o recurso: recria e envia a tela inteira.
+        let rects: &[Rect] = if self.scanout_lost {
+            self.attach_scanout_resource()?;
+            core::slice::from_ref(&screen)
+        } else {
+            rects
+        };
+        let mut covered: Option<Rect> = None;
+        for rect in rects.iter().filter_map(|r| r.intersect(&screen)) {
+            self.queue(&TransferToHost2d {
+                header: CtrlHeader::command(CMD_TRANSFER_TO_HOST_2D),
+                rect: rect.into(),
+                offset: rect.y as u64 * self.width as u64 * 4 + rect.x as u64 * 4,
+                resource_id: SCANOUT_RESOURCE_ID,
+                padding: 0,
+            }, size_of::<CtrlHeader>())?;
+            covered = Some(covered.map_or(rect, |c| c.union(&rect)));
+        }
+        if let Some(area) = covered {
+            self.queue(&ResourceFlush {
+                header: CtrlHeader::command(CMD_RESOURCE_FLUSH),
+                rect: area.into(),
+                resource_id: SCANOUT_RESOURCE_ID,
+                padding: 0,
+            }, size_of::<CtrlHeader>())?;
+        }
+        self.submit()
+    }
+}
+
+impl Scanout for VirtioGpu {
+    fn flush(&mut self, rects: &[Rect]) -> Result<(), DisplayError> {
+        self.flush_rects(rects).map_err(|_| DisplayError::ScanoutFailed)
+    }
+}
+
+/// 🚀 Cria o `DISPLAY` sobre um VirtIO-GPU, se houver um no barramento.
+/// * Chamado do kernel_main antes do display do firmware (que fica como alternativa).
+pub fn init_display() -> Result<(), VirtioError> {
+    let mut gpu = VirtioGpu::probe()?;
+    let pixels = gpu.create_scanout()?;
+    let (width, height) = gpu.resolution();
+
+    let info = FramebufferInfo {
+        address: pixels as usize,
+        width,
+        height,
+        pitch: width * 4,
+        bpp: 32,
+        format: PixelFormat::XRGB8888,
+    };
+    // # SAFETY: O backing tem `pitch * height` bytes e vive dentro do `gpu`, que
+    // passa a pertencer ao driver de display.
+    let mut driver = unsafe { DisplayDriver::new(info) }.map_err(|_| VirtioError::DeviceError)?;
+    driver.attach_scanout(Box::new(gpu));
+    driver.initialize().map_err(|_| VirtioError::DeviceError)?;
+    driver.present(false).map_err(|_| VirtioError::DeviceError)?;
+
+    DISPLAY.call_once(|| Mutex::new(driver));
+    crate::println!("INFO: VirtIO-GPU: scanout 2D {}x{}.", width, height);
+    Ok(())
+}
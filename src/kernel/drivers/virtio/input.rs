@@ -0,0 +1,469 @@
+// src/kernel/drivers/virtio/input.rs
+
+//! Driver VirtIO-Input do LightOS (teclado, tablet e multi-toque do QEMU).
+//!
+//! O dispositivo entrega eventos evdev (tipo, código, valor) de 8 bytes na fila
+//! de eventos, em buffers que o driver mantém sempre postados:
+//! * Teclas (`EV_KEY` de teclado) vão para a `EVDEV_KEY_QUEUE`, no espaço de códigos do PS/2.
+//! * Eixos absolutos (`EV_ABS`) e botões de toque montam o estado do ponteiro,
+//!   que a cada `SYN_REPORT` vira uma varredura do touchscreen
+//!   (`touchscreen::submit_scan`): o mesmo caminho de quadros MT-B do
+//!   controlador MMIO. Dispositivos multi-toque usam os slots `ABS_MT_*`.
+//! * Um tablet sem botão pressionado só move o cursor (hover).
+//!
+//! Os dispositivos são ligados pelo registro de drivers PCI. Com o x2APIC ativo,
+//! cada um interrompe no seu vetor MSI-X; senão, pela linha INTx (compartilhável).
+//!
+//! Testável no QEMU com `-device virtio-tablet-pci -device virtio-keyboard-pci`
+//! (ou `virtio-multitouch-pci`).
+
+use alloc::vec::Vec;
+use core::mem::{self, size_of};
+use core::ptr;
+use spin::Mutex;
+
+use super::queue::{Segment, Virtqueue};
+use super::{pci_match, VirtioError, VirtioPci, DEVICE_INPUT, VIRTQUEUE_FEATURES};
+use crate::drivers::display::DISPLAY;
+use crate::drivers::keyboard;
+use crate::drivers::overlay;
+use crate::drivers::pci::{self, PciDevice, PciDriver};
+use crate::drivers::touchscreen::{self, ScanContact, TouchEvent, TouchSource, MAX_CONTACTS};
+use crate::interrupts::{self, apic, dispatch, threaded::{self, Coalescing, IrqReturn}, PIC_1_OFFSET};
+use crate::memory::dma::DmaBuffer;
+
+// Configuração do dispositivo (virtio_input_config).
+const CFG_SELECT: usize = 0;
+const CFG_SUBSEL: usize = 1;
+const CFG_SIZE: usize = 2;
+const CFG_DATA: usize = 8;
+const CFG_ABS_INFO: u8 = 0x12;
+
+// Tipos e códigos de evento (linux/input-event-codes.h).
+const EV_SYN: u16 = 0x00;
+const EV_KEY: u16 = 0x01;
+const EV_ABS: u16 = 0x03;
+const SYN_REPORT: u16 = 0;
+const SYN_DROPPED: u16 = 3;
+const ABS_X: u16 = 0x00;
+const ABS_Y: u16 = 0x01;
+const ABS_PRESSURE: u16 = 0x18;
+const ABS_MT_SLOT: u16 = 0x2F;
+const ABS_MT_POSITION_X: u16 = 0x35;
+const ABS_MT_POSITION_Y: u16 = 0x36;
+const ABS_MT_TRACKING_ID: u16 = 0x39;
+const ABS_MT_PRESSURE: u16 = 0x3A;
+/// Códigos de `EV_KEY` a partir daqui são botões (`BTN_MISC`), não teclas.
+const BTN_MISC: u16 = 0x100;
+const BTN_LEFT: u16 = 0x110;
+const BTN_TOUCH: u16 = 0x14A;
+
+/// Fila de eventos (a fila 1, de status, não é usada).
+const EVENT_QUEUE: u16 = 0;
+/// Entradas pedidas para a fila de eventos (um buffer postado por entrada).
+const EVENT_QUEUE_SIZE: u16 = 64;
+/// Bit "fila" do registrador ISR.
+const ISR_QUEUE: u8 = 1;
+/// Pressão de um contato em dispositivos sem eixo de pressão.
+const FULL_PRESSURE: u8 = u8::MAX;
+
+/// 📨 Evento evdev como o dispositivo o escreve.
+#[repr(C)]
+#[derive(Debug, Clone, Copy)]
+struct InputEvent {
+    kind: u16,
+    code: u16,
+    value: u32,
+}
+
+const EVENT_SIZE: usize = size_of::<InputEvent>();
+
+/// 📏 Faixa de um eixo absoluto e o tamanho de destino para onde é escalado.
+#[derive(Debug, Clone, Copy)]
+struct Axis {
+    min: i32,
+    max: i32,
+    /// Pixels (ou níveis de pressão) do destino; 0 = sem escala.
+    target: u32,
+}
+
+impl Axis {
+    fn scale(&self, value: i32) -> u16 {
+        let offset = (value.clamp(self.min, self.max) - self.min) as i64;
+        if self.target == 0 {
+            return offset.min(u16::MAX as i64) as u16;
+        }
+        let span = (self.max - self.min).max(1) as i64;
+        (offset * (self.target as i64 - 1) / span).min(u16::MAX as i64) as u16
+    }
+}
+
+/// 🖐️ Estado do ponteiro acumulado até o próximo `SYN_REPORT`.
+#[derive(Default)]
+struct PointerState {
+    x: u16,
+    y: u16,
+    pressure: Option<u8>,
+    touching: bool,
+    /// Havia contato no último relatório entregue.
+    was_touching: bool,
+    /// Contato ativo em cada slot MT do dispositivo.
+    mt: [Option<ScanContact>; MAX_CONTACTS],
+    mt_slot: usize,
+    /// Algum evento de ponteiro desde o último relatório.
+    dirty: bool,
+}
+
+/// 🔌 Um dispositivo VirtIO-Input.
+pub struct VirtioInput {
+    transport: VirtioPci,
+    queue: Virtqueue,
+    /// Um evento por buffer, `queue.size()` buffers.
+    events: DmaBuffer,
+    /// Buffer postado em cada descritor.
+    buffer_of_desc: Vec<u16>,
+    vector: u8,
+    /// Vetor MSI-X exclusivo (sem ISR a ler); senão, linha INTx.
+    msix: bool,
+    abs_x: Option<Axis>,
+    abs_y: Option<Axis>,
+    abs_pressure: Option<Axis>,
+    mt_x: Option<Axis>,
+    mt_y: Option<Axis>,
+    mt_pressure: Option<Axis>,
+    pointer: PointerState,
+    /// Fonte de toque (dispositivos de ponteiro, depois de registrados).
+    touch_source: Option<TouchSource>,
+    /// Após um `SYN_DROPPED`, descarta tudo até o próximo `SYN_REPORT`.
+    dropping: bool,
+}
+
+impl VirtioInput {
+    /// 🔍 Inicializa `device`, posta todos os buffers de evento e o liga.
+    fn probe(device: PciDevice) -> Result<Self, VirtioError> {
+        let mut transport = VirtioPci::new(device)?;
+        transport.negotiate(VIRTQUEUE_FEATURES)?;
+        let queue = transport.setup_queue(EVENT_QUEUE, EVENT_QUEUE_SIZE)?;
+        let (vector, msix) = Self::setup_interrupt(&mut transport)?;
+        let count = queue.size() as usize;
+        let events = DmaBuffer::new(count * EVENT_SIZE).map_err(|_| VirtioError::OutOfMemory)?;
+        let mut buffer_of_desc = Vec::new();
+        buffer_of_desc.try_reserve_exact(count).map_err(|_| VirtioError::OutOfMemory)?;
+        buffer_of_desc.resize(count, 0);
+
+        let (width, height) = screen_size();
+        let pressure_levels = FULL_PRESSURE as u32 + 1;
+        let mut input = VirtioInput {
+            abs_x: abs_info(&transport, ABS_X, width),
+            abs_y: abs_info(&transport, ABS_Y, height),
+            abs_pressure: abs_info(&transport, ABS_PRESSURE, pressure_levels),
+            mt_x: abs_info(&transport, ABS_MT_POSITION_X, width),
+            mt_y: abs_info(&transport, ABS_MT_POSITION_Y, height),
+            mt_pressure: abs_info(&transport, ABS_MT_PRESSURE, pressure_levels),
+            transport,
+            queue,
+            events,
+            buffer_of_desc,
+            vector,
+            msix,
+            pointer: PointerState::default(),
+            touch_source: None,
+            dropping: false,
+        };
+        for buffer in 0..count as u16 {
+            input.post(buffer)?;
+        }
+        input.transport.driver_ok();
+        input.queue.kick();
+        Ok(input)
+    }
+
+    /// ⚡ Escolhe a interrupção da fila de eventos: (vetor, é MSI-X).
+    /// * Com o x2APIC ativo: MSI-X, num vetor dinâmico exclusivo.
+    /// * Sem ele (ou sem MSI-X): a linha INTx, se for uma IRQ ISA (roteada como
+    ///   nível no IO-APIC e mascarada até o `start`).
+    fn setup_interrupt(transport: &mut VirtioPci) -> Result<(u8, bool), VirtioError> {
+        if apic::is_active() {
+            match transport.route_queue_msix(EVENT_QUEUE) {
+                Ok(vector) => return Ok((vector, true)),
+                Err(e) => crate::println!("INFO: VirtIO-Input sem MSI-X ({:?}); usando INTx.", e),
+            }
+        }
+        interrupts::route_pci_intx(transport.pci_device().interrupt_line)
+            .map(|vector| (vector, false))
+            .ok_or(VirtioError::NoInterrupt)
+    }
+
+    /// `true` se o dispositivo reporta posições (tablet ou multi-toque).
+    pub fn is_pointer(&self) -> bool {
+        self.mt_x.is_some() || self.abs_x.is_some()
+    }
+
+    fn kind(&self) -> &'static str {
+        match (self.mt_x.is_some(), self.abs_x.is_some()) {
+            (true, _) => "multi-toque",
+            (false, true) => "tablet",
+            _ => "teclado",
+        }
+    }
+
+    /// Entrega o buffer `buffer` ao dispositivo (sem notificar).
+    fn post(&mut self, buffer: u16) -> Result<(), VirtioError> {
+        let addr = self.events.phys_addr() + (buffer as usize * EVENT_SIZE) as u64;
+        let desc = self.queue.add(&[Segment::write(addr, EVENT_SIZE as u32)])?;
+        self.buffer_of_desc[desc as usize] = buffer;
+        Ok(())
+    }
+
+    /// 🚰 Processa os eventos devolvidos e os repõe com uma única notificação.
+    /// Retorna `true` se alguma varredura de toque foi entregue.
+    fn drain(&mut self) -> bool {
+        let mut touched = false;
+        let mut reposted = false;
+        // Sem interrupções enquanto o lote é drenado; ao re-armar, o que chegou
+        // nesse meio-tempo (e não vai interromper) é drenado também.
+        self.queue.disable_interrupts();
+        loop {
+            while let Some((desc, _)) = self.queue.pop_used() {
+                let buffer = self.buffer_of_desc[desc as usize];
+                // # SAFETY: O buffer está dentro de `events` e o dispositivo já o devolveu.
+                let event = unsafe {
+                    ptr::read_volatile(self.events.as_mut_ptr().add(buffer as usize * EVENT_SIZE) as *const InputEvent)
+                };
+                touched |= self.handle(event);
+                reposted |= self.post(buffer).is_ok();
+            }
+            if !self.queue.enable_interrupts() {
+                break;
+            }
+        }
+        if reposted {
+            self.queue.kick();
+        }
+        touched
+    }
+
+    fn handle(&mut self, event: InputEvent) -> bool {
+        match (event.kind, event.code) {
+            (EV_SYN, SYN_DROPPED) => {
+                self.dropping = true;
+                false
+            }
+            (EV_SYN, SYN_REPORT) => !mem::replace(&mut self.dropping, false) && self.report(),
+            _ if self.dropping => false,
+            (EV_KEY, code) if code < BTN_MISC => {
+                keyboard::handle_evdev_key(code, event.value != 0);
+                false
+            }
+            (EV_KEY, BTN_LEFT) | (EV_KEY, BTN_TOUCH) => {
+                self.pointer.touching = event.value != 0;
+                self.pointer.dirty = true;
+                false
+            }
+            (EV_ABS, code) => {
+                self.absolute(code, event.value as i32);
+                false
+            }
+            _ => false,
+        }
+    }
+
+    fn absolute(&mut self, code: u16, value: i32) {
+        let pointer = &mut self.pointer;
+        pointer.dirty = true;
+        let slot = pointer.mt_slot;
+        match code {
+            ABS_X => pointer.x = self.abs_x.map_or(pointer.x, |a| a.scale(value)),
+            ABS_Y => pointer.y = self.abs_y.map_or(pointer.y, |a| a.scale(value)),
+            ABS_PRESSURE => pointer.pressure = self.abs_pressure.map(|a| a.scale(value) as u8),
+            ABS_MT_SLOT => pointer.mt_slot = value.max(0) as usize,
+            ABS_MT_TRACKING_ID if slot < MAX_CONTACTS => {
+                // Um ID novo é um toque novo, mesmo se o slot não ficou vago no meio.
+                let previous = pointer.mt[slot].unwrap_or(ScanContact { id: 0, x: 0, y: 0, pressure: 0 });
+                pointer.mt[slot] = (value >= 0).then(|| ScanContact { id: value as u8, pressure: FULL_PRESSURE, ..previous });
+            }
+            ABS_MT_POSITION_X | ABS_MT_POSITION_Y | ABS_MT_PRESSURE if slot < MAX_CONTACTS => {
+                if let Some(contact) = pointer.mt[slot].as_mut() {
+                    match code {
+                        ABS_MT_POSITION_X => contact.x = self.mt_x.map_or(contact.x, |a| a.scale(value)),
+                        ABS_MT_POSITION_Y => contact.y = self.mt_y.map_or(contact.y, |a| a.scale(value)),
+                        _ => contact.pressure = self.mt_pressure.map_or(contact.pressure, |a| a.scale(value) as u8),
+                    }
+                }
+            }
+            _ => {}
+        }
+    }
+
+    /// 📤 Fecha um relatório (`SYN_REPORT`): entrega a varredura de toque.
+    fn report(&mut self) -> bool {
+        let pointer = &mut self.pointer;
+        if !mem::replace(&mut pointer.dirty, false) {
+            return false;
+        }
+        let mut contacts = [ScanContact { id: 0, x: 0, y: 0, pressure: 0 }; MAX_CONTACTS];
+        let mut count = 0;
+
+        if self.mt_x.is_some() {
+            for contact in pointer.mt.iter().flatten() {
+                contacts[count] = *contact;
+                count += 1;
+            }
+        } else if self.abs_x.is_some() {
+            if !pointer.touching && !pointer.was_touching {
+                // Hover: só o cursor acompanha.
+                overlay::on_touch_event(&TouchEvent { x: pointer.x, y: pointer.y, pressure: 0, down: false });
+                return false;
+            }
+            if pointer.touching {
+                let pressure = pointer.pressure.unwrap_or(FULL_PRESSURE);
+                contacts[0] = ScanContact { id: 0, x: pointer.x, y: pointer.y, pressure };
+                count = 1;
+            }
+            pointer.was_touching = pointer.touching;
+        } else {
+            return false;
+        }
+        match self.touch_source {
+            Some(source) => {
+                touchscreen::submit_scan(source, &contacts[..count]);
+                true
+            }
+            None => false,
+        }
+    }
+}
+
+/// Faixa do eixo `code`, escalada para `target`, se o dispositivo o tiver.
+fn abs_info(transport: &VirtioPci, code: u16, target: u32) -> Option<Axis> {
+    transport.write_config(CFG_SELECT, CFG_ABS_INFO);
+    transport.write_config(CFG_SUBSEL, code as u8);
+    if transport.read_config::<u8>(CFG_SIZE)? == 0 {
+        return None;
+    }
+    let min = transport.read_config::<u32>(CFG_DATA)? as i32;
+    let max = transport.read_config::<u32>(CFG_DATA + 4)? as i32;
+    Some(Axis { min, max: max.max(min), target })
+}
+
+/// Resolução do display (0 x 0 sem display: coordenadas do dispositivo).
+fn screen_size() -> (u32, u32) {
+    DISPLAY.get().map_or((0, 0), |display| {
+        let bounds = display.lock().bounds();
+        (bounds.width, bounds.height)
+    })
+}
+
+// ------------------------------------------------------------------------
+// --- Registro Global e Interrupção ---
+// ------------------------------------------------------------------------
+
+/// Dispositivos inicializados (os de INTx podem compartilhar a linha).
+static INPUTS: Mutex<Vec<VirtioInput>> = Mutex::new(Vec::new());
+
+/// 🚗 Driver no registro PCI.
+static DRIVER: PciDriver = PciDriver {
+    name: "virtio-input",
+    matches: &[pci_match(DEVICE_INPUT)],
+    probe: probe_device,
+};
+
+/// ⚡ Top half: com MSI-X a interrupção já identifica o dispositivo; com INTx,
+/// lê (e zera) o ISR dos dispositivos da linha.
+fn input_top_half(vector: u8) -> IrqReturn {
+    let inputs = match INPUTS.try_lock() {
+        Some(inputs) => inputs,
+        // O bottom half está drenando (e, em INTx, a linha fica mascarada até ele terminar).
+        None => return IrqReturn::WakeThread,
+    };
+    let mut pending = false;
+    for input in inputs.iter().filter(|input| input.vector == vector) {
+        pending |= input.msix || input.transport.read_isr() & ISR_QUEUE != 0;
+    }
+    if pending { IrqReturn::WakeThread } else { IrqReturn::None }
+}
+
+/// 🧵 Bottom half: processa os eventos e acorda o leitor de toque.
+fn input_bottom_half(vector: u8, _coalesced: u32) {
+    let mut touched = false;
+    for input in INPUTS.lock().iter_mut().filter(|input| input.vector == vector) {
+        touched |= input.drain();
+    }
+    if touched {
+        touchscreen::publish();
+    }
+}
+
+/// 🔌 Probe do registro PCI: inicializa `device` e liga a sua interrupção.
+fn probe_device(device: PciDevice) -> bool {
+    match start(device) {
+        Ok(()) => true,
+        Err(e) => {
+            crate::println!("WARN: VirtIO-Input {:?}: {:?}", device.address, e);
+            false
+        }
+    }
+}
+
+fn start(device: PciDevice) -> Result<(), VirtioError> {
+    let input = VirtioInput::probe(device)?;
+    let (vector, msix, pointer) = (input.vector, input.msix, input.is_pointer());
+    if msix {
+        crate::println!("INFO: VirtIO-Input: {} no vetor MSI-X {:#x}.", input.kind(), vector);
+    } else {
+        crate::println!("INFO: VirtIO-Input: {} na IRQ {}.", input.kind(), vector - PIC_1_OFFSET);
+    }
+
+    // Em qualquer falha daqui em diante, `input` é solto antes de retornar: o
+    // `Drop` do transporte reseta o dispositivo (que para de escrever nos buffers).
+    let shared = INPUTS.lock().iter().any(|other| other.vector == vector);
+    // O vetor MSI-X é exclusivo deste dispositivo: volta para a faixa dinâmica.
+    let release_vector = || {
+        if msix {
+            dispatch::free_vector(vector);
+        }
+    };
+    if !shared {
+        // INTx é nível: mascarada (oneshot) até o bottom half drenar. MSI-X é borda.
+        if threaded::request_threaded_irq(vector, input_top_half, input_bottom_half, Coalescing::NONE, !msix).is_err() {
+            release_vector();
+            return Err(VirtioError::NoInterrupt);
+        }
+    }
+    let touched = {
+        let mut inputs = INPUTS.lock();
+        if inputs.try_reserve(1).is_err() {
+            drop(inputs);
+            if !shared {
+                let _ = threaded::free_threaded_irq(vector);
+            }
+            release_vector();
+            return Err(VirtioError::OutOfMemory);
+        }
+        inputs.push(input);
+        inputs.last_mut().map_or(false, |input| {
+            if pointer {
+                input.touch_source = Some(touchscreen::attach_source());
+            }
+            // O que chegou antes do handler não interromperia de novo (índice de evento).
+            input.drain()
+        })
+    };
+    if touched {
+        touchscreen::publish();
+    }
+    if !shared && !msix {
+        interrupts::unmask_vector(vector);
+    }
+    Ok(())
+}
+
+/// 🚀 Registra o driver: inicializa todos os VirtIO-Input do barramento.
+/// Retorna quantos foram ligados.
+/// * Chamado do kernel_main depois do display (a escala dos eixos usa a resolução).
+pub fn init_input() -> Result<usize, VirtioError> {
+    match pci::register_driver(&DRIVER)? {
+        0 => Err(VirtioError::NotFound),
+        started => Ok(started),
+    }
+}
@@ -0,0 +1,371 @@
+// src/kernel/drivers/virtio/mod.rs
+
+//! Dispositivos VirtIO sobre PCI (transporte "modern", VirtIO 1.x).
+//!
+//! O dispositivo expõe suas estruturas por capabilities de fabricante (id 0x09),
+//! cada uma apontando para um trecho de um BAR:
+//! * Common config: negociação de features, status e configuração das filas.
+//! * Notify: onde o driver avisa que colocou buffers numa fila.
+//! * ISR: status de interrupção (para INTx).
+//! * Device config: campos específicos do tipo de dispositivo.
+//!
+//! Com o x2APIC ativo, as filas podem interromper por MSI-X (`route_queue_msix`),
+//! cada uma no seu vetor; sem ele, a linha INTx é compartilhada e o ISR diz quem foi.
+
+pub mod gpu;
+pub mod input;
+pub mod queue;
+
+use alloc::vec::Vec;
+use core::cell::Cell;
+use core::ptr;
+
+use super::pci::{self, MsixTable, PciDevice, PciError, PciMatch};
+use crate::interrupts::{apic, dispatch};
+use crate::memory::paging::CacheMode;
+use queue::Virtqueue;
+
+/// Vendor ID da Red Hat (todos os dispositivos VirtIO).
+pub const VIRTIO_VENDOR_ID: u16 = 0x1AF4;
+/// Device IDs "modern" são `0x1040 + tipo`.
+const MODERN_DEVICE_ID_BASE: u16 = 0x1040;
+
+/// Tipos de dispositivo VirtIO usados pelo LightOS.
+pub const DEVICE_GPU: u16 = 16;
+pub const DEVICE_INPUT: u16 = 18;
+pub const DEVICE_SOUND: u16 = 25;
+
+/// 🪪 Critério de `pci::register_driver` para os dispositivos VirtIO do `device_type`.
+pub const fn pci_match(device_type: u16) -> PciMatch {
+    PciMatch::device(VIRTIO_VENDOR_ID, MODERN_DEVICE_ID_BASE + device_type)
+}
+
+/// Feature obrigatória do transporte modern.
+pub const VIRTIO_F_VERSION_1: u64 = 1 << 32;
+/// Features de transporte das virtqueues (ver `queue`).
+pub const VIRTIO_F_INDIRECT_DESC: u64 = 1 << 28;
+pub const VIRTIO_F_EVENT_IDX: u64 = 1 << 29;
+pub const VIRTIO_F_RING_PACKED: u64 = 1 << 34;
+/// Todas as features de fila que `Virtqueue` implementa; os drivers as pedem em `negotiate`.
+pub const VIRTQUEUE_FEATURES: u64 = VIRTIO_F_INDIRECT_DESC | VIRTIO_F_EVENT_IDX | VIRTIO_F_RING_PACKED;
+
+const PCI_CAP_VENDOR: u8 = 0x09;
+const CFG_COMMON: u8 = 1;
+const CFG_NOTIFY: u8 = 2;
+const CFG_ISR: u8 = 3;
+const CFG_DEVICE: u8 = 4;
+
+/// Nenhuma entrada MSI-X associada (configuração ou fila).
+const NO_MSIX_VECTOR: u16 = 0xFFFF;
+
+const STATUS_ACKNOWLEDGE: u8 = 1;
+const STATUS_DRIVER: u8 = 2;
+const STATUS_DRIVER_OK: u8 = 4;
+const STATUS_FEATURES_OK: u8 = 8;
+const STATUS_FAILED: u8 = 128;
+
+// Offsets da estrutura common config.
+const COMMON_DEVICE_FEATURE_SELECT: usize = 0x00;
+const COMMON_DEVICE_FEATURE: usize = 0x04;
+const COMMON_DRIVER_FEATURE_SELECT: usize = 0x08;
+const COMMON_DRIVER_FEATURE: usize = 0x0C;
+const COMMON_MSIX_CONFIG: usize = 0x10;
+const COMMON_NUM_QUEUES: usize = 0x12;
+const COMMON_DEVICE_STATUS: usize = 0x14;
+const COMMON_QUEUE_SELECT: usize = 0x16;
+const COMMON_QUEUE_SIZE: usize = 0x18;
+const COMMON_QUEUE_MSIX_VECTOR: usize = 0x1A;
+const COMMON_QUEUE_ENABLE: usize = 0x1C;
+const COMMON_QUEUE_NOTIFY_OFF: usize = 0x1E;
+const COMMON_QUEUE_DESC: usize = 0x20;
+const COMMON_QUEUE_DRIVER: usize = 0x28;
+const COMMON_QUEUE_DEVICE: usize = 0x30;
+
+/// Leituras do status durante o reset antes de desistir.
+const RESET_SPIN_LIMIT: u32 = 1_000_000;
+
+/// 🚨 Erros dos drivers VirtIO.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum VirtioError {
+    /// Nenhum dispositivo do tipo pedido no barramento.
+    NotFound,
+    /// Falta uma capability obrigatória do transporte modern.
+    MissingCapability,
+    /// O dispositivo recusou as features (ou não é VirtIO 1.x).
+    FeaturesRejected,
+    /// A fila não existe ou tem tamanho zero.
+    QueueUnavailable,
+    /// Não há descritores livres na fila.
+    QueueFull,
+    /// Sem memória de DMA.
+    OutOfMemory,
+    /// O dispositivo respondeu com erro.
+    DeviceError,
+    /// O dispositivo não respondeu a tempo.
+    Timeout,
+    /// O dispositivo não tem uma interrupção utilizável.
+    NoInterrupt,
+    /// Erro de acesso ao PCI.
+    Pci(PciError),
+}
+
+impl From<PciError> for VirtioError {
+    fn from(e: PciError) -> Self {
+        VirtioError::Pci(e)
+    }
+}
+
+/// 🔌 Transporte VirtIO-PCI de um dispositivo.
+/// * Ao ser descartado, reinicia o dispositivo: ele deixa de acessar as filas e
+///   buffers de DMA. Por isso os drivers o declaram como o PRIMEIRO campo (os
+///   campos são descartados na ordem de declaração).
+pub struct VirtioPci {
+    device: PciDevice,
+    common: *mut u8,
+    notify: *mut u8,
+    notify_multiplier: u32,
+    isr: *mut u8,
+    device_cfg: *mut u8,
+    /// Features aceitas na última negociação (definem o formato das filas).
+    features: Cell<u64>,
+    /// Tabela MSI-X, depois do primeiro `route_queue_msix`.
+    msix: Option<MsixTable>,
+}
+
+// # SAFETY: Os ponteiros são MMIO do próprio dispositivo; o acesso é serializado
+// pelo dono do transporte (o driver).
+unsafe impl Send for VirtioPci {}
+
+impl Drop for VirtioPci {
+    fn drop(&mut self) {
+        // Sem o reset, o dispositivo ainda pode escrever em memória já liberada.
+        if self.reset().is_err() {
+            self.device.disable_bus_master();
+        }
+    }
+}
+
+impl VirtioPci {
+    /// 🔍 Encontra o primeiro dispositivo VirtIO do `device_type` e mapeia suas estruturas.
+    pub fn find(device_type: u16) -> Result<Self, VirtioError> {
+        let device = Self::find_all(device_type).into_iter().next().ok_or(VirtioError::NotFound)?;
+        Self::new(device)
+    }
+
+    /// 🔍 Todos os dispositivos VirtIO do `device_type` no barramento.
+    pub fn find_all(device_type: u16) -> Vec<PciDevice> {
+        let wanted = pci_match(device_type);
+        pci::enumerate().into_iter().filter(|d| wanted.matches(d)).collect()
+    }
+
+    /// 🏭 Mapeia as estruturas de configuração de `device`.
+    pub fn new(device: PciDevice) -> Result<Self, VirtioError> {
+        device.enable();
+        let addr = device.address;
+
+        // Várias estruturas costumam dividir um BAR: `map_bar` devolve o mesmo mapeamento.
+        let locate = |cap: u16| -> Result<*mut u8, VirtioError> {
+            let bar = addr.read_u8(cap + 4);
+            let offset = addr.read_u32(cap + 8) as usize;
+            if bar > 5 {
+                return Err(VirtioError::MissingCapability);
+            }
+            let (base, _) = device.map_bar(bar, CacheMode::Uncached)?;
+            // # SAFETY: `offset` está dentro do BAR (informado pelo próprio dispositivo).
+            Ok(unsafe { base.add(offset) })
+        };
+
+        let (mut common, mut notify, mut isr, mut device_cfg) = (None, None, None, None);
+        let mut notify_multiplier = 0;
+        for (id, cap) in device.capabilities() {
+            if id != PCI_CAP_VENDOR {
+                continue;
+            }
+            match addr.read_u8(cap + 3) {
+                CFG_COMMON if common.is_none() => common = Some(locate(cap)?),
+                CFG_NOTIFY if notify.is_none() => {
+                    notify = Some(locate(cap)?);
+                    notify_multiplier = addr.read_u32(cap + 16);
+                }
+                CFG_ISR if isr.is_none() => isr = Some(locate(cap)?),
+                CFG_DEVICE if device_cfg.is_none() => device_cfg = Some(locate(cap)?),
+                _ => {}
+            }
+        }
+
+        Ok(VirtioPci {
+            device,
+            common: common.ok_or(VirtioError::MissingCapability)?,
+            notify: notify.ok_or(VirtioError::MissingCapability)?,
+            notify_multiplier,
+            isr: isr.ok_or(VirtioError::MissingCapability)?,
+            // Alguns dispositivos (ex: sem configuração própria) não têm device config.
+            device_cfg: device_cfg.unwrap_or(ptr::null_mut()),
+            features: Cell::new(0),
+            msix: None,
+        })
+    }
+
+    /// Dispositivo PCI subjacente.
+    pub fn pci_device(&self) -> &PciDevice {
+        &self.device
+    }
+
+    // --- Acesso à Common Config ---
+
+    fn read_common<T: Copy>(&self, offset: usize) -> T {
+        // # SAFETY: `offset` é um campo da common config, alinhado ao seu tipo.
+        unsafe { ptr::read_volatile(self.common.add(offset) as *const T) }
+    }
+
+    fn write_common<T: Copy>(&self, offset: usize, value: T) {
+        // # SAFETY: Ver `read_common`.
+        unsafe { ptr::write_volatile(self.common.add(offset) as *mut T, value) }
+    }
+
+    fn set_status(&self, bits: u8) {
+        let status: u8 = self.read_common(COMMON_DEVICE_STATUS);
+        self.write_common(COMMON_DEVICE_STATUS, status | bits);
+    }
+
+    /// 🔄 Reinicia o dispositivo (todas as filas e features são descartadas).
+    pub fn reset(&self) -> Result<(), VirtioError> {
+        self.write_common(COMMON_DEVICE_STATUS, 0u8);
+        for _ in 0..RESET_SPIN_LIMIT {
+            if self.read_common::<u8>(COMMON_DEVICE_STATUS) == 0 {
+                return Ok(());
+            }
+            core::hint::spin_loop();
+        }
+        Err(VirtioError::Timeout)
+    }
+
+    /// 🤝 Reinicia o dispositivo e negocia as features: aceita as que ele oferece
+    /// dentre `wanted` (mais `VIRTIO_F_VERSION_1`). Retorna as aceitas.
+    pub fn negotiate(&self, wanted: u64) -> Result<u64, VirtioError> {
+        self.reset()?;
+        self.set_status(STATUS_ACKNOWLEDGE);
+        self.set_status(STATUS_DRIVER);
+
+        let mut offered = 0u64;
+        for select in 0..2u32 {
+            self.write_common(COMMON_DEVICE_FEATURE_SELECT, select);
+            offered |= (self.read_common::<u32>(COMMON_DEVICE_FEATURE) as u64) << (32 * select);
+        }
+        if offered & VIRTIO_F_VERSION_1 == 0 {
+            self.set_status(STATUS_FAILED);
+            return Err(VirtioError::FeaturesRejected);
+        }
+
+        let accepted = offered & (wanted | VIRTIO_F_VERSION_1);
+        for select in 0..2u32 {
+            self.write_common(COMMON_DRIVER_FEATURE_SELECT, select);
+            self.write_common(COMMON_DRIVER_FEATURE, (accepted >> (32 * select)) as u32);
+        }
+        self.set_status(STATUS_FEATURES_OK);
+        if self.read_common::<u8>(COMMON_DEVICE_STATUS) & STATUS_FEATURES_OK == 0 {
+            self.set_status(STATUS_FAILED);
+            return Err(VirtioError::FeaturesRejected);
+        }
+        self.features.set(accepted);
+        Ok(accepted)
+    }
+
+    /// Features aceitas na última negociação.
+    pub fn features(&self) -> u64 {
+        self.features.get()
+    }
+
+    /// Número de filas do dispositivo.
+    pub fn num_queues(&self) -> u16 {
+        self.read_common(COMMON_NUM_QUEUES)
+    }
+
+    /// ➕ Cria e habilita a fila `index` com até `max_size` entradas.
+    pub fn setup_queue(&self, index: u16, max_size: u16) -> Result<Virtqueue, VirtioError> {
+        self.write_common(COMMON_QUEUE_SELECT, index);
+        let device_max: u16 = self.read_common(COMMON_QUEUE_SIZE);
+        if device_max == 0 {
+            return Err(VirtioError::QueueUnavailable);
+        }
+        // Tamanho potência de 2 (exigido pelo anel split; o packed também o usa).
+        let limit = device_max.min(max_size.max(1));
+        let size = 1u16 << (15 - limit.leading_zeros() as u16);
+        self.write_common(COMMON_QUEUE_SIZE, size);
+
+        let notify_off: u16 = self.read_common(COMMON_QUEUE_NOTIFY_OFF);
+        // # SAFETY: O offset de notificação está dentro da estrutura notify do BAR.
+        let notify = unsafe { self.notify.add(notify_off as usize * self.notify_multiplier as usize) } as *mut u16;
+        let queue = Virtqueue::new(index, size, notify, self.features.get())?;
+
+        self.write_common(COMMON_QUEUE_DESC, queue.desc_addr().as_u64());
+        self.write_common(COMMON_QUEUE_DRIVER, queue.avail_addr().as_u64());
+        self.write_common(COMMON_QUEUE_DEVICE, queue.used_addr().as_u64());
+        self.write_common(COMMON_QUEUE_ENABLE, 1u16);
+        Ok(queue)
+    }
+
+    /// 📨 Entrega as interrupções da fila `queue` por MSI-X, num vetor dinâmico da
+    /// CPU atual (a entrada da tabela é o índice da fila). Retorna o vetor.
+    /// * Chamado depois de `setup_queue` e antes de `driver_ok`.
+    /// * Mudanças de configuração deixam de interromper.
+    /// * Em falha, o vetor é devolvido e, se esta chamada ligou a MSI-X, ela é
+    ///   desligada e a INTx religada (o driver pode cair para a INTx).
+    pub fn route_queue_msix(&mut self, queue: u16) -> Result<u8, VirtioError> {
+        let enabled_here = self.msix.is_none();
+        if enabled_here {
+            self.msix = Some(self.device.enable_msix()?);
+        }
+        let table = self.msix.as_ref().ok_or(VirtioError::NoInterrupt)?;
+        let routed = table.route_entry(queue, apic::LocalApic::id());
+
+        let result = match routed {
+            Ok(vector) => {
+                self.write_common(COMMON_MSIX_CONFIG, NO_MSIX_VECTOR);
+                self.write_common(COMMON_QUEUE_SELECT, queue);
+                self.write_common(COMMON_QUEUE_MSIX_VECTOR, queue);
+                // O dispositivo devolve NO_VECTOR se não conseguiu associar a entrada.
+                if self.read_common::<u16>(COMMON_QUEUE_MSIX_VECTOR) == queue {
+                    return Ok(vector);
+                }
+                table.mask(queue);
+                dispatch::free_vector(vector);
+                Err(VirtioError::NoInterrupt)
+            }
+            Err(e) => Err(e.into()),
+        };
+        if enabled_here {
+            self.device.disable_msix();
+            self.msix = None;
+        }
+        result
+    }
+
+    /// ✅ Conclui a inicialização: o dispositivo passa a processar as filas.
+    pub fn driver_ok(&self) {
+        self.set_status(STATUS_DRIVER_OK);
+    }
+
+    /// 📥 Lê (e limpa) o status de interrupção: bit 0 = fila, bit 1 = configuração.
+    pub fn read_isr(&self) -> u8 {
+        // # SAFETY: Registrador ISR do dispositivo (a leitura o zera).
+        unsafe { ptr::read_volatile(self.isr) }
+    }
+
+    /// 📥 Lê um campo da configuração específica do dispositivo.
+    pub fn read_config<T: Copy>(&self, offset: usize) -> Option<T> {
+        if self.device_cfg.is_null() {
+            return None;
+        }
+        // # SAFETY: `offset` é um campo da device config, alinhado ao seu tipo.
+        Some(unsafe { ptr::read_volatile(self.device_cfg.add(offset) as *const T) })
+    }
+
+    /// 📤 Escreve um campo da configuração específica do dispositivo.
+    pub fn write_config<T: Copy>(&self, offset: usize, value: T) {
+        if !self.device_cfg.is_null() {
+            // # SAFETY: Ver `read_config`.
+            unsafe { ptr::write_volatile(self.device_cfg.add(offset) as *mut T, value) }
+        }
+    }
+}
@@ -0,0 +1,638 @@
+// src/kernel/drivers/virtio/queue.rs
+
+//! Virtqueues (VirtIO 1.x), compartilhadas por todos os drivers VirtIO.
+//!
+//! Dois formatos de anel, escolhidos pelas features negociadas:
+//! * **Split** (seção 2.7): tabela de descritores, anel "available" (cabeças que
+//!   o driver entrega) e anel "used" (cabeças devolvidas, com o total escrito).
+//! * **Packed** (seção 2.8, `VIRTIO_F_RING_PACKED`): um único anel de
+//!   descritores que o dispositivo devolve no lugar, marcados pelos bits
+//!   AVAIL/USED e um contador de volta; menos linhas de cache por requisição.
+//!
+//! Extensões opcionais, usadas quando negociadas:
+//! * Descritores indiretos (`VIRTIO_F_INDIRECT_DESC`): uma requisição de vários
+//!   segmentos ocupa um único descritor do anel, apontando para uma tabela própria.
+//! * Supressão de notificações por índice de evento (`VIRTIO_F_EVENT_IDX`): o
+//!   driver só escreve no registrador de notificação (uma saída da VM) quando o
+//!   dispositivo pediu, e o dispositivo só interrompe no índice que o driver pediu.
+//!
+//! `add` nunca notifica: um lote de requisições é seguido de um único `kick`.
+
+use alloc::vec::Vec;
+use core::mem::size_of;
+use core::ptr;
+use core::sync::atomic::{fence, Ordering};
+use x86_64::PhysAddr;
+
+use super::{VirtioError, VIRTIO_F_EVENT_IDX, VIRTIO_F_INDIRECT_DESC, VIRTIO_F_RING_PACKED};
+use crate::memory::dma::DmaBuffer;
+
+const DESC_F_NEXT: u16 = 1;
+const DESC_F_WRITE: u16 = 2;
+const DESC_F_INDIRECT: u16 = 4;
+/// Bits de disponibilidade do anel packed.
+const DESC_F_AVAIL: u16 = 1 << 7;
+const DESC_F_USED: u16 = 1 << 15;
+
+/// Anel split: o driver não quer interrupções / o dispositivo não quer notificações.
+const AVAIL_F_NO_INTERRUPT: u16 = 1;
+const USED_F_NO_NOTIFY: u16 = 1;
+
+/// Supressão de eventos do anel packed.
+const EVENT_FLAGS_ENABLE: u16 = 0;
+const EVENT_FLAGS_DISABLE: u16 = 1;
+const EVENT_FLAGS_DESC: u16 = 2;
+/// Bit do contador de volta em `off_wrap`.
+const EVENT_WRAP_SHIFT: u16 = 15;
+
+/// Segmentos máximos de uma requisição indireta (uma tabela por cabeça).
+pub const MAX_INDIRECT: usize = 16;
+
+/// Fim da lista de descritores (ou IDs) livres.
+const NO_DESC: u16 = u16::MAX;
+
+/// 📑 Descritor do anel split (e das suas tabelas indiretas).
+#[repr(C)]
+#[derive(Debug, Clone, Copy)]
+struct Descriptor {
+    addr: u64,
+    len: u32,
+    flags: u16,
+    next: u16,
+}
+
+/// 📑 Descritor do anel packed (e das suas tabelas indiretas).
+#[repr(C)]
+#[derive(Debug, Clone, Copy)]
+struct PackedDescriptor {
+    addr: u64,
+    len: u32,
+    id: u16,
+    flags: u16,
+}
+
+/// 🔕 Estrutura de supressão de eventos do anel packed.
+#[repr(C)]
+#[derive(Debug, Clone, Copy)]
+struct EventSuppress {
+    off_wrap: u16,
+    flags: u16,
+}
+
+/// ✂️ Um segmento de uma requisição.
+#[derive(Debug, Clone, Copy)]
+pub struct Segment {
+    pub addr: PhysAddr,
+    pub len: u32,
+    /// `true` se o dispositivo escreve no segmento (resposta), `false` se lê.
+    pub device_writable: bool,
+}
+
+impl Segment {
+    /// Segmento que o dispositivo lê.
+    pub fn read(addr: PhysAddr, len: u32) -> Self {
+        Segment { addr, len, device_writable: false }
+    }
+
+    /// Segmento que o dispositivo escreve.
+    pub fn write(addr: PhysAddr, len: u32) -> Self {
+        Segment { addr, len, device_writable: true }
+    }
+
+    fn access_flags(&self) -> u16 {
+        if self.device_writable { DESC_F_WRITE } else { 0 }
+    }
+}
+
+/// `true` se o dispositivo pediu um evento em `event` e o índice passou por ele
+/// de `old` para `new` (vring_need_event da especificação).
+fn need_event(event: u16, new: u16, old: u16) -> bool {
+    new.wrapping_sub(event).wrapping_sub(1) < new.wrapping_sub(old)
+}
+
+/// 🔁 Estado do anel split.
+struct SplitRing {
+    desc: *mut Descriptor,
+    /// flags, idx, ring[size], used_event.
+    avail: *mut u16,
+    /// flags, idx, ring[size] de (id: u32, len: u32), avail_event.
+    used: *mut u16,
+    avail_offset: usize,
+    used_offset: usize,
+    free_head: u16,
+    /// Cópia local de `avail.idx` (só o driver escreve).
+    avail_idx: u16,
+    /// Próxima entrada do anel used a consumir.
+    last_used: u16,
+}
+
+/// 🔁 Estado do anel packed.
+struct PackedRing {
+    desc: *mut PackedDescriptor,
+    /// Escrita pelo driver: quando o dispositivo deve interromper.
+    driver_event: *mut EventSuppress,
+    /// Escrita pelo dispositivo: quando o driver deve notificar.
+    device_event: *mut EventSuppress,
+    next_avail: u16,
+    avail_wrap: bool,
+    next_used: u16,
+    used_wrap: bool,
+    /// Lista livre de IDs de requisição (`next_id[id]` encadeia os livres).
+    free_id: u16,
+    next_id: Vec<u16>,
+    /// Descritores do anel ocupados por cada ID em voo.
+    chain_len: Vec<u16>,
+}
+
+enum Ring {
+    Split(SplitRing),
+    Packed(PackedRing),
+}
+
+/// 🔁 Uma virtqueue (split ou packed).
+pub struct Virtqueue {
+    index: u16,
+    size: u16,
+    memory: DmaBuffer,
+    notify: *mut u16,
+    /// Tabelas indiretas (`MAX_INDIRECT` descritores por cabeça/ID), se negociadas.
+    indirect: Option<DmaBuffer>,
+    event_idx: bool,
+    num_free: u16,
+    /// Requisições e descritores adicionados desde a última notificação.
+    pending: u16,
+    pending_descs: u16,
+    /// O driver quer interrupções de "used" (ver `disable_interrupts`).
+    interrupts_enabled: bool,
+    ring: Ring,
+}
+
+// # SAFETY: A fila é dona exclusiva da sua memória; o registrador de notificação
+// é escrito só pelo dono.
+unsafe impl Send for Virtqueue {}
+
+impl Virtqueue {
+    /// 🏭 Aloca uma fila de `size` entradas (potência de 2) que notifica em `notify`,
+    /// no formato e com as extensões de `features` (as features negociadas).
+    pub fn new(index: u16, size: u16, notify: *mut u16, features: u64) -> Result<Self, VirtioError> {
+        let n = size as usize;
+        let packed = features & VIRTIO_F_RING_PACKED != 0;
+        let (avail_offset, used_offset, total) = if packed {
+            (16 * n, 16 * n + size_of::<EventSuppress>(), 16 * n + 2 * size_of::<EventSuppress>())
+        } else {
+            let used_offset = (16 * n + 6 + 2 * n + 3) & !3;
+            (16 * n, used_offset, used_offset + 6 + 8 * n)
+        };
+        let memory = DmaBuffer::new(total).map_err(|_| VirtioError::OutOfMemory)?;
+        let base = memory.as_mut_ptr();
+        let indirect = match features & VIRTIO_F_INDIRECT_DESC {
+            0 => None,
+            _ => Some(DmaBuffer::new(n * MAX_INDIRECT * 16).map_err(|_| VirtioError::OutOfMemory)?),
+        };
+
+        let ring = if packed {
+            let mut next_id = Vec::new();
+            let mut chain_len = Vec::new();
+            next_id.try_reserve_exact(n).map_err(|_| VirtioError::OutOfMemory)?;
+            chain_len.try_reserve_exact(n).map_err(|_| VirtioError::OutOfMemory)?;
+            next_id.extend((1..=size).map(|id| if id < size { id } else { NO_DESC }));
+            chain_len.resize(n, 0);
+            Ring::Packed(PackedRing {
+                desc: base as *mut PackedDescriptor,
+                // # SAFETY: Os offsets estão dentro de `total` bytes.
+                driver_event: unsafe { base.add(avail_offset) } as *mut EventSuppress,
+                device_event: unsafe { base.add(used_offset) } as *mut EventSuppress,
+                next_avail: 0,
+                avail_wrap: true,
+                next_used: 0,
+                used_wrap: true,
+                free_id: 0,
+                next_id,
+                chain_len,
+            })
+        } else {
+            let desc = base as *mut Descriptor;
+            // Encadeia todos os descritores na lista livre.
+            for i in 0..size {
+                let next = if i + 1 < size { i + 1 } else { NO_DESC };
+                // # SAFETY: `i < size`: dentro da tabela.
+                unsafe { ptr::write_volatile(desc.add(i as usize), Descriptor { addr: 0, len: 0, flags: 0, next }) };
+            }
+            Ring::Split(SplitRing {
+                desc,
+                // # SAFETY: Os offsets estão dentro de `total` bytes.
+                avail: unsafe { base.add(avail_offset) } as *mut u16,
+                used: unsafe { base.add(used_offset) } as *mut u16,
+                avail_offset,
+                used_offset,
+                free_head: 0,
+                avail_idx: 0,
+                last_used: 0,
+            })
+        };
+
+        Ok(Virtqueue {
+            index,
+            size,
+            memory,
+            notify,
+            indirect,
+            event_idx: features & VIRTIO_F_EVENT_IDX != 0,
+            num_free: size,
+            pending: 0,
+            pending_descs: 0,
+            interrupts_enabled: true,
+            ring,
+        })
+    }
+
+    /// Índice da fila no dispositivo.
+    pub fn index(&self) -> u16 {
+        self.index
+    }
+
+    /// Número de entradas.
+    pub fn size(&self) -> u16 {
+        self.size
+    }
+
+    /// Descritores livres.
+    pub fn num_free(&self) -> u16 {
+        self.num_free
+    }
+
+    /// `true` se o anel é packed.
+    pub fn is_packed(&self) -> bool {
+        matches!(self.ring, Ring::Packed(_))
+    }
+
+    /// Área de descritores.
+    pub fn desc_addr(&self) -> PhysAddr {
+        self.memory.phys_addr()
+    }
+
+    /// Área do driver (anel available ou supressão de eventos do driver).
+    pub fn avail_addr(&self) -> PhysAddr {
+        let offset = match &self.ring {
+            Ring::Split(split) => split.avail_offset,
+            Ring::Packed(_) => self.size as usize * 16,
+        };
+        self.memory.phys_addr() + offset as u64
+    }
+
+    /// Área do dispositivo (anel used ou supressão de eventos do dispositivo).
+    pub fn used_addr(&self) -> PhysAddr {
+        let offset = match &self.ring {
+            Ring::Split(split) => split.used_offset,
+            Ring::Packed(_) => self.size as usize * 16 + size_of::<EventSuppress>(),
+        };
+        self.memory.phys_addr() + offset as u64
+    }
+
+    /// Tabela indireta da cabeça/ID `slot`: (endereço virtual, físico).
+    fn indirect_table(&self, slot: u16) -> Option<(*mut u8, PhysAddr)> {
+        let table = self.indirect.as_ref()?;
+        let offset = slot as usize * MAX_INDIRECT * 16;
+        // # SAFETY: `slot < size`: dentro do buffer de tabelas.
+        Some((unsafe { table.as_mut_ptr().add(offset) }, table.phys_addr() + offset as u64))
+    }
+
+    /// Requisições de vários segmentos usam uma tabela indireta quando possível.
+    fn wants_indirect(&self, segments: usize) -> bool {
+        self.indirect.is_some() && (2..=MAX_INDIRECT).contains(&segments)
+    }
+
+    /// ➕ Coloca uma requisição (cadeia de segmentos) na fila, sem avisar o
+    /// dispositivo. Retorna o identificador devolvido por `pop_used`.
+    pub fn add(&mut self, segments: &[Segment]) -> Result<u16, VirtioError> {
+        let indirect = self.wants_indirect(segments.len());
+        let needed = if indirect { 1 } else { segments.len() };
+        if segments.is_empty() || needed > self.num_free as usize {
+            return Err(VirtioError::QueueFull);
+        }
+        let token = match self.ring {
+            Ring::Split(_) => self.add_split(segments, indirect),
+            Ring::Packed(_) => self.add_packed(segments, indirect)?,
+        };
+        self.num_free -= needed as u16;
+        self.pending = self.pending.wrapping_add(1);
+        self.pending_descs = self.pending_descs.wrapping_add(needed as u16);
+        Ok(token)
+    }
+
+    fn add_split(&mut self, segments: &[Segment], indirect: bool) -> u16 {
+        let head = match &self.ring {
+            Ring::Split(split) => split.free_head,
+            Ring::Packed(_) => unreachable!(),
+        };
+        let table = if indirect { self.indirect_table(head) } else { None };
+        let size = self.size;
+        let split = match &mut self.ring {
+            Ring::Split(split) => split,
+            Ring::Packed(_) => unreachable!(),
+        };
+
+        // # SAFETY: Todos os índices de descritor são < size; a tabela indireta
+        // tem `MAX_INDIRECT >= segments.len()` entradas.
+        unsafe {
+            if let Some((table, phys)) = table {
+                let entries = table as *mut Descriptor;
+                for (i, segment) in segments.iter().enumerate() {
+                    let last = i + 1 == segments.len();
+                    let flags = segment.access_flags() | if last { 0 } else { DESC_F_NEXT };
+                    ptr::write_volatile(entries.add(i), Descriptor {
+                        addr: segment.addr.as_u64(),
+                        len: segment.len,
+                        flags,
+                        next: (i + 1) as u16,
+                    });
+                }
+                let next = ptr::read_volatile(split.desc.add(head as usize)).next;
+                ptr::write_volatile(split.desc.add(head as usize), Descriptor {
+                    addr: phys.as_u64(),
+                    len: (segments.len() * size_of::<Descriptor>()) as u32,
+                    flags: DESC_F_INDIRECT,
+                    next,
+                });
+                split.free_head = next;
+            } else {
+                let mut current = head;
+                for (i, segment) in segments.iter().enumerate() {
+                    let next = ptr::read_volatile(split.desc.add(current as usize)).next;
+                    let last = i + 1 == segments.len();
+                    let flags = segment.access_flags() | if last { 0 } else { DESC_F_NEXT };
+                    ptr::write_volatile(split.desc.add(current as usize), Descriptor {
+                        addr: segment.addr.as_u64(),
+                        len: segment.len,
+                        flags,
+                        next,
+                    });
+                    if last {
+                        split.free_head = next;
+                    } else {
+                        current = next;
+                    }
+                }
+            }
+
+            // ring[avail_idx % size] está dentro do anel available.
+            let slot = 2 + (split.avail_idx % size) as usize;
+            ptr::write_volatile(split.avail.add(slot), head);
+            // Os descritores e a entrada do anel precisam estar visíveis antes do idx.
+            fence(Ordering::Release);
+            split.avail_idx = split.avail_idx.wrapping_add(1);
+            ptr::write_volatile(split.avail.add(1), split.avail_idx);
+        }
+        head
+    }
+
+    fn add_packed(&mut self, segments: &[Segment], indirect: bool) -> Result<u16, VirtioError> {
+        let id = match &self.ring {
+            Ring::Packed(packed) if packed.free_id != NO_DESC => packed.free_id,
+            _ => return Err(VirtioError::QueueFull),
+        };
+        let table = if indirect { self.indirect_table(id) } else { None };
+        let size = self.size;
+        let packed = match &mut self.ring {
+            Ring::Packed(packed) => packed,
+            Ring::Split(_) => unreachable!(),
+        };
+        packed.free_id = packed.next_id[id as usize];
+
+        let head = packed.next_avail;
+        let mut head_flags = 0;
+        let mut count = 0u16;
+        // Os flags da cabeça são escritos por último: até lá a cadeia inteira é invisível.
+        let mut push = |packed: &mut PackedRing, addr: u64, len: u32, flags: u16| {
+            let avail_bits = if packed.avail_wrap { DESC_F_AVAIL } else { DESC_F_USED };
+            let flags = flags | avail_bits;
+            let index = packed.next_avail as usize;
+            // # SAFETY: `next_avail < size`: dentro do anel.
+            unsafe {
+                let desc = packed.desc.add(index);
+                let hidden = if count == 0 { head_flags = flags; (*desc).flags } else { flags };
+                ptr::write_volatile(desc, PackedDescriptor { addr, len, id, flags: hidden });
+            }
+            count += 1;
+            packed.next_avail += 1;
+            if packed.next_avail == size {
+                packed.next_avail = 0;
+                packed.avail_wrap = !packed.avail_wrap;
+            }
+        };
+
+        if let Some((table, phys)) = table {
+            let entries = table as *mut PackedDescriptor;
+            for (i, segment) in segments.iter().enumerate() {
+                // # SAFETY: `i < MAX_INDIRECT`: dentro da tabela.
+                unsafe {
+                    ptr::write_volatile(entries.add(i), PackedDescriptor {
+                        addr: segment.addr.as_u64(),
+                        len: segment.len,
+                        id: 0,
+                        flags: segment.access_flags(),
+                    });
+                }
+            }
+            let len = (segments.len() * size_of::<PackedDescriptor>()) as u32;
+            push(packed, phys.as_u64(), len, DESC_F_INDIRECT);
+        } else {
+            for (i, segment) in segments.iter().enumerate() {
+                let next = if i + 1 < segments.len() { DESC_F_NEXT } else { 0 };
+                push(packed, segment.addr.as_u64(), segment.len, segment.access_flags() | next);
+            }
+        }
+        packed.chain_len[id as usize] = count;
+
+        fence(Ordering::Release);
+        // # SAFETY: `head < size`: dentro do anel.
+        unsafe { ptr::write_volatile(ptr::addr_of_mut!((*packed.desc.add(head as usize)).flags), head_flags) };
+        Ok(id)
+    }
+
+    /// 🔔 Avisa o dispositivo das requisições adicionadas desde o último aviso,
+    /// se ele quiser (supressão de notificações). Retorna `true` se notificou.
+    pub fn kick(&mut self) -> bool {
+        let (added, added_descs) = (self.pending, self.pending_descs);
+        self.pending = 0;
+        self.pending_descs = 0;
+        if added == 0 {
+            return false;
+        }
+        // Os índices publicados precisam ser visíveis antes de ler a supressão do dispositivo.
+        fence(Ordering::SeqCst);
+
+        let needed = match &self.ring {
+            Ring::Split(split) => {
+                // # SAFETY: flags e avail_event estão dentro do anel used.
+                unsafe {
+                    if self.event_idx {
+                        let avail_event = ptr::read_volatile(split.used.add(2 + 4 * self.size as usize));
+                        need_event(avail_event, split.avail_idx, split.avail_idx.wrapping_sub(added))
+                    } else {
+                        ptr::read_volatile(split.used) & USED_F_NO_NOTIFY == 0
+                    }
+                }
+            }
+            Ring::Packed(packed) => {
+                // # SAFETY: Estrutura de supressão do dispositivo, dentro do bloco da fila.
+                let event = unsafe { ptr::read_volatile(packed.device_event) };
+                match event.flags {
+                    EVENT_FLAGS_DESC if self.event_idx => {
+                        let wrap = event.off_wrap >> EVENT_WRAP_SHIFT != 0;
+                        let mut event_idx = event.off_wrap & !(1 << EVENT_WRAP_SHIFT);
+                        if wrap != packed.avail_wrap {
+                            event_idx = event_idx.wrapping_sub(self.size);
+                        }
+                        let new = packed.next_avail;
+                        need_event(event_idx, new, new.wrapping_sub(added_descs))
+                    }
+                    EVENT_FLAGS_DISABLE => false,
+                    _ => true,
+                }
+            }
+        };
+        if needed {
+            // # SAFETY: Registrador de notificação da fila.
+            unsafe { ptr::write_volatile(self.notify, self.index) };
+        }
+        needed
+    }
+
+    /// `true` se o dispositivo devolveu requisições ainda não consumidas.
+    pub fn has_used(&self) -> bool {
+        match &self.ring {
+            Ring::Split(split) => {
+                // # SAFETY: `used.idx` está dentro do anel used.
+                let used_idx = unsafe { ptr::read_volatile(split.used.add(1)) };
+                used_idx != split.last_used
+            }
+            Ring::Packed(packed) => {
+                // # SAFETY: `next_used < size`: dentro do anel.
+                let flags = unsafe { ptr::read_volatile(ptr::addr_of!((*packed.desc.add(packed.next_used as usize)).flags)) };
+                let avail = flags & DESC_F_AVAIL != 0;
+                let used = flags & DESC_F_USED != 0;
+                avail == used && used == packed.used_wrap
+            }
+        }
+    }
+
+    /// 📥 Consome uma requisição devolvida: (identificador, bytes escritos pelo
+    /// dispositivo). Os descritores voltam para a lista livre.
+    pub fn pop_used(&mut self) -> Option<(u16, u32)> {
+        if !self.has_used() {
+            return None;
+        }
+        // As entradas só podem ser lidas depois do idx (ou dos flags).
+        fence(Ordering::Acquire);
+        let size = self.size;
+        let rearm = self.event_idx && self.interrupts_enabled;
+
+        let (id, len, freed) = match &mut self.ring {
+            Ring::Split(split) => {
+                // # SAFETY: ring[last_used % size] está dentro do anel used (elementos
+                // de 8 bytes começando no byte 4); a cadeia tem índices < size.
+                unsafe {
+                    let elem = (split.used as *mut u8).add(4 + 8 * (split.last_used % size) as usize) as *const u32;
+                    let (id, len) = (ptr::read_volatile(elem) as u16, ptr::read_volatile(elem.add(1)));
+                    split.last_used = split.last_used.wrapping_add(1);
+
+                    // Devolve a cadeia para a lista livre (uma cabeça indireta é um só descritor).
+                    let mut freed = 0;
+                    let mut current = id;
+                    loop {
+                        let desc = ptr::read_volatile(split.desc.add(current as usize));
+                        freed += 1;
+                        if desc.flags & DESC_F_NEXT == 0 {
+                            ptr::write_volatile(split.desc.add(current as usize), Descriptor { next: split.free_head, ..desc });
+                            break;
+                        }
+                        current = desc.next;
+                    }
+                    split.free_head = id;
+                    if rearm {
+                        // Pede uma interrupção na próxima entrada devolvida.
+                        ptr::write_volatile(split.avail.add(2 + size as usize), split.last_used);
+                    }
+                    (id, len, freed)
+                }
+            }
+            Ring::Packed(packed) => {
+                // # SAFETY: `next_used < size`: dentro do anel.
+                let desc = unsafe { ptr::read_volatile(packed.desc.add(packed.next_used as usize)) };
+                let id = desc.id;
+                let freed = core::mem::replace(&mut packed.chain_len[id as usize], 0);
+                packed.next_used += freed;
+                if packed.next_used >= size {
+                    packed.next_used -= size;
+                    packed.used_wrap = !packed.used_wrap;
+                }
+                packed.next_id[id as usize] = packed.free_id;
+                packed.free_id = id;
+                if rearm {
+                    packed.write_driver_event(EVENT_FLAGS_DESC);
+                }
+                (id, desc.len, freed)
+            }
+        };
+        self.num_free += freed;
+        if rearm {
+            fence(Ordering::SeqCst);
+        }
+        Some((id, len))
+    }
+
+    /// 🔕 Pede ao dispositivo que não interrompa ao devolver requisições (ex:
+    /// drivers que esperam ativamente ou um bottom half drenando um lote).
+    pub fn disable_interrupts(&mut self) {
+        self.interrupts_enabled = false;
+        match &mut self.ring {
+            Ring::Split(split) => {
+                // # SAFETY: flags e used_event estão dentro do anel available.
+                unsafe {
+                    if self.event_idx {
+                        // Um índice já passado: a próxima interrupção só viria após uma volta inteira.
+                        ptr::write_volatile(split.avail.add(2 + self.size as usize), split.last_used.wrapping_sub(1));
+                    } else {
+                        ptr::write_volatile(split.avail, AVAIL_F_NO_INTERRUPT);
+                    }
+                }
+            }
+            Ring::Packed(packed) => packed.write_driver_event(EVENT_FLAGS_DISABLE),
+        }
+    }
+
+    /// 🔔 Volta a pedir interrupções a partir da próxima requisição devolvida.
+    /// Retorna `true` se já há requisições devolvidas: o chamador deve drená-las,
+    /// pois a interrupção delas pode ter sido suprimida.
+    pub fn enable_interrupts(&mut self) -> bool {
+        self.interrupts_enabled = true;
+        match &mut self.ring {
+            Ring::Split(split) => {
+                // # SAFETY: flags e used_event estão dentro do anel available.
+                unsafe {
+                    if self.event_idx {
+                        ptr::write_volatile(split.avail.add(2 + self.size as usize), split.last_used);
+                    } else {
+                        ptr::write_volatile(split.avail, 0);
+                    }
+                }
+            }
+            Ring::Packed(packed) => {
+                let flags = if self.event_idx { EVENT_FLAGS_DESC } else { EVENT_FLAGS_ENABLE };
+                packed.write_driver_event(flags);
+            }
+        }
+        fence(Ordering::SeqCst);
+        self.has_used()
+    }
+}
+
+impl PackedRing {
+    /// Escreve a supressão do driver; com `DESC`, pede evento na próxima devolução.
+    fn write_driver_event(&mut self, flags: u16) {
+        let off_wrap = self.next_used | (self.used_wrap as u16) << EVENT_WRAP_SHIFT;
+        // # SAFETY: Estrutura de supressão do driver, dentro do bloco da fila.
+        unsafe { ptr::write_volatile(self.driver_event, EventSuppress { off_wrap, flags }) };
+    }
+}
@@ -66,7 +66,9 @@ uint32_t lightos_ipc_send(uint64_t dest_id, const Message* msg_ptr);
 uint32_t lightos_ipc_receive(uint64_t receiver_id, Message* out_msg_ptr);
 
 /**
- * @brief Inicializa e verifica o driver de Touchscreen.
+ * @brief Inicializa o driver de Touchscreen e o registra globalmente.
+ * Os eventos passam a ser entregues pela IRQ do dispositivo; o endereço deve
+ * permanecer mapeado.
  * * @param mmio_addr Endereço base de MMIO do dispositivo.
  * @return LightOSErrorCode (0 em caso de sucesso).
  */
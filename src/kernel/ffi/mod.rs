@@ -7,7 +7,7 @@
 use crate::{
     ipc::{self, Endpoint, Message, IpcError}, 
     drivers::{
-        touchscreen::{self, TouchscreenDriver, TouchscreenError},
+        touchscreen,
     },
     RustKernelConfig,
 };
@@ -61,22 +61,16 @@ pub extern "C" fn lightos_ipc_receive(receiver_id: u64, out_msg_ptr: *mut Messag
 
 /// 👆 Wrapper de FFI para inicializar o driver de Touchscreen.
 /// 
+/// O driver fica registrado globalmente e passa a entregar eventos pela sua IRQ
+/// (`RustKernelConfig::TOUCHSCREEN_IRQ_LINE`) para `touchscreen::TOUCH_QUEUE`.
+/// 
 /// Assinatura C: u32 lightos_driver_touch_init(uintptr_t mmio_addr);
 #[no_mangle]
 pub extern "C" fn lightos_driver_touch_init(mmio_addr: usize) -> u32 {
-    // Nota: Em um kernel real, o estado do driver seria armazenado em uma estrutura
-    // global gerenciada pelo Rust, e não apenas inicializado.
-    
-    // # SAFETY: Assumimos que 'mmio_addr' é um endereço de hardware válido e mapeado.
-    let mut driver = unsafe { 
-        match TouchscreenDriver::new(mmio_addr) {
-            Ok(d) => d,
-            Err(e) => return e as u32,
-        }
-    };
-    
-    match driver.init() {
-        Ok(_) => 0,
+    // # SAFETY: Assumimos que 'mmio_addr' é um endereço de hardware válido e mapeado
+    // permanentemente (o driver o guarda após o retorno).
+    match unsafe { touchscreen::register(mmio_addr, RustKernelConfig::TOUCHSCREEN_IRQ_LINE) } {
+        Ok(()) => 0,
         Err(e) => e as u32,
     }
 }
@@ -0,0 +1,446 @@
+// src/kernel/interrupts/apic.rs
+
+//! Controlador de Interrupções Avançado (x2APIC Local + IO-APIC) para o LightOS.
+//!
+//! Substitui o par 8259 legado (`pic.rs`) quando a CPU suporta x2APIC:
+//! * O APIC Local é acessado apenas via MSRs (sem MMIO e sem Port I/O).
+//! * O EOI é uma única escrita de MSR, sem nenhum lock.
+//! * O IO-APIC roteia as IRQs legadas (ISA) e as GSIs para qualquer CPU (afinidade).
+//! * Dispositivos PCI podem usar MSI, cuja mensagem é montada por `msi_message`.
+
+use core::arch::x86_64::{__cpuid, __cpuid_count};
+use core::ptr;
+use core::sync::atomic::{AtomicBool, AtomicU32, Ordering};
+use spin::{Mutex, Once};
+use x86_64::registers::model_specific::Msr;
+use x86_64::PhysAddr;
+
+use super::PIC_1_OFFSET;
+use crate::memory::paging::{self, CacheMode};
+use crate::RustKernelConfig::arch_hal::{IO_APIC_BASE, MAX_CPUS};
+
+// ------------------------------------------------------------------------
+// --- Constantes de MSR (x2APIC) ---
+// ------------------------------------------------------------------------
+
+/// MSR IA32_APIC_BASE: endereço base e bits de habilitação do APIC Local.
+const IA32_APIC_BASE: u32 = 0x1B;
+/// Bit 10: habilita o modo x2APIC (EXTD).
+const APIC_BASE_X2APIC_ENABLE: u64 = 1 << 10;
+/// Bit 11: habilita globalmente o APIC Local (EN).
+const APIC_BASE_GLOBAL_ENABLE: u64 = 1 << 11;
+
+/// MSR do ID do APIC Local.
+const X2APIC_ID: u32 = 0x802;
+/// MSR do Task Priority Register.
+const X2APIC_TPR: u32 = 0x808;
+/// MSR de End Of Interrupt (escrever 0 sinaliza o EOI).
+const X2APIC_EOI: u32 = 0x80B;
+/// MSR do Spurious Interrupt Vector Register.
+const X2APIC_SVR: u32 = 0x80F;
+/// MSR da LVT LINT0 (ExtINT do 8259 legado).
+const X2APIC_LVT_LINT0: u32 = 0x835;
+/// MSR da LVT LINT1 (normalmente NMI).
+const X2APIC_LVT_LINT1: u32 = 0x836;
+/// MSR da LVT de Erro.
+const X2APIC_LVT_ERROR: u32 = 0x837;
+
+/// Bit de software-enable no SVR.
+const SVR_APIC_ENABLE: u64 = 1 << 8;
+/// Bit de máscara das entradas LVT.
+const LVT_MASKED: u64 = 1 << 16;
+
+/// Vetor usado para interrupções espúrias do APIC (não exige EOI).
+pub const SPURIOUS_VECTOR: u8 = 0xFF;
+/// Vetor usado para erros internos do APIC Local.
+pub const APIC_ERROR_VECTOR: u8 = 0xFE;
+
+// ------------------------------------------------------------------------
+// --- Registradores do IO-APIC ---
+// ------------------------------------------------------------------------
+
+/// Offset do registrador de seleção (IOREGSEL).
+const IOAPIC_REGSEL: usize = 0x00;
+/// Offset da janela de dados (IOWIN).
+const IOAPIC_WINDOW: usize = 0x10;
+/// Tamanho da janela de MMIO do IO-APIC.
+const IOAPIC_MMIO_SIZE: usize = 0x20;
+/// Registrador de versão (contém o número máximo de entradas de redirecionamento).
+const IOAPIC_REG_VERSION: u32 = 0x01;
+/// Primeiro registrador da Tabela de Redirecionamento (2 registradores por entrada).
+const IOAPIC_REG_REDTBL: u32 = 0x10;
+
+/// Bit de máscara de uma entrada de redirecionamento.
+const REDIR_MASKED: u32 = 1 << 16;
+/// Polaridade ativa em nível baixo.
+const REDIR_ACTIVE_LOW: u32 = 1 << 13;
+/// Disparo por nível (em vez de borda).
+const REDIR_LEVEL_TRIGGERED: u32 = 1 << 14;
+
+/// 🚨 Erros do subsistema APIC.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum ApicError {
+    /// A CPU não possui APIC Local.
+    ApicNotPresent,
+    /// A CPU não suporta o modo x2APIC (o kernel permanece no 8259).
+    X2ApicUnsupported,
+    /// A GSI solicitada não existe neste IO-APIC.
+    InvalidGsi,
+    /// O ID de APIC de destino não cabe no campo de 8 bits do IO-APIC/MSI
+    /// (exigiria Interrupt Remapping).
+    DestinationOutOfRange,
+    /// O IO-APIC ainda não foi inicializado.
+    NotInitialized,
+    /// Não foi possível mapear o MMIO do IO-APIC.
+    MmioMapFailed,
+}
+
+/// 🚦 Indica se o x2APIC está ativo (e, portanto, se o EOI vai para o MSR).
+static X2APIC_ACTIVE: AtomicBool = AtomicBool::new(false);
+
+/// Retorna `true` quando as interrupções são entregues pelo x2APIC/IO-APIC.
+#[inline(always)]
+pub fn is_active() -> bool {
+    X2APIC_ACTIVE.load(Ordering::Relaxed)
+}
+
+// ------------------------------------------------------------------------
+// --- APIC Local (x2APIC) ---
+// ------------------------------------------------------------------------
+
+/// 🧠 APIC Local em modo x2APIC (todo acesso é via RDMSR/WRMSR).
+pub struct LocalApic;
+
+impl LocalApic {
+    /// 🔍 Verifica o suporte da CPU (CPUID.01h: EDX[9] = APIC, ECX[21] = x2APIC).
+    pub fn detect() -> Result<(), ApicError> {
+        // # SAFETY: CPUID está disponível em toda CPU x86_64.
+        let leaf1 = unsafe { __cpuid(1) };
+        if leaf1.edx & (1 << 9) == 0 {
+            return Err(ApicError::ApicNotPresent);
+        }
+        if leaf1.ecx & (1 << 21) == 0 {
+            return Err(ApicError::X2ApicUnsupported);
+        }
+        Ok(())
+    }
+
+    /// ⚙️ Habilita o APIC Local desta CPU em modo x2APIC.
+    ///
+    /// # Safety
+    /// Deve ser chamado uma vez por CPU, com interrupções desabilitadas.
+    pub unsafe fn enable() {
+        let mut base = Msr::new(IA32_APIC_BASE);
+        let mut value = base.read();
+        // Desabilitado -> x2APIC direto é uma transição inválida (#GP): com EN=0,
+        // liga o xAPIC (EN) numa escrita e só então o x2APIC (EXTD) noutra.
+        if value & APIC_BASE_GLOBAL_ENABLE == 0 {
+            value |= APIC_BASE_GLOBAL_ENABLE;
+            base.write(value);
+        }
+        base.write(value | APIC_BASE_X2APIC_ENABLE);
+
+        // Aceita todas as prioridades.
+        Msr::new(X2APIC_TPR).write(0);
+
+        // LINT0/LINT1 mascarados: o 8259 não entrega mais nada por ExtINT.
+        Msr::new(X2APIC_LVT_LINT0).write(LVT_MASKED);
+        Msr::new(X2APIC_LVT_LINT1).write(LVT_MASKED);
+        Msr::new(X2APIC_LVT_ERROR).write(APIC_ERROR_VECTOR as u64);
+
+        // Software-enable + vetor espúrio.
+        Msr::new(X2APIC_SVR).write(SVR_APIC_ENABLE | SPURIOUS_VECTOR as u64);
+    }
+
+    /// 🆔 ID do APIC Local pelo CPUID, válido antes de `enable`.
+    /// * CPUID.0Bh: EDX = ID x2APIC (32 bits); sem a folha, CPUID.01h: EBX[31:24].
+    pub fn cpuid_id() -> u32 {
+        // # SAFETY: CPUID está disponível em toda CPU x86_64.
+        unsafe {
+            if __cpuid(0).eax >= 0x0B {
+                let leaf = __cpuid_count(0x0B, 0);
+                if leaf.ebx != 0 {
+                    return leaf.edx;
+                }
+            }
+            __cpuid(1).ebx >> 24
+        }
+    }
+
+    /// 🆔 Retorna o ID do APIC Local da CPU atual (32 bits no x2APIC).
+    #[inline]
+    pub fn id() -> u32 {
+        // # SAFETY: Leitura de MSR válida quando o x2APIC está habilitado.
+        unsafe { Msr::new(X2APIC_ID).read() as u32 }
+    }
+}
+
+// ------------------------------------------------------------------------
+// --- Índices Densos de CPU ---
+// ------------------------------------------------------------------------
+
+/// Entrada livre em `CPU_APIC_IDS`.
+const NO_APIC_ID: u32 = u32::MAX;
+
+/// ID de APIC de cada índice de CPU (0..MAX_CPUS), registrado na subida da CPU.
+/// * Os IDs de APIC são esparsos (ex: 0, 2, 4...); os índices são densos e únicos.
+static CPU_APIC_IDS: [AtomicU32; MAX_CPUS] = {
+    const FREE: AtomicU32 = AtomicU32::new(NO_APIC_ID);
+    [FREE; MAX_CPUS]
+};
+
+/// 🧭 Associa o índice denso `cpu_index` ao ID de APIC da CPU atual.
+/// * Chamado uma vez por CPU, na própria CPU, na subida (`gdt::init_for_cpu`).
+pub fn register_cpu(cpu_index: usize) {
+    CPU_APIC_IDS[cpu_index].store(LocalApic::cpuid_id(), Ordering::Release);
+}
+
+/// 🆔 Índice denso da CPU atual (`None` se ela não foi registrada).
+/// * Sem x2APIC só há a CPU de boot (índice 0).
+#[inline]
+pub fn cpu_index() -> Option<usize> {
+    if !is_active() {
+        return Some(0);
+    }
+    let id = LocalApic::id();
+    CPU_APIC_IDS.iter().position(|entry| entry.load(Ordering::Relaxed) == id)
+}
+
+/// 📢 Sinaliza o fim da interrupção ao APIC Local.
+///
+/// Uma única escrita de MSR: sem Port I/O, sem Mutex e sem leitura prévia.
+#[inline(always)]
+pub fn end_of_interrupt() {
+    // # SAFETY: O MSR de EOI é write-only e só tem efeito na CPU local.
+    unsafe { Msr::new(X2APIC_EOI).write(0) }
+}
+
+// ------------------------------------------------------------------------
+// --- IO-APIC ---
+// ------------------------------------------------------------------------
+
+/// 🔀 Polaridade/Disparo de uma linha roteada pelo IO-APIC.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum Trigger {
+    /// Borda, ativa em nível alto (padrão das IRQs ISA).
+    EdgeHigh,
+    /// Nível, ativa em nível baixo (padrão das linhas INTx do PCI).
+    LevelLow,
+}
+
+/// 🔌 Um IO-APIC acessado por MMIO (IOREGSEL/IOWIN).
+pub struct IoApic {
+    base: *mut u32,
+    /// Número de entradas de redirecionamento (GSIs atendidas).
+    redirection_entries: u32,
+}
+
+// O IO-APIC é protegido pelo Mutex global; o ponteiro MMIO pode trocar de CPU.
+unsafe impl Send for IoApic {}
+
+impl IoApic {
+    /// 🏭 Cria o acesso ao IO-APIC a partir do seu endereço virtual já mapeado.
+    ///
+    /// # Safety
+    /// `virt_base` deve apontar para o MMIO do IO-APIC, mapeado sem cache.
+    pub unsafe fn new(virt_base: usize) -> Self {
+        let mut ioapic = IoApic {
+            base: virt_base as *mut u32,
+            redirection_entries: 0,
+        };
+        let version = ioapic.read(IOAPIC_REG_VERSION);
+        ioapic.redirection_entries = ((version >> 16) & 0xFF) + 1;
+        ioapic
+    }
+
+    fn read(&mut self, reg: u32) -> u32 {
+        // # SAFETY: `base` é o MMIO do IO-APIC (garantido por `new`).
+        unsafe {
+            ptr::write_volatile(self.base.byte_add(IOAPIC_REGSEL), reg);
+            ptr::read_volatile(self.base.byte_add(IOAPIC_WINDOW))
+        }
+    }
+
+    fn write(&mut self, reg: u32, value: u32) {
+        // # SAFETY: `base` é o MMIO do IO-APIC (garantido por `new`).
+        unsafe {
+            ptr::write_volatile(self.base.byte_add(IOAPIC_REGSEL), reg);
+            ptr::write_volatile(self.base.byte_add(IOAPIC_WINDOW), value);
+        }
+    }
+
+    /// Número de GSIs atendidas por este IO-APIC.
+    pub fn gsi_count(&self) -> u32 {
+        self.redirection_entries
+    }
+
+    /// 🗺️ Programa a GSI `gsi` para entregar `vector` ao APIC `dest_apic_id`.
+    ///
+    /// A entrada é escrita mascarada e só então desmascarada, evitando uma
+    /// entrega com destino/vetor parcialmente atualizados.
+    pub fn route(&mut self, gsi: u32, vector: u8, dest_apic_id: u32, trigger: Trigger) -> Result<(), ApicError> {
+        self.program(gsi, vector, dest_apic_id, trigger, false)
+    }
+
+    /// 🗺️ Como `route`, mas a entrada termina mascarada (o driver desmascara
+    /// quando o handler estiver pronto).
+    pub fn route_masked(&mut self, gsi: u32, vector: u8, dest_apic_id: u32, trigger: Trigger) -> Result<(), ApicError> {
+        self.program(gsi, vector, dest_apic_id, trigger, true)
+    }
+
+    fn program(&mut self, gsi: u32, vector: u8, dest_apic_id: u32, trigger: Trigger, masked: bool) -> Result<(), ApicError> {
+        if gsi >= self.redirection_entries {
+            return Err(ApicError::InvalidGsi);
+        }
+        // Sem Interrupt Remapping o campo de destino (modo físico) tem 8 bits.
+        if dest_apic_id > 0xFF {
+            return Err(ApicError::DestinationOutOfRange);
+        }
+
+        let reg = IOAPIC_REG_REDTBL + gsi * 2;
+        let mut low = vector as u32; // Delivery Mode = Fixed, Destination Mode = Físico
+        if trigger == Trigger::LevelLow {
+            low |= REDIR_ACTIVE_LOW | REDIR_LEVEL_TRIGGERED;
+        }
+        if masked {
+            low |= REDIR_MASKED;
+        }
+
+        self.write(reg, REDIR_MASKED);
+        self.write(reg + 1, dest_apic_id << 24);
+        self.write(reg, low);
+        Ok(())
+    }
+
+    /// 🎯 Altera apenas a CPU de destino de uma GSI (afinidade por CPU).
+    pub fn set_affinity(&mut self, gsi: u32, dest_apic_id: u32) -> Result<(), ApicError> {
+        if gsi >= self.redirection_entries {
+            return Err(ApicError::InvalidGsi);
+        }
+        if dest_apic_id > 0xFF {
+            return Err(ApicError::DestinationOutOfRange);
+        }
+        self.write(IOAPIC_REG_REDTBL + gsi * 2 + 1, dest_apic_id << 24);
+        Ok(())
+    }
+
+    /// 🔇 Mascara uma GSI.
+    pub fn mask(&mut self, gsi: u32) -> Result<(), ApicError> {
+        self.update_mask(gsi, true)
+    }
+
+    /// 🔊 Desmascara uma GSI.
+    pub fn unmask(&mut self, gsi: u32) -> Result<(), ApicError> {
+        self.update_mask(gsi, false)
+    }
+
+    fn update_mask(&mut self, gsi: u32, masked: bool) -> Result<(), ApicError> {
+        if gsi >= self.redirection_entries {
+            return Err(ApicError::InvalidGsi);
+        }
+        let reg = IOAPIC_REG_REDTBL + gsi * 2;
+        let low = self.read(reg);
+        let low = if masked { low | REDIR_MASKED } else { low & !REDIR_MASKED };
+        self.write(reg, low);
+        Ok(())
+    }
+}
+
+/// 🔑 Instância global do IO-APIC.
+/// O Mutex só é usado no caminho de configuração (rotear/mascarar), nunca no EOI.
+pub static IO_APIC: Once<Mutex<IoApic>> = Once::new();
+
+/// 🔁 Converte uma IRQ ISA (0-15) na GSI correspondente.
+///
+/// Os Interrupt Source Overrides da MADT ainda não são lidos; usamos o único
+/// override universal dos PCs/QEMU: o PIT (IRQ 0) está ligado à GSI 2.
+pub fn isa_irq_to_gsi(irq: u8) -> u32 {
+    match irq {
+        0 => 2,
+        n => n as u32,
+    }
+}
+
+// ------------------------------------------------------------------------
+// --- MSI (Message Signaled Interrupts) ---
+// ------------------------------------------------------------------------
+
+/// 📨 Endereço/Dado de uma mensagem MSI, a serem escritos no dispositivo PCI.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct MsiMessage {
+    /// Endereço da mensagem (0xFEEx_xxxx).
+    pub address: u64,
+    /// Dado da mensagem (vetor + modo de entrega).
+    pub data: u32,
+}
+
+/// 📨 Monta a mensagem MSI para entregar `vector` (borda, Fixed) ao APIC `dest_apic_id`.
+/// A afinidade por CPU de um dispositivo MSI é definida aqui, no endereço.
+pub fn msi_message(vector: u8, dest_apic_id: u32) -> Result<MsiMessage, ApicError> {
+    if dest_apic_id > 0xFF {
+        return Err(ApicError::DestinationOutOfRange);
+    }
+    Ok(MsiMessage {
+        address: 0xFEE0_0000 | ((dest_apic_id as u64) << 12),
+        data: vector as u32,
+    })
+}
+
+// ------------------------------------------------------------------------
+// --- Inicialização ---
+// ------------------------------------------------------------------------
+
+/// ⚙️ Habilita o x2APIC na CPU de boot e roteia as 16 IRQs ISA pelo IO-APIC.
+///
+/// Os vetores continuam os mesmos do 8259 remapeado (`PIC_1_OFFSET + irq`),
+/// portanto as entradas já instaladas na IDT permanecem válidas.
+///
+/// Tudo o que pode falhar (mapear e programar o IO-APIC) acontece antes de o
+/// APIC Local trocar de modo e mascarar o LINT0: em caso de erro, a CPU continua
+/// no modo original e o 8259 pode voltar a entregar as IRQs.
+///
+/// # Safety
+/// Deve ser chamado com interrupções desabilitadas, após o 8259 ter sido
+/// mascarado e após o Paging estar ativo (o MMIO do IO-APIC é mapeado Uncached).
+pub unsafe fn init() -> Result<(), ApicError> {
+    LocalApic::detect()?;
+    let bsp = LocalApic::cpuid_id();
+
+    let mmio = paging::map_mmio_region(PhysAddr::new(IO_APIC_BASE as u64), IOAPIC_MMIO_SIZE, CacheMode::Uncached)
+        .map_err(|_| ApicError::MmioMapFailed)?;
+    let mut ioapic = IoApic::new(mmio.as_u64() as usize);
+    if let Err(e) = route_isa_irqs(&mut ioapic, bsp) {
+        // Nenhuma entrada parcial fica entregando ao lado do 8259.
+        for irq in 0..16u8 {
+            let _ = ioapic.mask(isa_irq_to_gsi(irq));
+        }
+        return Err(e);
+    }
+    let gsi_count = ioapic.gsi_count();
+    IO_APIC.call_once(|| Mutex::new(ioapic));
+
+    LocalApic::enable();
+    X2APIC_ACTIVE.store(true, Ordering::Release);
+    crate::println!("INFO: x2APIC habilitado (APIC ID {}), IO-APIC com {} GSIs.", bsp, gsi_count);
+    Ok(())
+}
+
+/// Roteia as IRQs ISA (borda, ativas em alto) para `dest_apic_id`.
+fn route_isa_irqs(ioapic: &mut IoApic, dest_apic_id: u32) -> Result<(), ApicError> {
+    for irq in 0..16u8 {
+        // A IRQ 2 é a cascata do 8259 e não existe no IO-APIC.
+        if irq == 2 {
+            continue;
+        }
+        ioapic.route(isa_irq_to_gsi(irq), PIC_1_OFFSET + irq, dest_apic_id, Trigger::EdgeHigh)?;
+    }
+    Ok(())
+}
+
+/// 🎯 Redireciona uma IRQ ISA para outra CPU (afinidade).
+pub fn set_irq_affinity(irq: u8, dest_apic_id: u32) -> Result<(), ApicError> {
+    let ioapic = IO_APIC.get().ok_or(ApicError::NotInitialized)?;
+    x86_64::instructions::interrupts::without_interrupts(|| {
+        ioapic.lock().set_affinity(isa_irq_to_gsi(irq), dest_apic_id)
+    })
+}
@@ -0,0 +1,207 @@
+// src/kernel/interrupts/dispatch.rs
+
+//! Tabela de Despacho de IRQs por vetor para o LightOS.
+//!
+//! Cada vetor (0-255) tem no máximo um handler registrado e um contador por CPU.
+//! O caminho de interrupção não toma nenhum spinlock:
+//! * O handler é lido com um único `load` atômico.
+//! * O contador é da CPU local (índice denso registrado na subida da CPU, linha
+//!   de cache própria), incrementado sem `lock`.
+//! * O EOI é delegado a `super::end_of_interrupt` (MSR no x2APIC, `outb` no 8259).
+
+use core::sync::atomic::{AtomicU64, AtomicUsize, Ordering};
+
+use super::apic;
+use super::frame::TrapFrame;
+use crate::RustKernelConfig::arch_hal::MAX_CPUS;
+
+/// Número de vetores da IDT.
+pub const VECTOR_COUNT: usize = 256;
+
+/// Primeiro vetor disponível para IRQs (0-31 são exceções da CPU).
+pub const FIRST_IRQ_VECTOR: u8 = 32;
+
+/// Faixa de vetores distribuída dinamicamente a dispositivos MSI (acima das
+/// IRQs ISA remapeadas e abaixo dos vetores de sistema do APIC).
+pub const DYNAMIC_VECTOR_START: u8 = 0x40;
+pub const DYNAMIC_VECTOR_END: u8 = 0xE0;
+
+/// ⚡ Assinatura de um handler de IRQ registrado.
+/// * Executa em contexto de interrupção, com interrupções desabilitadas.
+/// * O EOI é enviado pelo despachante; o handler não deve enviá-lo.
+pub type IrqHandler = fn(vector: u8);
+
+/// 🚨 Erros de registro na tabela de despacho.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum DispatchError {
+    /// O vetor pertence às exceções da CPU (0-31).
+    ReservedVector,
+    /// Já existe um handler registrado para este vetor.
+    AlreadyRegistered,
+    /// Não há handler registrado para este vetor.
+    NotRegistered,
+    /// Todos os vetores dinâmicos já foram distribuídos.
+    NoFreeVector,
+}
+
+/// Vetores dinâmicos em uso: um bit por vetor da IDT (só a faixa dinâmica é usada).
+static DYNAMIC_VECTORS: [AtomicU64; VECTOR_COUNT / 64] = {
+    const FREE: AtomicU64 = AtomicU64::new(0);
+    [FREE; VECTOR_COUNT / 64]
+};
+
+/// Valor sentinela de "nenhum handler" na tabela.
+const NO_HANDLER: usize = 0;
+
+/// 📚 Handlers registrados, indexados pelo vetor (ponteiros de função como `usize`).
+static HANDLERS: [AtomicUsize; VECTOR_COUNT] = {
+    const EMPTY: AtomicUsize = AtomicUsize::new(NO_HANDLER);
+    [EMPTY; VECTOR_COUNT]
+};
+
+/// 🔢 Contadores de uma CPU, alinhados para não compartilhar linhas de cache
+/// com os contadores das outras CPUs.
+#[repr(C, align(64))]
+struct CpuIrqCounters {
+    counts: [AtomicU64; VECTOR_COUNT],
+}
+
+impl CpuIrqCounters {
+    const fn new() -> Self {
+        const ZERO: AtomicU64 = AtomicU64::new(0);
+        CpuIrqCounters { counts: [ZERO; VECTOR_COUNT] }
+    }
+}
+
+static COUNTERS: [CpuIrqCounters; MAX_CPUS] = {
+    const CPU: CpuIrqCounters = CpuIrqCounters::new();
+    [CPU; MAX_CPUS]
+};
+
+/// Interrupções recebidas por CPUs sem índice registrado (atômicas: compartilhadas).
+static UNREGISTERED_COUNTS: CpuIrqCounters = CpuIrqCounters::new();
+
+// ------------------------------------------------------------------------
+// --- API de Registro ---
+// ------------------------------------------------------------------------
+
+/// ➕ Registra `handler` para o `vector`.
+///
+/// A publicação é um único `compare_exchange`, portanto pode ocorrer com as
+/// interrupções habilitadas e em paralelo com o despacho em outras CPUs.
+pub fn register_handler(vector: u8, handler: IrqHandler) -> Result<(), DispatchError> {
+    if vector < FIRST_IRQ_VECTOR {
+        return Err(DispatchError::ReservedVector);
+    }
+    HANDLERS[vector as usize]
+        .compare_exchange(NO_HANDLER, handler as usize, Ordering::AcqRel, Ordering::Acquire)
+        .map(|_| ())
+        .map_err(|_| DispatchError::AlreadyRegistered)
+}
+
+/// 🎟️ Reserva um vetor livre da faixa dinâmica (para MSI/MSI-X).
+/// * Devolvido com `free_vector` quando o dispositivo desiste dele.
+pub fn allocate_vector() -> Result<u8, DispatchError> {
+    for vector in DYNAMIC_VECTOR_START..DYNAMIC_VECTOR_END {
+        let bit = 1u64 << (vector % 64);
+        if DYNAMIC_VECTORS[vector as usize / 64].fetch_or(bit, Ordering::AcqRel) & bit == 0 {
+            return Ok(vector);
+        }
+    }
+    Err(DispatchError::NoFreeVector)
+}
+
+/// ♻️ Devolve um vetor de `allocate_vector`: a origem de máscara volta ao
+/// padrão e o vetor pode ser reservado de novo.
+/// * O chamador já desligou a fonte (entrada MSI/MSI-X) e removeu o handler.
+pub fn free_vector(vector: u8) {
+    if !(DYNAMIC_VECTOR_START..DYNAMIC_VECTOR_END).contains(&vector) {
+        return;
+    }
+    super::clear_vector_source(vector);
+    DYNAMIC_VECTORS[vector as usize / 64].fetch_and(!(1u64 << (vector % 64)), Ordering::AcqRel);
+}
+
+/// ➖ Remove o handler do `vector`.
+/// * Um despacho já em andamento em outra CPU ainda pode executar o handler antigo.
+pub fn unregister_handler(vector: u8) -> Result<(), DispatchError> {
+    match HANDLERS[vector as usize].swap(NO_HANDLER, Ordering::AcqRel) {
+        NO_HANDLER => Err(DispatchError::NotRegistered),
+        _ => Ok(()),
+    }
+}
+
+/// 📊 Total de interrupções recebidas no `vector` (soma de todas as CPUs).
+pub fn irq_count(vector: u8) -> u64 {
+    COUNTERS
+        .iter()
+        .chain(core::iter::once(&UNREGISTERED_COUNTS))
+        .map(|cpu| cpu.counts[vector as usize].load(Ordering::Relaxed))
+        .sum()
+}
+
+// ------------------------------------------------------------------------
+// --- Caminho de Interrupção ---
+// ------------------------------------------------------------------------
+
+/// ⚡ Despacha o `vector` para o handler registrado e envia o EOI.
+///
+/// Retorna `false` se nenhum handler estava registrado (o EOI é enviado mesmo
+/// assim, para não travar a linha no controlador).
+#[inline]
+pub fn dispatch(vector: u8) -> bool {
+    // O vetor espúrio do APIC não tem ISR em serviço: não há EOI a enviar.
+    if vector == apic::SPURIOUS_VECTOR {
+        return false;
+    }
+
+    // Contador da CPU local: o índice denso é exclusivo desta CPU e as
+    // interrupções estão desabilitadas, então um load + store simples (sem
+    // prefixo `lock`) não perde incrementos. Uma CPU não registrada usa `fetch_add`.
+    match apic::cpu_index() {
+        Some(cpu) => {
+            let counter = &COUNTERS[cpu].counts[vector as usize];
+            counter.store(counter.load(Ordering::Relaxed).wrapping_add(1), Ordering::Relaxed);
+        }
+        None => {
+            UNREGISTERED_COUNTS.counts[vector as usize].fetch_add(1, Ordering::Relaxed);
+        }
+    }
+
+    let raw = HANDLERS[vector as usize].load(Ordering::Acquire);
+    let handled = raw != NO_HANDLER;
+    if handled {
+        // # SAFETY: Apenas ponteiros `IrqHandler` válidos são publicados na tabela.
+        let handler: IrqHandler = unsafe { core::mem::transmute::<usize, IrqHandler>(raw) };
+        handler(vector);
+    }
+
+    // Interrupções de software (INT n) não passam pelo controlador: sem EOI.
+    if !super::is_software_vector(vector) {
+        super::end_of_interrupt(vector);
+    }
+    handled
+}
+
+/// 🌉 Ponto de entrada FFI chamado pelo stub Assembly comum (`lightos_irq_common`).
+///
+/// * `frame` é o Trap Frame completo, na stack IST de IRQs da CPU.
+/// * `entry_tsc` é o TSC lido pelo stub logo após salvar os registradores.
+///
+/// Retorna o frame a ser retomado pelo stub: o próprio `frame` ou, se uma troca
+/// de tarefa foi solicitada (temporizador, `task::yield_now`), o frame salvo da
+/// próxima tarefa escolhida pelo Scheduler.
+#[no_mangle]
+pub unsafe extern "C" fn lightos_irq_dispatch(frame: *mut TrapFrame, entry_tsc: u64) -> *mut TrapFrame {
+    let vector = (*frame).vector as u8;
+    dispatch(vector);
+
+    let resume = if crate::task::take_reschedule_request() {
+        crate::task::preempt(frame)
+    } else {
+        frame
+    };
+
+    super::stats::record(vector, entry_tsc, super::stats::read_tsc());
+    resume
+}
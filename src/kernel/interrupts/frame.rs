@@ -0,0 +1,69 @@
+// src/kernel/interrupts/frame.rs
+
+//! Trap Frame uniforme construído pelos stubs de entrada de IRQ (`irq_handlers_asm.s`).
+//!
+//! Todo vetor de IRQ empilha exatamente este layout. O Scheduler troca de tarefa
+//! simplesmente devolvendo ao stub o ponteiro para o frame de outra tarefa: o stub
+//! restaura os registradores a partir dele e executa IRETQ.
+
+use x86_64::VirtAddr;
+
+/// 🧱 Estado completo da CPU salvo na entrada de uma interrupção.
+/// * A ordem dos campos DEVE corresponder à ordem de `push` em `lightos_irq_common`
+///   (o último registrador empilhado fica no menor endereço).
+#[derive(Debug, Default, Clone, Copy)]
+#[repr(C)]
+pub struct TrapFrame {
+    // --- Empilhados por lightos_irq_common ---
+    pub r15: u64,
+    pub r14: u64,
+    pub r13: u64,
+    pub r12: u64,
+    pub r11: u64,
+    pub r10: u64,
+    pub r9: u64,
+    pub r8: u64,
+    pub rbp: u64,
+    pub rdi: u64,
+    pub rsi: u64,
+    pub rdx: u64,
+    pub rcx: u64,
+    pub rbx: u64,
+    pub rax: u64,
+    // --- Empilhados pelo stub do vetor (IRQ_ENTRY) ---
+    pub vector: u64,
+    pub error_code: u64,
+    // --- Empilhados pela CPU (Interrupt Stack Frame) ---
+    pub rip: u64,
+    pub cs: u64,
+    pub rflags: u64,
+    pub rsp: u64,
+    pub ss: u64,
+}
+
+/// Tamanho do frame em bytes (conferido contra o Assembly).
+pub const TRAP_FRAME_SIZE: usize = 22 * 8;
+const _: () = assert!(core::mem::size_of::<TrapFrame>() == TRAP_FRAME_SIZE);
+
+/// RFLAGS inicial de uma tarefa: bit 1 (reservado, sempre 1) + IF (interrupções habilitadas).
+const INITIAL_RFLAGS: u64 = 0x202;
+
+impl TrapFrame {
+    /// 🏭 Cria o frame inicial de uma tarefa de kernel.
+    /// * O primeiro IRETQ para este frame "retorna" para `entry_point` com a stack
+    ///   em `stack_top`, exatamente como uma tarefa preemptada seria retomada.
+    pub fn new_kernel_task(entry_point: u64, stack_top: VirtAddr) -> Self {
+        let selectors = super::gdt::selectors();
+        // ABI System V: na entrada de uma função, RSP + 8 é múltiplo de 16.
+        let rsp = stack_top.align_down(16u64).as_u64() - 8;
+
+        TrapFrame {
+            rip: entry_point,
+            cs: selectors.kernel_code.0 as u64,
+            rflags: INITIAL_RFLAGS,
+            rsp,
+            ss: selectors.kernel_data.0 as u64,
+            ..TrapFrame::default()
+        }
+    }
+}
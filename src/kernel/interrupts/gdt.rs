@@ -0,0 +1,112 @@
+// src/kernel/interrupts/gdt.rs
+
+//! GDT e TSS por CPU, com as stacks IST (Interrupt Stack Table) do LightOS.
+//!
+//! * `DOUBLE_FAULT_IST_INDEX`: stack dedicada ao Double Fault.
+//! * `IRQ_IST_INDEX`: stack por CPU usada por todos os stubs de IRQ, de modo que
+//!   o tratamento nunca depende da stack (possivelmente pequena) da tarefa interrompida.
+//!
+//! As IRQs usam interrupt gates (IF=0 na entrada), então uma IRQ nunca aninha
+//! sobre outra na mesma stack IST.
+
+use spin::Once;
+use x86_64::instructions::segmentation::{Segment, CS, DS, ES, SS};
+use x86_64::instructions::tables::load_tss;
+use x86_64::structures::gdt::{Descriptor, GlobalDescriptorTable, SegmentSelector};
+use x86_64::structures::tss::TaskStateSegment;
+use x86_64::VirtAddr;
+
+use crate::RustKernelConfig::arch_hal::MAX_CPUS;
+
+/// Índice IST da stack de Double Fault.
+pub const DOUBLE_FAULT_IST_INDEX: u16 = 0;
+/// Índice IST da stack de IRQs.
+pub const IRQ_IST_INDEX: u16 = 1;
+
+/// Tamanho de cada stack IST (16 KB).
+const IST_STACK_SIZE: usize = 16 * 1024;
+
+/// 🧱 Stack IST alinhada (a CPU exige apenas 16 bytes; 4 KB evita falso compartilhamento).
+#[repr(C, align(4096))]
+struct IstStack([u8; IST_STACK_SIZE]);
+
+impl IstStack {
+    fn top(&'static self) -> VirtAddr {
+        VirtAddr::from_ptr(self.0.as_ptr()) + IST_STACK_SIZE as u64
+    }
+}
+
+static mut DOUBLE_FAULT_STACKS: [IstStack; MAX_CPUS] = {
+    const STACK: IstStack = IstStack([0; IST_STACK_SIZE]);
+    [STACK; MAX_CPUS]
+};
+static mut IRQ_STACKS: [IstStack; MAX_CPUS] = {
+    const STACK: IstStack = IstStack([0; IST_STACK_SIZE]);
+    [STACK; MAX_CPUS]
+};
+
+/// 🔑 Seletores de segmento do kernel (iguais em todas as CPUs).
+#[derive(Debug, Clone, Copy)]
+pub struct Selectors {
+    pub kernel_code: SegmentSelector,
+    pub kernel_data: SegmentSelector,
+    pub tss: SegmentSelector,
+}
+
+/// TSS de cada CPU (precisa de endereço fixo: a GDT aponta para ela).
+static mut TSS: [TaskStateSegment; MAX_CPUS] = {
+    const TSS_INIT: TaskStateSegment = TaskStateSegment::new();
+    [TSS_INIT; MAX_CPUS]
+};
+
+static CPU_GDT: [Once<(GlobalDescriptorTable, Selectors)>; MAX_CPUS] = {
+    const EMPTY: Once<(GlobalDescriptorTable, Selectors)> = Once::new();
+    [EMPTY; MAX_CPUS]
+};
+
+/// ⚙️ Constrói e carrega a GDT/TSS da CPU `cpu_index` e registra o seu ID de APIC
+/// (índice denso usado pelos contadores por CPU).
+///
+/// # Safety
+/// Deve ser chamado uma única vez por CPU, na própria CPU, antes de carregar a IDT.
+pub unsafe fn init_for_cpu(cpu_index: usize) {
+    super::apic::register_cpu(cpu_index);
+
+    let (gdt, selectors) = CPU_GDT[cpu_index].call_once(|| {
+        // # SAFETY: Cada CPU escreve apenas a sua própria TSS e usa apenas as suas stacks.
+        let tss = &mut *core::ptr::addr_of_mut!(TSS[cpu_index]);
+        tss.interrupt_stack_table[DOUBLE_FAULT_IST_INDEX as usize] =
+            (*core::ptr::addr_of!(DOUBLE_FAULT_STACKS[cpu_index])).top();
+        tss.interrupt_stack_table[IRQ_IST_INDEX as usize] =
+            (*core::ptr::addr_of!(IRQ_STACKS[cpu_index])).top();
+
+        let mut gdt = GlobalDescriptorTable::new();
+        let selectors = Selectors {
+            kernel_code: gdt.append(Descriptor::kernel_code_segment()),
+            kernel_data: gdt.append(Descriptor::kernel_data_segment()),
+            tss: gdt.append(Descriptor::tss_segment(&*core::ptr::addr_of!(TSS[cpu_index]))),
+        };
+        (gdt, selectors)
+    });
+
+    gdt.load();
+    CS::set_reg(selectors.kernel_code);
+    SS::set_reg(selectors.kernel_data);
+    DS::set_reg(selectors.kernel_data);
+    ES::set_reg(selectors.kernel_data);
+    load_tss(selectors.tss);
+}
+
+/// ⚙️ Inicializa a GDT/TSS da CPU de boot (chamado do kernel_main, antes da IDT).
+pub fn init() {
+    // # SAFETY: Chamado uma vez, na CPU de boot, durante a inicialização.
+    unsafe { init_for_cpu(0) }
+}
+
+/// 🔑 Retorna os seletores do kernel (da CPU de boot; idênticos nas demais).
+pub fn selectors() -> Selectors {
+    CPU_GDT[0]
+        .get()
+        .map(|(_, selectors)| *selectors)
+        .expect("GDT não inicializada")
+}
@@ -3,86 +3,115 @@
 // ------------------------------------------------------------------------
 // --- Importações FFI (Rust) ---
 // ------------------------------------------------------------------------
-.extern lightos_timer_handler_rust
-.extern lightos_keyboard_handler_rust
+.extern lightos_irq_dispatch
 
 // ------------------------------------------------------------------------
-// --- lightos_timer_handler (Ponto de Entrada Assembly do Timer IRQ) ---
+// --- Convenção do Trap Frame (Deve corresponder a src/kernel/interrupts/frame.rs) ---
 // ------------------------------------------------------------------------
 
-.global lightos_timer_handler
-lightos_timer_handler:
-    // 1. Salvar Contexto da Interrupção (Registradores Caller-Saved)
-    // Os registradores Callee-Saved (RBP, RBX, R12-R15) são salvos pelo Assembly
-    // de troca de contexto (context_switch.s). Aqui, salvamos o resto.
-    
-    pushq %rdi      // RDI é usado para passar argumentos
-    pushq %rsi
-    pushq %rdx
+// Layout a partir do RSP após lightos_irq_common salvar os registradores:
+//   0   r15   8 r14  16 r13  24 r12  32 r11  40 r10  48 r9   56 r8
+//   64  rbp  72 rdi  80 rsi  88 rdx  96 rcx 104 rbx 112 rax
+//   120 vetor 128 código de erro
+//   136 rip  144 cs  152 rflags 160 rsp 168 ss   (empilhados pela CPU)
+.equ FRAME_VECTOR,   120
+.equ FRAME_SIZE,     176 // 22 palavras * 8 bytes
+
+// Tamanho fixo de cada stub de vetor: o Rust calcula o endereço do stub do
+// vetor V como `lightos_irq_stubs_start + (V - 32) * IRQ_STUB_SIZE`.
+.equ IRQ_STUB_SIZE,  16
+.equ FIRST_IRQ_VECTOR, 32
+.equ LAST_IRQ_VECTOR,  255
+
+.section .text
+
+// ------------------------------------------------------------------------
+// --- lightos_irq_common (Caminho Único de Entrada/Saída de IRQ) ---
+// ------------------------------------------------------------------------
+
+// Chegamos aqui já na stack IST de IRQs da CPU (definida na IDT/TSS), com
+// interrupções desabilitadas (interrupt gate).
+//
+// Contrato com o Rust:
+//   TrapFrame* lightos_irq_dispatch(TrapFrame* frame, u64 entry_tsc);
+// O valor de retorno é o frame a ser RETOMADO. Se o Scheduler decidiu trocar
+// de tarefa, ele devolve o frame salvo da próxima tarefa; caso contrário,
+// devolve o próprio `frame`. A troca de contexto é apenas `mov %rax, %rsp`.
+
+lightos_irq_common:
+    // 1. Completar o Trap Frame (todos os registradores de propósito geral)
+    pushq %rax
+    pushq %rbx
     pushq %rcx
+    pushq %rdx
+    pushq %rsi
+    pushq %rdi
+    pushq %rbp
     pushq %r8
     pushq %r9
     pushq %r10
     pushq %r11
-    
-    // 2. Chamar o Scheduler (Função Rust)
-    
-    // O RDI deve conter o ponteiro para o TaskContext salvo.
-    // Como o contexto de IRQ está na stack, e a stack é o contexto da Task, 
-    // precisamos de uma lógica mais complexa, mas para simplificar:
-    
-    // Neste ponto, o RSP aponta para os registradores salvos na stack.
-    // Em um kernel real, o Agendador manteria o RSP do contexto anterior.
-    // Usaremos a convenção de que a função Rust manipulará o contexto salvo.
-    
-    // Chamada simplificada (Passando o ponteiro para o TaskContext. O Assembly de troca
-    // de contexto em 'context_switch.s' faria este passo de forma mais limpa).
-    
-    // Se o Assembly de troca for usado, o código seria:
-    // call lightos_context_switch_save // Salva o contexto na TaskContext
-    // mov %rdi, %r8                    // Move o ponteiro para o TaskContext (arg 1 para o Rust)
-    // mov %r8, %rdi
-    // call lightos_timer_handler_rust  // Chamada ao Rust (que agenda o próximo)
-    // call lightos_context_switch_restore // Restaura o contexto da nova Task (não retorna!)
-    
-    // Usando apenas o handler Rust, a chamada é:
-    mov %rsp, %rdi  // Passar o ponteiro do RSP (contexto salvo) como Arg 1
-    call lightos_timer_handler_rust
-
-    // 3. Restaurar Contexto (Se o Rust retornou, significa que a tarefa não foi trocada)
-    
+    pushq %r12
+    pushq %r13
+    pushq %r14
+    pushq %r15
+
+    // 2. Carimbo de tempo de entrada para stats.rs (RDTSC -> EDX:EAX)
+    rdtsc
+    shl $32, %rdx
+    or %rax, %rdx
+    mov %rdx, %rsi          // Arg 2: TSC de entrada
+    mov %rsp, %rdi          // Arg 1: ponteiro para o TrapFrame
+
+    // 3. Chamar o Rust. A CPU alinha o RSP em 16 antes de empilhar o frame de
+    //    interrupção; 22 palavras (176 bytes) mantêm esse alinhamento.
+    cld
+    call lightos_irq_dispatch
+
+    // 4. Retomar o frame devolvido (o mesmo, ou o de outra tarefa)
+    mov %rax, %rsp
+
+    popq %r15
+    popq %r14
+    popq %r13
+    popq %r12
     popq %r11
     popq %r10
     popq %r9
     popq %r8
-    popq %rcx
-    popq %rdx
-    popq %rsi
+    popq %rbp
     popq %rdi
+    popq %rsi
+    popq %rdx
+    popq %rcx
+    popq %rbx
+    popq %rax
 
-    // 4. IRETQ (Retorno da Interrupção)
-    iretq 
-
+    add $16, %rsp           // Descartar vetor e código de erro
+    iretq
 
 // ------------------------------------------------------------------------
-// --- lightos_keyboard_handler (Ponto de Entrada Assembly do Keyboard IRQ) ---
+// --- Stubs por Vetor (IRQ_ENTRY) ---
 // ------------------------------------------------------------------------
 
-.global lightos_keyboard_handler
-lightos_keyboard_handler:
-    // Salvar registradores voláteis
-    pushq %rdi
-    pushq %rsi
-    pushq %rdx
-    pushq %rcx
-    
-    call lightos_keyboard_handler_rust // Chama o handler Rust
+// Um stub por vetor de 32 a 255. Como nenhuma IRQ empilha código de erro,
+// o stub empilha 0 no lugar dele, deixando o frame uniforme para todo vetor.
+// Pior caso: push imm8 (2) + push imm32 (5) + jmp rel32 (5) = 12 <= IRQ_STUB_SIZE.
+.macro IRQ_ENTRY vector
+    .balign IRQ_STUB_SIZE
+    pushq $0                // Código de erro (fictício)
+    pushq $\vector          // Número do vetor
+    jmp lightos_irq_common
+.endm
 
-    // Restaurar registradores
-    popq %rcx
-    popq %rdx
-    popq %rsi
-    popq %rdi
-    
-    // Retorno da Interrupção
-    iretq
+.balign IRQ_STUB_SIZE
+.global lightos_irq_stubs_start
+lightos_irq_stubs_start:
+.set irq_vector, FIRST_IRQ_VECTOR
+.rept LAST_IRQ_VECTOR - FIRST_IRQ_VECTOR + 1
+    IRQ_ENTRY irq_vector
+    .set irq_vector, irq_vector + 1
+.endr
+.balign IRQ_STUB_SIZE
+.global lightos_irq_stubs_end
+lightos_irq_stubs_end:
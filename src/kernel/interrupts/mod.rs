@@ -25,15 +25,326 @@ use x86_64::registers::control::Cr2;
 use lazy_static::lazy_static; 
 use spin::Mutex; 
 use x86_64::instructions::interrupts; // Necessário para desabilitar/reabilitar IRQ
+use core::sync::atomic::{AtomicU64, Ordering};
+use x86_64::VirtAddr;
 
 // Módulos internos
 pub mod pic;
+pub mod pit;
+pub mod apic;
+pub mod dispatch;
+pub mod threaded;
+pub mod stats;
+pub mod frame;
+pub mod gdt;
 use crate::{task, syscall}; 
 use crate::memory::vma::VMA_Error; // Importa o erro VMA
 
-// ... (Constantes e Enumerações InterruptIndex permanecem as mesmas) ...
-// ... (Funções lightos_* Assembly e init_idt_and_pics permanecem as mesmas) ...
-// ... (Exceções: divide_error_handler, double_fault_handler, general_protection_fault_handler permanecem as mesmas) ...
+/// Vetor da IRQ 0 no 8259 mestre remapeado (logo após as exceções da CPU).
+pub const PIC_1_OFFSET: u8 = 32;
+/// Vetor da IRQ 8 no 8259 escravo.
+pub const PIC_2_OFFSET: u8 = PIC_1_OFFSET + 8;
+
+// ------------------------------------------------------------------------
+// --- IDT ---
+// ------------------------------------------------------------------------
+
+lazy_static! {
+    /// 📜 IDT do kernel: exceções da CPU e os stubs de IRQ (32-255).
+    static ref IDT: InterruptDescriptorTable = {
+        let mut idt = InterruptDescriptorTable::new();
+        idt.divide_error.set_handler_fn(divide_error_handler);
+        idt.general_protection_fault.set_handler_fn(general_protection_fault_handler);
+        idt.page_fault.set_handler_fn(page_fault_handler);
+        // # SAFETY: A stack IST de Double Fault é configurada por `gdt::init`.
+        unsafe {
+            idt.double_fault
+                .set_handler_fn(double_fault_handler)
+                .set_stack_index(gdt::DOUBLE_FAULT_IST_INDEX);
+        }
+        install_irq_stubs(&mut idt);
+        idt
+    };
+}
+
+/// ⚙️ Carrega a IDT, registra os handlers do kernel, inicializa o 8259, programa
+/// o PIT a `TIMER_FREQUENCY_HZ` e habilita as interrupções.
+/// * Deve ser chamado após `gdt::init` (as entradas usam as stacks IST).
+pub fn init_idt_and_pics() {
+    IDT.load();
+    register_kernel_irq_handlers();
+    // # SAFETY: Chamado uma vez, no boot, antes de habilitar as interrupções.
+    unsafe {
+        pic::PICS.lock().initialize();
+        pit::set_frequency(crate::RustKernelConfig::TIMER_FREQUENCY_HZ);
+    }
+    interrupts::enable();
+}
+
+// ------------------------------------------------------------------------
+// --- Stubs de Entrada de IRQ (irq_handlers_asm.s) ---
+// ------------------------------------------------------------------------
+
+extern "C" {
+    /// Início dos stubs IRQ_ENTRY (um por vetor, de 32 a 255, a cada `IRQ_STUB_SIZE` bytes).
+    static lightos_irq_stubs_start: u8;
+}
+
+/// Tamanho fixo de cada stub (deve ser igual a IRQ_STUB_SIZE no Assembly).
+const IRQ_STUB_SIZE: u64 = 16;
+
+/// Vetor de software usado por `task::yield_now` para entrar no mesmo caminho
+/// de troca de contexto da preempção.
+pub const YIELD_VECTOR: u8 = 0xF0;
+
+/// Retorna `true` para vetores disparados por `INT n` (sem EOI no controlador).
+#[inline(always)]
+pub fn is_software_vector(vector: u8) -> bool {
+    vector == YIELD_VECTOR
+}
+
+/// 🧩 Instala os stubs gerados para todos os vetores de IRQ (32-255) na IDT.
+/// * Todos usam a stack IST de IRQs da CPU (`gdt::IRQ_IST_INDEX`).
+pub fn install_irq_stubs(idt: &mut InterruptDescriptorTable) {
+    // # SAFETY: Os stubs são código válido de entrada de interrupção, e a stack IST
+    // é configurada por `gdt::init` antes de a IDT ser carregada.
+    unsafe {
+        let base = VirtAddr::from_ptr(core::ptr::addr_of!(lightos_irq_stubs_start));
+        for vector in dispatch::FIRST_IRQ_VECTOR..=u8::MAX {
+            let stub = base + (vector - dispatch::FIRST_IRQ_VECTOR) as u64 * IRQ_STUB_SIZE;
+            idt[vector]
+                .set_handler_addr(stub)
+                .set_stack_index(gdt::IRQ_IST_INDEX);
+        }
+    }
+}
+// ------------------------------------------------------------------------
+// --- Base de Tempo (Tiques do Temporizador) ---
+// ------------------------------------------------------------------------
+
+/// Vetor da IRQ 0 (temporizador), nunca mascarado pela detecção de tempestades.
+pub const TIMER_VECTOR: u8 = PIC_1_OFFSET;
+
+/// Tiques do temporizador desde o boot (a `TIMER_FREQUENCY_HZ`).
+static TIMER_TICKS: AtomicU64 = AtomicU64::new(0);
+
+/// ⏱️ Retorna o número de tiques do temporizador desde o boot.
+#[inline]
+pub fn current_tick() -> u64 {
+    TIMER_TICKS.load(Ordering::Relaxed)
+}
+
+/// ⏰ Avança a base de tempo; chamado pelo handler do temporizador a cada IRQ 0.
+/// * Alimenta a coalescência das IRQs threaded e o resfriamento das tempestades.
+pub fn on_timer_tick() {
+    let now = TIMER_TICKS.fetch_add(1, Ordering::Relaxed) + 1;
+    threaded::on_timer_tick(now);
+    stats::on_timer_tick(now);
+}
+
+// ------------------------------------------------------------------------
+// --- Controlador de Interrupções (8259 legado ou x2APIC/IO-APIC) ---
+// ------------------------------------------------------------------------
+
+/// ⚡ Migra a entrega de interrupções do 8259 para o x2APIC + IO-APIC.
+///
+/// Deve ser chamado após `init_idt_and_pics` e após o Paging (o IO-APIC é MMIO).
+/// Se a CPU não suportar x2APIC, o 8259 continua ativo e nada é alterado.
+pub fn init_apic() {
+    interrupts::without_interrupts(|| {
+        if let Err(e) = apic::LocalApic::detect() {
+            crate::println!("WARN: x2APIC indisponível ({:?}). Mantendo o PIC 8259.", e);
+            return;
+        }
+
+        // # SAFETY: Interrupções desabilitadas; o 8259 é mascarado antes do IO-APIC assumir.
+        unsafe {
+            pic::PICS.lock().disable();
+            if let Err(e) = apic::init() {
+                crate::println!("ERRO: Falha ao inicializar o IO-APIC: {:?}. Voltando ao 8259.", e);
+                pic::PICS.lock().initialize();
+            }
+        }
+    });
+}
+
+/// 📢 Envia o EOI ao controlador de interrupções ativo, sem nenhum lock.
+/// * x2APIC: uma única escrita de MSR.
+/// * 8259: um ou dois `outb` diretos nas portas de comando.
+#[inline]
+pub fn end_of_interrupt(vector: u8) {
+    if apic::is_active() {
+        apic::end_of_interrupt();
+    } else if (PIC_1_OFFSET..PIC_1_OFFSET + 16).contains(&vector) {
+        // # SAFETY: O vetor pertence a uma IRQ do 8259 remapeado.
+        unsafe { pic::end_of_interrupt(vector); }
+    }
+}
+
+// ------------------------------------------------------------------------
+// --- Máscara por Vetor (na Origem) ---
+// ------------------------------------------------------------------------
+
+/// 🔌 Onde um vetor é mascarado.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum VectorSource {
+    /// Sem máscara na origem (ex: MSI sem máscara por vetor; mensagens de borda
+    /// não repetem enquanto o bottom half roda).
+    None,
+    /// IRQ ISA (0-15): a linha no 8259 ou a GSI correspondente no IO-APIC.
+    Isa(u8),
+    /// Entrada de redirecionamento do IO-APIC (ex: INTx do PCI).
+    Gsi(u32),
+    /// Máscara do próprio dispositivo (entrada MSI-X, bit de máscara da MSI):
+    /// `mask(context, masked)`.
+    Device { mask: fn(context: u64, masked: bool), context: u64 },
+}
+
+/// 👤 Quem mascarou um vetor. A origem só é desmascarada quando nenhum dono a
+/// mantém mascarada (ex: o fim da tempestade não reabre uma linha oneshot).
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+#[repr(u8)]
+pub enum MaskOwner {
+    /// O driver (`mask_vector`/`unmask_vector`).
+    Driver = 1 << 0,
+    /// IRQ threaded oneshot, até o bottom half rodar.
+    Oneshot = 1 << 1,
+    /// Detecção de tempestades (`stats`), até o resfriamento.
+    Storm = 1 << 2,
+}
+
+/// Estado de máscara de um vetor.
+#[derive(Clone, Copy)]
+struct VectorMask {
+    /// `None` = origem padrão (`default_source`).
+    source: Option<VectorSource>,
+    /// Bits de `MaskOwner` que mantêm o vetor mascarado.
+    owners: u8,
+}
+
+static VECTOR_MASKS: Mutex<[VectorMask; 256]> = Mutex::new([VectorMask { source: None, owners: 0 }; 256]);
+
+/// Origem dos vetores sem registro: as IRQs ISA remapeadas; os demais não têm linha.
+fn default_source(vector: u8) -> VectorSource {
+    match vector.checked_sub(PIC_1_OFFSET) {
+        Some(irq) if irq < 16 => VectorSource::Isa(irq),
+        _ => VectorSource::None,
+    }
+}
+
+/// 🧷 Registra onde `vector` é mascarado (chamado por quem programa a origem:
+/// `route_pci_intx`, `MsixTable::route_entry`, `PciDevice::enable_msi`).
+pub fn set_vector_source(vector: u8, source: VectorSource) {
+    interrupts::without_interrupts(|| VECTOR_MASKS.lock()[vector as usize].source = Some(source));
+}
+
+/// 🔀 Prepara a linha INTx `line` (0-15) de um dispositivo PCI e retorna o seu vetor.
+/// * IO-APIC: a GSI da linha é reprogramada como nível, ativa em baixo (o padrão
+///   das INTx; como borda, uma linha compartilhada perde interrupções) e fica
+///   mascarada até `unmask_vector`. Uma linha já preparada não é tocada.
+/// * 8259: a linha já entrega no vetor ISA; nada a programar.
+pub fn route_pci_intx(line: u8) -> Option<u8> {
+    if line >= 16 {
+        return None;
+    }
+    let vector = PIC_1_OFFSET + line;
+    if !apic::is_active() {
+        return Some(vector);
+    }
+    let gsi = apic::isa_irq_to_gsi(line);
+    let ioapic = apic::IO_APIC.get()?;
+    interrupts::without_interrupts(|| {
+        let mut masks = VECTOR_MASKS.lock();
+        let entry = &mut masks[vector as usize];
+        if !matches!(entry.source, Some(VectorSource::Gsi(routed)) if routed == gsi) {
+            ioapic.lock().route_masked(gsi, vector, apic::LocalApic::id(), apic::Trigger::LevelLow).ok()?;
+            // Os donos de máscara (ex: tempestade) continuam valendo: a entrada
+            // nova já sai mascarada e só abre quando nenhum deles restar.
+            entry.source = Some(VectorSource::Gsi(gsi));
+        }
+        Some(vector)
+    })
+}
+
+/// 🧹 Volta `vector` à origem padrão, sem donos de máscara (vetor liberado).
+pub fn clear_vector_source(vector: u8) {
+    interrupts::without_interrupts(|| VECTOR_MASKS.lock()[vector as usize] = VectorMask { source: None, owners: 0 });
+}
+
+/// 🔇 Mascara `vector` na origem (linha do 8259, RTE do IO-APIC ou entrada MSI/MSI-X).
+pub fn mask_vector(vector: u8) {
+    mask_vector_for(vector, MaskOwner::Driver);
+}
+
+/// 🔊 Desmascara `vector` na origem (se nenhum outro dono o mantém mascarado).
+pub fn unmask_vector(vector: u8) {
+    unmask_vector_for(vector, MaskOwner::Driver);
+}
+
+/// 🔇 Mascara `vector` em nome de `owner`.
+pub fn mask_vector_for(vector: u8, owner: MaskOwner) {
+    update_vector_mask(vector, owner, true);
+}
+
+/// 🔊 Retira a máscara de `owner`; a origem só abre quando não resta nenhum dono.
+pub fn unmask_vector_for(vector: u8, owner: MaskOwner) {
+    update_vector_mask(vector, owner, false);
+}
+
+fn update_vector_mask(vector: u8, owner: MaskOwner, masked: bool) {
+    // Caminho de configuração e top halves: o lock é tomado com interrupções
+    // desabilitadas para que um handler nunca espere por um lock da própria CPU.
+    // Ele também serializa a escrita na origem entre CPUs.
+    interrupts::without_interrupts(|| {
+        let mut masks = VECTOR_MASKS.lock();
+        let entry = &mut masks[vector as usize];
+        if masked {
+            entry.owners |= owner as u8;
+        } else {
+            entry.owners &= !(owner as u8);
+        }
+        apply_mask(entry.source.unwrap_or_else(|| default_source(vector)), entry.owners != 0);
+    });
+}
+
+fn apply_mask(source: VectorSource, masked: bool) {
+    match source {
+        VectorSource::None => {}
+        VectorSource::Isa(irq) => {
+            if apic::is_active() {
+                apply_mask(VectorSource::Gsi(apic::isa_irq_to_gsi(irq)), masked);
+            } else {
+                // # SAFETY: `irq` está em 0-15.
+                unsafe { pic::PICS.lock().set_irq_masked(irq, masked); }
+            }
+        }
+        VectorSource::Gsi(gsi) => {
+            if let Some(ioapic) = apic::IO_APIC.get() {
+                let mut ioapic = ioapic.lock();
+                let _ = if masked { ioapic.mask(gsi) } else { ioapic.unmask(gsi) };
+            }
+        }
+        VectorSource::Device { mask, context } => mask(context, masked),
+    }
+}
+
+// ------------------------------------------------------------------------
+// --- Handlers de Exceção ---
+// ------------------------------------------------------------------------
+
+extern "x86-interrupt" fn divide_error_handler(stack_frame: InterruptStackFrame) {
+    crate::println!("FATAL: Divisão por zero.\n{:#?}", stack_frame);
+    loop { x86_64::instructions::hlt(); }
+}
+
+extern "x86-interrupt" fn double_fault_handler(stack_frame: InterruptStackFrame, _error_code: u64) -> ! {
+    panic!("DOUBLE FAULT\n{:#?}", stack_frame);
+}
+
+extern "x86-interrupt" fn general_protection_fault_handler(stack_frame: InterruptStackFrame, error_code: u64) {
+    crate::println!("FATAL: General Protection Fault (código {:#x}).\n{:#?}", error_code, stack_frame);
+    loop { x86_64::instructions::hlt(); }
+}
 
 // ------------------------------------------------------------------------
 // --- Handler de Falha de Página (Page Fault) ---
@@ -100,6 +411,35 @@ extern "x86-interrupt" fn page_fault_handler(
 }
 
 // ------------------------------------------------------------------------
-// --- Handlers de IRQ (lightos_timer_handler_rust, lightos_keyboard_handler_rust) ---
-// ... (Permanecem os mesmos) ...
+// --- Handlers de IRQ do Kernel (Temporizador, Teclado, Yield) ---
 // ------------------------------------------------------------------------
+
+/// Vetor do teclado PS/2 (IRQ 1).
+pub const KEYBOARD_VECTOR: u8 = PIC_1_OFFSET + 1;
+
+/// ⏰ IRQ 0: avança a base de tempo e pede a troca de tarefa (quantum = 1 tique).
+fn timer_irq(_vector: u8) {
+    on_timer_tick();
+    task::request_reschedule();
+}
+
+/// ⌨️ IRQ 1: lê o scancode do controlador PS/2 e o enfileira para os leitores.
+fn keyboard_irq(_vector: u8) {
+    use crate::RustKernelConfig::arch_hal::PS2_DATA_PORT;
+    // # SAFETY: Ler a porta de dados do PS/2 reconhece a interrupção do teclado.
+    let scancode = unsafe { x86_64::instructions::port::Port::<u8>::new(PS2_DATA_PORT).read() };
+    crate::drivers::keyboard::handle_ps2_scancode(scancode);
+}
+
+/// 🔁 `INT YIELD_VECTOR`: a tarefa atual cede a CPU (ex: bloqueio em IPC).
+fn yield_irq(_vector: u8) {
+    task::request_reschedule();
+}
+
+/// ⚙️ Registra os handlers do kernel na tabela de despacho.
+/// * Chamado por `init_idt_and_pics`, antes de habilitar as interrupções.
+pub fn register_kernel_irq_handlers() {
+    let _ = dispatch::register_handler(TIMER_VECTOR, timer_irq);
+    let _ = dispatch::register_handler(KEYBOARD_VECTOR, keyboard_irq);
+    let _ = dispatch::register_handler(YIELD_VECTOR, yield_irq);
+}
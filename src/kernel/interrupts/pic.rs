@@ -89,12 +89,45 @@ impl PicChained {
         // O kernel real restauraria: master.data.write(master_mask); slave.data.write(slave_mask);
     }
 
+    /// 🔇 Mascara todas as IRQs dos dois 8259.
+    /// * Usado quando o x2APIC/IO-APIC assume a entrega de interrupções (`apic.rs`).
+    pub unsafe fn disable(&mut self) {
+        self.master.lock().data.write(0xFF);
+        self.slave.lock().data.write(0xFF);
+    }
+
+    /// 🔇 Mascara ou desmascara uma única IRQ (0-15) no IMR do 8259 correspondente.
+    pub unsafe fn set_irq_masked(&mut self, irq: u8, masked: bool) {
+        let (pic, bit) = if irq < 8 {
+            (&self.master, irq)
+        } else {
+            (&self.slave, irq - 8)
+        };
+        let mut pic = pic.lock();
+        let imr = pic.data.read();
+        let imr = if masked { imr | (1 << bit) } else { imr & !(1 << bit) };
+        pic.data.write(imr);
+    }
+
     /// 📢 Envia o EOI.
     /// * Se a interrupção veio do Escravo (IRQ 8-15), o EOI deve ser enviado para o Escravo E o Mestre.
     pub unsafe fn notify_end_of_interrupt(&mut self, interrupt_id: u8) {
-        if interrupt_id >= PIC_2_OFFSET {
-            self.slave.lock().send_eoi();
-        }
-        self.master.lock().send_eoi();
+        end_of_interrupt(interrupt_id);
+    }
+}
+
+/// 📢 Envia o EOI sem tomar nenhum Mutex.
+/// * O EOI é um único `outb` na porta de comando, que é atômico por natureza e não
+///   depende do estado guardado em `Pic`; os locks de `PICS` protegem apenas a
+///   sequência de inicialização e as máscaras (IMR).
+///
+/// # Safety
+/// `interrupt_id` deve ser um vetor de IRQ do 8259 remapeado.
+#[inline]
+pub unsafe fn end_of_interrupt(interrupt_id: u8) {
+    const PIC_EOI: u8 = 0x20;
+    if interrupt_id >= PIC_2_OFFSET {
+        Port::<u8>::new(PIC_SLAVE_COMMAND_PORT).write(PIC_EOI);
     }
+    Port::<u8>::new(PIC_MASTER_COMMAND_PORT).write(PIC_EOI);
 }
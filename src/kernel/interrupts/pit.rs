@@ -0,0 +1,20 @@
+// src/kernel/interrupts/pit.rs
+
+use x86_64::instructions::port::Port;
+use crate::RustKernelConfig::arch_hal::{PIT_CHANNEL0_DATA_PORT, PIT_COMMAND_PORT, PIT_INPUT_FREQUENCY_HZ};
+
+/// ⏲️ Programa o canal 0 do PIT 8254 para disparar a IRQ 0 a `hz` interrupções por segundo.
+/// * Sem isso o canal fica no padrão do BIOS (~18,2 Hz), e tudo que converte
+///   tiques em tempo por `TIMER_FREQUENCY_HZ` erra pelo mesmo fator.
+/// * O divisor é arredondado e limitado a 16 bits (mínimo ~18,2 Hz).
+pub unsafe fn set_frequency(hz: u32) {
+    let divisor = ((PIT_INPUT_FREQUENCY_HZ + hz / 2) / hz.max(1)).clamp(1, 0xFFFF) as u16;
+
+    // Canal 0, acesso byte baixo/alto, modo 2 (gerador de taxa), contagem binária.
+    const CHANNEL0_LOHI_RATE_GENERATOR: u8 = 0b00_11_010_0;
+    let mut command: Port<u8> = Port::new(PIT_COMMAND_PORT);
+    let mut data: Port<u8> = Port::new(PIT_CHANNEL0_DATA_PORT);
+    command.write(CHANNEL0_LOHI_RATE_GENERATOR);
+    data.write(divisor as u8);
+    data.write((divisor >> 8) as u8);
+}
@@ -0,0 +1,224 @@
+// src/kernel/interrupts/stats.rs
+
+//! Instrumentação de Latência e Detecção de Tempestades de Interrupção.
+//!
+//! Alimentado pelo stub Assembly comum (`lightos_irq_common` em `irq_handlers_asm.s`),
+//! que lê o TSC na entrada; o despachante lê o TSC novamente após o EOI. Cada
+//! vetor registra mínimo/média/máximo em ciclos e um histograma log2.
+//!
+//! Uma linha que dispara mais de `STORM_THRESHOLD` vezes dentro de uma janela de
+//! `STORM_WINDOW_TICKS` tiques é mascarada automaticamente. O aviso é registrado
+//! fora do contexto de interrupção (`report_storms`) e a linha é desmascarada
+//! após `STORM_COOLDOWN_TICKS`; se a tempestade persistir, ela é mascarada de novo.
+
+use core::arch::x86_64::_rdtsc;
+use core::sync::atomic::{AtomicBool, AtomicU64, Ordering};
+
+use super::dispatch::{self, VECTOR_COUNT};
+
+/// Número de baldes do histograma de duração.
+pub const HISTOGRAM_BUCKETS: usize = 16;
+/// Log2 do limite superior do primeiro balde (< 128 ciclos).
+const HISTOGRAM_FIRST_SHIFT: u32 = 7;
+
+/// Janela de detecção de tempestade, em tiques do temporizador.
+pub const STORM_WINDOW_TICKS: u64 = 10;
+/// Interrupções por janela acima das quais a linha é considerada em tempestade.
+pub const STORM_THRESHOLD: u64 = 50_000;
+/// Tiques que uma linha em tempestade permanece mascarada.
+pub const STORM_COOLDOWN_TICKS: u64 = 100;
+
+/// 📈 Estatísticas de um vetor. Alinhadas à linha de cache para que vetores
+/// diferentes não disputem a mesma linha.
+#[repr(C, align(64))]
+struct VectorStats {
+    samples: AtomicU64,
+    total_cycles: AtomicU64,
+    min_cycles: AtomicU64,
+    max_cycles: AtomicU64,
+    histogram: [AtomicU64; HISTOGRAM_BUCKETS],
+    /// Tique em que a janela de tempestade atual começou.
+    window_start: AtomicU64,
+    /// Interrupções na janela atual.
+    window_count: AtomicU64,
+    /// Tique em que a linha foi mascarada por tempestade (0 = não mascarada).
+    storm_masked_at: AtomicU64,
+    /// Aviso de tempestade pendente de registro.
+    storm_report_pending: AtomicBool,
+}
+
+impl VectorStats {
+    const fn new() -> Self {
+        const ZERO: AtomicU64 = AtomicU64::new(0);
+        VectorStats {
+            samples: AtomicU64::new(0),
+            total_cycles: AtomicU64::new(0),
+            min_cycles: AtomicU64::new(u64::MAX),
+            max_cycles: AtomicU64::new(0),
+            histogram: [ZERO; HISTOGRAM_BUCKETS],
+            window_start: AtomicU64::new(0),
+            window_count: AtomicU64::new(0),
+            storm_masked_at: AtomicU64::new(0),
+            storm_report_pending: AtomicBool::new(false),
+        }
+    }
+}
+
+static STATS: [VectorStats; VECTOR_COUNT] = {
+    const EMPTY: VectorStats = VectorStats::new();
+    [EMPTY; VECTOR_COUNT]
+};
+
+/// Vetores mascarados por tempestade (um bit por vetor): o tique só visita estes.
+static STORM_MASKED: [AtomicU64; VECTOR_COUNT / 64] = {
+    const NONE: AtomicU64 = AtomicU64::new(0);
+    [NONE; VECTOR_COUNT / 64]
+};
+
+/// 📋 Cópia consistente o bastante das estatísticas de um vetor.
+#[derive(Debug, Clone, Copy, Default)]
+pub struct IrqStatsSnapshot {
+    /// Interrupções recebidas (todas as CPUs).
+    pub count: u64,
+    /// Duração mínima do tratamento, em ciclos de TSC.
+    pub min_cycles: u64,
+    /// Duração média do tratamento, em ciclos de TSC.
+    pub avg_cycles: u64,
+    /// Duração máxima do tratamento, em ciclos de TSC.
+    pub max_cycles: u64,
+    /// Balde `i` conta durações em [2^(i+6), 2^(i+7)) ciclos (o primeiro e o
+    /// último são abertos).
+    pub histogram: [u64; HISTOGRAM_BUCKETS],
+    /// A linha está mascarada por tempestade.
+    pub storm_masked: bool,
+}
+
+/// Lê o TSC.
+#[inline(always)]
+pub fn read_tsc() -> u64 {
+    // # SAFETY: RDTSC está disponível em toda CPU x86_64.
+    unsafe { _rdtsc() }
+}
+
+#[inline(always)]
+fn bucket_for(cycles: u64) -> usize {
+    let log2 = 63 - (cycles | 1).leading_zeros();
+    (log2.saturating_sub(HISTOGRAM_FIRST_SHIFT - 1) as usize).min(HISTOGRAM_BUCKETS - 1)
+}
+
+// ------------------------------------------------------------------------
+// --- Caminho de Interrupção ---
+// ------------------------------------------------------------------------
+
+/// ⏱️ Registra uma interrupção tratada em `vector`, entre `entry_tsc` (lido pelo
+/// stub Assembly) e `exit_tsc`. Chamado pelo despachante, com interrupções desabilitadas.
+#[inline]
+pub fn record(vector: u8, entry_tsc: u64, exit_tsc: u64) {
+    let stats = &STATS[vector as usize];
+    let cycles = exit_tsc.wrapping_sub(entry_tsc);
+
+    stats.samples.fetch_add(1, Ordering::Relaxed);
+    stats.total_cycles.fetch_add(cycles, Ordering::Relaxed);
+    stats.min_cycles.fetch_min(cycles, Ordering::Relaxed);
+    stats.max_cycles.fetch_max(cycles, Ordering::Relaxed);
+    stats.histogram[bucket_for(cycles)].fetch_add(1, Ordering::Relaxed);
+
+    if vector != super::TIMER_VECTOR {
+        detect_storm(vector, stats);
+    }
+}
+
+fn detect_storm(vector: u8, stats: &VectorStats) {
+    let now = super::current_tick();
+    let start = stats.window_start.load(Ordering::Relaxed);
+
+    if now.wrapping_sub(start) >= STORM_WINDOW_TICKS {
+        stats.window_start.store(now, Ordering::Relaxed);
+        stats.window_count.store(1, Ordering::Relaxed);
+        return;
+    }
+
+    let count = stats.window_count.fetch_add(1, Ordering::Relaxed) + 1;
+    if count > STORM_THRESHOLD && stats.storm_masked_at.load(Ordering::Relaxed) == 0 {
+        // `max(1)`: o valor 0 significa "não mascarada".
+        stats.storm_masked_at.store(now.max(1), Ordering::Relaxed);
+        stats.storm_report_pending.store(true, Ordering::Release);
+        STORM_MASKED[vector as usize / 64].fetch_or(1 << (vector % 64), Ordering::Release);
+        super::mask_vector_for(vector, super::MaskOwner::Storm);
+    }
+}
+
+// ------------------------------------------------------------------------
+// --- Manutenção (fora do caminho crítico) ---
+// ------------------------------------------------------------------------
+
+/// ⏰ Chamado a cada tique: retira a máscara de tempestade das linhas cujo
+/// resfriamento expirou (uma linha mascarada também por oneshot continua fechada).
+/// * Só os vetores marcados em `STORM_MASKED` são visitados.
+pub fn on_timer_tick(now: u64) {
+    for (word_index, word) in STORM_MASKED.iter().enumerate() {
+        let mut bits = word.load(Ordering::Acquire);
+        while bits != 0 {
+            let bit = bits.trailing_zeros();
+            bits &= bits - 1;
+            let vector = (word_index * 64) as u8 + bit as u8;
+            let stats = &STATS[vector as usize];
+            let masked_at = stats.storm_masked_at.load(Ordering::Relaxed);
+            if now.wrapping_sub(masked_at) < STORM_COOLDOWN_TICKS {
+                continue;
+            }
+            word.fetch_and(!(1 << bit), Ordering::AcqRel);
+            stats.storm_masked_at.store(0, Ordering::Relaxed);
+            stats.window_start.store(now, Ordering::Relaxed);
+            stats.window_count.store(0, Ordering::Relaxed);
+            super::unmask_vector_for(vector, super::MaskOwner::Storm);
+        }
+    }
+}
+
+/// 📝 Registra no log as tempestades detectadas desde a última chamada.
+/// * Chamado pela thread `lightos-irqd`, nunca em contexto de interrupção.
+pub fn report_storms() {
+    for (vector, stats) in STATS.iter().enumerate() {
+        if stats.storm_report_pending.swap(false, Ordering::AcqRel) {
+            crate::println!(
+                "WARN: Tempestade de IRQ no vetor {} (> {} interrupções em {} tiques). Linha mascarada por {} tiques.",
+                vector, STORM_THRESHOLD, STORM_WINDOW_TICKS, STORM_COOLDOWN_TICKS
+            );
+        }
+    }
+}
+
+/// 📋 Retorna as estatísticas do `vector`.
+pub fn snapshot(vector: u8) -> IrqStatsSnapshot {
+    let stats = &STATS[vector as usize];
+    let samples = stats.samples.load(Ordering::Relaxed);
+    let mut histogram = [0u64; HISTOGRAM_BUCKETS];
+    for (dst, src) in histogram.iter_mut().zip(stats.histogram.iter()) {
+        *dst = src.load(Ordering::Relaxed);
+    }
+
+    IrqStatsSnapshot {
+        count: dispatch::irq_count(vector),
+        min_cycles: if samples == 0 { 0 } else { stats.min_cycles.load(Ordering::Relaxed) },
+        avg_cycles: stats.total_cycles.load(Ordering::Relaxed).checked_div(samples).unwrap_or(0),
+        max_cycles: stats.max_cycles.load(Ordering::Relaxed),
+        histogram,
+        storm_masked: stats.storm_masked_at.load(Ordering::Relaxed) != 0,
+    }
+}
+
+/// 🖨️ Imprime as estatísticas de todos os vetores que já receberam interrupções.
+pub fn dump() {
+    crate::println!("--- IRQ: Estatísticas por Vetor (ciclos de TSC) ---");
+    for vector in 0..VECTOR_COUNT {
+        let s = snapshot(vector as u8);
+        if s.count == 0 {
+            continue;
+        }
+        crate::println!("Vetor {:3}: n={} min={} avg={} max={}{}",
+            vector, s.count, s.min_cycles, s.avg_cycles, s.max_cycles,
+            if s.storm_masked { " [MASCARADO: tempestade]" } else { "" });
+    }
+    crate::println!("---------------------------------------------------");
+}
@@ -0,0 +1,307 @@
+// src/kernel/interrupts/threaded.rs
+
+//! Interrupções "Threaded" (Top Half + Bottom Half) com Coalescência para Drivers.
+//!
+//! Um driver registra:
+//! * Um **top half** mínimo, executado em contexto de interrupção: apenas reconhece
+//!   (ack) o dispositivo e diz se há trabalho pendente.
+//! * Um **bottom half**, executado na thread de kernel `lightos-irqd`, com as
+//!   interrupções habilitadas, que faz o trabalho pesado (drenar FIFOs, IPC, etc.).
+//!
+//! A coalescência por dispositivo acorda o bottom half somente quando `max_events`
+//! interrupções se acumularam ou quando a mais antiga espera há `max_delay_ticks`
+//! tiques do temporizador (`super::current_tick`). Dispositivos de alta taxa
+//! (touch, áudio) deixam assim de monopolizar a CPU com uma execução de bottom
+//! half por interrupção.
+
+use core::sync::atomic::{AtomicBool, AtomicU32, AtomicU64, AtomicU8, AtomicUsize, Ordering};
+use x86_64::instructions::interrupts;
+use x86_64::registers::control::Cr3;
+
+use super::dispatch::{self, DispatchError, VECTOR_COUNT};
+
+/// Número máximo de IRQs threaded registradas simultaneamente.
+pub const MAX_THREADED_IRQS: usize = 32;
+
+/// Valor sentinela de "vetor sem slot threaded".
+const NO_SLOT: u8 = 0xFF;
+
+/// ↩️ Resultado do top half.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum IrqReturn {
+    /// A interrupção não era deste dispositivo (linha compartilhada).
+    None,
+    /// Tratada por completo no top half; não há trabalho para o bottom half.
+    Handled,
+    /// Reconhecida; há trabalho pendente para o bottom half.
+    WakeThread,
+}
+
+/// ⏱️ Limiares de coalescência de um dispositivo.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct Coalescing {
+    /// Acorda o bottom half após este número de interrupções pendentes (>= 1).
+    pub max_events: u32,
+    /// Acorda o bottom half quando a interrupção pendente mais antiga tem esta
+    /// idade, em tiques do temporizador (0 = sem limite de tempo).
+    pub max_delay_ticks: u64,
+}
+
+impl Coalescing {
+    /// Sem coalescência: cada interrupção acorda o bottom half.
+    pub const NONE: Coalescing = Coalescing { max_events: 1, max_delay_ticks: 0 };
+}
+
+/// ⚡ Top half: roda com interrupções desabilitadas, antes do EOI.
+pub type TopHalf = fn(vector: u8) -> IrqReturn;
+/// 🧵 Bottom half: roda na thread `lightos-irqd`; recebe quantas interrupções
+/// foram coalescidas desde a última execução.
+pub type BottomHalf = fn(vector: u8, coalesced: u32);
+
+/// 🚨 Erros de registro de IRQs threaded.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum ThreadedIrqError {
+    /// Todos os `MAX_THREADED_IRQS` slots estão ocupados.
+    NoFreeSlot,
+    /// `max_events` deve ser pelo menos 1.
+    InvalidCoalescing,
+    /// Erro vindo da tabela de despacho (vetor reservado ou já registrado).
+    Dispatch(DispatchError),
+    /// Não há IRQ threaded registrada neste vetor.
+    NotRegistered,
+}
+
+/// Estados de um slot.
+const SLOT_FREE: u8 = 0;
+/// Reservado por um registrador, que ainda preenche os campos.
+const SLOT_CLAIMED: u8 = 1;
+const SLOT_READY: u8 = 2;
+
+/// 📌 Estado de uma IRQ threaded registrada.
+/// * Todos os campos são atômicos: um slot liberado e reaproveitado pode ainda
+///   ser lido por um top half em andamento em outra CPU (que vê a configuração
+///   antiga ou a nova, nunca memória inválida).
+struct ThreadedIrq {
+    state: AtomicU8,
+    vector: AtomicU8,
+    /// `TopHalf` e `BottomHalf` como `usize` (mesmo modelo da tabela de despacho).
+    top_half: AtomicUsize,
+    bottom_half: AtomicUsize,
+    max_events: AtomicU32,
+    max_delay_ticks: AtomicU64,
+    /// Se `true`, a linha fica mascarada enquanto o bottom half está pendente
+    /// (equivalente ao IRQF_ONESHOT: o dispositivo não interrompe de novo até ser servido).
+    oneshot: AtomicBool,
+    /// Interrupções acumuladas desde a última execução do bottom half.
+    pending: AtomicU32,
+    /// Tique em que a interrupção pendente mais antiga chegou.
+    first_pending_tick: AtomicU64,
+    /// Linha mascarada pelo modo oneshot.
+    masked: AtomicBool,
+}
+
+impl ThreadedIrq {
+    const fn new() -> Self {
+        ThreadedIrq {
+            state: AtomicU8::new(SLOT_FREE),
+            vector: AtomicU8::new(0),
+            top_half: AtomicUsize::new(0),
+            bottom_half: AtomicUsize::new(0),
+            max_events: AtomicU32::new(1),
+            max_delay_ticks: AtomicU64::new(0),
+            oneshot: AtomicBool::new(false),
+            pending: AtomicU32::new(0),
+            first_pending_tick: AtomicU64::new(0),
+            masked: AtomicBool::new(false),
+        }
+    }
+
+    fn is_ready(&self) -> bool {
+        self.state.load(Ordering::Acquire) == SLOT_READY
+    }
+
+    fn top_half(&self) -> TopHalf {
+        // # SAFETY: Só ponteiros `TopHalf` válidos são gravados antes de `SLOT_READY`.
+        unsafe { core::mem::transmute::<usize, TopHalf>(self.top_half.load(Ordering::Relaxed)) }
+    }
+
+    fn bottom_half(&self) -> BottomHalf {
+        // # SAFETY: Só ponteiros `BottomHalf` válidos são gravados antes de `SLOT_READY`.
+        unsafe { core::mem::transmute::<usize, BottomHalf>(self.bottom_half.load(Ordering::Relaxed)) }
+    }
+}
+
+static SLOTS: [ThreadedIrq; MAX_THREADED_IRQS] = {
+    const EMPTY: ThreadedIrq = ThreadedIrq::new();
+    [EMPTY; MAX_THREADED_IRQS]
+};
+
+/// Vetor -> índice do slot (ou `NO_SLOT`).
+static SLOT_OF_VECTOR: [AtomicU8; VECTOR_COUNT] = {
+    const NONE: AtomicU8 = AtomicU8::new(NO_SLOT);
+    [NONE; VECTOR_COUNT]
+};
+
+/// Bitmap de slots cujo bottom half deve rodar (um bit por slot).
+static WAKE_MASK: AtomicU32 = AtomicU32::new(0);
+
+// ------------------------------------------------------------------------
+// --- API de Registro ---
+// ------------------------------------------------------------------------
+
+/// ➕ Registra uma IRQ threaded para `vector`.
+pub fn request_threaded_irq(
+    vector: u8,
+    top_half: TopHalf,
+    bottom_half: BottomHalf,
+    coalescing: Coalescing,
+    oneshot: bool,
+) -> Result<(), ThreadedIrqError> {
+    if coalescing.max_events == 0 {
+        return Err(ThreadedIrqError::InvalidCoalescing);
+    }
+
+    // Reserva o primeiro slot livre (o `compare_exchange` garante um único vencedor).
+    let index = SLOTS
+        .iter()
+        .position(|slot| {
+            slot.state.compare_exchange(SLOT_FREE, SLOT_CLAIMED, Ordering::Acquire, Ordering::Relaxed).is_ok()
+        })
+        .ok_or(ThreadedIrqError::NoFreeSlot)?;
+    let irq = &SLOTS[index];
+    irq.vector.store(vector, Ordering::Relaxed);
+    irq.top_half.store(top_half as usize, Ordering::Relaxed);
+    irq.bottom_half.store(bottom_half as usize, Ordering::Relaxed);
+    irq.max_events.store(coalescing.max_events, Ordering::Relaxed);
+    irq.max_delay_ticks.store(coalescing.max_delay_ticks, Ordering::Relaxed);
+    irq.oneshot.store(oneshot, Ordering::Relaxed);
+    irq.pending.store(0, Ordering::Relaxed);
+    irq.masked.store(false, Ordering::Relaxed);
+    irq.state.store(SLOT_READY, Ordering::Release);
+
+    // O handler entra antes do índice: um vetor já registrado por outro dono
+    // não tem o seu slot sobrescrito (e um top half sem índice não faz nada).
+    if let Err(e) = dispatch::register_handler(vector, threaded_top_half) {
+        irq.state.store(SLOT_FREE, Ordering::Release);
+        return Err(ThreadedIrqError::Dispatch(e));
+    }
+    SLOT_OF_VECTOR[vector as usize].store(index as u8, Ordering::Release);
+    Ok(())
+}
+
+/// ➖ Remove a IRQ threaded de `vector` (desfaz `request_threaded_irq`).
+/// * O chamador mascara a linha antes: um top half já em andamento em outra CPU
+///   ainda pode rodar uma última vez. Um bottom half pendente é descartado.
+/// * Libera a máscara do modo oneshot, se estiver aplicada.
+pub fn free_threaded_irq(vector: u8) -> Result<(), ThreadedIrqError> {
+    let index = SLOT_OF_VECTOR[vector as usize].swap(NO_SLOT, Ordering::AcqRel);
+    let irq = SLOTS.get(index as usize).ok_or(ThreadedIrqError::NotRegistered)?;
+    let _ = dispatch::unregister_handler(vector);
+
+    WAKE_MASK.fetch_and(!(1 << index), Ordering::AcqRel);
+    irq.pending.store(0, Ordering::Release);
+    if irq.masked.swap(false, Ordering::AcqRel) {
+        super::unmask_vector_for(vector, super::MaskOwner::Oneshot);
+    }
+    irq.state.store(SLOT_FREE, Ordering::Release);
+    Ok(())
+}
+
+// ------------------------------------------------------------------------
+// --- Caminho de Interrupção (Top Half) ---
+// ------------------------------------------------------------------------
+
+/// Handler genérico instalado na tabela de despacho para toda IRQ threaded.
+fn threaded_top_half(vector: u8) {
+    let index = SLOT_OF_VECTOR[vector as usize].load(Ordering::Acquire);
+    let irq = match SLOTS.get(index as usize) {
+        Some(irq) if irq.is_ready() => irq,
+        _ => return,
+    };
+
+    if (irq.top_half())(vector) != IrqReturn::WakeThread {
+        return;
+    }
+
+    let pending = irq.pending.fetch_add(1, Ordering::AcqRel) + 1;
+    if pending == 1 {
+        irq.first_pending_tick.store(super::current_tick(), Ordering::Relaxed);
+    }
+
+    if irq.oneshot.load(Ordering::Relaxed) && !irq.masked.swap(true, Ordering::AcqRel) {
+        super::mask_vector_for(vector, super::MaskOwner::Oneshot);
+    }
+
+    if pending >= irq.max_events.load(Ordering::Relaxed) {
+        WAKE_MASK.fetch_or(1 << index, Ordering::Release);
+    }
+}
+
+/// ⏰ Chamado a cada tique (via `super::on_timer_tick`): acorda os bottom halves
+/// cujo limite de atraso expirou.
+pub fn on_timer_tick(now: u64) {
+    for (index, irq) in SLOTS.iter().enumerate() {
+        if !irq.is_ready() {
+            continue;
+        }
+        let delay = irq.max_delay_ticks.load(Ordering::Relaxed);
+        if delay == 0 || irq.pending.load(Ordering::Acquire) == 0 {
+            continue;
+        }
+        if now.wrapping_sub(irq.first_pending_tick.load(Ordering::Relaxed)) >= delay {
+            WAKE_MASK.fetch_or(1 << index, Ordering::Release);
+        }
+    }
+}
+
+// ------------------------------------------------------------------------
+// --- Thread de Bottom Halves (lightos-irqd) ---
+// ------------------------------------------------------------------------
+
+/// 🧵 Executa todos os bottom halves sinalizados. Retorna `true` se algum rodou.
+fn run_pending_bottom_halves() -> bool {
+    let mut mask = WAKE_MASK.swap(0, Ordering::AcqRel);
+    let ran = mask != 0;
+
+    while mask != 0 {
+        let index = mask.trailing_zeros() as usize;
+        mask &= mask - 1;
+
+        let irq = &SLOTS[index];
+        if irq.is_ready() {
+            let vector = irq.vector.load(Ordering::Relaxed);
+            let coalesced = irq.pending.swap(0, Ordering::AcqRel);
+            if coalesced != 0 {
+                (irq.bottom_half())(vector, coalesced);
+            }
+            if irq.oneshot.load(Ordering::Relaxed) && irq.masked.swap(false, Ordering::AcqRel) {
+                super::unmask_vector_for(vector, super::MaskOwner::Oneshot);
+            }
+        }
+    }
+    ran
+}
+
+/// 🔁 Laço principal da thread de kernel `lightos-irqd`.
+extern "C" fn irq_thread_main() {
+    loop {
+        super::stats::report_storms();
+        if !run_pending_bottom_halves() {
+            // Nada pendente: dorme até a próxima interrupção (sem janela de corrida
+            // entre o teste e o HLT, graças ao `sti; hlt` atômico).
+            interrupts::disable();
+            if WAKE_MASK.load(Ordering::Acquire) == 0 {
+                interrupts::enable_and_hlt();
+            } else {
+                interrupts::enable();
+            }
+        }
+    }
+}
+
+/// 🚀 Cria a thread de kernel dos bottom halves (chamado do kernel_main, após o Scheduler).
+pub fn initialize() {
+    let (kernel_p4, _) = Cr3::read();
+    crate::task::spawn_task(irq_thread_main, kernel_p4.start_address());
+    crate::println!("INFO: Thread de IRQs (lightos-irqd) criada.");
+}
@@ -1,6 +1,6 @@
 // src/kernel/ipc/manager.rs
 
-use super::message::{Message, IpcResult, Endpoint};
+use super::message::{Message, IpcError, IpcKind, IpcResult, Endpoint};
 use spin::{Mutex, Once}; 
 
 /// 📚 Tabela Global para mapear Endpoints para Endereços de Caixa de Entrada.
@@ -109,6 +109,20 @@ pub fn receive_message(receiver: Endpoint) -> IpcResult<Message> {
     }
 }
 
+/// 🔔 Notificação leve: entrega `word` ao `destination` como `IpcKind::Notification`.
+///
+/// Se a caixa de entrada já tem uma mensagem pendente, a notificação é coalescida
+/// (o receptor ainda vai acordar e consultar o estado compartilhado) e a chamada
+/// retorna `Ok`.
+pub fn notify(destination: Endpoint, sender: Endpoint, word: u64) -> IpcResult<()> {
+    let mut payload = [0u8; 48];
+    payload[..8].copy_from_slice(&word.to_le_bytes());
+    match send_message(destination, Message { sender, kind: IpcKind::Notification, payload }) {
+        Err(IpcError::InvalidEndpointState) => Ok(()),
+        result => result,
+    }
+}
+
 /// 📝 Registra um novo endpoint no sistema.
 pub fn register_endpoint(endpoint: Endpoint) -> IpcResult<()> {
     if let Some(map) = ENDPOINT_MAP.get() {
@@ -10,7 +10,7 @@ mod manager;
 
 // Exporta tipos e funções públicas
 pub use message::{Message, IpcError, IpcResult, Endpoint, IpcKind};
-pub use manager::{IpcManager, send_message, receive_message, register_endpoint};
+pub use manager::{IpcManager, send_message, receive_message, register_endpoint, notify};
 
 // Funções de inicialização do subsistema IPC
 // Esta é a função que o código de inicialização do Kernel C/Rust chamaria.
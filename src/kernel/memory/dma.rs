@@ -0,0 +1,102 @@
+// src/kernel/memory/dma.rs
+
+//! Buffers de DMA para Drivers de Dispositivos.
+//!
+//! Um `DmaBuffer` é um bloco de frames fisicamente contíguos (o dispositivo só
+//! conhece endereços físicos), acessado pela CPU através do mapeamento linear da
+//! memória física. No x86 o DMA é coerente com as caches: não há flush manual,
+//! apenas barreiras de ordem entre a escrita dos dados e o aviso ao dispositivo.
+
+use alloc::vec::Vec;
+use spin::Mutex;
+use x86_64::structures::paging::{PageSize, Size4KiB};
+use x86_64::PhysAddr;
+
+use super::frame_alloc::FRAME_ALLOCATOR;
+use crate::RustKernelConfig::arch_hal::KERNEL_HH_BASE;
+
+/// 🚨 Erros de alocação de DMA.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum DmaError {
+    /// Tamanho zero.
+    InvalidSize,
+    /// Sem frames contíguos livres.
+    OutOfMemory,
+}
+
+/// Blocos devolvidos, reaproveitados por `DmaBuffer::new` (o PMM sequencial não recebe frames de volta).
+static FREE_BLOCKS: Mutex<Vec<(PhysAddr, u64)>> = Mutex::new(Vec::new());
+
+/// 📦 Memória fisicamente contígua, zerada na alocação e devolvida no `Drop`.
+pub struct DmaBuffer {
+    phys: PhysAddr,
+    pages: u64,
+    len: usize,
+}
+
+// # SAFETY: O buffer é dono exclusivo dos seus frames.
+unsafe impl Send for DmaBuffer {}
+
+impl DmaBuffer {
+    /// 🏭 Aloca pelo menos `len` bytes contíguos, alinhados a 4 KiB.
+    pub fn new(len: usize) -> Result<Self, DmaError> {
+        if len == 0 {
+            return Err(DmaError::InvalidSize);
+        }
+        let pages = (len as u64 + Size4KiB::SIZE - 1) / Size4KiB::SIZE;
+
+        // Reaproveita o menor bloco livre que comporte o pedido.
+        let recycled = {
+            let mut free = FREE_BLOCKS.lock();
+            free.iter()
+                .enumerate()
+                .filter(|(_, &(_, p))| p >= pages)
+                .min_by_key(|(_, &(_, p))| p)
+                .map(|(index, _)| index)
+                .map(|index| free.swap_remove(index))
+        };
+        let (phys, pages) = match recycled {
+            Some(block) => block,
+            None => {
+                let frame = FRAME_ALLOCATOR.lock().allocate_contiguous(pages).ok_or(DmaError::OutOfMemory)?;
+                (frame.start_address(), pages)
+            }
+        };
+
+        let buffer = DmaBuffer { phys, pages, len };
+        // # SAFETY: Os frames pertencem ao buffer e são acessíveis pelo mapeamento linear.
+        unsafe { core::ptr::write_bytes(buffer.as_mut_ptr(), 0, (pages * Size4KiB::SIZE) as usize) };
+        Ok(buffer)
+    }
+
+    /// Endereço físico (o que se entrega ao dispositivo).
+    #[inline]
+    pub fn phys_addr(&self) -> PhysAddr {
+        self.phys
+    }
+
+    /// Tamanho pedido, em bytes.
+    #[inline]
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    /// Ponteiro para o buffer no espaço do kernel.
+    #[inline]
+    pub fn as_mut_ptr(&self) -> *mut u8 {
+        (KERNEL_HH_BASE as u64 + self.phys.as_u64()) as *mut u8
+    }
+
+    /// 📄 Conteúdo do buffer.
+    /// * O dispositivo pode escrever nele a qualquer momento se estiver com ele.
+    pub fn as_slice_mut(&mut self) -> &mut [u8] {
+        // # SAFETY: `len` bytes dentro dos frames do buffer; `&mut self` dá exclusividade à CPU.
+        unsafe { core::slice::from_raw_parts_mut(self.as_mut_ptr(), self.len) }
+    }
+}
+
+impl Drop for DmaBuffer {
+    fn drop(&mut self) {
+        FREE_BLOCKS.lock().push((self.phys, self.pages));
+    }
+}
@@ -1,10 +1,11 @@
 // src/kernel/memory/frame_alloc.rs
 
 use x86_64::{
-    structures::paging::{PageSize, Size4KiB, FrameAllocator},
+    structures::paging::{PageSize, PhysFrame, Size4KiB, FrameAllocator},
     PhysAddr,
 };
 use core::fmt;
+use spin::Mutex;
 
 // Definição de tipos para clareza
 pub type PhysicalAddress = PhysAddr;
@@ -17,6 +18,9 @@ pub enum PmmError {
     InvalidInfo,
 }
 
+/// 🌐 PMM global do kernel (preenchido por `paging::init_paging_and_heap`).
+pub static FRAME_ALLOCATOR: Mutex<PhysicalMemoryManager> = Mutex::new(PhysicalMemoryManager::new());
+
 /// 🧠 Implementação simples de um Gerenciador de Quadros Físicos (PMM).
 /// * Em um kernel real, isso seria um Bitmap Allocator ou Buddy Allocator.
 pub struct PhysicalMemoryManager {
@@ -69,29 +73,34 @@ impl PhysicalMemoryManager {
     }
 }
 
-// Implementa o Trait FrameAllocator do x86_64
-unsafe impl FrameAllocator<Size4KiB> for PhysicalMemoryManager {
-    fn allocate_frame(&mut self) -> Option<x86_64::structures::paging::PhysFrame<Size4KiB>> {
-        // Implementação simplificada: aloca frames sequencialmente.
-        let frame = PhysFrame::containing_address(self.next_free_frame);
-        
-        // Verificação simplificada se o frame está dentro de uma região disponível
-        // (Lógica real exigiria verificar todas as regiões e marcar frames como usados)
-        let frame_addr = frame.start_address().as_u64();
-        let frame_size = Size4KiB::SIZE;
+impl PhysicalMemoryManager {
+    /// 🧱 Aloca `count` frames fisicamente contíguos (buffers compartilhados, DMA).
+    /// * Se a região atual não comporta o bloco, salta para a próxima região que comporte.
+    pub fn allocate_contiguous(&mut self, count: u64) -> Option<PhysFrame<Size4KiB>> {
+        let bytes = count.checked_mul(Size4KiB::SIZE)?;
+        let next = self.next_free_frame.align_up(Size4KiB::SIZE).as_u64();
 
         for i in 0..self.region_count {
             let (start, len) = self.available_regions[i];
-            let end = start.as_u64() + len;
-
-            if frame_addr >= start.as_u64() && (frame_addr + frame_size) <= end {
-                // Encontrado: Atualiza para o próximo frame
-                self.next_free_frame = PhysAddr::new(frame_addr + frame_size);
-                return Some(frame);
+            let (start, end) = (start.as_u64(), start.as_u64() + len);
+            if end <= next {
+                continue; // Região já consumida pelo alocador sequencial.
+            }
+            let base = PhysAddr::new(next.max(start)).align_up(Size4KiB::SIZE).as_u64();
+            if base + bytes <= end {
+                self.next_free_frame = PhysAddr::new(base + bytes);
+                return Some(PhysFrame::containing_address(PhysAddr::new(base)));
             }
         }
-        
-        // Nenhum frame livre na região sequencial atual.
         None
     }
 }
+
+// Implementa o Trait FrameAllocator do x86_64
+unsafe impl FrameAllocator<Size4KiB> for PhysicalMemoryManager {
+    fn allocate_frame(&mut self) -> Option<x86_64::structures::paging::PhysFrame<Size4KiB>> {
+        // Implementação simplificada: aloca frames sequencialmente, saltando
+        // para a próxima região quando a atual se esgota.
+        self.allocate_contiguous(1)
+    }
+}
@@ -10,6 +10,9 @@ use x86_64::VirtAddr;
 // Importa os submódulos
 mod frame_alloc;
 mod heap_alloc;
+pub mod dma;
+pub mod paging;
+pub mod shared;
 
 // Exporta as APIs públicas
 pub use frame_alloc::{
@@ -17,6 +20,7 @@ pub use frame_alloc::{
     FrameAllocator, 
     PmmError, 
     PhysicalAddress,
+    FRAME_ALLOCATOR,
 };
 pub use heap_alloc::{
     allocator, 
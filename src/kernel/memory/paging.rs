@@ -7,14 +7,22 @@
 
 use x86_64::{
     structures::paging::{
-        Page, PageTable, PageTableFlags, PhysFrame, Size4KiB, Mapper,
+        Page, PageSize, PageTable, PageTableFlags, PhysFrame, Size4KiB, Mapper,
         OffsetPageTable, FrameAllocator, page_table,
     },
     PhysAddr, VirtAddr,
 };
+use core::arch::x86_64::__cpuid;
 use core::ptr::NonNull;
+use core::sync::atomic::{AtomicBool, AtomicU64, Ordering};
+use spin::{Mutex, Once};
+use x86_64::registers::control::Cr3;
+use x86_64::registers::model_specific::Msr;
+use x86_64::structures::paging::mapper::MapToError;
 
-use super::{frame_alloc::PhysicalMemoryManager, MemoryError};
+use super::{frame_alloc::{PhysicalMemoryManager, FRAME_ALLOCATOR}, MemoryError};
+use crate::multiboot2::{BootInfo, MemoryRegionKind};
+use crate::RustKernelConfig::arch_hal::{MMIO_VIRT_BASE, MMIO_VIRT_SIZE, RESERVED_LOW_PHYS_END};
 
 // ------------------------------------------------------------------------
 // --- Endereços de Configuração ---
@@ -24,6 +32,9 @@ use super::{frame_alloc::PhysicalMemoryManager, MemoryError};
 /// (Deve ser o mesmo que KERNEL_HH_BASE em x86_64_arch.hal)
 const KERNEL_OFFSET: u64 = 0xFFFF_8000_0000_0000;
 
+/// Fim (exclusivo) da metade de usuário do espaço de endereçamento canônico.
+const USER_SPACE_END: u64 = 0x0000_8000_0000_0000;
+
 // ------------------------------------------------------------------------
 // --- Gerenciador de Mapeamento Principal ---
 // ------------------------------------------------------------------------
@@ -31,6 +42,16 @@ const KERNEL_OFFSET: u64 = 0xFFFF_8000_0000_0000;
 /// 🗺️ Alias para o nosso gerenciador de mapeamento de páginas.
 pub type KernelMapper = OffsetPageTable<'static>;
 
+/// 🌐 Mapper global do kernel (criado em `init_paging_and_heap`).
+static KERNEL_MAPPER: Once<Mutex<KernelMapper>> = Once::new();
+/// Endereço físico da P4 do kernel (o CR3 ativo durante o boot).
+static KERNEL_P4: Once<PhysAddr> = Once::new();
+
+/// P4 (CR3) do espaço de endereçamento do kernel.
+pub fn kernel_p4() -> Option<PhysAddr> {
+    KERNEL_P4.get().copied()
+}
+
 /// 🏭 Cria um novo gerenciador de mapeamento de páginas (KernelMapper).
 /// 
 /// Assume que o mapeamento recursivo de 4 níveis já está configurado e acessível.
@@ -112,44 +133,46 @@ pub fn create_mapping(
 /// # Safety
 /// É altamente inseguro, pois modifica tabelas de páginas globais e inicializa o heap.
 pub unsafe fn init_paging_and_heap(
-    multiboot2_info_ptr: u64,
+    boot_info: &BootInfo,
     mut pmm: PhysicalMemoryManager,
     heap_start_addr: VirtAddr,
     heap_size: usize,
 ) -> Result<(), MemoryError> {
     
-    // 1. Inicializa o PMM (Gerenciador de Quadros Físicos)
-    // * Aqui você leria o multiboot2_info_ptr para preencher as regiões livres do PMM.
-    // Exemplo: pmm.add_available_region(...); 
+    // 1. Inicializa o PMM (Gerenciador de Quadros Físicos) com a RAM livre do Multiboot2,
+    //    menos os módulos de boot (que o bootloader pode carregar acima de
+    //    `RESERVED_LOW_PHYS_END` e que são lidos pelo mapeamento linear).
+    for region in boot_info.memory_map().filter(|r| r.kind == MemoryRegionKind::Available) {
+        let mut start = region.base.max(RESERVED_LOW_PHYS_END as u64);
+        let end = region.base + region.length;
+        while start < end {
+            // Próximo módulo que toca [start, end): a RAM livre vai até o início dele.
+            let module = boot_info
+                .modules()
+                .filter(|m| m.start < end && m.end > start)
+                .min_by_key(|m| m.start);
+            let (free_end, next) = match module {
+                Some(m) => (m.start.max(start), m.end),
+                None => (end, end),
+            };
+            let free_start = PhysAddr::new(start).align_up(Size4KiB::SIZE);
+            let free_end = PhysAddr::new(free_end).align_down(Size4KiB::SIZE);
+            if free_end > free_start {
+                pmm.add_available_region(free_start, free_end - free_start);
+            }
+            start = next;
+        }
+    }
+    pmm.log_initialized_regions();
+    *FRAME_ALLOCATOR.lock() = pmm;
     
     // 2. Inicializa o Kernel Mapper
-    let mut mapper = init_kernel_mapper();
-    
+    KERNEL_P4.call_once(|| Cr3::read().0.start_address());
+    KERNEL_MAPPER.call_once(|| Mutex::new(init_kernel_mapper()));
     crate::println!("INFO: Kernel Mapper inicializado. (Offset: {:#x})", KERNEL_OFFSET);
 
-    // 3. Configuração de Mapeamento Inicial (Exemplo: Mapear o Framebuffer)
-    // (O Framebuffer é MMIO e precisa ser mapeado no espaço virtual do Kernel)
-    let fb_phys_addr = PhysAddr::new(0xE000_0000); // Exemplo de endereço de MMIO do FB
-    let fb_virt_addr = VirtAddr::new(KERNEL_OFFSET + 0x100_0000); // Endereço virtual
-    
-    let fb_page: Page = Page::containing_address(fb_virt_addr);
-    let fb_frame: PhysFrame = PhysFrame::containing_address(fb_phys_addr);
-
-    // Mapear o frame do FB para a página virtual, tornando-o acessível.
-    let fb_flags = PageTableFlags::PRESENT | PageTableFlags::WRITABLE | PageTableFlags::NO_CACHE;
-
-    let map_result = mapper.map_to(fb_page, fb_frame, fb_flags, &mut pmm);
-
-    match map_result {
-        Ok(tlb_flush) => {
-            tlb_flush.flush();
-            crate::println!("INFO: Framebuffer mapeado para {:#x}", fb_virt_addr.as_u64());
-        },
-        Err(e) => {
-            crate::println!("ERRO: Falha ao mapear Framebuffer: {:?}", e);
-            return Err(MemoryError::PagingError);
-        }
-    }
+    // 3. Tipos de memória: reprograma o PAT para oferecer Write-Combining (framebuffer).
+    init_pat();
 
     // 4. Inicializa o Heap do Kernel (K-Heap)
     // O Heap deve ser inicializado APÓS ter sido mapeado na tabela de páginas.
@@ -162,6 +185,225 @@ pub unsafe fn init_paging_and_heap(
     }
 }
 
+/// 🔗 Mapeia `pages` páginas contíguas de `phys` em `virt`, no espaço de
+/// endereçamento cuja P4 está em `p4_phys` (o do kernel ou o de uma tarefa).
+///
+/// # Safety
+/// Os frames devem pertencer ao chamador (não à RAM livre do PMM) e `virt` deve
+/// estar livre no espaço de endereçamento alvo.
+pub unsafe fn map_frames_in(
+    p4_phys: PhysAddr,
+    virt: VirtAddr,
+    phys: PhysAddr,
+    pages: u64,
+    flags: PageTableFlags,
+) -> Result<(), MemoryError> {
+    let kernel_mapper = KERNEL_MAPPER.get().ok_or(MemoryError::InvalidMapping)?;
+    let mut kernel_mapper = kernel_mapper.lock();
+    let mut allocator = FRAME_ALLOCATOR.lock();
+
+    // O espaço do kernel usa o mapper global; outros recebem um mapper temporário
+    // (o lock do global continua tomado: serializa toda edição de tabelas).
+    let mut task_mapper;
+    let mapper: &mut KernelMapper = if Some(&p4_phys) == KERNEL_P4.get() {
+        &mut kernel_mapper
+    } else {
+        let p4 = &mut *((KERNEL_OFFSET + p4_phys.as_u64()) as *mut PageTable);
+        task_mapper = OffsetPageTable::new(p4, VirtAddr::new(KERNEL_OFFSET));
+        &mut task_mapper
+    };
+
+    for i in 0..pages {
+        let page: Page<Size4KiB> = Page::containing_address(virt + i * Size4KiB::SIZE);
+        let frame = PhysFrame::containing_address(phys + i * Size4KiB::SIZE);
+        match mapper.map_to(page, frame, flags, &mut *allocator) {
+            Ok(flush) => flush.flush(),
+            // Mapeamento idêntico já existente (ex: região mapeada de novo): nada a fazer.
+            Err(MapToError::PageAlreadyMapped(existing)) if existing == frame => {}
+            Err(MapToError::FrameAllocationFailed) => return Err(MemoryError::FrameAllocationFailed),
+            Err(_) => return Err(MemoryError::PagingError),
+        }
+    }
+    Ok(())
+}
+
+/// 🧹 Desfaz `pages` páginas a partir de `virt` no espaço com P4 `p4_phys`
+/// (páginas já ausentes são ignoradas). Os frames não são liberados.
+/// * A TLB local é invalidada página a página; um espaço que não está ativo
+///   não tem entradas na TLB (sem PCID, a troca de CR3 as descarta).
+///
+/// # Safety
+/// O chamador garante que nada mais usa as páginas desfeitas.
+pub unsafe fn unmap_frames_in(p4_phys: PhysAddr, virt: VirtAddr, pages: u64) -> Result<(), MemoryError> {
+    let kernel_mapper = KERNEL_MAPPER.get().ok_or(MemoryError::InvalidMapping)?;
+    let mut kernel_mapper = kernel_mapper.lock();
+
+    let mut task_mapper;
+    let mapper: &mut KernelMapper = if Some(&p4_phys) == KERNEL_P4.get() {
+        &mut kernel_mapper
+    } else {
+        let p4 = &mut *((KERNEL_OFFSET + p4_phys.as_u64()) as *mut PageTable);
+        task_mapper = OffsetPageTable::new(p4, VirtAddr::new(KERNEL_OFFSET));
+        &mut task_mapper
+    };
+
+    for i in 0..pages {
+        let page: Page<Size4KiB> = Page::containing_address(virt + i * Size4KiB::SIZE);
+        if let Ok((_, flush)) = mapper.unmap(page) {
+            flush.flush();
+        }
+    }
+    Ok(())
+}
+
+/// 📤 Copia `src` para o endereço de usuário `dst` do espaço ativo (CR3).
+/// * Falha com `InvalidMapping`, sem copiar nada, se `[dst, dst + len)` sai da
+///   metade de usuário ou tem alguma página ausente, não gravável ou de kernel.
+/// * O lock do mapper global fica tomado durante a cópia: nenhuma página do
+///   intervalo é desfeita entre a verificação e a escrita.
+pub fn copy_to_user(dst: u64, src: &[u8]) -> Result<(), MemoryError> {
+    let kernel_mapper = KERNEL_MAPPER.get().ok_or(MemoryError::InvalidMapping)?;
+    let _tables = kernel_mapper.lock();
+    let (p4, _) = Cr3::read();
+
+    let end = dst.checked_add(src.len() as u64).ok_or(MemoryError::InvalidMapping)?;
+    if end > USER_SPACE_END {
+        return Err(MemoryError::InvalidMapping);
+    }
+    if src.is_empty() {
+        return Ok(());
+    }
+    let mut page = dst & !(Size4KiB::SIZE - 1);
+    while page < end {
+        // # SAFETY: `p4` é a P4 ativa e as tabelas estão no mapa físico do kernel.
+        let size = unsafe { user_writable_page(p4.start_address(), page) }.ok_or(MemoryError::InvalidMapping)?;
+        page = (page & !(size - 1)) + size;
+    }
+
+    // # SAFETY: O intervalo inteiro está mapeado, é de usuário e gravável.
+    unsafe { core::ptr::copy_nonoverlapping(src.as_ptr(), dst as *mut u8, src.len()) };
+    Ok(())
+}
+
+/// Percorre as tabelas de `p4_phys` até a página que contém `addr` e retorna o
+/// seu tamanho (4 KiB, 2 MiB ou 1 GiB) se todos os níveis são presentes, de
+/// usuário e graváveis (a CPU exige os bits em todos os níveis).
+///
+/// # Safety
+/// `p4_phys` deve ser uma P4 válida, e o chamador segura o lock do mapper global.
+unsafe fn user_writable_page(p4_phys: PhysAddr, addr: u64) -> Option<u64> {
+    let required = PageTableFlags::PRESENT | PageTableFlags::USER_ACCESSIBLE | PageTableFlags::WRITABLE;
+    let virt = VirtAddr::new(addr);
+    let indices = [virt.p4_index(), virt.p3_index(), virt.p2_index(), virt.p1_index()];
+    // Tamanho coberto por uma entrada de P3, P2 e P1.
+    let sizes = [0, 1 << 30, 1 << 21, Size4KiB::SIZE];
+
+    let mut table = &*((KERNEL_OFFSET + p4_phys.as_u64()) as *const PageTable);
+    for (level, index) in indices.iter().enumerate() {
+        let entry = &table[*index];
+        if !entry.flags().contains(required) {
+            return None;
+        }
+        if level == 3 || (level > 0 && entry.flags().contains(PageTableFlags::HUGE_PAGE)) {
+            return Some(sizes[level]);
+        }
+        table = &*((KERNEL_OFFSET + entry.addr().as_u64()) as *const PageTable);
+    }
+    None
+}
+
+// ------------------------------------------------------------------------
+// --- Mapeamento de MMIO (Tipos de Cache via PAT) ---
+// ------------------------------------------------------------------------
+
+/// MSR IA32_PAT.
+const IA32_PAT: u32 = 0x277;
+/// Valor do PAT após o reset, com a entrada PA1 (PWT=1, PCD=0) trocada de
+/// Write-Through (0x04) para Write-Combining (0x01). As demais mantêm o padrão.
+const PAT_WITH_WC: u64 = 0x0007_0406_0007_0106;
+
+/// `true` se a entrada PA1 do PAT foi reprogramada para Write-Combining.
+static PAT_WC_ENABLED: AtomicBool = AtomicBool::new(false);
+
+/// Próximo endereço livre da janela de MMIO (alocação sequencial, nunca liberada).
+static NEXT_MMIO_VIRT: AtomicU64 = AtomicU64::new(MMIO_VIRT_BASE as u64);
+
+/// 🧊 Tipo de cache de um mapeamento de MMIO.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum CacheMode {
+    /// Uncached: registradores de dispositivos (leituras/escritas com efeito colateral).
+    Uncached,
+    /// Write-Combining: escritas em rajada, sem leituras especulativas (framebuffer).
+    /// * Cai para `Uncached` se a CPU não tem PAT.
+    WriteCombining,
+}
+
+impl CacheMode {
+    fn page_flags(self) -> PageTableFlags {
+        match self {
+            CacheMode::WriteCombining if PAT_WC_ENABLED.load(Ordering::Relaxed) => PageTableFlags::WRITE_THROUGH,
+            _ => PageTableFlags::NO_CACHE | PageTableFlags::WRITE_THROUGH,
+        }
+    }
+}
+
+/// ⚙️ Reprograma o PAT da CPU atual (CPUID.01h:EDX[16]).
+/// * Deve ser repetido em cada CPU com o mesmo valor (o PAT é por CPU).
+unsafe fn init_pat() {
+    // # SAFETY: CPUID está disponível em toda CPU x86_64.
+    if __cpuid(1).edx & (1 << 16) == 0 {
+        crate::println!("WARN: CPU sem PAT; framebuffer ficará Uncached.");
+        return;
+    }
+
+    x86_64::instructions::interrupts::without_interrupts(|| {
+        // O PAT não pode mudar com linhas em cache de um tipo antigo: WBINVD antes e
+        // depois, e recarga do CR3 para descartar a TLB.
+        core::arch::asm!("wbinvd", options(nostack));
+        Msr::new(IA32_PAT).write(PAT_WITH_WC);
+        core::arch::asm!("wbinvd", options(nostack));
+        let (frame, flags) = Cr3::read();
+        Cr3::write(frame, flags);
+    });
+    PAT_WC_ENABLED.store(true, Ordering::Relaxed);
+}
+
+/// 🗺️ Mapeia `size` bytes de MMIO a partir de `phys` na janela de MMIO do kernel.
+/// * `phys` não precisa estar alinhado; o endereço devolvido preserva o offset na página.
+pub fn map_mmio_region(phys: PhysAddr, size: usize, cache: CacheMode) -> Result<VirtAddr, MemoryError> {
+    let mapper = KERNEL_MAPPER.get().ok_or(MemoryError::InvalidMapping)?;
+    if size == 0 {
+        return Err(MemoryError::InvalidMapping);
+    }
+
+    let first: PhysFrame<Size4KiB> = PhysFrame::containing_address(phys);
+    let last: PhysFrame<Size4KiB> = PhysFrame::containing_address(phys + (size as u64 - 1));
+    let pages = (last.start_address() - first.start_address()) / Size4KiB::SIZE + 1;
+
+    // Reserva a faixa virtual (uma página extra de guarda entre regiões).
+    let virt_start = NEXT_MMIO_VIRT.fetch_add((pages + 1) * Size4KiB::SIZE, Ordering::Relaxed);
+    if virt_start + pages * Size4KiB::SIZE > (MMIO_VIRT_BASE + MMIO_VIRT_SIZE) as u64 {
+        return Err(MemoryError::InvalidMapping);
+    }
+
+    let flags = PageTableFlags::PRESENT | PageTableFlags::WRITABLE | PageTableFlags::NO_EXECUTE | cache.page_flags();
+    let mut mapper = mapper.lock();
+    let mut allocator = FRAME_ALLOCATOR.lock();
+
+    for i in 0..pages {
+        let page: Page<Size4KiB> = Page::containing_address(VirtAddr::new(virt_start + i * Size4KiB::SIZE));
+        let frame = PhysFrame::containing_address(first.start_address() + i * Size4KiB::SIZE);
+        // # SAFETY: A página virtual é nova (janela exclusiva) e o frame é MMIO, não RAM do PMM.
+        match unsafe { mapper.map_to(page, frame, flags, &mut *allocator) } {
+            Ok(flush) => flush.flush(),
+            Err(MapToError::FrameAllocationFailed) => return Err(MemoryError::FrameAllocationFailed),
+            Err(_) => return Err(MemoryError::PagingError),
+        }
+    }
+
+    Ok(VirtAddr::new(virt_start) + (phys.as_u64() - first.start_address().as_u64()))
+}
+
 // ------------------------------------------------------------------------
 // --- Teste de Memória (Exemplo) ---
 // ------------------------------------------------------------------------
@@ -0,0 +1,187 @@
+// src/kernel/memory/shared.rs
+
+//! Regiões de Memória Compartilhada entre Tarefas e o Kernel.
+//!
+//! Uma região é um bloco de frames fisicamente contíguos, visível:
+//! * Ao kernel, pelo mapeamento linear da memória física (`KERNEL_HH_BASE + phys`).
+//! * A cada tarefa que a mapeia, em um endereço fixo da janela `SHARED_USER_BASE`
+//!   (o mesmo em todos os espaços de endereçamento).
+//!
+//! É o transporte dos pixels das superfícies do compositor: a aplicação escreve
+//! diretamente na região e só os metadados (ids, retângulos) passam por syscalls.
+
+use alloc::collections::BTreeMap;
+use alloc::vec::Vec;
+use core::sync::atomic::{AtomicU32, AtomicU64, Ordering};
+use spin::Mutex;
+use x86_64::structures::paging::{PageSize, PageTableFlags, Size4KiB};
+use x86_64::{PhysAddr, VirtAddr};
+
+use super::frame_alloc::FRAME_ALLOCATOR;
+use super::paging;
+use crate::RustKernelConfig::arch_hal::{KERNEL_HH_BASE, SHARED_USER_BASE, SHARED_USER_SIZE};
+
+/// 🆔 Identificador de uma região compartilhada.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, PartialOrd, Ord)]
+#[repr(transparent)]
+pub struct SharedRegionId(pub u32);
+
+/// 🚨 Erros de memória compartilhada.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum SharedMemoryError {
+    /// Tamanho zero ou maior que a janela de mapeamento.
+    InvalidSize,
+    /// Sem frames contíguos livres.
+    OutOfMemory,
+    /// A janela de endereços de userspace se esgotou.
+    AddressSpaceExhausted,
+    /// Id desconhecido.
+    NotFound,
+    /// Falha ao editar as tabelas de páginas.
+    MappingFailed,
+}
+
+/// 📦 Uma região alocada.
+#[derive(Debug, Clone)]
+struct SharedRegion {
+    phys: PhysAddr,
+    pages: u64,
+    /// Endereço na janela de userspace (fixo para a vida da região).
+    user_virt: VirtAddr,
+    /// P4 dos espaços de endereçamento onde `map_into` mapeou a região.
+    mapped_in: Vec<PhysAddr>,
+}
+
+impl SharedRegion {
+    fn size(&self) -> usize {
+        (self.pages * Size4KiB::SIZE) as usize
+    }
+}
+
+static REGIONS: Mutex<BTreeMap<SharedRegionId, SharedRegion>> = Mutex::new(BTreeMap::new());
+
+/// Regiões liberadas, reaproveitadas por `create` (o PMM sequencial não recebe frames de volta).
+static FREE_REGIONS: Mutex<Vec<SharedRegion>> = Mutex::new(Vec::new());
+
+static NEXT_ID: AtomicU32 = AtomicU32::new(1);
+static NEXT_USER_VIRT: AtomicU64 = AtomicU64::new(SHARED_USER_BASE as u64);
+
+/// ➕ Cria uma região de pelo menos `size` bytes, zerada.
+pub fn create(size: usize) -> Result<SharedRegionId, SharedMemoryError> {
+    if size == 0 || size > SHARED_USER_SIZE {
+        return Err(SharedMemoryError::InvalidSize);
+    }
+    let pages = (size as u64 + Size4KiB::SIZE - 1) / Size4KiB::SIZE;
+
+    // Reaproveita uma região liberada que comporte o pedido (a menor delas).
+    let recycled = {
+        let mut free = FREE_REGIONS.lock();
+        free.iter()
+            .enumerate()
+            .filter(|(_, r)| r.pages >= pages)
+            .min_by_key(|(_, r)| r.pages)
+            .map(|(index, _)| index)
+            .map(|index| free.swap_remove(index))
+    };
+
+    let region = match recycled {
+        Some(region) => region,
+        None => {
+            let first = FRAME_ALLOCATOR
+                .lock()
+                .allocate_contiguous(pages)
+                .ok_or(SharedMemoryError::OutOfMemory)?;
+            let user_virt = NEXT_USER_VIRT.fetch_add(pages * Size4KiB::SIZE, Ordering::Relaxed);
+            if user_virt + pages * Size4KiB::SIZE > (SHARED_USER_BASE + SHARED_USER_SIZE) as u64 {
+                return Err(SharedMemoryError::AddressSpaceExhausted);
+            }
+            SharedRegion { phys: first.start_address(), pages, user_virt: VirtAddr::new(user_virt), mapped_in: Vec::new() }
+        }
+    };
+
+    // # SAFETY: Os frames pertencem à região e são acessíveis pelo mapeamento linear.
+    unsafe { core::ptr::write_bytes(kernel_ptr(&region), 0, region.size()) };
+
+    let id = SharedRegionId(NEXT_ID.fetch_add(1, Ordering::Relaxed));
+    REGIONS.lock().insert(id, region);
+    Ok(id)
+}
+
+/// ➖ Libera a região: desfaz o mapeamento em cada tarefa que a mapeou e só
+/// então a devolve para reaproveitamento (os frames irão para outro dono).
+/// * Se um mapeamento não puder ser desfeito, a região não é reaproveitada.
+pub fn release(id: SharedRegionId) -> Result<(), SharedMemoryError> {
+    let mut region = REGIONS.lock().remove(&id).ok_or(SharedMemoryError::NotFound)?;
+
+    let mut unmapped = true;
+    for p4_phys in region.mapped_in.drain(..) {
+        // # SAFETY: A região saiu de `REGIONS`: nenhum novo acesso pelo id, e os
+        // frames só são reaproveitados depois de sumirem de todas as tarefas.
+        unmapped &= unsafe { paging::unmap_frames_in(p4_phys, region.user_virt, region.pages) }.is_ok();
+    }
+    if !unmapped {
+        return Err(SharedMemoryError::MappingFailed);
+    }
+
+    let mut free = FREE_REGIONS.lock();
+    // Sem memória para a lista: a região vaza, mas nunca fica mapeada por engano.
+    if free.try_reserve(1).is_ok() {
+        free.push(region);
+    }
+    Ok(())
+}
+
+fn kernel_ptr(region: &SharedRegion) -> *mut u8 {
+    (KERNEL_HH_BASE as u64 + region.phys.as_u64()) as *mut u8
+}
+
+/// 🔍 Visão do kernel da região: (ponteiro, tamanho em bytes).
+pub fn kernel_view(id: SharedRegionId) -> Option<(*mut u8, usize)> {
+    REGIONS.lock().get(&id).map(|region| (kernel_ptr(region), region.size()))
+}
+
+/// 🗺️ Torna a região acessível no espaço de endereçamento com P4 `p4_phys` e
+/// retorna o endereço onde ela aparece.
+/// * No espaço do kernel (tarefas de kernel), usa o mapeamento linear existente.
+/// * Em outro espaço, mapeia na janela `SHARED_USER_BASE` (acessível ao Ring 3);
+///   uma segunda chamada para o mesmo espaço retorna o mapeamento existente.
+pub fn map_into(id: SharedRegionId, p4_phys: PhysAddr) -> Result<VirtAddr, SharedMemoryError> {
+    let (phys, pages, user_virt) = {
+        let mut regions = REGIONS.lock();
+        let region = regions.get_mut(&id).ok_or(SharedMemoryError::NotFound)?;
+
+        if paging::kernel_p4() == Some(p4_phys) {
+            return Ok(VirtAddr::from_ptr(kernel_ptr(region)));
+        }
+        if region.mapped_in.contains(&p4_phys) {
+            return Ok(region.user_virt);
+        }
+        // Registra antes de mapear: um `release` concorrente desfaz este mapeamento também.
+        region.mapped_in.try_reserve(1).map_err(|_| SharedMemoryError::OutOfMemory)?;
+        region.mapped_in.push(p4_phys);
+        (region.phys, region.pages, region.user_virt)
+    };
+
+    let flags = PageTableFlags::PRESENT
+        | PageTableFlags::WRITABLE
+        | PageTableFlags::USER_ACCESSIBLE
+        | PageTableFlags::NO_EXECUTE;
+    // # SAFETY: Os frames pertencem à região; `user_virt` é exclusivo dela na janela.
+    if unsafe { paging::map_frames_in(p4_phys, user_virt, phys, pages, flags) }.is_err() {
+        // Desfaz o que foi mapeado e o registro (se a região ainda existe).
+        // # SAFETY: As páginas acabaram de ser mapeadas por esta chamada.
+        let _ = unsafe { paging::unmap_frames_in(p4_phys, user_virt, pages) };
+        if let Some(region) = REGIONS.lock().get_mut(&id) {
+            region.mapped_in.retain(|p4| *p4 != p4_phys);
+        }
+        return Err(SharedMemoryError::MappingFailed);
+    }
+    // Um `release` concorrente pode ter desfeito o registro antes do mapeamento.
+    let still_registered = REGIONS.lock().get(&id).map_or(false, |region| region.mapped_in.contains(&p4_phys));
+    if !still_registered {
+        // # SAFETY: A região foi liberada; o mapeamento recém-criado não pode sobreviver.
+        let _ = unsafe { paging::unmap_frames_in(p4_phys, user_virt, pages) };
+        return Err(SharedMemoryError::NotFound);
+    }
+    Ok(user_virt)
+}
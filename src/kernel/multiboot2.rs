@@ -0,0 +1,268 @@
+// src/kernel/multiboot2.rs
+
+//! Leitura da Estrutura de Informações de Boot do Multiboot2.
+//!
+//! O bootloader (GRUB, em BIOS ou UEFI) entrega um bloco de tags alinhadas em
+//! 8 bytes. O LightOS usa:
+//! * Tag 6 (Memory Map): regiões de RAM livres para o PMM.
+//! * Tag 3 (Module): arquivos carregados junto com o kernel (ex.: fonte PSF).
+//! * Tag 8 (Framebuffer Info): o modo gráfico que o firmware configurou
+//!   (VBE no BIOS, GOP no UEFI), com endereço, pitch e máscaras de cor.
+//! * Tags 14/15 (ACPI old/new RSDP): cópia da RSDP, ponto de partida das tabelas ACPI.
+//!
+//! A estrutura é lida através do mapeamento da memória física em `KERNEL_HH_BASE`.
+
+use core::ptr;
+
+use crate::RustKernelConfig::arch_hal::KERNEL_HH_BASE;
+
+/// Tipo da tag de fim.
+const TAG_END: u32 = 0;
+/// Tipo da tag de módulo.
+const TAG_MODULE: u32 = 3;
+/// Tipo da tag do mapa de memória.
+const TAG_MEMORY_MAP: u32 = 6;
+/// Tipo da tag de framebuffer.
+const TAG_FRAMEBUFFER: u32 = 8;
+/// Tipos das tags com a cópia da RSDP (ACPI 1.0 e ACPI 2.0+).
+const TAG_ACPI_OLD_RSDP: u32 = 14;
+const TAG_ACPI_NEW_RSDP: u32 = 15;
+
+/// 🚨 Erros de leitura da estrutura de boot.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum BootInfoError {
+    /// Ponteiro nulo ou não alinhado em 8 bytes.
+    InvalidPointer,
+    /// Tamanho total incoerente.
+    InvalidSize,
+}
+
+// ------------------------------------------------------------------------
+// --- Mapa de Memória ---
+// ------------------------------------------------------------------------
+
+/// 🗂️ Tipo de uma região do mapa de memória.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum MemoryRegionKind {
+    /// RAM livre.
+    Available,
+    /// Tabelas ACPI (recuperável após lidas).
+    AcpiReclaimable,
+    /// Memória ACPI NVS (preservar na hibernação).
+    AcpiNvs,
+    /// RAM com defeito.
+    Defective,
+    /// Reservada (firmware, MMIO, etc.).
+    Reserved,
+}
+
+/// 📍 Uma região física reportada pelo bootloader.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct MemoryRegion {
+    pub base: u64,
+    pub length: u64,
+    pub kind: MemoryRegionKind,
+}
+
+// ------------------------------------------------------------------------
+// --- Módulos ---
+// ------------------------------------------------------------------------
+
+/// 📎 Um módulo carregado pelo bootloader (`module2` no GRUB).
+#[derive(Debug, Clone, Copy)]
+pub struct BootModule {
+    /// Endereço físico do início do módulo.
+    pub start: u64,
+    /// Endereço físico do fim (exclusivo).
+    pub end: u64,
+    /// Linha de comando do módulo (texto após o caminho no `module2`).
+    pub cmdline: &'static str,
+}
+
+impl BootModule {
+    /// 📄 Conteúdo do módulo, pelo mapeamento linear da memória física.
+    /// * `paging::init_paging_and_heap` exclui os módulos das regiões do PMM.
+    pub fn data(&self) -> &'static [u8] {
+        let len = self.end.saturating_sub(self.start) as usize;
+        // # SAFETY: O bootloader carregou `len` bytes em `start`; o PMM nunca
+        // entrega esses frames, então a área não é reutilizada.
+        unsafe { core::slice::from_raw_parts((KERNEL_HH_BASE as u64 + self.start) as *const u8, len) }
+    }
+}
+
+// ------------------------------------------------------------------------
+// --- Framebuffer ---
+// ------------------------------------------------------------------------
+
+/// 🎚️ Posição e tamanho de um canal de cor (tag 8, tipo RGB).
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct ColorField {
+    pub position: u8,
+    pub size: u8,
+}
+
+/// 🎨 Tipo de framebuffer configurado pelo firmware.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum FramebufferKind {
+    /// Cores indexadas por paleta.
+    Indexed,
+    /// Cor direta, com a posição de cada canal.
+    Rgb { red: ColorField, green: ColorField, blue: ColorField },
+    /// Modo texto EGA (sem gráficos).
+    EgaText,
+}
+
+/// 🖥️ Conteúdo da tag de framebuffer (endereço FÍSICO).
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct FramebufferTag {
+    pub phys_addr: u64,
+    pub pitch: u32,
+    pub width: u32,
+    pub height: u32,
+    pub bpp: u8,
+    pub kind: FramebufferKind,
+}
+
+impl FramebufferTag {
+    /// Tamanho em bytes da área visível (`pitch * height`).
+    pub fn size(&self) -> usize {
+        self.pitch as usize * self.height as usize
+    }
+}
+
+// ------------------------------------------------------------------------
+// --- Estrutura de Informações de Boot ---
+// ------------------------------------------------------------------------
+
+/// 📦 Estrutura de informações do Multiboot2 (somente leitura).
+#[derive(Debug, Clone, Copy)]
+pub struct BootInfo {
+    base: *const u8,
+    total_size: usize,
+}
+
+impl BootInfo {
+    /// 🏭 Valida o cabeçalho da estrutura no endereço físico `phys_addr`.
+    ///
+    /// # Safety
+    /// `phys_addr` deve ser o ponteiro entregue pelo bootloader, e a memória
+    /// física deve estar mapeada em `KERNEL_HH_BASE`.
+    pub unsafe fn load(phys_addr: u64) -> Result<Self, BootInfoError> {
+        if phys_addr == 0 || phys_addr & 7 != 0 {
+            return Err(BootInfoError::InvalidPointer);
+        }
+        let base = (KERNEL_HH_BASE as u64 + phys_addr) as *const u8;
+        let total_size = ptr::read(base as *const u32) as usize;
+        // Cabeçalho (8) + tag de fim (8), no mínimo.
+        if total_size < 16 {
+            return Err(BootInfoError::InvalidSize);
+        }
+        Ok(BootInfo { base, total_size })
+    }
+
+    /// Itera sobre as tags: (tipo, ponteiro para o início da tag, tamanho).
+    fn tags(&self) -> impl Iterator<Item = (u32, *const u8, usize)> + '_ {
+        let end = self.total_size;
+        let mut offset = 8;
+        core::iter::from_fn(move || {
+            if offset + 8 > end {
+                return None;
+            }
+            // # SAFETY: `offset + 8 <= total_size`, dentro da estrutura validada em `load`.
+            let (tag, kind, size) = unsafe {
+                let tag = self.base.add(offset);
+                (tag, ptr::read(tag as *const u32), ptr::read(tag.add(4) as *const u32) as usize)
+            };
+            if kind == TAG_END || size < 8 || offset + size > end {
+                return None;
+            }
+            // Tags começam em fronteiras de 8 bytes.
+            offset += (size + 7) & !7;
+            Some((kind, tag, size))
+        })
+    }
+
+    /// 🗺️ Regiões do mapa de memória (tag 6).
+    pub fn memory_map(&self) -> impl Iterator<Item = MemoryRegion> + '_ {
+        self.tags()
+            .filter(|&(kind, _, _)| kind == TAG_MEMORY_MAP)
+            .flat_map(|(_, tag, size)| {
+                // # SAFETY: A tag tem pelo menos 16 bytes (cabeçalho + entry_size/version).
+                let entry_size = unsafe { ptr::read(tag.add(8) as *const u32) } as usize;
+                let count = if entry_size < 24 || size < 16 { 0 } else { (size - 16) / entry_size };
+                (0..count).map(move |i| {
+                    // # SAFETY: `i < count`: a entrada está dentro da tag.
+                    unsafe {
+                        let entry = tag.add(16 + i * entry_size);
+                        let kind = match ptr::read(entry.add(16) as *const u32) {
+                            1 => MemoryRegionKind::Available,
+                            3 => MemoryRegionKind::AcpiReclaimable,
+                            4 => MemoryRegionKind::AcpiNvs,
+                            5 => MemoryRegionKind::Defective,
+                            _ => MemoryRegionKind::Reserved,
+                        };
+                        MemoryRegion {
+                            base: ptr::read_unaligned(entry as *const u64),
+                            length: ptr::read_unaligned(entry.add(8) as *const u64),
+                            kind,
+                        }
+                    }
+                })
+            })
+    }
+
+    /// 📎 Módulos carregados pelo bootloader (tag 3).
+    pub fn modules(&self) -> impl Iterator<Item = BootModule> + '_ {
+        self.tags()
+            .filter(|&(kind, _, size)| kind == TAG_MODULE && size >= 16)
+            .map(|(_, tag, size)| {
+                // # SAFETY: A tag tem `size >= 16` bytes; a cmdline é terminada em zero dentro dela.
+                unsafe {
+                    let text = core::slice::from_raw_parts(tag.add(16), size - 16);
+                    let len = text.iter().position(|&b| b == 0).unwrap_or(text.len());
+                    BootModule {
+                        start: ptr::read(tag.add(8) as *const u32) as u64,
+                        end: ptr::read(tag.add(12) as *const u32) as u64,
+                        cmdline: core::str::from_utf8(&text[..len]).unwrap_or(""),
+                    }
+                }
+            })
+    }
+
+    /// 🖥️ Framebuffer configurado pelo firmware (tag 8), se houver.
+    pub fn framebuffer(&self) -> Option<FramebufferTag> {
+        let (_, tag, size) = self.tags().find(|&(kind, _, _)| kind == TAG_FRAMEBUFFER)?;
+        if size < 31 {
+            return None;
+        }
+
+        // # SAFETY: Os campos lidos estão dentro de `size` bytes da tag.
+        unsafe {
+            let read_u8 = |offset: usize| ptr::read(tag.add(offset));
+            let field = |offset: usize| ColorField { position: read_u8(offset), size: read_u8(offset + 1) };
+
+            let kind = match read_u8(29) {
+                0 => FramebufferKind::Indexed,
+                1 if size >= 38 => FramebufferKind::Rgb { red: field(32), green: field(34), blue: field(36) },
+                _ => FramebufferKind::EgaText,
+            };
+
+            Some(FramebufferTag {
+                phys_addr: ptr::read_unaligned(tag.add(8) as *const u64),
+                pitch: ptr::read_unaligned(tag.add(16) as *const u32),
+                width: ptr::read_unaligned(tag.add(20) as *const u32),
+                height: ptr::read_unaligned(tag.add(24) as *const u32),
+                bpp: read_u8(28),
+                kind,
+            })
+        }
+    }
+
+    /// 🧭 Cópia da RSDP entregue pelo bootloader (tag 15, senão tag 14).
+    pub fn acpi_rsdp(&self) -> Option<&'static [u8]> {
+        let find = |wanted: u32| self.tags().find(|&(kind, _, size)| kind == wanted && size > 8);
+        let (_, tag, size) = find(TAG_ACPI_NEW_RSDP).or_else(|| find(TAG_ACPI_OLD_RSDP))?;
+        // # SAFETY: A RSDP ocupa o resto da tag; a estrutura de boot não é reutilizada.
+        Some(unsafe { core::slice::from_raw_parts(tag.add(8), size - 8) })
+    }
+}
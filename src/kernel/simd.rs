@@ -0,0 +1,95 @@
+// src/kernel/simd.rs
+
+//! Detecção e Habilitação de Extensões SIMD (SSE2/AVX2) da CPU para o LightOS.
+//!
+//! O kernel é compilado sem SSE; apenas funções marcadas com
+//! `#[target_feature(enable = "...")]` usam registradores XMM/YMM, escolhidas em
+//! tempo de execução a partir de `features()`.
+//!
+//! O caminho de IRQ (`irq_handlers_asm.s`) não salva o estado XMM/YMM. Por isso
+//! todo trecho SIMD deve rodar dentro de `with_simd`, que desabilita as
+//! interrupções: nenhuma troca de tarefa pode ocorrer no meio dele. Os trechos
+//! devem ser curtos (uma linha de pixels, um período de áudio).
+
+use core::arch::x86_64::{__cpuid, __cpuid_count, __get_cpuid_max};
+use spin::Once;
+use x86_64::instructions::interrupts;
+use x86_64::registers::control::{Cr0, Cr0Flags, Cr4, Cr4Flags};
+use x86_64::registers::xcontrol::{XCr0, XCr0Flags};
+
+/// 🧩 Extensões SIMD detectadas E habilitadas pelo kernel.
+#[derive(Debug, Default, Clone, Copy, PartialEq, Eq)]
+pub struct CpuFeatures {
+    /// SSE2 (128 bits, inteiros). Presente em toda CPU x86_64.
+    pub sse2: bool,
+    /// SSE4.1 (`pminsd`, `blendv`, etc.).
+    pub sse4_1: bool,
+    /// AVX (estado YMM salvo via XSAVE e habilitado no XCR0).
+    pub avx: bool,
+    /// AVX2 (256 bits, inteiros). Exige `avx`.
+    pub avx2: bool,
+}
+
+static FEATURES: Once<CpuFeatures> = Once::new();
+
+/// 🔍 Lê o CPUID (folhas 01h e 07h).
+fn detect() -> CpuFeatures {
+    // # SAFETY: CPUID está disponível em toda CPU x86_64.
+    let (leaf1, leaf7_ebx) = unsafe {
+        let leaf1 = __cpuid(1);
+        let leaf7_ebx = if __get_cpuid_max(0).0 >= 7 { __cpuid_count(7, 0).ebx } else { 0 };
+        (leaf1, leaf7_ebx)
+    };
+
+    let xsave = leaf1.ecx & (1 << 26) != 0;
+    let avx = xsave && leaf1.ecx & (1 << 28) != 0;
+
+    CpuFeatures {
+        sse2: leaf1.edx & (1 << 26) != 0,
+        sse4_1: leaf1.ecx & (1 << 19) != 0,
+        avx,
+        avx2: avx && leaf7_ebx & (1 << 5) != 0,
+    }
+}
+
+/// ⚙️ Detecta e habilita SSE (CR0/CR4) e, se disponível, AVX (CR4.OSXSAVE + XCR0).
+/// * Chamado uma vez do kernel_main, na CPU de boot, antes dos drivers gráficos e de áudio.
+pub fn init() -> CpuFeatures {
+    *FEATURES.call_once(|| {
+        let detected = detect();
+
+        // # SAFETY: Apenas habilita extensões que o CPUID reportou; nenhum código
+        // usa XMM/YMM antes deste ponto.
+        unsafe {
+            // SSE: sem emulação de FPU (EM=0), com monitoramento (MP=1), FXSAVE e #XM.
+            Cr0::update(|flags| {
+                flags.remove(Cr0Flags::EMULATE_COPROCESSOR);
+                flags.insert(Cr0Flags::MONITOR_COPROCESSOR);
+            });
+            Cr4::update(|flags| flags.insert(Cr4Flags::OSFXSR | Cr4Flags::OSXMMEXCPT_ENABLE));
+
+            if detected.avx {
+                Cr4::update(|flags| flags.insert(Cr4Flags::OSXSAVE));
+                XCr0::write(XCr0Flags::X87 | XCr0Flags::SSE | XCr0Flags::AVX);
+            }
+        }
+
+        crate::println!(
+            "INFO: SIMD habilitado (SSE2: {}, SSE4.1: {}, AVX: {}, AVX2: {}).",
+            detected.sse2, detected.sse4_1, detected.avx, detected.avx2
+        );
+        detected
+    })
+}
+
+/// 📋 Extensões habilitadas (todas `false` antes de `init`).
+#[inline]
+pub fn features() -> CpuFeatures {
+    FEATURES.get().copied().unwrap_or_default()
+}
+
+/// 🔒 Executa um trecho SIMD curto sem risco de preempção (interrupções desabilitadas).
+#[inline]
+pub fn with_simd<R>(f: impl FnOnce() -> R) -> R {
+    interrupts::without_interrupts(f)
+}
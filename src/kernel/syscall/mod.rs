@@ -6,8 +6,17 @@
 //! No x86_64, Syscalls são geralmente acionadas por uma instrução como `SYSCALL` 
 //! ou por uma interrupção de software (ex: INT 0x80).
 
+use x86_64::registers::control::Cr3;
 use x86_64::structures::idt::InterruptStackFrame;
 
+use crate::drivers::blit::Rect;
+use crate::drivers::audio::{AudioFormat, AudioTelemetry};
+use crate::drivers::compositor::{self, BlendMode, CompositorError, SurfaceId};
+use crate::drivers::pcm_ring::{self, PcmRingId};
+use crate::drivers::sound::SoundError;
+use crate::ipc::Endpoint;
+use crate::memory::paging;
+
 // ------------------------------------------------------------------------
 // --- Definições de Syscall ---
 // ------------------------------------------------------------------------
@@ -22,6 +31,28 @@ pub enum SyscallId {
     Exit = 2,
     /// Cria uma nova tarefa.
     SpawnTask = 3,
+    /// Cria uma superfície do compositor.
+    SurfaceCreate = 20,
+    /// Mapeia os pixels de uma superfície no espaço da tarefa.
+    SurfaceMap = 21,
+    /// Informa ao compositor a região redesenhada de uma superfície.
+    SurfaceCommit = 22,
+    /// Posiciona uma superfície (x, y, z, visibilidade).
+    SurfaceConfigure = 23,
+    /// Destrói uma superfície.
+    SurfaceDestroy = 24,
+    /// Cria um anel de períodos de áudio compartilhado (fluxo do mixer).
+    AudioRingCreate = 30,
+    /// Mapeia o anel de áudio no espaço da tarefa.
+    AudioRingMap = 31,
+    /// Registra o endpoint notificado a cada período consumido.
+    AudioRingNotify = 32,
+    /// Ajusta o ganho do fluxo do anel.
+    AudioRingGain = 33,
+    /// Fecha o anel de áudio.
+    AudioRingDestroy = 34,
+    /// Copia a telemetria do pipeline de áudio (`AudioTelemetry`).
+    AudioTelemetry = 35,
     /// Faz uma chamada para o Trusted Execution Environment (TEE).
     TrustyCall = 100,
     /// ID Inválido.
@@ -68,6 +99,17 @@ pub fn syscall_dispatcher(id: u64, args: SyscallArgs) -> u64 {
         1 => SyscallId::PrintString,
         2 => SyscallId::Exit,
         3 => SyscallId::SpawnTask,
+        20 => SyscallId::SurfaceCreate,
+        21 => SyscallId::SurfaceMap,
+        22 => SyscallId::SurfaceCommit,
+        23 => SyscallId::SurfaceConfigure,
+        24 => SyscallId::SurfaceDestroy,
+        30 => SyscallId::AudioRingCreate,
+        31 => SyscallId::AudioRingMap,
+        32 => SyscallId::AudioRingNotify,
+        33 => SyscallId::AudioRingGain,
+        34 => SyscallId::AudioRingDestroy,
+        35 => SyscallId::AudioTelemetry,
         100 => SyscallId::TrustyCall,
         _ => SyscallId::Invalid,
     };
@@ -106,6 +148,37 @@ pub fn syscall_dispatcher(id: u64, args: SyscallArgs) -> u64 {
             0
         }
 
+        SyscallId::SurfaceCreate
+        | SyscallId::SurfaceMap
+        | SyscallId::SurfaceCommit
+        | SyscallId::SurfaceConfigure
+        | SyscallId::SurfaceDestroy => surface_syscall(syscall_id, args).unwrap_or(SYSCALL_ERROR),
+
+        SyscallId::AudioRingCreate
+        | SyscallId::AudioRingMap
+        | SyscallId::AudioRingNotify
+        | SyscallId::AudioRingGain
+        | SyscallId::AudioRingDestroy => audio_ring_syscall(syscall_id, args).unwrap_or(SYSCALL_ERROR),
+
+        SyscallId::AudioTelemetry => {
+            // Syscall 35: AudioTelemetry(out: *mut AudioTelemetry, size: usize)
+            // O tamanho permite a binários antigos receber só o prefixo que conhecem.
+            match crate::drivers::audio::telemetry() {
+                Some(telemetry) => {
+                    let len = (args.arg2 as usize).min(core::mem::size_of::<AudioTelemetry>());
+                    // # SAFETY: `AudioTelemetry` é `repr(C)` e só tem inteiros; lê-se o prefixo `len`.
+                    let bytes = unsafe {
+                        core::slice::from_raw_parts(&telemetry as *const AudioTelemetry as *const u8, len)
+                    };
+                    match paging::copy_to_user(args.arg1, bytes) {
+                        Ok(()) => len as u64,
+                        Err(_) => SYSCALL_ERROR,
+                    }
+                }
+                None => SYSCALL_ERROR,
+            }
+        }
+
         SyscallId::TrustyCall => {
             // Syscall 100: TrustyCall(handle: u64, command_ptr: *const u8, ...)
             // Encaminha a chamada para o módulo TEE/Trusty
@@ -117,7 +190,83 @@ pub fn syscall_dispatcher(id: u64, args: SyscallArgs) -> u64 {
         SyscallId::Invalid => {
             crate::println!("[ERRO] Syscall ID inválido: {}", id);
             // Retorna um código de erro Syscall
-            0xFFFF_FFFF_FFFF_FFFF 
+            SYSCALL_ERROR
+        }
+    }
+}
+
+/// Valor de retorno de erro das Syscalls.
+pub const SYSCALL_ERROR: u64 = 0xFFFF_FFFF_FFFF_FFFF;
+
+/// Divide um argumento empacotado `baixo | alto << 32` em dois u32.
+fn split_u32_pair(arg: u64) -> (u32, u32) {
+    (arg as u32, (arg >> 32) as u32)
+}
+
+/// 🖼️ Syscalls de superfície (20-24). Só metadados cruzam a fronteira: os pixels
+/// ficam na memória compartilhada mapeada por `SurfaceMap`.
+/// * Cada superfície pertence à tarefa que a criou: as demais recebem erro.
+fn surface_syscall(id: SyscallId, args: SyscallArgs) -> Result<u64, CompositorError> {
+    let surface = SurfaceId(args.arg1 as u32);
+    let owner = crate::task::current_task_id().ok_or(CompositorError::NotFound)?;
+    match id {
+        // SurfaceCreate(width, height, alpha: bool) -> id
+        SyscallId::SurfaceCreate => {
+            let blend = if args.arg3 != 0 { BlendMode::Alpha } else { BlendMode::Opaque };
+            compositor::create_surface(owner, args.arg1 as u32, args.arg2 as u32, blend).map(|s| s.0 as u64)
+        }
+        // SurfaceMap(id) -> endereço dos pixels (ARGB8888, stride = largura)
+        SyscallId::SurfaceMap => {
+            let (p4, _) = Cr3::read();
+            compositor::map_surface(surface, owner, p4.start_address()).map(|addr| addr.as_u64())
+        }
+        // SurfaceCommit(id, x | y << 32, width | height << 32)
+        SyscallId::SurfaceCommit => {
+            let ((x, y), (width, height)) = (split_u32_pair(args.arg2), split_u32_pair(args.arg3));
+            compositor::commit(surface, owner, Rect::new(x, y, width, height)).map(|_| 0)
+        }
+        // SurfaceConfigure(id, x | y << 32, z, visible)
+        SyscallId::SurfaceConfigure => {
+            let (x, y) = split_u32_pair(args.arg2);
+            compositor::configure(surface, owner, x, y, args.arg3 as i32, args.arg4 != 0).map(|_| 0)
+        }
+        // SurfaceDestroy(id)
+        SyscallId::SurfaceDestroy => compositor::destroy_surface(surface, owner).map(|_| 0),
+        _ => Ok(SYSCALL_ERROR),
+    }
+}
+
+/// 🔊 Syscalls de anel de áudio (30-34). Depois de `AudioRingMap`, a tarefa
+/// submete períodos avançando `write_index` no cabeçalho, sem syscalls.
+/// * Cada anel pertence à tarefa que o criou: as demais recebem erro.
+fn audio_ring_syscall(id: SyscallId, args: SyscallArgs) -> Result<u64, SoundError> {
+    let ring = PcmRingId(args.arg1 as u32);
+    let owner = crate::task::current_task_id().ok_or(SoundError::InvalidBuffer)?;
+    match id {
+        // AudioRingCreate(sample_rate, channels | bits << 8, period_frames | period_count << 32) -> id
+        SyscallId::AudioRingCreate => {
+            let format = AudioFormat {
+                sample_rate: args.arg1 as u32,
+                channels: args.arg2 as u8,
+                bits_per_sample: (args.arg2 >> 8) as u8,
+            };
+            let (period_frames, period_count) = split_u32_pair(args.arg3);
+            pcm_ring::create(owner, format, period_frames as usize, period_count as usize).map(|r| r.0 as u64)
+        }
+        // AudioRingMap(id) -> endereço do cabeçalho (`PcmRingHeader`)
+        SyscallId::AudioRingMap => {
+            let (p4, _) = Cr3::read();
+            pcm_ring::map(ring, owner, p4.start_address()).map(|addr| addr.as_u64())
+        }
+        // AudioRingNotify(id, endpoint) (endpoint 0 desliga)
+        SyscallId::AudioRingNotify => {
+            let endpoint = (args.arg2 != 0).then(|| Endpoint(args.arg2));
+            pcm_ring::set_notify(ring, owner, endpoint).map(|_| 0)
         }
+        // AudioRingGain(id, ganho Q15)
+        SyscallId::AudioRingGain => pcm_ring::set_gain(ring, owner, args.arg2 as u32).map(|_| 0),
+        // AudioRingDestroy(id)
+        SyscallId::AudioRingDestroy => pcm_ring::destroy(ring, owner).map(|_| 0),
+        _ => Ok(SYSCALL_ERROR),
     }
 }
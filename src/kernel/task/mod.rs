@@ -20,16 +20,16 @@
 
 use alloc::boxed::Box;
 use alloc::collections::VecDeque;
+use core::sync::atomic::{AtomicBool, Ordering};
 use spin::Mutex;
 use x86_64::{VirtAddr, PhysAddr}; // Necessário para PhysAddr (CR3)
 
 // Importa o VMA Manager
 use crate::memory::vma::VMA_Manager;
+use crate::interrupts::frame::TrapFrame;
 
-mod context;
 mod scheduler;
 
-pub use context::TaskContext;
 pub use scheduler::Scheduler;
 
 // ------------------------------------------------------------------------
@@ -40,8 +40,9 @@ pub use scheduler::Scheduler;
 pub struct Task {
     /// ID único da tarefa.
     id: TaskId,
-    /// O contexto de registradores da CPU a ser salvo/restaurado.
-    pub context: TaskContext,
+    /// Trap Frame salvo na última preempção (ou o frame inicial da tarefa).
+    /// * Fica no Heap para que o stub de IRQ possa retomá-lo diretamente.
+    pub frame: Box<TrapFrame>,
     /// Endereço Físico da Tabela de Páginas de Nível 4 (CR3) desta tarefa.
     /// * Essencial para o isolamento do Userspace.
     pub cr3_phys_addr: PhysAddr,
@@ -97,32 +98,86 @@ pub fn spawn_task(entry_point: extern "C" fn(), cr3_base: PhysAddr) {
     // 2. Define o ponteiro da stack
     let stack_top = VirtAddr::from_ptr(stack.as_ptr()) + stack_size;
     
-    // 3. Cria o Contexto
-    let context = TaskContext::new(stack_top, entry_point as u64);
+    // 3. Cria o Trap Frame inicial (retomado pelo stub de IRQ como uma preempção)
+    let frame = Box::new(TrapFrame::new_kernel_task(entry_point as u64, stack_top));
 
     // 4. Cria a Estrutura da Tarefa
+    let task_id = TaskId::new();
     let new_task = Task {
-        id: TaskId::new(),
-        context,
+        id: task_id,
+        frame,
         cr3_phys_addr: cr3_base, // Endereço da P4 Table da nova tarefa
         vma_manager: VMA_Manager::new(), // Um novo gerenciador de VMA para isolamento
         stack,
     };
     
     // 5. Adiciona a Tarefa ao Agendador
-    TASK_MANAGER.lock().add_task(new_task);
+    x86_64::instructions::interrupts::without_interrupts(|| {
+        TASK_MANAGER.lock().add_task(new_task);
+    });
     crate::println!("INFO: Tarefa #{} agendada. (CR3: {:#x})", 
-        new_task.id.0, new_task.cr3_phys_addr.as_u64());
+        task_id.0, cr3_base.as_u64());
 }
 
 // ------------------------------------------------------------------------
-// --- Função de Alternância de Contexto (Chamada pelo Timer IRQ) ---
+// --- Alternância de Contexto (Chamada pelo caminho de IRQ) ---
 // ------------------------------------------------------------------------
 
+/// 🆔 ID da tarefa em execução (`None` antes de o Scheduler escolher uma).
+pub fn current_task_id() -> Option<TaskId> {
+    x86_64::instructions::interrupts::without_interrupts(|| {
+        TASK_MANAGER.lock().current_task_id()
+    })
+}
+
+/// Troca de tarefa pendente (pedida pelo temporizador ou por `yield_now`).
+static NEED_RESCHED: AtomicBool = AtomicBool::new(false);
+
+/// ⏰ Pede uma troca de tarefa ao fim da interrupção atual.
+pub fn request_reschedule() {
+    NEED_RESCHED.store(true, Ordering::Release);
+}
+
+/// Consome o pedido de troca de tarefa (chamado pelo despachante de IRQs).
+pub fn take_reschedule_request() -> bool {
+    NEED_RESCHED.swap(false, Ordering::AcqRel)
+}
+
+/// 🤝 Cede a CPU voluntariamente.
+/// * Dispara a interrupção de software `YIELD_VECTOR`, que percorre o mesmo
+///   caminho de entrada/saída das IRQs: a tarefa é salva e retomada como uma preempção.
+pub fn yield_now() {
+    request_reschedule();
+    // # SAFETY: O vetor de yield tem stub e handler instalados na IDT.
+    unsafe {
+        core::arch::asm!("int {v}", v = const crate::interrupts::YIELD_VECTOR);
+    }
+}
+
+/// 🛑 Termina a tarefa atual: ela sai do Scheduler na próxima troca e não volta.
+/// * Enquanto não houver outra tarefa pronta, continua cedendo a CPU.
+pub fn exit_current() -> ! {
+    loop {
+        x86_64::instructions::interrupts::without_interrupts(|| TASK_MANAGER.lock().request_exit());
+        yield_now();
+    }
+}
+
 /// 🔄 Função principal de pré-empting (alternância de contexto).
-/// 
+///
+/// Recebe o frame da tarefa interrompida e devolve o frame a ser retomado.
+/// Se o Scheduler estiver ocupado (a tarefa interrompida segura o lock), a
+/// troca é adiada e o próprio `frame` é devolvido.
+///
 /// # Safety
-/// É insegura; exige manipulação de registradores CR3 e troca de contexto.
-pub unsafe fn schedule_next(current_context: &mut TaskContext) {
-    TASK_MANAGER.lock().schedule_next(current_context);
+/// Deve ser chamada apenas pelo despachante de IRQs, com interrupções desabilitadas
+/// e `frame` apontando para o Trap Frame completo da tarefa interrompida.
+pub unsafe fn preempt(frame: *mut TrapFrame) -> *mut TrapFrame {
+    match TASK_MANAGER.try_lock() {
+        Some(mut scheduler) => scheduler.preempt(frame),
+        None => {
+            request_reschedule();
+            frame
+        }
+    }
 }
@@ -18,8 +18,10 @@
 
 //! Implementação do Algoritmo de Agendamento (Round-Robin) com isolamento de memória.
 
+use alloc::boxed::Box;
 use alloc::collections::VecDeque;
-use super::{Task, TaskContext};
+use super::{Task, TaskId};
+use crate::interrupts::frame::TrapFrame;
 use x86_64::registers::control::Cr3;
 use x86_64::PhysAddr;
 
@@ -29,6 +31,8 @@ pub struct Scheduler {
     task_queue: VecDeque<Task>,
     /// A tarefa atualmente em execução.
     current_task: Option<Task>,
+    /// A tarefa atual pediu para terminar: não volta para a fila na próxima troca.
+    exit_requested: bool,
 }
 
 impl Scheduler {
@@ -37,6 +41,7 @@ impl Scheduler {
         Scheduler {
             task_queue: VecDeque::new(),
             current_task: None,
+            exit_requested: false,
         }
     }
 
@@ -45,13 +50,27 @@ impl Scheduler {
         self.task_queue.push_back(task);
     }
 
+    /// 🆔 ID da tarefa em execução.
+    pub fn current_task_id(&self) -> Option<TaskId> {
+        self.current_task.as_ref().map(|task| task.id)
+    }
+
+    /// 🛑 Marca a tarefa atual para ser descartada na próxima troca.
+    pub fn request_exit(&mut self) {
+        self.exit_requested = true;
+    }
+
     /// 🔄 Implementa a lógica do agendamento (Round-Robin) e realiza a troca de CR3.
-    /// * Escolhe a próxima tarefa, salva o contexto da atual e prepara para a troca.
+    /// * Salva o frame da tarefa atual e devolve o frame da próxima tarefa.
     ///
     /// # Safety
-    /// `current_context` é o contexto salvo da tarefa que acabou de ser pré-emptada.
-    pub unsafe fn schedule_next(&mut self, current_context: &mut TaskContext) {
-        
+    /// `current` é o Trap Frame da tarefa que acabou de ser pré-emptada (na stack IST).
+    pub unsafe fn preempt(&mut self, current: *mut TrapFrame) -> *mut TrapFrame {
+        // Nenhuma outra tarefa pronta: continua a atual, sem copiar o frame.
+        if self.task_queue.is_empty() {
+            return current;
+        }
+
         // 1. Lidar com a primeira execução (Kernel Task 0)
         if self.current_task.is_none() {
             // Captura o endereço CR3 atual do Kernel (P4 Table)
@@ -61,7 +80,7 @@ impl Scheduler {
             // NOTA: Para simplificar, o VMA Manager é vazio.
             let kernel_task = Task {
                 id: super::TaskId(0), 
-                context: *current_context,
+                frame: Box::new(*current),
                 cr3_phys_addr: p4_table_frame.start_address(), // CR3 do Kernel
                 vma_manager: crate::memory::vma::VMA_Manager::new(), 
                 stack: Box::new([]), 
@@ -69,38 +88,36 @@ impl Scheduler {
             self.current_task = Some(kernel_task);
         }
 
-        // 2. Pré-emptar a tarefa atual: Salvar o contexto dela e colocá-la no final da fila.
-        // Já que esta função é chamada do Assembly Wrapper (após lightos_context_switch_save), 
-        // o `current_context` já contém os registradores salvos (RBX, RBP, R12-R15, RFLAGS).
+        // 2. Pré-emptar a tarefa atual: Salvar o frame dela e colocá-la no final da fila.
+        // Uma tarefa que pediu para terminar é descartada (a stack dela é liberada;
+        // estamos na stack IST, não nela).
         if let Some(mut prev_task) = self.current_task.take() {
-            prev_task.context = *current_context;
-            self.task_queue.push_back(prev_task);
+            if core::mem::take(&mut self.exit_requested) {
+                drop(prev_task);
+            } else {
+                *prev_task.frame = *current;
+                self.task_queue.push_back(prev_task);
+            }
         }
 
         // 3. Selecionar a próxima tarefa (Round-Robin)
-        if let Some(next_task) = self.task_queue.pop_front() {
-            
-            let next_task_id = next_task.id.0;
-            let next_cr3 = next_task.cr3_phys_addr;
-            
-            // 4. Trocar o Contexto de Memória (CR3)
-            // Esta é a parte crucial para o isolamento.
-            if Cr3::read().0.start_address() != next_cr3 {
-                Self::switch_cr3(next_cr3);
-                crate::println!("SCHED: Troca de CR3 para {:#x}", next_cr3.as_u64());
-            }
+        let mut next_task = match self.task_queue.pop_front() {
+            Some(task) => task,
+            None => return current, // Inalcançável: a fila tinha ao menos a anterior.
+        };
 
-            // 5. Restaurar o Contexto da CPU (Feito pelo Assembly, aqui preparamos o contexto)
-            *current_context = next_task.context; 
-            self.current_task = Some(next_task);
-            
-            crate::println!("SCHED: Trocando para Tarefa #{}", next_task_id);
-
-        } else {
-            // Nenhuma tarefa pronta (Retorna para a tarefa IDLE do Kernel)
-            crate::println!("SCHED: Nenhuma tarefa de usuário disponível. Continuar IDLE.");
-            // O contexto do kernel_main será restaurado.
+        // 4. Trocar o Contexto de Memória (CR3)
+        // Esta é a parte crucial para o isolamento.
+        let next_cr3 = next_task.cr3_phys_addr;
+        if Cr3::read().0.start_address() != next_cr3 {
+            Self::switch_cr3(next_cr3);
         }
+
+        // 5. O stub de IRQ restaura os registradores a partir deste frame (no Heap,
+        // que não se move enquanto a tarefa existir).
+        let next_frame: *mut TrapFrame = &mut *next_task.frame;
+        self.current_task = Some(next_task);
+        next_frame
     }
     
     /// ⚛️ Troca o registro CR3 da CPU.
@@ -40,6 +40,9 @@ pub mod interrupts;     // IDT, PIC e Handlers IRQ
 pub mod memory;         // MMU, Paging e Heap
 pub mod task;           // Scheduler e Context Switch
 pub mod syscall;        // Dispatcher de Chamadas de Sistema
+pub mod simd;           // Detecção/Habilitação de SSE2/AVX2
+pub mod multiboot2;     // Leitura das informações de boot (memória, framebuffer)
+pub mod acpi;           // Tabelas ACPI (MCFG)
 
 
 // Reexporta as configurações HAL específicas da arquitetura
@@ -72,15 +75,23 @@ pub extern "C" fn kernel_main(multiboot2_info_ptr: u64) -> ! {
 
     // 1. INICIALIZAÇÃO CRÍTICA (ORDEM É VITAL)
     
-    // 1.1. ⚡ Inicializar IDT, PIC e Habilitar Interrupções
+    // 1.1. ⚡ Inicializar GDT/TSS (stacks IST), IDT, PIC e Habilitar Interrupções
+    interrupts::gdt::init();
     interrupts::init_idt_and_pics();
     
     // 1.2. 💾 Inicializar Paging e Heap
-    let pmm_allocator = memory::frame_alloc::PhysicalMemoryManager::new();
+    let pmm_allocator = memory::PhysicalMemoryManager::new();
+    let boot_info = match unsafe { multiboot2::BootInfo::load(multiboot2_info_ptr) } {
+        Ok(info) => info,
+        Err(e) => {
+            println!("[FATAL] Informações do Multiboot2 inválidas: {:?}", e);
+            loop { unsafe { x86_64::instructions::hlt(); } }
+        }
+    };
 
     match unsafe { 
         memory::paging::init_paging_and_heap(
-            multiboot2_info_ptr, 
+            &boot_info, 
             pmm_allocator, 
             KERNEL_HEAP_START, 
             HEAP_SIZE
@@ -93,17 +104,63 @@ pub extern "C" fn kernel_main(multiboot2_info_ptr: u64) -> ! {
         }
     }
     
+    // 1.2.0. 🧩 Habilitar SSE/AVX (usados pelo motor 2D)
+    simd::init();
+
+    // 1.2.1. ⚡ Migrar do PIC 8259 para o x2APIC/IO-APIC (exige o MMIO mapeado)
+    interrupts::init_apic();
+
+    // 1.2.2. 🧭 Tabelas ACPI e acesso ECAM ao PCIe (antes da primeira enumeração PCI)
+    match acpi::init(&boot_info) {
+        Ok(()) => println!("[ACPI] {} janela(s) ECAM.", drivers::pci::init_ecam()),
+        Err(e) => println!("[ACPI] Tabelas indisponíveis ({:?}); PCI pelas portas de configuração.", e),
+    }
+    
     // 1.3. ⚙️ Inicializar Subsistemas Essenciais
     ipc::initialize();
     syscall::initialize();
     task::initialize(); // Inicializa o Scheduler/Task Manager
+    interrupts::threaded::initialize(); // Thread dos bottom halves de IRQ
     
 
     // 2. Inicializar Drivers e Iniciar Tarefas
     
     // 2.1. Drivers (Exemplo: Display)
     // O Driver de Display usará o Heap e o Paging (que agora estão prontos)
-    // ... (Código de inicialização do DisplayDriver permanece o mesmo) ...
+    // Preferência: VirtIO-GPU (transferência só do dano); senão, o framebuffer do firmware.
+    match drivers::virtio::gpu::init_display() {
+        Ok(()) => println!("[DRIVER] Display inicializado sobre VirtIO-GPU."),
+        Err(e) => {
+            println!("[DRIVER] VirtIO-GPU indisponível ({:?}); usando o framebuffer do firmware.", e);
+            match drivers::display::init_boot_display(boot_info.framebuffer()) {
+                Ok(()) => println!("[DRIVER] Display inicializado a partir do framebuffer do firmware."),
+                Err(e) => println!("[DRIVER] Sem display gráfico: {:?}", e),
+            }
+        }
+    }
+    if let Err(e) = drivers::font::load_boot_font(&boot_info) {
+        println!("[DRIVER] Sem fonte do sistema (módulo PSF): {:?}", e);
+    }
+    if let Err(e) = drivers::compositor::initialize() {
+        println!("[DRIVER] Compositor desativado: {:?}", e);
+    }
+    if let Err(e) = drivers::overlay::init_pointer() {
+        println!("[DRIVER] Cursor desativado: {:?}", e);
+    }
+    match drivers::virtio::input::init_input() {
+        Ok(count) => println!("[DRIVER] VirtIO-Input: {} dispositivo(s).", count),
+        Err(e) => println!("[DRIVER] Sem VirtIO-Input: {:?}", e),
+    }
+    match drivers::sound::initialize_sound_subsystem() {
+        Ok(()) => {
+            println!("[DRIVER] Áudio inicializado.");
+            if RustKernelConfig::AUDIO_BENCHMARK_AT_BOOT {
+                let (kernel_p4, _) = x86_64::registers::control::Cr3::read();
+                task::spawn_task(drivers::audio_bench::benchmark_task, kernel_p4.start_address());
+            }
+        }
+        Err(e) => println!("[DRIVER] Sem áudio: {:?}", e),
+    }
     println!("[DRIVER] Drivers básicos inicializados.");
 
     // 2.2. Iniciar Tarefas de Usuário (Exemplo)